@@ -0,0 +1,55 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+/// Minimal benchmarks runner. Benchmarks are not a part of the unit tests
+/// as their results depend on the machine, they are built with
+/// VOXELENGINE_BUILD_BENCHMARKS option and run manually:
+/// `VoxelEngineBenchmark [name filter]`
+namespace benchmark {
+    struct Case {
+        std::string name;
+        std::function<void()> function;
+    };
+
+    std::vector<Case>& get_cases();
+
+    struct Registrar {
+        Registrar(std::string name, std::function<void()> function) {
+            get_cases().push_back({std::move(name), std::move(function)});
+        }
+    };
+
+    /// @brief Call the function count times
+    /// @return average call duration in nanoseconds
+    template <typename Func>
+    inline double measure(size_t count, Func&& func) {
+        using namespace std::chrono;
+        auto start = steady_clock::now();
+        for (size_t i = 0; i < count; i++) {
+            func();
+        }
+        auto elapsed = duration<double, std::nano>(steady_clock::now() - start);
+        return elapsed.count() / count;
+    }
+
+    /// @brief Prevent computation of the value from being optimized out
+    void keep(uint64_t value);
+
+    /// @brief Print measured value of the running benchmark
+    void report(const std::string& label, double value, const std::string& unit);
+
+    /// @brief Mark the running benchmark failed (results are not valid)
+    void fail(const std::string& message);
+}
+
+#define BENCHMARK(NAME)                                                  \
+    static void benchmark_##NAME();                                      \
+    static benchmark::Registrar benchmark_registrar_##NAME(              \
+        #NAME, benchmark_##NAME                                          \
+    );                                                                   \
+    static void benchmark_##NAME()
@@ -0,0 +1,108 @@
+#include "benchmark.hpp"
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "coders/compression.hpp"
+#include "coders/rle.hpp"
+#include "voxels/Chunk.hpp"
+
+/// @brief Layered terrain with ore veins and caves
+static void generate_terrain(voxel* voxels) {
+    std::mt19937 random(0);
+    for (uint y = 0; y < CHUNK_H; y++) {
+        for (uint z = 0; z < CHUNK_D; z++) {
+            for (uint x = 0; x < CHUNK_W; x++) {
+                auto& vox = voxels[vox_index(x, y, z)];
+                uint height = 60 + (x * 3 + z * 5) % 7;
+                if (y == 0) {
+                    vox.id = 1;
+                } else if (y < height - 4) {
+                    bool cave = ((x + y / 3) % 11 == 0) && (z + y) % 5 < 2;
+                    bool ore = random() % 40 == 0;
+                    vox.id = cave ? 0 : (ore ? 3 + random() % 3 : 2);
+                } else if (y < height) {
+                    vox.id = 6;
+                } else if (y == height) {
+                    vox.id = 7;
+                    vox.state.rotation = random() % 4;
+                } else if (y < 64) {
+                    vox.id = 8;
+                }
+            }
+        }
+    }
+}
+
+/// Compression ratio and speed of LZ4 compared to gzip on chunk data,
+/// raw and encoded with extRLE16 as stored in regions
+BENCHMARK(LZ4_ChunkData) {
+    using compression::Method;
+    constexpr size_t iterations = 200;
+
+    Chunk chunk(0, 0);
+    generate_terrain(chunk.getVoxels());
+    auto raw = chunk.encode();
+
+    std::vector<ubyte> rleBuffer(CHUNK_DATA_LEN * 2);
+    size_t rleSize =
+        extrle::encode16(raw.get(), CHUNK_DATA_LEN, rleBuffer.data());
+
+    struct Input {
+        std::string name;
+        const ubyte* data;
+        size_t size;
+    };
+    struct Codec {
+        std::string name;
+        Method method;
+    };
+    for (const auto& input : {
+             Input {"raw", raw.get(), static_cast<size_t>(CHUNK_DATA_LEN)},
+             Input {"extRLE16", rleBuffer.data(), rleSize},
+         }) {
+        for (const auto& codec : {
+                 Codec {"gzip", Method::GZIP},
+                 Codec {"LZ4", Method::LZ4},
+             }) {
+            std::string label = input.name + " " + codec.name;
+
+            size_t size = 0;
+            auto compressed = compression::compress(
+                input.data, input.size, size, codec.method
+            );
+            auto decompressed = compression::decompress(
+                compressed.get(), size, input.size, codec.method
+            );
+            if (std::memcmp(decompressed.get(), input.data, input.size)) {
+                benchmark::fail(label + " round trip result differs");
+            }
+
+            double compressTime = benchmark::measure(iterations, [&]() {
+                size_t len;
+                benchmark::keep(compression::compress(
+                    input.data, input.size, len, codec.method
+                )[0]);
+            });
+            double decompressTime = benchmark::measure(iterations, [&]() {
+                benchmark::keep(compression::decompress(
+                    compressed.get(), size, input.size, codec.method
+                )[0]);
+            });
+            // bytes per nanosecond to MB/s
+            benchmark::report(
+                label + " ratio", static_cast<double>(input.size) / size, "x"
+            );
+            benchmark::report(
+                label + " compress", input.size / compressTime * 1000, "MB/s"
+            );
+            benchmark::report(
+                label + " decompress",
+                input.size / decompressTime * 1000,
+                "MB/s"
+            );
+        }
+    }
+}
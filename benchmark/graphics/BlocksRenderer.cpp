@@ -0,0 +1,200 @@
+#include "benchmark.hpp"
+
+#include <cmath>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "assets/Assets.hpp"
+#include "content/Content.hpp"
+#include "content/ContentBuilder.hpp"
+#include "core_defs.hpp"
+#include "frontend/ContentGfxCache.hpp"
+#include "graphics/core/Atlas.hpp"
+#include "graphics/core/ImageData.hpp"
+#include "graphics/render/BlocksRenderer.hpp"
+#include "items/ItemDef.hpp"
+#include "lighting/Lightmap.hpp"
+#include "settings.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/Chunk.hpp"
+
+namespace {
+    enum Blocks : blockid_t {
+        AIR, STONE, DIRT, GRASS_BLOCK, COAL_ORE, WOOD, LEAVES, WATER, GRASS
+    };
+
+    constexpr int SEA_LEVEL = 52;
+
+    uint32_t hash(int x, int y, int z) {
+        uint32_t h = x * 73856093U ^ y * 19349663U ^ z * 83492791U;
+        h ^= h >> 13;
+        h *= 0x5bd1e995U;
+        return h ^ (h >> 15);
+    }
+
+    int height_at(int x, int z) {
+        return 56 + static_cast<int>(
+            10.0f * std::sin(x * 0.09f) * std::cos(z * 0.07f) +
+            4.0f * std::sin((x + z) * 0.23f)
+        );
+    }
+
+    bool is_tree(int x, int z) {
+        return height_at(x, z) > SEA_LEVEL && hash(x, 0, z) % 67 == 0;
+    }
+
+    /// @brief Hilly terrain with caves, ores, trees, tall grass and lakes
+    blockid_t terrain_at(int x, int y, int z) {
+        int height = height_at(x, z);
+        if (y < height - 4) {
+            uint32_t h = hash(x / 3, y / 3, z / 3);
+            if (y > 4 && h % 23 == 0) {
+                return AIR;
+            }
+            return hash(x, y, z) % 40 == 0 ? COAL_ORE : STONE;
+        } else if (y < height - 1) {
+            return DIRT;
+        } else if (y == height - 1) {
+            return height > SEA_LEVEL ? GRASS_BLOCK : DIRT;
+        } else if (y < SEA_LEVEL) {
+            return WATER;
+        }
+        for (int tz = z - 2; tz <= z + 2; tz++) {
+            for (int tx = x - 2; tx <= x + 2; tx++) {
+                if (!is_tree(tx, tz)) {
+                    continue;
+                }
+                int top = height_at(tx, tz) + 5;
+                if (tx == x && tz == z && y < top) {
+                    return WOOD;
+                }
+                if (y >= top - 2 && y <= top) {
+                    return LEAVES;
+                }
+            }
+        }
+        if (y == height && hash(x, y, z) % 6 == 0) {
+            return GRASS;
+        }
+        return AIR;
+    }
+}
+
+/// Mesh build latency of a chunk with generated terrain containing regular,
+/// optional culling (leaves), translucent (water) and X-sprite blocks
+BENCHMARK(BlocksRenderer_Build) {
+    constexpr size_t iterations = 50;
+
+    ContentBuilder builder;
+    builder.items.create("core:empty");
+    auto& air = builder.blocks.create("core:air");
+    air.defaults.model.type = BlockModelType::NONE;
+    air.lightPassing = true;
+    air.skyLightPassing = true;
+    air.obstacle = false;
+    air.material = "base:air";
+    air.pickingItem = "core:empty";
+    auto createBlock = [&builder](const std::string& name) -> Block& {
+        auto& block = builder.blocks.create("base:" + name);
+        block.material = "base:stone";
+        block.pickingItem = "core:empty";
+        for (auto& texture : block.defaults.textureFaces) {
+            texture = name;
+        }
+        return block;
+    };
+    // created in Blocks enum order
+    for (const auto& name : {"stone", "dirt", "grass_block", "coal_ore"}) {
+        createBlock(name);
+    }
+    createBlock("wood");
+    auto& leaves = createBlock("leaves");
+    leaves.defaults.drawGroup = 5;
+    leaves.defaults.culling = CullingMode::OPTIONAL;
+    auto& water = createBlock("water");
+    water.defaults.drawGroup = 3;
+    water.lightPassing = true;
+    water.obstacle = false;
+    water.translucent = true;
+    auto& grass = createBlock("grass");
+    grass.defaults.drawGroup = 1;
+    grass.defaults.model.type = BlockModelType::XSPRITE;
+    grass.lightPassing = true;
+    grass.obstacle = false;
+    auto content = builder.build();
+
+    std::unordered_map<std::string, UVRegion> regions {
+        {TEXTURE_NOTFOUND, UVRegion(0.0f, 0.0f, 0.25f, 0.25f)}
+    };
+    float u = 0.25f;
+    for (const auto& name : {"stone", "dirt", "grass_block", "coal_ore",
+                             "wood", "leaves", "leaves_opaque", "water",
+                             "grass"}) {
+        regions[name] = UVRegion(u, 0.0f, u + 0.0625f, 0.0625f);
+        u += 0.0625f;
+    }
+    Assets assets {nullptr};
+    assets.store(
+        std::make_unique<Atlas>(
+            std::make_unique<ImageData>(ImageFormat::RGBA8888, 256, 256),
+            std::move(regions),
+            false
+        ),
+        "blocks"
+    );
+    EngineSettings settings;
+    ContentGfxCache cache(*content, assets, settings.graphics);
+    const auto* blockDefs = content->getIndices()->blocks.getDefs();
+
+    Chunk chunk(0, 0, std::make_shared<Lightmap>());
+    VoxelsRenderVolume volume(
+        -VOXELS_BUFFER_PADDING, 0, -VOXELS_BUFFER_PADDING
+    );
+    constexpr int w = VoxelsRenderVolume::width;
+    constexpr int d = VoxelsRenderVolume::depth;
+    auto voxels = volume.getVoxels();
+    auto lights = volume.getLights();
+    for (int y = 0; y < CHUNK_H; y++) {
+        for (int z = 0; z < d; z++) {
+            for (int x = 0; x < w; x++) {
+                int lx = x - VOXELS_BUFFER_PADDING;
+                int lz = z - VOXELS_BUFFER_PADDING;
+                blockid_t id = terrain_at(lx, y, lz);
+                size_t index = vox_index(x, y, z, w, d);
+                voxels[index] = {id, {}};
+                lights[index] = blockDefs[id]->lightPassing
+                                    ? Lightmap::SUN_LIGHT_ONLY
+                                    : 0;
+                if (lx >= 0 && lz >= 0 && lx < CHUNK_W && lz < CHUNK_D) {
+                    chunk.set(lx, y, lz, {id, {}});
+                }
+            }
+        }
+    }
+    chunk.updateHeights();
+
+    for (bool greedy : {false, true}) {
+        settings.graphics.greedyMeshing.set(greedy);
+        BlocksRenderer renderer(1'000'000, blockDefs, cache, settings);
+        size_t vertices = 0;
+        double time = benchmark::measure(iterations, [&]() {
+            renderer.build(&chunk, volume);
+            auto mesh = renderer.createMesh();
+            vertices = 0;
+            for (const auto& section : mesh.sections) {
+                vertices += section.mesh.vertices.size();
+                for (const auto& entry : section.sortingMesh.entries) {
+                    vertices += entry.vertexData.size();
+                }
+            }
+        });
+        if (vertices == 0) {
+            benchmark::fail("empty mesh");
+        }
+        benchmark::keep(vertices);
+        std::string label = greedy ? "build greedy" : "build";
+        benchmark::report(label, time / 1e6, "ms");
+        benchmark::report(label + " vertices", vertices, "");
+    }
+}
@@ -0,0 +1,119 @@
+#include "benchmark.hpp"
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+
+#include "content/Content.hpp"
+#include "lighting/Lighting.hpp"
+#include "lighting/Lightmap.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/Chunk.hpp"
+
+/// @brief Per-column walk with block definition lookups the layered
+/// prebuild replaced
+static void prebuild_sky_light_columns(
+    Chunk& chunk, const ContentIndices& indices
+) {
+    auto& lightmap = *chunk.lightmap;
+    const auto* blockDefs = indices.blocks.getDefs();
+
+    int highestPoint = 0;
+    for (int z = 0; z < CHUNK_D; z++) {
+        for (int x = 0; x < CHUNK_W; x++) {
+            for (int y = CHUNK_H - 1; y >= 0; y--) {
+                voxel vox = chunk.get(x, y, z);
+                if (!blockDefs[vox.id]->skyLightPassing) {
+                    if (highestPoint < y) {
+                        highestPoint = y;
+                    }
+                    break;
+                }
+                lightmap.setS(x, y, z, 15);
+            }
+        }
+    }
+    if (highestPoint < CHUNK_H - 1) {
+        highestPoint++;
+    }
+    lightmap.highestPoint = highestPoint;
+}
+
+/// Sky light prebuild of a chunk with terrain at 60-100 height and
+/// transparent blocks in the air layers above it
+BENCHMARK(Lighting_PrebuildSkyLight) {
+    constexpr size_t iterations = 2000;
+
+    Block air {"core:air"};
+    Block stone {"base:stone"};
+    Block glass {"base:glass"};
+    air.lightPassing = true;
+    air.skyLightPassing = true;
+    glass.lightPassing = true;
+    glass.skyLightPassing = true;
+    ContentIndices indices(
+        ContentUnitIndices<Block, blockid_t>({&air, &stone, &glass}),
+        ContentUnitIndices<ItemDef, itemid_t>({}),
+        ContentUnitIndices<EntityDef, entitydefid_t>({})
+    );
+
+    Chunk chunk(0, 0, std::make_shared<Lightmap>());
+    std::mt19937 random(0);
+    voxel* voxels = chunk.getVoxels();
+    for (int z = 0; z < CHUNK_D; z++) {
+        for (int x = 0; x < CHUNK_W; x++) {
+            int height = 60 + (x * 7 + z * 13) % 40;
+            for (int y = 0; y < CHUNK_H; y++) {
+                blockid_t id = 0;
+                if (y < height) {
+                    id = 1;
+                } else if (random() % 16 == 0) {
+                    id = 2;
+                }
+                voxels[vox_index(x, y, z)].id = id;
+            }
+        }
+    }
+    chunk.pack();
+
+    auto expected = std::make_unique<Lightmap>();
+    auto reference = [&]() {
+        chunk.lightmap->clear();
+        prebuild_sky_light_columns(chunk, indices);
+    };
+    reference();
+    expected->set(chunk.lightmap.get());
+    expected->highestPoint = chunk.lightmap->highestPoint;
+    double referenceTime = benchmark::measure(iterations, reference);
+    benchmark::report("column walk", referenceTime / 1000.0, "mcs");
+
+    struct Path {
+        std::string name;
+        noise::SimdLevel level;
+    };
+    for (const auto& [name, level] : {
+             Path {"layers", noise::SimdLevel::NONE},
+             Path {"layers SSE4.1", noise::SimdLevel::SSE41},
+             Path {"layers AVX2", noise::SimdLevel::AVX2},
+         }) {
+        // not supported by CPU or build
+        if (level > noise::get_simd_level()) {
+            continue;
+        }
+        auto prebuild = [&, level = level]() {
+            chunk.lightmap->clear();
+            Lighting::prebuildSkyLight(chunk, indices, level);
+        };
+        prebuild();
+        if (chunk.lightmap->highestPoint != expected->highestPoint ||
+            std::memcmp(
+                chunk.lightmap->map, expected->map, sizeof(Lightmap::map)
+            )) {
+            benchmark::fail(name + " result differs from column walk");
+        }
+        double time = benchmark::measure(iterations, prebuild);
+        benchmark::report(name, time / 1000.0, "mcs");
+        benchmark::report(name + " speedup", referenceTime / time, "x");
+    }
+}
@@ -0,0 +1,41 @@
+#include "benchmark.hpp"
+
+#include <iomanip>
+#include <iostream>
+
+static volatile uint64_t sink = 0;
+static bool failed = false;
+
+std::vector<benchmark::Case>& benchmark::get_cases() {
+    static std::vector<Case> cases;
+    return cases;
+}
+
+void benchmark::keep(uint64_t value) {
+    sink = sink + value;
+}
+
+void benchmark::report(
+    const std::string& label, double value, const std::string& unit
+) {
+    std::cout << "  " << std::left << std::setw(40) << label << std::right
+              << std::fixed << std::setprecision(2) << std::setw(12) << value
+              << " " << unit << std::endl;
+}
+
+void benchmark::fail(const std::string& message) {
+    std::cerr << "  FAILED: " << message << std::endl;
+    failed = true;
+}
+
+int main(int argc, char** argv) {
+    std::string filter = argc > 1 ? argv[1] : "";
+    for (const auto& benchmarkCase : benchmark::get_cases()) {
+        if (benchmarkCase.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        std::cout << benchmarkCase.name << std::endl;
+        benchmarkCase.function();
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "maths/FastNoiseLite.h"
+#include "maths/noise_batch.hpp"
+#include "typedefs.hpp"
+
+/// Heightmap:noise(offset, 0.1, 4) of a 256x256 map computed with
+/// per-sample FastNoiseLite calls and with bulk kernels at each SIMD level
+BENCHMARK(NoiseBatch_Heightmap) {
+    constexpr uint size = 256;
+    constexpr int octaves = 4;
+    constexpr size_t iterations = 10;
+
+    std::vector<float> xs(size);
+    std::vector<float> ys(size);
+    std::vector<float> reference(size * size);
+    std::vector<float> values(size * size);
+
+    struct NoiseType {
+        std::string name;
+        fnl_noise_type type;
+    };
+    struct Path {
+        std::string name;
+        noise::SimdLevel level;
+    };
+    for (const auto& [typeName, type] : {
+             NoiseType {"OpenSimplex2", FNL_NOISE_OPENSIMPLEX2},
+             NoiseType {"Perlin", FNL_NOISE_PERLIN},
+             NoiseType {"Cellular", FNL_NOISE_CELLULAR},
+         }) {
+        auto state = fnlCreateState();
+        state.noise_type = type;
+
+        double referenceTime = benchmark::measure(iterations, [&]() {
+            std::fill(reference.begin(), reference.end(), 0.0f);
+            for (uint y = 0; y < size; y++) {
+                for (uint x = 0; x < size; x++) {
+                    for (int c = 0; c < octaves; c++) {
+                        float m = 0.1f * (1 << c);
+                        reference[y * size + x] +=
+                            fnlGetNoise2D(&state, x * m, y * m) /
+                            static_cast<float>(1 << c);
+                    }
+                }
+            }
+        });
+        benchmark::report(
+            typeName + " FastNoiseLite", referenceTime / 1e6, "ms"
+        );
+
+        for (const auto& [name, level] : {
+                 Path {"bulk", noise::SimdLevel::NONE},
+                 Path {"bulk SSE4.1", noise::SimdLevel::SSE41},
+                 Path {"bulk AVX2", noise::SimdLevel::AVX2},
+             }) {
+            // not supported by CPU or build
+            if (level > noise::get_simd_level()) {
+                continue;
+            }
+            double time = benchmark::measure(iterations, [&, level = level]() {
+                std::fill(values.begin(), values.end(), 0.0f);
+                for (int c = 0; c < octaves; c++) {
+                    float m = 0.1f * (1 << c);
+                    float amplitude = 1.0f / static_cast<float>(1 << c);
+                    for (uint y = 0; y < size; y++) {
+                        for (uint x = 0; x < size; x++) {
+                            xs[x] = x * m;
+                            ys[x] = y * m;
+                        }
+                        noise::add_noise_2d(
+                            state,
+                            xs.data(),
+                            ys.data(),
+                            amplitude,
+                            values.data() + y * size,
+                            size,
+                            level
+                        );
+                    }
+                }
+            });
+            if (values != reference) {
+                benchmark::fail(
+                    typeName + " " + name + " result differs from reference"
+                );
+            }
+            benchmark::report(typeName + " " + name, time / 1e6, "ms");
+            benchmark::report(
+                typeName + " " + name + " speedup", referenceTime / time, "x"
+            );
+        }
+    }
+}
@@ -0,0 +1,84 @@
+#include "benchmark.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "network/Network.hpp"
+
+using namespace std::chrono;
+
+/// Throughput of a loopback TCP connection streaming data in 64 KiB sends
+BENCHMARK(Sockets_TcpLoopbackThroughput) {
+    const size_t total = 128 * 1024 * 1024;
+    const size_t chunkSize = 64 * 1024;
+
+    NetworkSettings settings {};
+    auto network = network::Network::create(settings);
+
+    std::atomic<u64id_t> serverSide = 0;
+    std::atomic<bool> connected = false;
+    int port = network->findFreePort();
+    network->openTcpServer(port, [&serverSide](u64id_t, u64id_t cid) {
+        serverSide = cid;
+    });
+    u64id_t clientSide = network->connectTcp(
+        "127.0.0.1",
+        port,
+        [&connected](u64id_t) { connected = true; },
+        [](u64id_t, std::string message) { benchmark::fail(message); }
+    );
+    for (int i = 0; i < 1000 && !(connected && serverSide); i++) {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    if (!(connected && serverSide)) {
+        benchmark::fail("could not connect");
+        return;
+    }
+    auto sender = network->getConnection(clientSide, true);
+    auto receiver = dynamic_cast<network::ReadableConnection*>(
+        network->getConnection(serverSide, true)
+    );
+    if (receiver == nullptr) {
+        benchmark::fail("server side connection is not readable");
+        return;
+    }
+
+    std::vector<char> chunk(chunkSize);
+    for (size_t i = 0; i < chunkSize; i++) {
+        chunk[i] = i % 251;
+    }
+    auto start = steady_clock::now();
+    std::thread producer([sender, &chunk, total, chunkSize]() {
+        for (size_t sent = 0; sent < total; sent += chunkSize) {
+            sender->send(chunk.data(), chunk.size());
+        }
+    });
+    std::vector<char> dst(chunkSize);
+    size_t received = 0;
+    while (received < total) {
+        int size = receiver->recv(dst.data(), dst.size());
+        if (size < 0) {
+            break;
+        }
+        received += size;
+        if (size == 0) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    double elapsed = duration<double>(steady_clock::now() - start).count();
+
+    if (received != total) {
+        benchmark::fail(
+            "received " + std::to_string(received) + " of " +
+            std::to_string(total) + " bytes"
+        );
+        return;
+    }
+    benchmark::report("streamed", total / 1024.0 / 1024.0, "MiB");
+    benchmark::report("elapsed", elapsed * 1000.0, "ms");
+    benchmark::report("throughput", total / 1024.0 / 1024.0 / elapsed, "MiB/s");
+}
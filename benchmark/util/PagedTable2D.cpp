@@ -0,0 +1,91 @@
+#include "benchmark.hpp"
+
+#include <memory>
+#include <random>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "constants.hpp"
+#include "maths/voxmaths.hpp"
+#include "util/PagedTable2D.hpp"
+#include "voxels/voxel.hpp"
+
+static inline uint64_t keyfrom(int32_t x, int32_t z) {
+    union {
+        int32_t pos[2];
+        uint64_t key;
+    } ekey;
+    ekey.pos[0] = x;
+    ekey.pos[1] = z;
+    return ekey.key;
+}
+
+/// Random voxel reads through the GlobalChunks lookup table compared to
+/// the unordered_map lookup it replaced
+BENCHMARK(PagedTable2D_RandomVoxelReads) {
+    constexpr int radius = 16;
+    constexpr int height = 16;
+    constexpr size_t reads = 10'000'000;
+
+    std::vector<std::unique_ptr<voxel[]>> chunks;
+    std::unordered_map<uint64_t, voxel*> map;
+    map.max_load_factor(CHUNKS_MAP_MAX_LOAD_FACTOR);
+    util::PagedTable2D<voxel*> table;
+    std::mt19937 random(0);
+    for (int z = -radius; z < radius; z++) {
+        for (int x = -radius; x < radius; x++) {
+            auto& voxels = chunks.emplace_back(
+                std::make_unique<voxel[]>(CHUNK_W * CHUNK_D * height)
+            );
+            for (int i = 0; i < CHUNK_W * CHUNK_D * height; i++) {
+                voxels[i].id = random() % 8;
+            }
+            map[keyfrom(x, z)] = voxels.get();
+            table.set(x, z, voxels.get());
+        }
+    }
+    std::vector<glm::ivec3> positions(4096);
+    for (auto& pos : positions) {
+        pos = {
+            static_cast<int>(random() % (radius * 2 * CHUNK_W)) -
+                radius * CHUNK_W,
+            static_cast<int>(random() % height),
+            static_cast<int>(random() % (radius * 2 * CHUNK_D)) -
+                radius * CHUNK_D
+        };
+    }
+
+    uint64_t mapSum = 0;
+    size_t index = 0;
+    double mapTime = benchmark::measure(reads, [&]() {
+        const auto& pos = positions[index++ % positions.size()];
+        int cx = floordiv<CHUNK_W>(pos.x);
+        int cz = floordiv<CHUNK_D>(pos.z);
+        const auto& found = map.find(keyfrom(cx, cz));
+        voxel* voxels = found == map.end() ? nullptr : found->second;
+        mapSum += voxels[vox_index(
+            pos.x - cx * CHUNK_W, pos.y, pos.z - cz * CHUNK_D
+        )].id;
+    });
+
+    uint64_t tableSum = 0;
+    index = 0;
+    double tableTime = benchmark::measure(reads, [&]() {
+        const auto& pos = positions[index++ % positions.size()];
+        int cx = floordiv<CHUNK_W>(pos.x);
+        int cz = floordiv<CHUNK_D>(pos.z);
+        voxel* voxels = table.get(cx, cz);
+        tableSum += voxels[vox_index(
+            pos.x - cx * CHUNK_W, pos.y, pos.z - cz * CHUNK_D
+        )].id;
+    });
+
+    if (mapSum != tableSum) {
+        benchmark::fail("lookup results differ");
+    }
+    benchmark::keep(tableSum);
+    benchmark::report("unordered_map read", mapTime, "ns");
+    benchmark::report("PagedTable2D read", tableTime, "ns");
+    benchmark::report("speedup", mapTime / tableTime, "x");
+}
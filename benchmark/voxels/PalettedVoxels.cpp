@@ -0,0 +1,130 @@
+#include "benchmark.hpp"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "constants.hpp"
+#include "voxels/PalettedVoxels.hpp"
+#include "voxels/voxel.hpp"
+
+/// Random and sequential voxel reads and writes through PalettedVoxels
+/// compared to the flat voxels array of a chunk with terrain up to 64 height
+BENCHMARK(PalettedVoxels_Access) {
+    constexpr size_t randomCount = 10'000'000;
+    constexpr size_t sequentialPasses = 40;
+
+    std::mt19937 random(0);
+    auto voxels = std::make_unique<voxel[]>(CHUNK_VOL);
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        uint y = i / (CHUNK_W * CHUNK_D);
+        if (y < 50) {
+            voxels[i].id = 1 + random() % 4;
+        } else if (y < 64) {
+            voxels[i].id = 5 + random() % 2;
+        }
+    }
+    PalettedVoxels paletted(voxels.get());
+    benchmark::report(
+        "flat memory", CHUNK_VOL * sizeof(voxel) / 1024.0, "KiB"
+    );
+    benchmark::report(
+        "paletted memory", paletted.getMemoryUsage() / 1024.0, "KiB"
+    );
+
+    // written voxels are taken from the neighbour of the same section, so
+    // palettes do not grow
+    struct Access {
+        uint index;
+        voxel vox;
+    };
+    std::vector<Access> accesses(4096);
+    for (auto& access : accesses) {
+        access.index = random() % CHUNK_VOL;
+        access.vox = voxels[access.index ^ 1];
+    }
+
+    uint64_t flatSum = 0;
+    size_t index = 0;
+    double flatRandomGet = benchmark::measure(randomCount, [&]() {
+        const auto& access = accesses[index++ % accesses.size()];
+        flatSum += voxels[access.index].id;
+    });
+    uint64_t palettedSum = 0;
+    index = 0;
+    double palettedRandomGet = benchmark::measure(randomCount, [&]() {
+        const auto& access = accesses[index++ % accesses.size()];
+        palettedSum += paletted.get(access.index).id;
+    });
+
+    index = 0;
+    double flatRandomSet = benchmark::measure(randomCount, [&]() {
+        const auto& access = accesses[index++ % accesses.size()];
+        voxels[access.index] = access.vox;
+    });
+    index = 0;
+    double palettedRandomSet = benchmark::measure(randomCount, [&]() {
+        const auto& access = accesses[index++ % accesses.size()];
+        paletted.set(access.index, access.vox);
+    });
+
+    double flatSequentialGet = benchmark::measure(sequentialPasses, [&]() {
+        for (uint y = 0; y < CHUNK_H; y++) {
+            for (uint z = 0; z < CHUNK_D; z++) {
+                for (uint x = 0; x < CHUNK_W; x++) {
+                    flatSum += voxels[vox_index(x, y, z)].id;
+                }
+            }
+        }
+    }) / CHUNK_VOL;
+    double palettedSequentialGet = benchmark::measure(sequentialPasses, [&]() {
+        for (uint y = 0; y < CHUNK_H; y++) {
+            for (uint z = 0; z < CHUNK_D; z++) {
+                for (uint x = 0; x < CHUNK_W; x++) {
+                    palettedSum += paletted.get(x, y, z).id;
+                }
+            }
+        }
+    }) / CHUNK_VOL;
+
+    double flatSequentialSet = benchmark::measure(sequentialPasses, [&]() {
+        for (uint y = 0; y < CHUNK_H; y++) {
+            for (uint z = 0; z < CHUNK_D; z++) {
+                for (uint x = 0; x < CHUNK_W; x++) {
+                    uint i = vox_index(x, y, z);
+                    voxels[i] = voxels[i ^ 1];
+                }
+            }
+        }
+    }) / CHUNK_VOL;
+    double palettedSequentialSet = benchmark::measure(sequentialPasses, [&]() {
+        for (uint y = 0; y < CHUNK_H; y++) {
+            for (uint z = 0; z < CHUNK_D; z++) {
+                for (uint x = 0; x < CHUNK_W; x++) {
+                    uint i = vox_index(x, y, z);
+                    paletted.set(i, paletted.get(i ^ 1));
+                }
+            }
+        }
+    }) / CHUNK_VOL;
+
+    if (flatSum != palettedSum) {
+        benchmark::fail("read results differ");
+    }
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        if (paletted.get(i).id != voxels[i].id) {
+            benchmark::fail("written voxels differ");
+            break;
+        }
+    }
+    benchmark::keep(palettedSum);
+
+    benchmark::report("flat random get", flatRandomGet, "ns");
+    benchmark::report("paletted random get", palettedRandomGet, "ns");
+    benchmark::report("flat random set", flatRandomSet, "ns");
+    benchmark::report("paletted random set", palettedRandomSet, "ns");
+    benchmark::report("flat sequential get", flatSequentialGet, "ns");
+    benchmark::report("paletted sequential get", palettedSequentialGet, "ns");
+    benchmark::report("flat sequential set", flatSequentialSet, "ns");
+    benchmark::report("paletted sequential set", palettedSequentialSet, "ns");
+}
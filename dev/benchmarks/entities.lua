@@ -0,0 +1,69 @@
+-- Entities physics benchmark: spawns 1k-10k rigidbodies through
+-- entities.spawn and measures the server tick time.
+-- Not a part of engine tests, run manually:
+-- vctest -e build/VoxelEngine -d dev/benchmarks -u build --output-always
+
+local util = require "core:tests_util"
+
+-- Create world and prepare settings
+util.create_demo_world("core:default")
+app.set_setting("chunks.load-distance", 3)
+app.set_setting("chunks.load-speed", 1)
+
+-- Create player
+local pid = player.create("Xerxes")
+player.set_spawnpoint(pid, 0, 100, 0)
+player.set_pos(pid, 0, 100, 0)
+
+-- Wait for chunk to load
+app.sleep_until(function () return block.get(0, 0, 0) ~= -1 end)
+
+local TICKS = 100
+-- Default server tps is 20
+local TICK_BUDGET = 1.0 / 20
+local SPACING = 0.4
+
+local itemid = item.index("base:stone.item")
+
+for _, count in ipairs({1000, 5000, 10000}) do
+    local side = math.ceil(math.sqrt(count))
+    local drops = {}
+
+    local start = time.precise_time()
+    for i = 0, count - 1 do
+        local x = (i % side - side / 2) * SPACING
+        local z = (math.floor(i / side) - side / 2) * SPACING
+        -- Unique data keeps drops from merging into stacks, pickup delay
+        -- keeps them from being collected by the player
+        drops[#drops + 1] = entities.spawn("base:drop", {x, 100 + i % 4, z}, {
+            base__drop = {
+                id = itemid,
+                count = 1,
+                data = {index = i},
+                pickup_delay = 1e9
+            }
+        })
+    end
+    local spawn_time = time.precise_time() - start
+
+    app.tick()
+    start = time.precise_time()
+    for _ = 1, TICKS do
+        app.tick()
+    end
+    local tick_time = (time.precise_time() - start) / TICKS
+
+    print(string.format(
+        "%d rigidbodies: spawn %.2f ms, %.2f ms per tick",
+        count, spawn_time * 1000, tick_time * 1000
+    ))
+    for _, drop in ipairs(drops) do
+        drop:despawn()
+    end
+    app.tick()
+
+    assert(tick_time < TICK_BUDGET, string.format(
+        "%d rigidbodies: tick takes %.2f ms, budget is %.2f ms",
+        count, tick_time * 1000, TICK_BUDGET * 1000
+    ))
+end
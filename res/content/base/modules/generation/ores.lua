@@ -1,4 +1,5 @@
 local ores = {}
+local rng = random.Random()
 
 function ores.load(directory)
     ores.ores = file.read_combined_list(directory.."/ores.json")
@@ -6,21 +7,23 @@ end
 
 function ores.place(placements, x, z, w, d, seed, hmap, chunk_height)
     local BLOCKS_PER_CHUNK = w * d * chunk_height
+    -- ores depend on the chunk position only, not on the generation order
+    rng:seed(bit.band(bit.bxor(seed, x * 73856093, z * 19349663), 0x7FFFFFFF))
     for _, ore in ipairs(ores.ores) do
         local count = BLOCKS_PER_CHUNK / ore.rarity
 
         -- average count is less than 1
         local addchance = math.fmod(count, 1.0)
-        if math.random() < addchance then
+        if rng:random() < addchance then
             count = count + 1
         end
 
         for i=1,count do
-            local sx = math.random() * w
-            local sz = math.random() * d
-            local sy = math.random() * (chunk_height * 0.5) + 6
+            local sx = rng:random() * w
+            local sz = rng:random() * d
+            local sy = rng:random() * (chunk_height * 0.5) + 6
             if sy < hmap:at(sx, sz) * chunk_height - 6 then
-                table.insert(placements, {ore.struct, {sx, sy, sz}, math.random()*4, -1})
+                table.insert(placements, {ore.struct, {sx, sy, sz}, rng:random()*4, -1})
             end
         end
     end
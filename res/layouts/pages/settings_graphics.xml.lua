@@ -43,6 +43,7 @@ function on_open()
     create_checkbox("graphics.backlight", "Backlight", "graphics.backlight.tooltip")
     create_checkbox("graphics.soft-lighting", "Soft lighting", "graphics.soft-lighting.tooltip")
     create_checkbox("graphics.dense-render", "Dense blocks render", "graphics.dense-render.tooltip")
+    create_checkbox("graphics.greedy-meshing", "Greedy meshing", "graphics.greedy-meshing.tooltip")
     create_checkbox("graphics.advanced-render", "Advanced render", "graphics.advanced-render.tooltip")
     create_trackbar_setting("graphics.ssao", "SSAO", 1, "", "graphics.ssao.tooltip")
     create_trackbar_setting("graphics.shadows-quality", "Shadows quality", 1)
@@ -146,10 +146,6 @@ local function __vc_on_world_tick(tps)
     time.schedules.world:tick(1.0 / tps)
 end
 
-local function __vc_process_before_quit()
-    block.__process_register_events()
-end
-
 local function __vc_on_world_save()
     local rule_values = {}
     for name, rule in pairs(__rules.rules) do
@@ -194,10 +190,6 @@ local function __process_post_runnables()
     fn_audio_reset_fetch_buffer()
     debug.pull_events()
     network.__process_events()
-    if not hud or not hud.is_paused() then
-        block.__process_register_events()
-        block.__perform_ticks(time.delta())
-    end
 end
 
 local __vc__is_post_runnable = false
@@ -219,7 +211,6 @@ return {
     __vc_on_hud_open = __vc_on_hud_open,
     __vc_on_world_open = __vc_on_world_open,
     __vc_on_world_tick = __vc_on_world_tick,
-    __vc_process_before_quit = __vc_process_before_quit,
     __vc_on_world_save = __vc_on_world_save,
     __vc_on_world_quit = __vc_on_world_quit,
     __vc__process_post_runnables = __vc__process_post_runnables,
@@ -0,0 +1,30 @@
+#ifndef CHUNK_VERTEX_GLSL_
+#define CHUNK_VERTEX_GLSL_
+
+// ChunkVertex::POSITION_SCALE and ChunkVertex::POSITION_BIAS
+#define CHUNK_POSITION_SCALE 128.0
+#define CHUNK_POSITION_BIAS 64.0
+
+vec3 decode_chunk_position(vec4 position) {
+    return position.xyz / CHUNK_POSITION_SCALE - CHUNK_POSITION_BIAS;
+}
+
+// Texture tile size in atlas pixels, zero if the face is not tiled
+vec2 decode_tile_size(vec4 position) {
+    return vec2(mod(position.w, 256.0), floor(position.w / 256.0));
+}
+
+// Tiles grid coordinates of a cube face (axes as in BlocksRenderer)
+vec2 calc_tile_coord(vec3 position, vec3 normal) {
+    vec3 axisX = vec3(sign(normal.z), 0.0, 0.0);
+    vec3 axisY = vec3(0.0, 1.0, 0.0);
+    if (abs(normal.x) > 0.5) {
+        axisX = vec3(0.0, 0.0, -sign(normal.x));
+    } else if (abs(normal.y) > 0.5) {
+        axisX = vec3(1.0, 0.0, 0.0);
+        axisY = vec3(0.0, 0.0, -sign(normal.y));
+    }
+    return vec2(dot(position, axisX), dot(position, axisY)) + 0.5;
+}
+
+#endif // CHUNK_VERTEX_GLSL_
@@ -0,0 +1,18 @@
+#ifndef TILING_GLSL_
+#define TILING_GLSL_
+
+// Sample atlas texture repeated over a merged face.
+// uv is an atlas coordinate if tileSize is zero, tile origin otherwise.
+// tileSize is in atlas pixels, tile is the tiles grid coordinate
+vec4 sample_tiled(sampler2D tex, vec2 uv, vec2 tile, vec2 tileSize) {
+    vec2 size = tileSize / vec2(textureSize(tex, 0));
+    // derivatives of the continuous coordinate prevent seams between tiles
+    vec2 dx = dFdx(tile) * size;
+    vec2 dy = dFdy(tile) * size;
+    if (tileSize.x == 0.0) {
+        return texture(tex, uv);
+    }
+    return textureGrad(tex, uv + fract(tile) * size, dx, dy);
+}
+
+#endif // TILING_GLSL_
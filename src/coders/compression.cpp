@@ -6,6 +6,7 @@
 
 #include "rle.hpp"
 #include "gzip.hpp"
+#include "lz4.hpp"
 #include "util/BufferPool.hpp"
 
 using namespace compression;
@@ -27,13 +28,13 @@ static std::shared_ptr<ubyte[]> get_buffer(size_t minSize) {
     return nullptr;
 }
 
-static auto compress_rle(
+static auto compress_with(
     const ubyte* src,
     size_t srclen,
     size_t& len,
+    size_t bufferSize,
     size_t(*encodefunc)(const ubyte*, size_t, ubyte*)
 ) {
-    size_t bufferSize = srclen * 2;
     auto buffer = get_buffer(bufferSize);
     auto bytes = buffer.get();
     std::unique_ptr<ubyte[]> uptr;
@@ -62,9 +63,15 @@ std::unique_ptr<ubyte[]> compression::compress(
         case Method::NONE:
             throw std::invalid_argument("compression method is NONE");
         case Method::EXTRLE8:
-            return compress_rle(src, srclen, len, extrle::encode);
+            return compress_with(src, srclen, len, srclen * 2, extrle::encode);
         case Method::EXTRLE16:
-            return compress_rle(src, srclen, len, extrle::encode16);
+            return compress_with(
+                src, srclen, len, srclen * 2, extrle::encode16
+            );
+        case Method::LZ4:
+            return compress_with(
+                src, srclen, len, lz4::max_encoded_size(srclen), lz4::encode
+            );
         case Method::GZIP: {
             auto buffer = gzip::compress(src, srclen);
             auto data = std::make_unique<ubyte[]>(buffer.size());
@@ -98,6 +105,11 @@ std::unique_ptr<ubyte[]> compression::decompress(
             }
             return decompressed;
         }
+        case Method::LZ4: {
+            auto decompressed = std::make_unique<ubyte[]>(dstlen);
+            decompress({src, srclen}, decompressed.get(), dstlen, method);
+            return decompressed;
+        }
         case Method::GZIP: {
             auto buffer = gzip::decompress(src, srclen);
             if (buffer.size() != dstlen) {
@@ -132,6 +144,16 @@ void compression::decompress(const util::span<ubyte> src, ubyte* dst, size_t dst
             }
             break;
         }
+        case Method::LZ4: {
+            size_t decoded = lz4::decode(src.data(), src.size(), dst, dstlen);
+            if (decoded != dstlen) {
+                throw std::runtime_error(
+                    "expected decompressed size " + std::to_string(dstlen) +
+                    " got " + std::to_string(decoded)
+                );
+            }
+            break;
+        }
         case Method::GZIP: {
             auto buffer = gzip::decompress(src.data(), src.size());
             if (buffer.size() != dstlen) {
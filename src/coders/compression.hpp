@@ -6,8 +6,9 @@
 #include "util/span.hpp"
 
 namespace compression {
+    /// @brief Compression method. Values are stored in region files
     enum class Method {
-        NONE, EXTRLE8, EXTRLE16, GZIP
+        NONE, EXTRLE8, EXTRLE16, GZIP, LZ4
     };
 
     /// @brief Compress buffer
@@ -0,0 +1,182 @@
+#include "lz4.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+inline constexpr size_t MIN_MATCH = 4;
+/// @brief Last match must start at least 12 bytes before the end of block
+inline constexpr size_t MF_LIMIT = 12;
+/// @brief Last 5 bytes are always literals
+inline constexpr size_t LAST_LITERALS = 5;
+inline constexpr size_t MAX_DISTANCE = 0xFFFF;
+inline constexpr int HASH_BITS = 12;
+/// @brief Search step grows every 2^SKIP_TRIGGER misses
+inline constexpr int SKIP_TRIGGER = 6;
+
+static inline uint32_t read32(const ubyte* src) {
+    uint32_t value;
+    std::memcpy(&value, src, sizeof(value));
+    return value;
+}
+
+static inline uint32_t hash32(uint32_t sequence) {
+    return (sequence * 2654435761U) >> (32 - HASH_BITS);
+}
+
+static inline ubyte* write_length(ubyte* dst, size_t length) {
+    while (length >= 255) {
+        *dst++ = 255;
+        length -= 255;
+    }
+    *dst++ = static_cast<ubyte>(length);
+    return dst;
+}
+
+static inline ubyte* write_sequence(
+    ubyte* dst,
+    const ubyte* literals,
+    size_t literalsLength,
+    size_t offset,
+    size_t matchLength
+) {
+    ubyte* token = dst++;
+    *token = static_cast<ubyte>(std::min<size_t>(literalsLength, 15) << 4);
+    if (literalsLength >= 15) {
+        dst = write_length(dst, literalsLength - 15);
+    }
+    if (literalsLength) {
+        std::memcpy(dst, literals, literalsLength);
+        dst += literalsLength;
+    }
+    if (offset == 0) {
+        return dst;
+    }
+    *dst++ = offset & 0xFF;
+    *dst++ = offset >> 8;
+    *token |= std::min<size_t>(matchLength, 15);
+    if (matchLength >= 15) {
+        dst = write_length(dst, matchLength - 15);
+    }
+    return dst;
+}
+
+size_t lz4::encode(const ubyte* src, size_t length, ubyte* dst) {
+    const ubyte* const end = src + length;
+    const ubyte* anchor = src;
+    ubyte* out = dst;
+
+    if (length > MF_LIMIT) {
+        const ubyte* const matchLimit = end - LAST_LITERALS;
+        const ubyte* const mfLimit = end - MF_LIMIT;
+        uint32_t table[1 << HASH_BITS] {};
+
+        const ubyte* ip = src + 1;
+        uint misses = 0;
+        while (ip <= mfLimit) {
+            uint32_t sequence = read32(ip);
+            uint32_t& entry = table[hash32(sequence)];
+            const ubyte* ref = src + entry;
+            entry = static_cast<uint32_t>(ip - src);
+            if (static_cast<size_t>(ip - ref) > MAX_DISTANCE ||
+                read32(ref) != sequence) {
+                ip += 1 + (misses++ >> SKIP_TRIGGER);
+                continue;
+            }
+            misses = 0;
+            while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+                ip--;
+                ref--;
+            }
+            const ubyte* matchEnd = ip + MIN_MATCH;
+            const ubyte* refEnd = ref + MIN_MATCH;
+            while (matchEnd < matchLimit && *matchEnd == *refEnd) {
+                matchEnd++;
+                refEnd++;
+            }
+            out = write_sequence(
+                out,
+                anchor,
+                ip - anchor,
+                ip - ref,
+                matchEnd - ip - MIN_MATCH
+            );
+            ip = anchor = matchEnd;
+            if (ip - 2 > src && ip <= mfLimit) {
+                table[hash32(read32(ip - 2))] =
+                    static_cast<uint32_t>(ip - 2 - src);
+            }
+        }
+    }
+    out = write_sequence(out, anchor, end - anchor, 0, 0);
+    return out - dst;
+}
+
+static inline size_t read_length(
+    const ubyte*& src, const ubyte* end, size_t length
+) {
+    if (length != 15) {
+        return length;
+    }
+    ubyte next;
+    do {
+        if (src >= end) {
+            throw std::runtime_error("unexpected end of lz4 data");
+        }
+        next = *src++;
+        length += next;
+    } while (next == 255);
+    return length;
+}
+
+size_t lz4::decode(
+    const ubyte* src, size_t length, ubyte* dst, size_t dstLength
+) {
+    const ubyte* const end = src + length;
+    ubyte* out = dst;
+    ubyte* const outEnd = dst + dstLength;
+
+    while (src < end) {
+        ubyte token = *src++;
+        size_t literals = read_length(src, end, token >> 4);
+        if (literals > static_cast<size_t>(end - src) ||
+            literals > static_cast<size_t>(outEnd - out)) {
+            throw std::runtime_error("buffer overflow");
+        }
+        if (literals) {
+            std::memcpy(out, src, literals);
+            out += literals;
+            src += literals;
+        }
+        if (src == end) {
+            break;
+        }
+        if (end - src < 2) {
+            throw std::runtime_error("unexpected end of lz4 data");
+        }
+        size_t offset = src[0] | (src[1] << 8);
+        src += 2;
+        if (offset == 0 || offset > static_cast<size_t>(out - dst)) {
+            throw std::runtime_error("invalid lz4 match offset");
+        }
+        size_t matchLength = read_length(src, end, token & 15) + MIN_MATCH;
+        if (matchLength > static_cast<size_t>(outEnd - out)) {
+            throw std::runtime_error("buffer overflow");
+        }
+        const ubyte* ref = out - offset;
+        if (offset >= matchLength) {
+            std::memcpy(out, ref, matchLength);
+            out += matchLength;
+        } else {
+            // overlapping match repeats the last offset bytes, so the
+            // already written part doubles with every non-overlapping copy
+            while (matchLength) {
+                size_t n = std::min(static_cast<size_t>(out - ref), matchLength);
+                std::memcpy(out, ref, n);
+                out += n;
+                matchLength -= n;
+            }
+        }
+    }
+    return out - dst;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "typedefs.hpp"
+
+/// @brief LZ4 block format codec (no frame, no checksums)
+namespace lz4 {
+    /// @brief Max encoded data length for the source length
+    constexpr size_t max_encoded_size(size_t length) {
+        return length + length / 255 + 16;
+    }
+
+    /// @param dst destination buffer of max_encoded_size(length) bytes
+    /// @return encoded data length
+    size_t encode(const ubyte* src, size_t length, ubyte* dst);
+
+    /// @return decoded data length
+    /// @throws std::runtime_error if data is corrupted or does not fit
+    /// the destination buffer
+    size_t decode(const ubyte* src, size_t length, ubyte* dst, size_t dstLength);
+}
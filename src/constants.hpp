@@ -20,7 +20,7 @@ inline constexpr uint MAX_SUBPROCESSES = 1;
 inline constexpr uint MAX_SUBPROCESS_DEPTH = 2;
 
 /// @brief world regions format version
-inline constexpr uint REGION_FORMAT_VERSION = 3;
+inline constexpr uint REGION_FORMAT_VERSION = 4;
 
 /// @brief max simultaneously open world region files
 inline constexpr uint MAX_OPEN_REGION_FILES = 32;
@@ -49,6 +49,12 @@ inline constexpr float CHUNKS_MAP_MAX_LOAD_FACTOR = 0.1f;
 /// @brief chunk volume (count of voxels per Chunk)
 inline constexpr int CHUNK_VOL = (CHUNK_W * CHUNK_H * CHUNK_D);
 
+/// @brief chunk mesh section height (chunk meshes are rebuilt by sections)
+inline constexpr int CHUNK_SECTION_H = 16;
+/// @brief number of mesh sections per chunk
+inline constexpr int CHUNK_SECTIONS = CHUNK_H / CHUNK_SECTION_H;
+static_assert(CHUNK_SECTIONS <= 32);
+
 /// @brief default player spawn radius (see GeneratorDef::playerSpawnRadius)
 inline constexpr float DEFAULT_PLAYER_SPAWN_RADIUS = 100.0f;
 
@@ -21,6 +21,14 @@ ContentIndices::ContentIndices(
     : blocks(std::move(blocks)),
       items(std::move(items)),
       entities(std::move(entities)) {
+    const auto& blockDefs = this->blocks.getIterable();
+    blocksLightPassing.resize(blockDefs.size() + 3);
+    for (size_t i = 0; i < blockDefs.size(); i++) {
+        const auto& def = *blockDefs[i];
+        blocksLightPassing[i] =
+            (def.lightPassing ? BLOCK_LIGHT_PASSING_BIT : 0) |
+            (def.skyLightPassing ? BLOCK_SKY_LIGHT_PASSING_BIT : 0);
+    }
 }
 
 Content::Content(
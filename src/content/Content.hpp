@@ -72,6 +72,11 @@ private:
     }
 };
 
+/// @brief Block::lightPassing bit of ContentIndices::blocksLightPassing
+inline constexpr ubyte BLOCK_LIGHT_PASSING_BIT = 0b01;
+/// @brief Block::skyLightPassing bit of ContentIndices::blocksLightPassing
+inline constexpr ubyte BLOCK_SKY_LIGHT_PASSING_BIT = 0b10;
+
 /// @brief Runtime defs cache: indices
 class ContentIndices {
 public:
@@ -79,6 +84,11 @@ public:
     ContentUnitIndices<ItemDef, itemid_t> items;
     ContentUnitIndices<EntityDef, entitydefid_t> entities;
 
+    /// @brief Dense per-block-id light passing flags used to avoid block
+    /// definition lookups in per-voxel loops. Padded with 3 zero bytes
+    /// for 32-bit gathers
+    std::vector<ubyte> blocksLightPassing;
+
     ContentIndices(
         ContentUnitIndices<Block, blockid_t> blocks,
         ContentUnitIndices<ItemDef, itemid_t> items,
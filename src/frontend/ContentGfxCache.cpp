@@ -7,6 +7,7 @@
 #include "content/Content.hpp"
 #include "content/ContentPack.hpp"
 #include "graphics/core/Atlas.hpp"
+#include "graphics/core/ImageData.hpp"
 #include "maths/UVRegion.hpp"
 #include "voxels/Block.hpp"
 #include "debug/Logger.hpp"
@@ -92,6 +93,8 @@ void ContentGfxCache::refresh() {
 
     sideregions = std::make_unique<UVRegion[]>(size);
     const auto& atlas = assets.require<Atlas>("blocks");
+    atlasWidth = atlas.getImage()->getWidth();
+    atlasHeight = atlas.getImage()->getHeight();
 
     const auto& blocks = indices->blocks.getIterable();
     for (blockid_t i = 0; i < blocks.size(); i++) {
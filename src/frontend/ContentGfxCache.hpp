@@ -28,6 +28,8 @@ class ContentGfxCache {
     // array of block sides uv regions (6 per block)
     std::unique_ptr<UVRegion[]> sideregions;
     std::unordered_map<uint64_t, model::Model> models;
+    uint atlasWidth = 0;
+    uint atlasHeight = 0;
     
     static inline uint64_t modelKey(blockid_t id, uint8_t variant) {
         return (uint64_t(id) << 8) | uint64_t(variant & 0xFF);
@@ -59,6 +61,15 @@ public:
 
     const model::Model& getModel(blockid_t id, uint8_t variant) const;
 
+    /// @brief Blocks atlas size in pixels
+    uint getAtlasWidth() const {
+        return atlasWidth;
+    }
+
+    uint getAtlasHeight() const {
+        return atlasHeight;
+    }
+
     void refresh(const Block& block, const Atlas& atlas);
 
     void refresh();
@@ -292,7 +292,11 @@ void Hud::updateWorldGenDebug() {
     uint padding = engine.getSettings().chunks.padding.get();
     auto generator =
         frontend.getController().getChunksController()->getGenerator();
-    auto debugInfo = generator->createDebugInfo();
+    const auto& position = player.getPosition();
+    auto debugInfo = generator->createDebugInfo(
+        floordiv<CHUNK_W>(glm::floor(position.x)),
+        floordiv<CHUNK_D>(glm::floor(position.z))
+    );
     
     int width = debugImgWorldGen->getWidth();
     int height = debugImgWorldGen->getHeight();
@@ -360,8 +364,8 @@ void Hud::update(bool visible) {
     }
 
     if (blockUI) {
-        voxel* vox = chunks.get(blockPos.x, blockPos.y, blockPos.z);
-        if (vox == nullptr || vox->id != currentblockid) {
+        auto vox = chunks.get(blockPos.x, blockPos.y, blockPos.z);
+        if (!vox || vox->id != currentblockid) {
             closeInventory();
         }
     }
@@ -40,8 +40,8 @@ void BlockWrapsRenderer::draw(BlockWrapper& wrapper, const Texture* texture) {
         return;
     }
 
-    const voxel* vox = chunks.get(wrapper.position);
-    if (vox == nullptr || vox->id == BLOCK_AIR) {
+    auto vox = chunks.get(wrapper.position);
+    if (!vox || vox->id == BLOCK_AIR) {
         return;
     }
     // one frame can be invalid due to texture change but ok
@@ -113,8 +113,8 @@ void BlockWrapsRenderer::refreshWrapper(BlockWrapper& wrapper) {
     }
     wrapper.dirtySides = 0x0;
 
-    const voxel* vox = chunks.get(wrapper.position);
-    if (vox == nullptr || vox->id == BLOCK_AIR) {
+    auto vox = chunks.get(wrapper.position);
+    if (!vox || vox->id == BLOCK_AIR) {
         return;
     }
     const auto& def = content.getIndices()->blocks.require(vox->id);
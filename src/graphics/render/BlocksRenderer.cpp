@@ -6,9 +6,12 @@
 #include "constants.hpp"
 #include "content/Content.hpp"
 #include "voxels/Chunks.hpp"
+#include "voxels/ChunkSnapshot.hpp"
 #include "lighting/Lightmap.hpp"
 #include "frontend/ContentGfxCache.hpp"
 
+#include <algorithm>
+
 const glm::vec3 BlocksRenderer::SUN_VECTOR(0.528265, 0.833149, -0.163704);
 constexpr float DIRECTIONAL_LIGHT_FACTOR = 0.3f;
 
@@ -43,8 +46,8 @@ void BlocksRenderer::vertex(
 ) {
 
     vertexBuffer[vertexCount++] = {
-        coord,
-        {u, v},
+        ChunkVertex::packPosition(coord),
+        ChunkVertex::packUV(u, v),
         {
             static_cast<uint8_t>(light.r * 255),
             static_cast<uint8_t>(light.g * 255),
@@ -150,6 +153,41 @@ void BlocksRenderer::faceAO(
     index(0, 1, 2, 0, 2, 3);
 }
 
+void BlocksRenderer::cubeFaceAO(
+    const glm::ivec3& coord,
+    const glm::ivec3& X,
+    const glm::ivec3& Y,
+    const glm::ivec3& Z,
+    const UVRegion& region,
+    bool lights
+) {
+    if (!lights) {
+        faceAO(coord, X, Y, Z, region, lights);
+        return;
+    }
+    if (vertexCount + 4 >= capacity || indexCount + 6 >= capacity) {
+        overflow = true;
+        return;
+    }
+    glm::vec3 axisZ(Z);
+    float d = glm::dot(axisZ, SUN_VECTOR);
+    d = (1.0f - DIRECTIONAL_LIGHT_FACTOR) + d * DIRECTIONAL_LIGHT_FACTOR;
+    glm::vec4 tint(d);
+
+    glm::vec4 corners[4];
+    pickSoftLights(coord + Z, X, Y, corners);
+
+    glm::vec3 pos(coord);
+    glm::vec3 x(X);
+    glm::vec3 y(Y);
+    float s = 0.5f;
+    vertex(pos + (-x - y + axisZ) * s, region.u1, region.v1, corners[0] * tint, axisZ, 0.0f);
+    vertex(pos + ( x - y + axisZ) * s, region.u2, region.v1, corners[1] * tint, axisZ, 0.0f);
+    vertex(pos + ( x + y + axisZ) * s, region.u2, region.v2, corners[2] * tint, axisZ, 0.0f);
+    vertex(pos + (-x + y + axisZ) * s, region.u1, region.v2, corners[3] * tint, axisZ, 0.0f);
+    index(0, 1, 2, 0, 2, 3);
+}
+
 void BlocksRenderer::face(
     const glm::vec3& coord,
     const glm::vec3& X,
@@ -387,16 +425,27 @@ void BlocksRenderer::blockCustomModel(
     }
 }
 
+/// @return bit of the face facing the axis direction in open faces mask
+static inline uint8_t face_bit(const glm::ivec3& dir) {
+    if (dir.x) {
+        return dir.x > 0 ? 0b1 : 0b10;
+    }
+    if (dir.y) {
+        return dir.y > 0 ? 0b100 : 0b1000;
+    }
+    return dir.z > 0 ? 0b10000 : 0b100000;
+}
+
 /* Fastest solid shaded blocks render method */
 void BlocksRenderer::blockCube(
     const glm::ivec3& coord,
     const UVRegion(&texfaces)[6],
     const Block& block,
     blockstate states,
+    uint8_t openFaces,
     bool lights,
     bool ao
 ) {
-    const auto& variant = block.getVariantByBits(states.userbits);
     glm::ivec3 X(1, 0, 0);
     glm::ivec3 Y(0, 1, 0);
     glm::ivec3 Z(0, 0, 1);
@@ -410,49 +459,262 @@ void BlocksRenderer::blockCube(
     }
 
     if (ao) {
-        if (isOpen(coord + Z, block, variant)) {
-            faceAO(coord, X, Y, Z, texfaces[5], lights);
+        if (openFaces & face_bit(Z)) {
+            cubeFaceAO(coord, X, Y, Z, texfaces[5], lights);
         }
-        if (isOpen(coord - Z, block, variant)) {
-            faceAO(coord, -X, Y, -Z, texfaces[4], lights);
+        if (openFaces & face_bit(-Z)) {
+            cubeFaceAO(coord, -X, Y, -Z, texfaces[4], lights);
         }
-        if (isOpen(coord + Y, block, variant)) {
-            faceAO(coord, X, -Z, Y, texfaces[3], lights);
+        if (openFaces & face_bit(Y)) {
+            cubeFaceAO(coord, X, -Z, Y, texfaces[3], lights);
         }
-        if (isOpen(coord - Y, block, variant)) {
-            faceAO(coord, X, Z, -Y, texfaces[2], lights);
+        if (openFaces & face_bit(-Y)) {
+            cubeFaceAO(coord, X, Z, -Y, texfaces[2], lights);
         }
-        if (isOpen(coord + X, block, variant)) {
-            faceAO(coord, -Z, Y, X, texfaces[1], lights);
+        if (openFaces & face_bit(X)) {
+            cubeFaceAO(coord, -Z, Y, X, texfaces[1], lights);
         }
-        if (isOpen(coord - X, block, variant)) {
-            faceAO(coord, Z, Y, -X, texfaces[0], lights);
+        if (openFaces & face_bit(-X)) {
+            cubeFaceAO(coord, Z, Y, -X, texfaces[0], lights);
         }
     } else {
-        if (isOpen(coord + Z, block, variant)) {
+        if (openFaces & face_bit(Z)) {
             face(coord, X, Y, Z, texfaces[5], lights ? pickLight(coord + Z) : glm::vec4(1,1,1,0), lights);
         }
-        if (isOpen(coord - Z, block, variant)) {
+        if (openFaces & face_bit(-Z)) {
             face(coord, -X, Y, -Z, texfaces[4], lights ? pickLight(coord - Z) : glm::vec4(1,1,1,0), lights);
         }
-        if (isOpen(coord + Y, block, variant)) {
+        if (openFaces & face_bit(Y)) {
             face(coord, X, -Z, Y, texfaces[3], lights ? pickLight(coord + Y) : glm::vec4(1,1,1,0), lights);
         }
-        if (isOpen(coord - Y, block, variant)) {
+        if (openFaces & face_bit(-Y)) {
             face(coord, X, Z, -Y, texfaces[2], lights ? pickLight(coord - Y) : glm::vec4(1,1,1,0), lights);
         }
-        if (isOpen(coord + X, block, variant)) {
+        if (openFaces & face_bit(X)) {
             face(coord, -Z, Y, X, texfaces[1], lights ? pickLight(coord + X) : glm::vec4(1,1,1,0), lights);
         }
-        if (isOpen(coord - X, block, variant)) {
+        if (openFaces & face_bit(-X)) {
             face(coord, Z, Y, -X, texfaces[0], lights ? pickLight(coord - X) : glm::vec4(1,1,1,0), lights);
         }
     }
 }
 
+/// @brief Cube faces axes (X, Y, Z) in texture faces order as in blockCube
+static const glm::ivec3 CUBE_FACES_AXES[6][3] {
+    {{0, 0, 1}, {0, 1, 0}, {-1, 0, 0}},
+    {{0, 0, -1}, {0, 1, 0}, {1, 0, 0}},
+    {{1, 0, 0}, {0, 0, 1}, {0, -1, 0}},
+    {{1, 0, 0}, {0, 0, -1}, {0, 1, 0}},
+    {{-1, 0, 0}, {0, 1, 0}, {0, 0, -1}},
+    {{1, 0, 0}, {0, 1, 0}, {0, 0, 1}},
+};
+
+static inline uint32_t pack_color(const glm::vec4& color) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(color.r * 255)) |
+           static_cast<uint32_t>(static_cast<uint8_t>(color.g * 255)) << 8 |
+           static_cast<uint32_t>(static_cast<uint8_t>(color.b * 255)) << 16 |
+           static_cast<uint32_t>(static_cast<uint8_t>(color.a * 255)) << 24;
+}
+
+uint16_t BlocksRenderer::tileSize(const UVRegion& region) const {
+    int width = static_cast<int>(
+        std::round((region.u2 - region.u1) * cache.getAtlasWidth())
+    );
+    int height = static_cast<int>(
+        std::round((region.v2 - region.v1) * cache.getAtlasHeight())
+    );
+    if (width <= 0 || height <= 0 || width > 255 || height > 255) {
+        return 0;
+    }
+    return width | height << 8;
+}
+
+void BlocksRenderer::blockCubeGreedy(
+    const glm::ivec3& coord,
+    const UVRegion(&texfaces)[6],
+    const Block& block,
+    blockstate states,
+    uint8_t openFaces,
+    bool lights,
+    bool ao
+) {
+    if (greedyMasks == nullptr) {
+        greedyMasks = std::make_unique<uint64_t[]>(6 * CHUNK_VOL);
+    }
+    uint8_t variantId = block.getVariantIndex(states.userbits);
+    uint64_t key = static_cast<uint64_t>(block.rt.id) << 48 |
+                   static_cast<uint64_t>(variantId) << 40;
+    size_t index = vox_index(coord.x, coord.y, coord.z);
+
+    for (int side = 0; side < 6; side++) {
+        const auto& [X, Y, Z] = CUBE_FACES_AXES[side];
+        if (!(openFaces & face_bit(Z))) {
+            continue;
+        }
+        if (tileSize(texfaces[side]) == 0) {
+            // texture region can not be repeated over merged face
+            if (ao) {
+                cubeFaceAO(coord, X, Y, Z, texfaces[side], lights);
+            } else {
+                face(coord, X, Y, Z, texfaces[side],
+                     lights ? pickLight(coord + Z) : glm::vec4(1, 1, 1, 0),
+                     lights);
+            }
+            continue;
+        }
+        glm::vec4 color(1.0f);
+        if (lights) {
+            float d = glm::dot(glm::vec3(Z), SUN_VECTOR);
+            d = (1.0f - DIRECTIONAL_LIGHT_FACTOR) + d * DIRECTIONAL_LIGHT_FACTOR;
+            if (ao) {
+                glm::vec4 softLights[4];
+                pickSoftLights(coord + Z, X, Y, softLights);
+                uint32_t corners[4] {
+                    pack_color(softLights[0] * d),
+                    pack_color(softLights[1] * d),
+                    pack_color(softLights[2] * d),
+                    pack_color(softLights[3] * d),
+                };
+                if (corners[0] != corners[1] || corners[0] != corners[2] ||
+                    corners[0] != corners[3]) {
+                    // smooth lighting gradient can not be merged
+                    cubeFaceAO(coord, X, Y, Z, texfaces[side], true);
+                    continue;
+                }
+                greedyMasks[side * CHUNK_VOL + index] = key | corners[0];
+                greedyFacesCount[side]++;
+                continue;
+            }
+            color = pickLight(coord + Z) * d;
+        } else if (!ao) {
+            color = glm::vec4(1, 1, 1, 0);
+        }
+        greedyMasks[side * CHUNK_VOL + index] = key | pack_color(color);
+        greedyFacesCount[side]++;
+    }
+}
+
+void BlocksRenderer::flushGreedyFaces(int yBegin, int yEnd) {
+    const int begin[3] {0, yBegin, 0};
+    const int end[3] {CHUNK_W, yEnd, CHUNK_D};
+    const int strides[3] {1, CHUNK_W * CHUNK_D, CHUNK_W};
+
+    for (int side = 0; side < 6; side++) {
+        if (greedyFacesCount[side] == 0) {
+            continue;
+        }
+        greedyFacesCount[side] = 0;
+        uint64_t* mask = greedyMasks.get() + side * CHUNK_VOL;
+        if (overflow) {
+            std::fill(mask, mask + CHUNK_VOL, 0);
+            continue;
+        }
+        const auto& [X, Y, Z] = CUBE_FACES_AXES[side];
+        // n - face normal axis, faces are merged along a and b axes
+        int n = Z.x ? 0 : (Z.y ? 1 : 2);
+        int a = n == 0 ? 2 : 0;
+        int b = n == 1 ? 2 : 1;
+
+        glm::ivec3 pos;
+        for (pos[n] = begin[n]; pos[n] < end[n]; pos[n]++) {
+        for (pos[b] = begin[b]; pos[b] < end[b]; pos[b]++) {
+        for (pos[a] = begin[a]; pos[a] < end[a]; pos[a]++) {
+            size_t maskIndex = vox_index(pos.x, pos.y, pos.z);
+            uint64_t key = mask[maskIndex];
+            if (key == 0) {
+                continue;
+            }
+            int w = 1;
+            while (pos[a] + w < end[a] &&
+                   mask[maskIndex + w * strides[a]] == key) {
+                w++;
+            }
+            int h = 1;
+            for (; pos[b] + h < end[b]; h++) {
+                size_t row = maskIndex + h * strides[b];
+                int i = 0;
+                while (i < w && mask[row + i * strides[a]] == key) {
+                    i++;
+                }
+                if (i < w) {
+                    break;
+                }
+            }
+            for (int j = 0; j < h; j++) {
+                for (int i = 0; i < w; i++) {
+                    mask[maskIndex + j * strides[b] + i * strides[a]] = 0;
+                }
+            }
+            if (overflow) {
+                continue;
+            }
+            if (vertexCount + 4 >= capacity || indexCount + 6 >= capacity) {
+                overflow = true;
+                continue;
+            }
+            blockid_t id = key >> 48;
+            uint8_t variantId = (key >> 40) & 0xFF;
+            const auto& def = *blockDefsCache[id];
+            const auto& region = cache.getRegion(id, variantId, side, densePass);
+
+            glm::vec3 center(pos);
+            center[a] += (w - 1) * 0.5f;
+            center[b] += (h - 1) * 0.5f;
+            float width = X[a] ? w : h;
+            float height = Y[a] ? w : h;
+            auto Xs = glm::vec3(X) * width;
+            auto Ys = glm::vec3(Y) * height;
+            auto Zs = glm::vec3(Z);
+
+            std::array<uint8_t, 4> color {
+                static_cast<uint8_t>(key),
+                static_cast<uint8_t>(key >> 8),
+                static_cast<uint8_t>(key >> 16),
+                static_cast<uint8_t>(key >> 24),
+            };
+            std::array<uint8_t, 4> normal {
+                static_cast<uint8_t>(Z.x * 127 + 128),
+                static_cast<uint8_t>(Z.y * 127 + 128),
+                static_cast<uint8_t>(Z.z * 127 + 128),
+                static_cast<uint8_t>(def.shadeless ? 255 : 0)
+            };
+            // tile coordinates are restored from position in the shader
+            uint16_t tile = tileSize(region);
+            auto origin = ChunkVertex::packUV(region.u1, region.v1);
+            float s = 0.5f;
+            vertexBuffer[vertexCount++] = {ChunkVertex::packPosition(
+                center + (-Xs - Ys + Zs) * s, tile), origin, color, normal};
+            vertexBuffer[vertexCount++] = {ChunkVertex::packPosition(
+                center + ( Xs - Ys + Zs) * s, tile), origin, color, normal};
+            vertexBuffer[vertexCount++] = {ChunkVertex::packPosition(
+                center + ( Xs + Ys + Zs) * s, tile), origin, color, normal};
+            vertexBuffer[vertexCount++] = {ChunkVertex::packPosition(
+                center + (-Xs + Ys + Zs) * s, tile), origin, color, normal};
+            index(0, 1, 2, 0, 2, 3);
+        }
+        }
+        }
+    }
+}
+
+uint8_t BlocksRenderer::getOpenFaces(
+    const glm::ivec3& coord, const Block& def, const Variant& variant
+) const {
+    static const glm::ivec3 directions[6] {
+        {1, 0, 0}, {-1, 0, 0}, {0, 1, 0}, {0, -1, 0}, {0, 0, 1}, {0, 0, -1}
+    };
+    uint8_t mask = 0;
+    for (int i = 0; i < 6; i++) {
+        if (isOpen(coord + directions[i], def, variant)) {
+            mask |= 1 << i;
+        }
+    }
+    return mask;
+}
+
 glm::vec4 BlocksRenderer::pickLight(int x, int y, int z) const {
     light_t light = voxelsBuffer->pickLight(
-        chunk->x * CHUNK_W + x, y, chunk->z * CHUNK_D + z
+        chunkX * CHUNK_W + x, y, chunkZ * CHUNK_D + z
     );
     return light ? Lightmap::extractNormalized(light) : glm::vec4(0.0f);
 }
@@ -480,193 +742,208 @@ glm::vec4 BlocksRenderer::pickSoftLight(
         right, up);
 }
 
-void BlocksRenderer::render(
-    const voxel* voxels, int totalBegin, int totalEnd
-) {
-    bool denseRender = this->denseRender;
-    bool densePass = this->densePass;
-    bool enableAO = settings.graphics.softLighting.get();
-
-    for (int i = totalBegin; i < totalEnd; i++) {
-        const voxel& vox = voxels[i];
-        blockid_t id = vox.id;
-        blockstate state = vox.state;
-        const auto& def = *blockDefsCache[id];
-        uint8_t variantId = def.getVariantIndex(state.userbits);
-        const auto& variant = def.getVariant(variantId);
-        if (id == 0 || state.segment) {
-            continue;
-        }
-        if (denseRender != (variant.culling == CullingMode::OPTIONAL)) {
-            continue;
-        }
-        if (def.translucent) {
-            continue;
+void BlocksRenderer::pickSoftLights(
+    const glm::ivec3& coord,
+    const glm::ivec3& right,
+    const glm::ivec3& up,
+    glm::vec4(&lights)[4]
+) const {
+    // [up][right] offsets from -1 to 1
+    glm::vec4 l[3][3];
+    for (int j = 0; j < 3; j++) {
+        for (int i = 0; i < 3; i++) {
+            l[j][i] = pickLight(coord + right * (i - 1) + up * (j - 1));
         }
-        const UVRegion texfaces[6] {
-            cache.getRegion(id, variantId, 0, densePass),
-            cache.getRegion(id, variantId, 1, densePass),
-            cache.getRegion(id, variantId, 2, densePass),
-            cache.getRegion(id, variantId, 3, densePass),
-            cache.getRegion(id, variantId, 4, densePass),
-            cache.getRegion(id, variantId, 5, densePass)
-        };
-        int x = i % CHUNK_W;
-        int y = i / (CHUNK_D * CHUNK_W);
-        int z = (i / CHUNK_D) % CHUNK_W;
+    }
+    // summed in pickSoftLight order to get the same values
+    lights[0] = (l[1][1] + l[1][0] + l[0][0] + l[0][1]) * 0.25f;
+    lights[1] = (l[1][2] + l[1][1] + l[0][1] + l[0][2]) * 0.25f;
+    lights[2] = (l[2][2] + l[2][1] + l[1][1] + l[1][2]) * 0.25f;
+    lights[3] = (l[2][1] + l[2][0] + l[1][0] + l[1][1]) * 0.25f;
+}
 
-        switch (def.getModel(state.userbits).type) {
-            case BlockModelType::BLOCK:
-                blockCube({x, y, z}, texfaces, def, vox.state, !def.shadeless,
-                            def.ambientOcclusion && enableAO);
-                break;
-            case BlockModelType::XSPRITE: {
-                if (!denseRender)
-                blockXSprite(x, y, z, glm::vec3(1.0f),
-                            texfaces[FACE_MX], texfaces[FACE_MZ], 1.0f);
-                break;
-            }
-            case BlockModelType::AABB: {
-                if (!denseRender)
-                blockAABB({x, y, z}, texfaces, &def, vox.state.rotation,
-                            !def.shadeless, def.ambientOcclusion && enableAO);
-                break;
-            }
-            case BlockModelType::CUSTOM: {
-                blockCustomModel(
-                    {x, y, z},
-                    def,
-                    vox.state,
-                    !def.shadeless,
-                    def.ambientOcclusion && enableAO
+void BlocksRenderer::blockModel(
+    const glm::ivec3& coord,
+    const voxel& vox,
+    const Block& def,
+    uint8_t variantId,
+    bool ao,
+    bool greedy
+) {
+    const auto& model = def.getModel(vox.state.userbits);
+    uint8_t openFaces = 0;
+    if (model.type == BlockModelType::BLOCK) {
+        openFaces = getOpenFaces(coord, def, def.getVariant(variantId));
+        // most of terrain blocks are hidden by neighbours, so textures
+        // and model dispatch are skipped for them
+        if (openFaces == 0) {
+            return;
+        }
+    }
+    blockid_t id = vox.id;
+    const UVRegion texfaces[6] {
+        cache.getRegion(id, variantId, 0, densePass),
+        cache.getRegion(id, variantId, 1, densePass),
+        cache.getRegion(id, variantId, 2, densePass),
+        cache.getRegion(id, variantId, 3, densePass),
+        cache.getRegion(id, variantId, 4, densePass),
+        cache.getRegion(id, variantId, 5, densePass)
+    };
+    bool lights = !def.shadeless;
+    switch (model.type) {
+        case BlockModelType::BLOCK:
+            if (greedy && !def.rotatable) {
+                blockCubeGreedy(
+                    coord, texfaces, def, vox.state, openFaces, lights, ao
+                );
+            } else {
+                blockCube(
+                    coord, texfaces, def, vox.state, openFaces, lights, ao
                 );
-                break;
             }
-            default:
-                break;
+            break;
+        case BlockModelType::XSPRITE: {
+            if (!denseRender)
+            blockXSprite(coord.x, coord.y, coord.z, glm::vec3(1.0f),
+                        texfaces[FACE_MX], texfaces[FACE_MZ], 1.0f);
+            break;
         }
-        if (overflow) {
-            return;
+        case BlockModelType::AABB: {
+            if (!denseRender)
+            blockAABB(coord, texfaces, &def, vox.state.rotation, lights, ao);
+            break;
+        }
+        case BlockModelType::CUSTOM: {
+            blockCustomModel(coord, def, vox.state, lights, ao);
+            break;
         }
+        default:
+            break;
+    }
+}
+
+void BlocksRenderer::copyDenseIndices(size_t start) {
+    size_t count = indexCount - start;
+    if (denseIndexCount + count >= capacity) {
+        overflow = true;
+        return;
     }
+    std::memcpy(
+        denseIndexBuffer.get() + denseIndexCount,
+        indexBuffer.get() + start,
+        count * sizeof(uint32_t)
+    );
+    denseIndexCount += count;
 }
 
-SortingMeshData BlocksRenderer::renderTranslucent(
+void BlocksRenderer::render(
     const voxel* voxels, int totalBegin, int totalEnd
 ) {
-    SortingMeshData sortingMesh {{}};
+    bool enableAO = settings.graphics.softLighting.get();
+    bool denseTextures = settings.graphics.denseRender.get();
+    bool greedy = settings.graphics.greedyMeshing.get();
 
     AABB aabb {};
     bool aabbInit = false;
     size_t totalSize = 0;
 
-    bool densePass = this->densePass;
-    bool enableAO = settings.graphics.softLighting.get();
     for (int i = totalBegin; i < totalEnd; i++) {
         const voxel& vox = voxels[i];
         blockid_t id = vox.id;
-        blockstate state = vox.state;
-        const auto& def = *blockDefsCache[id];
-        uint8_t variantId = def.getVariantIndex(state.userbits);
-        if (id == 0 || state.segment) {
-            continue;
-        }
-        if (!def.translucent) {
+        if (id == 0 || vox.state.segment) {
             continue;
         }
-        const UVRegion texfaces[6] {
-            cache.getRegion(id, variantId, 0, densePass),
-            cache.getRegion(id, variantId, 1, densePass),
-            cache.getRegion(id, variantId, 2, densePass),
-            cache.getRegion(id, variantId, 3, densePass),
-            cache.getRegion(id, variantId, 4, densePass),
-            cache.getRegion(id, variantId, 5, densePass)
-        };
+        const auto& def = *blockDefsCache[id];
+        uint8_t variantId = def.getVariantIndex(vox.state.userbits);
+        const auto& variant = def.getVariant(variantId);
         int x = i % CHUNK_W;
         int y = i / (CHUNK_D * CHUNK_W);
         int z = (i / CHUNK_D) % CHUNK_W;
-        switch (def.getModel(state.userbits).type) {
-            case BlockModelType::BLOCK:
-                blockCube({x, y, z}, texfaces, def, vox.state, !def.shadeless,
-                            def.ambientOcclusion && enableAO);
-                break;
-            case BlockModelType::XSPRITE: {
-                blockXSprite(x, y, z, glm::vec3(1.0f),
-                            texfaces[FACE_MX], texfaces[FACE_MZ], 1.0f);
+        bool ao = def.ambientOcclusion && enableAO;
+        size_t indexStart = indexCount;
+
+        if (def.translucent) {
+            // block geometry is moved to the sorting mesh entry
+            size_t vertexStart = vertexCount;
+            size_t offsetStart = vertexOffset;
+            denseRender = false;
+            densePass = false;
+            blockModel({x, y, z}, vox, def, variantId, ao, false);
+            if (overflow) {
                 break;
             }
-            case BlockModelType::AABB: {
-                blockAABB(
-                    {x, y, z},
-                    texfaces,
-                    &def,
-                    vox.state.rotation,
-                    !def.shadeless,
-                    def.ambientOcclusion && enableAO
-                );
-                break;
+            if (vertexCount == vertexStart) {
+                continue;
             }
-            case BlockModelType::CUSTOM: {
-                blockCustomModel(
-                    {x, y, z},
-                    def,
-                    vox.state,
-                    !def.shadeless,
-                    def.ambientOcclusion && enableAO
-                );
-                break;
+            SortingMeshEntry entry {
+                glm::vec3(
+                    x + chunkX * CHUNK_W + 0.5f,
+                    y + 0.5f,
+                    z + chunkZ * CHUNK_D + 0.5f
+                ),
+                util::Buffer<ChunkVertex>(indexCount - indexStart), 0};
+
+            totalSize += entry.vertexData.size();
+
+            for (size_t j = 0; j < entry.vertexData.size(); j++) {
+                ChunkVertex& vertex = entry.vertexData[j];
+                vertex = vertexBuffer[indexBuffer[indexStart + j]];
+
+                if (!aabbInit) {
+                    aabbInit = true;
+                    aabb.a = aabb.b = vertex.getPosition();
+                } else {
+                    aabb.addPoint(vertex.getPosition());
+                }
             }
-            default:
-                break;
-        }
-        if (vertexCount == 0) {
-            continue;
-        }
-        SortingMeshEntry entry {
-            glm::vec3(
-                x + chunk->x * CHUNK_W + 0.5f,
-                y + 0.5f,
-                z + chunk->z * CHUNK_D + 0.5f
-            ),
-            util::Buffer<ChunkVertex>(indexCount), 0};
-
-        totalSize += entry.vertexData.size();
-
-        for (int j = 0; j < indexCount; j++) {
-            std::memcpy(
-                entry.vertexData.data() + j,
-                vertexBuffer.get() + indexBuffer[j],
-                sizeof(ChunkVertex)
-            );
-            ChunkVertex& vertex = entry.vertexData[j];
-
-            if (!aabbInit) {
-                aabbInit = true;
-                aabb.a = aabb.b = vertex.position;
-            } else {
-                aabb.addPoint(vertex.position);
+            sortingMesh.entries.push_back(std::move(entry));
+            vertexCount = vertexStart;
+            vertexOffset = offsetStart;
+            indexCount = indexStart;
+        } else if (variant.culling != CullingMode::OPTIONAL) {
+            // shared by both index buffers
+            denseRender = false;
+            densePass = false;
+            blockModel({x, y, z}, vox, def, variantId, ao, greedy);
+            copyDenseIndices(indexStart);
+        } else {
+            denseRender = true;
+            densePass = denseTextures;
+            blockModel({x, y, z}, vox, def, variantId, ao, false);
+            copyDenseIndices(indexStart);
+            if (denseTextures) {
+                // dense variant is drawn by the dense index buffer only
+                indexCount = indexStart;
+                densePass = false;
+                blockModel({x, y, z}, vox, def, variantId, ao, false);
             }
-
-            vertex.position.x += chunk->x * CHUNK_W + 0.5f;
-            vertex.position.y += 0.5f;
-            vertex.position.z += chunk->z * CHUNK_D + 0.5f;
         }
-        sortingMesh.entries.push_back(std::move(entry));
-        vertexCount = 0;
-        vertexOffset = indexCount = 0;
+        if (overflow) {
+            break;
+        }
+    }
+    denseRender = false;
+    densePass = false;
+    if (greedy) {
+        size_t indexStart = indexCount;
+        flushGreedyFaces(
+            totalBegin / (CHUNK_W * CHUNK_D), totalEnd / (CHUNK_W * CHUNK_D)
+        );
+        copyDenseIndices(indexStart);
     }
 
     // additional powerful optimization
+    auto& entries = sortingMesh.entries;
     auto size = aabb.size();
     if ((size.y < 0.01f || size.x < 0.01f || size.z < 0.01f) &&
-         sortingMesh.entries.size() > 1) {
+         entries.size() > 1) {
         SortingMeshEntry newEntry {
-            sortingMesh.entries[0].position,
+            entries[0].position,
             util::Buffer<ChunkVertex>(totalSize),
             0
         };
         size_t offset = 0;
-        for (const auto& entry : sortingMesh.entries) {
+        for (const auto& entry : entries) {
             std::memcpy(
                 newEntry.vertexData.data() + offset,
                 entry.vertexData.data(),
@@ -674,115 +951,148 @@ SortingMeshData BlocksRenderer::renderTranslucent(
             );
             offset += entry.vertexData.size();
         }
-        return SortingMeshData {{std::move(newEntry)}};
+        entries.clear();
+        entries.push_back(std::move(newEntry));
     }
-    return sortingMesh;
 }
 
 void BlocksRenderer::build(
-    const Chunk* chunk, const VoxelsRenderVolume& volume
+    const Chunk* chunk, const VoxelsRenderVolume& volume, uint32_t sections
 ) {
-    meshAABB = AABB(glm::vec3(CHUNK_W, CHUNK_H, CHUNK_D));
-    this->chunk = chunk;
-    this->voxelsBuffer = &volume;
-    if (voxelsBuffer->pickBlockId(
-        chunk->x * CHUNK_W, 0, chunk->z * CHUNK_D
-    ) == BLOCK_VOID) {
-        cancelled = true;
-        return;
+    if (chunkVoxels == nullptr) {
+        chunkVoxels = std::make_unique<voxel[]>(CHUNK_VOL);
     }
-    const voxel* voxels = chunk->voxels;
-
-    int totalBegin = chunk->bottom * (CHUNK_W * CHUNK_D);
-    int totalEnd = chunk->top * (CHUNK_W * CHUNK_D);
+    uint begin = chunk->bottom * (CHUNK_W * CHUNK_D);
+    uint end = chunk->top * (CHUNK_W * CHUNK_D);
+    if (begin < end) {
+        chunk->copyVoxels(chunkVoxels.get() + begin, begin, end - begin);
+    }
+    build(
+        chunk->x,
+        chunk->z,
+        chunkVoxels.get(),
+        chunk->bottom,
+        chunk->top,
+        volume,
+        sections
+    );
+}
 
-    bool hasTranslucent = false;
-    for (int i = totalBegin; i < totalEnd; i++) {
-        const voxel& vox = voxels[i];
-        blockid_t id = vox.id;
-        const auto& def = *blockDefsCache[id];
-        if (def.translucent) {
-            hasTranslucent = true;
-            break;
+void BlocksRenderer::build(
+    const ChunkSnapshot& snapshot,
+    const VoxelsRenderVolume& volume,
+    uint32_t sections
+) {
+    if (chunkVoxels == nullptr) {
+        chunkVoxels = std::make_unique<voxel[]>(CHUNK_VOL);
+    }
+    // only built sections voxels are read from the flat array
+    for (int i = 0; i < CHUNK_SECTIONS; i++) {
+        const voxel* src = snapshot.getSectionVoxels(i);
+        if ((sections & (1U << i)) && src) {
+            std::copy(
+                src,
+                src + ChunkSnapshotSection::VOLUME,
+                chunkVoxels.get() + i * ChunkSnapshotSection::VOLUME
+            );
         }
     }
-    cancelled = false;
+    build(
+        snapshot.x,
+        snapshot.z,
+        chunkVoxels.get(),
+        snapshot.bottom,
+        snapshot.top,
+        volume,
+        sections
+    );
+}
 
-    overflow = false;
-    vertexCount = 0;
-    vertexOffset = indexCount = 0;
+void BlocksRenderer::build(
+    int x,
+    int z,
+    const voxel* voxels,
+    int bottom,
+    int top,
+    const VoxelsRenderVolume& volume,
+    uint32_t sections
+) {
+    meshAABB = AABB(glm::vec3(CHUNK_W, CHUNK_H, CHUNK_D));
+    chunkX = x;
+    chunkZ = z;
+    this->voxelsBuffer = &volume;
+    sectionsMask = sections;
+    builtSections.clear();
 
-    denseRender = false;
-    densePass = false;
+    bool checked = false;
+    for (int i = 0; i < CHUNK_SECTIONS; i++) {
+        if (!(sections & (1U << i))) {
+            continue;
+        }
+        int begin = std::max(i * CHUNK_SECTION_H, bottom);
+        int end = std::min((i + 1) * CHUNK_SECTION_H, top);
+        if (begin >= end) {
+            continue;
+        }
+        if (!checked && voxelsBuffer->pickBlockId(
+            chunkX * CHUNK_W, begin, chunkZ * CHUNK_D
+        ) == BLOCK_VOID) {
+            cancelled = true;
+            return;
+        }
+        checked = true;
 
-    if (hasTranslucent) {
-        sortingMesh = renderTranslucent(voxels, totalBegin, totalEnd);
-    } else {
+        overflow = false;
+        vertexCount = 0;
+        vertexOffset = 0;
+        indexCount = 0;
+        denseIndexCount = 0;
         sortingMesh = {};
-    }
 
-    overflow = false;
-    vertexCount = 0;
-    vertexOffset = 0;
-    indexCount = 0;
-    denseIndexCount = 0;
-
-    denseRender = false;
-    densePass = false;
-    render(voxels, totalBegin, totalEnd);
-
-    size_t endIndex = indexCount;
-    
-    denseRender = true;
-    densePass = settings.graphics.denseRender.get();
-    render(voxels, totalBegin, totalEnd);
+        render(
+            voxels,
+            begin * (CHUNK_W * CHUNK_D),
+            end * (CHUNK_W * CHUNK_D)
+        );
+        assert(vertexCount <= capacity);
+        assert(indexCount <= capacity);
+        assert(denseIndexCount <= capacity);
 
-    denseIndexCount = indexCount;
-    for (size_t i = 0; i < denseIndexCount; i++) {
-        denseIndexBuffer[i] = indexBuffer[i];
+        if (vertexCount == 0 && sortingMesh.entries.empty()) {
+            continue;
+        }
+        builtSections.push_back(ChunkSectionMeshData {
+            i,
+            MeshData(
+                util::Buffer(vertexBuffer.get(), vertexCount),
+                std::vector<util::Buffer<uint32_t>> {
+                    util::Buffer(indexBuffer.get(), indexCount),
+                    util::Buffer(denseIndexBuffer.get(), denseIndexCount),
+                },
+                util::Buffer(
+                    ChunkVertex::ATTRIBUTES,
+                    sizeof(ChunkVertex::ATTRIBUTES) / sizeof(VertexAttribute)
+                )
+            ),
+            std::move(sortingMesh)
+        });
     }
-
-    indexCount = endIndex;
-    densePass = false;
-    render(voxels, totalBegin, totalEnd);
+    cancelled = false;
 }
 
 ChunkMeshData BlocksRenderer::createMesh() {
     return ChunkMeshData {
-        MeshData(
-            util::Buffer(vertexBuffer.get(), vertexCount),
-            std::vector<util::Buffer<uint32_t>> {
-                util::Buffer(indexBuffer.get(), indexCount),
-                util::Buffer(denseIndexBuffer.get(), denseIndexCount),
-            },
-            util::Buffer(
-                ChunkVertex::ATTRIBUTES,
-                sizeof(ChunkVertex::ATTRIBUTES) / sizeof(VertexAttribute)
-            )
-        ),
-        std::move(sortingMesh),
-        std::move(meshAABB)
+        sectionsMask, std::move(builtSections), std::move(meshAABB)
     };
 }
 
-ChunkMesh BlocksRenderer::render(
-    const Chunk* chunk, const VoxelsRenderVolume& volume
-) {
-    build(chunk, volume);
-    
-    assert(vertexCount <= capacity);
-    assert(indexCount <= capacity);
-    assert(denseIndexCount <= capacity);
-
-    return ChunkMesh{std::make_unique<Mesh<ChunkVertex>>(
-        vertexBuffer.get(), vertexCount, 
-        std::vector<IndexBufferData> {
-            IndexBufferData {indexBuffer.get(), indexCount},
-            IndexBufferData {denseIndexBuffer.get(), denseIndexCount},
-        }
-    ), std::move(sortingMesh), nullptr, std::move(meshAABB)};
-}
-
 size_t BlocksRenderer::getMemoryConsumption() const {
-    return capacity * (sizeof(ChunkVertex) + sizeof(uint32_t) * 2);
+    size_t size = capacity * (sizeof(ChunkVertex) + sizeof(uint32_t) * 2);
+    if (greedyMasks) {
+        size += 6 * CHUNK_VOL * sizeof(uint64_t);
+    }
+    if (chunkVoxels) {
+        size += CHUNK_VOL * sizeof(voxel);
+    }
+    return size;
 }
@@ -18,6 +18,7 @@ class Content;
 class Block;
 class Chunk;
 class Chunks;
+class ChunkSnapshot;
 class ContentGfxCache;
 struct UVRegion;
 
@@ -31,12 +32,27 @@ public:
     );
     ~BlocksRenderer();
 
-    void build(const Chunk* chunk, const VoxelsRenderVolume& volume);
-    ChunkMesh render(
-        const Chunk* chunk, const VoxelsRenderVolume& volume
+    /// @brief Build chunk mesh sections
+    /// @param sections bit mask of sections to build, volume must contain
+    /// the sections voxels and one layer below and above them
+    void build(
+        const Chunk* chunk,
+        const VoxelsRenderVolume& volume,
+        uint32_t sections = ALL_SECTIONS
+    );
+
+    /// @brief Build chunk mesh sections reading chunk voxels from
+    /// the snapshot (for use off the chunk owner thread)
+    void build(
+        const ChunkSnapshot& snapshot,
+        const VoxelsRenderVolume& volume,
+        uint32_t sections = ALL_SECTIONS
     );
     ChunkMeshData createMesh();
 
+    static constexpr uint32_t ALL_SECTIONS =
+        CHUNK_SECTIONS == 32 ? ~0U : (1U << CHUNK_SECTIONS) - 1;
+
     size_t getMemoryConsumption() const;
 
     bool isCancelled() const {
@@ -57,7 +73,8 @@ private:
     bool densePass = false;
     bool denseRender = false;
     AABB meshAABB {};
-    const Chunk* chunk = nullptr;
+    int chunkX = 0;
+    int chunkZ = 0;
     const VoxelsRenderVolume* voxelsBuffer = nullptr;
 
     const Block* const* blockDefsCache;
@@ -67,6 +84,17 @@ private:
     util::PseudoRandom randomizer;
 
     SortingMeshData sortingMesh;
+    uint32_t sectionsMask = 0;
+    std::vector<ChunkSectionMeshData> builtSections;
+
+    /// @brief Greedy meshing faces keys (block id, variant and vertex
+    /// color) per texture side, indexed as voxels
+    std::unique_ptr<uint64_t[]> greedyMasks;
+    /// @brief Number of faces in greedyMasks per side
+    size_t greedyFacesCount[6] {};
+    /// @brief Chunk voxels copy used to build chunk mesh without
+    /// unpacking the chunk voxels (see Chunk::copyVoxels)
+    std::unique_ptr<voxel[]> chunkVoxels;
 
     void vertex(
         const glm::vec3& coord,
@@ -112,14 +140,42 @@ private:
         const UVRegion& region,
         bool lights
     );
+    /// @brief faceAO for a unit cube face, picks the lights shared by
+    /// the face corners once
+    void cubeFaceAO(
+        const glm::ivec3& coord,
+        const glm::ivec3& axisX,
+        const glm::ivec3& axisY,
+        const glm::ivec3& axisZ,
+        const UVRegion& region,
+        bool lights
+    );
+    /// @param openFaces mask of the faces to be drawn (see getOpenFaces)
     void blockCube(
         const glm::ivec3& coord,
         const UVRegion(&faces)[6], 
         const Block& block, 
         blockstate states, 
+        uint8_t openFaces,
+        bool lights,
+        bool ao
+    );
+    /// @brief Cube render method collecting faces with uniform lights
+    /// to be merged by flushGreedyFaces
+    void blockCubeGreedy(
+        const glm::ivec3& coord,
+        const UVRegion(&faces)[6],
+        const Block& block,
+        blockstate states,
+        uint8_t openFaces,
         bool lights,
         bool ao
     );
+    /// @brief Merge collected faces into rectangles and emit them
+    void flushGreedyFaces(int yBegin, int yEnd);
+    /// @return region size in atlas pixels packed for ChunkVertex::position
+    /// or 0 if the region can not be repeated over merged face
+    uint16_t tileSize(const UVRegion& region) const;
     void blockAABB(
         const glm::ivec3& coord,
         const UVRegion(&faces)[6], 
@@ -143,10 +199,16 @@ private:
         bool ao
     );
 
+    /// @brief Check all six block neighbours with isOpen
+    /// @return mask of open faces, bits 0-5 are +X, -X, +Y, -Y, +Z, -Z
+    uint8_t getOpenFaces(
+        const glm::ivec3& coord, const Block& def, const Variant& variant
+    ) const;
+
     // Does block allow to see other blocks sides (is it transparent)
     bool isOpen(const glm::ivec3& pos, const Block& def, const Variant& variant) const {
         const auto& vox = voxelsBuffer->pickBlock(
-            chunk->x * CHUNK_W + pos.x, pos.y, chunk->z * CHUNK_D + pos.z
+            chunkX * CHUNK_W + pos.x, pos.y, chunkZ * CHUNK_D + pos.z
         );
         if (vox.id == BLOCK_VOID) {
             return false;
@@ -179,7 +241,38 @@ private:
     glm::vec4 pickSoftLight(
         float x, float y, float z, const glm::ivec3& right, const glm::ivec3& up
     ) const;
+    /// @brief Same as pickSoftLight for each of coord, coord + right,
+    /// coord + right + up and coord + up, sampling the 3x3 neighbourhood once
+    void pickSoftLights(
+        const glm::ivec3& coord,
+        const glm::ivec3& right,
+        const glm::ivec3& up,
+        glm::vec4(&lights)[4]
+    ) const;
 
+    /// @brief Emit block geometry using current densePass and denseRender
+    void blockModel(
+        const glm::ivec3& coord,
+        const voxel& vox,
+        const Block& def,
+        uint8_t variantId,
+        bool ao,
+        bool greedy
+    );
+    /// @brief Append indices emitted since start to the dense index buffer
+    void copyDenseIndices(size_t start);
+
+    /// @brief Single sweep building normal and dense index buffers and
+    /// translucent blocks sorting mesh
     void render(const voxel* voxels, int totalBegin, int totalEnd);
-    SortingMeshData renderTranslucent(const voxel* voxels, int totalBegin, int totalEnd);
+
+    void build(
+        int x,
+        int z,
+        const voxel* voxels,
+        int bottom,
+        int top,
+        const VoxelsRenderVolume& volume,
+        uint32_t sections
+    );
 };
@@ -18,13 +18,60 @@
 #include "settings.hpp"
 #include "content/Content.hpp"
 
+#include <algorithm>
+#include <iterator>
+
 static debug::Logger logger("chunks-render");
 
 size_t ChunksRenderer::visibleChunks = 0;
 
 static constexpr inline size_t MAX_CHUNKS_ENQUEUED_IN_FRAME = 4;
+/// @brief Frames snapshot is kept after the last use
+static constexpr inline uint64_t SNAPSHOT_TTL_FRAMES = 120;
+
+static util::ObjectsPool<VoxelsRenderVolume> voxelsVolumesPool {};
+
+/// @brief Get layers range [bottom, top) of voxels volume required to build
+/// the mesh sections
+static void get_volume_layers(
+    uint32_t sections, int chunkTop, int& bottom, int& top
+) {
+    int first = 0;
+    while (first < CHUNK_SECTIONS - 1 && !(sections & (1U << first))) {
+        first++;
+    }
+    int last = CHUNK_SECTIONS - 1;
+    while (last > first && !(sections & (1U << last))) {
+        last--;
+    }
+    // one layer around the sections is required for faces culling
+    bottom = std::max(first * CHUNK_SECTION_H - 1, 0);
+    top = std::min(chunkTop + 1, (last + 1) * CHUNK_SECTION_H + 1);
+}
+
+/// @return bit mask of sections containing layers [bottom, top)
+static uint32_t get_layers_sections(int bottom, int top) {
+    uint32_t mask = 0;
+    for (int i = bottom / CHUNK_SECTION_H;
+         i < CHUNK_SECTIONS && i * CHUNK_SECTION_H < top;
+         i++) {
+        mask |= 1U << i;
+    }
+    return mask;
+}
+
+static std::shared_ptr<VoxelsRenderVolume> create_voxels_volume(int x, int z) {
+    auto voxelsBuffer = voxelsVolumesPool.create();
+    voxelsBuffer->setPosition(
+        x * CHUNK_W - VOXELS_BUFFER_PADDING,
+        0,
+        z * CHUNK_D - VOXELS_BUFFER_PADDING
+    );
+    return voxelsBuffer;
+}
 
 class RendererWorker : public util::Worker<RendererJob, RendererResult> {
+    const ContentIndices& indices;
     BlocksRenderer renderer;
 public:
     RendererWorker(
@@ -32,7 +79,8 @@ public:
         const ContentGfxCache& cache,
         const EngineSettings& settings
     )
-        : renderer(
+        : indices(*level.content.getIndices()),
+          renderer(
               settings.graphics.denseRender.get()
                   ? settings.graphics.chunkMaxVerticesDense.get()
                   : settings.graphics.chunkMaxVertices.get(),
@@ -43,21 +91,36 @@ public:
     }
 
     RendererResult operator()(const RendererJob& job) override {
-        auto chunk = job.chunk;
-        auto volume = job.volume;
-        renderer.build(chunk.get(), *volume);
+        const auto& snapshot = job.area.getCenter();
+        glm::ivec2 key(snapshot.x, snapshot.z);
+
+        int bottom, top;
+        get_volume_layers(job.sections, snapshot.top, bottom, top);
+        auto volume = create_voxels_volume(snapshot.x, snapshot.z);
+        Chunks::getVoxels(
+            indices,
+            job.area,
+            volume->getVoxels(),
+            volume->getLights(),
+            {volume->getX(), volume->getY(), volume->getZ()},
+            {VoxelsRenderVolume::width,
+             VoxelsRenderVolume::height,
+             VoxelsRenderVolume::depth},
+            job.backlight,
+            top,
+            bottom
+        );
+        renderer.build(snapshot, *volume, job.sections);
         if (renderer.isCancelled()) {
             return RendererResult {
-                glm::ivec2(chunk->x, chunk->z), true, ChunkMeshData {}};
+                key, true, snapshot.generation, ChunkMeshData {}};
         }
         auto meshData = renderer.createMesh();
         return RendererResult {
-            glm::ivec2(chunk->x, chunk->z), false, std::move(meshData)};
+            key, false, snapshot.generation, std::move(meshData)};
     }
 };
 
-static util::ObjectsPool<VoxelsRenderVolume> voxelsVolumesPool {};
-
 ChunksRenderer::ChunksRenderer(
     const Level& level,
     const Chunks& chunks,
@@ -78,15 +141,8 @@ ChunksRenderer::ChunksRenderer(
               );
           },
           [&](RendererResult&& result) {
-                if (!result.cancelled) {
-                    auto meshData = std::move(result.meshData);
-                    auto chunk = std::make_unique<Mesh<ChunkVertex>>(meshData.mesh);
-                    meshes[result.key] = ChunkMesh {
-                        std::move(chunk),
-                        std::move(meshData.sortingMesh),
-                        nullptr,
-                        std::move(meshData.meshAABB)
-                    };
+                if (!result.cancelled && isActual(result)) {
+                    applyMesh(result.key, std::move(result.meshData));
                 }
                 inwork.erase(result.key);
           },
@@ -112,26 +168,171 @@ ChunksRenderer::ChunksRenderer(
 ChunksRenderer::~ChunksRenderer() = default;
 
 std::shared_ptr<VoxelsRenderVolume> ChunksRenderer::prepareVoxelsVolume(
-    const Chunk& chunk
+    const Chunk& chunk, uint32_t sections
 ) {
-    auto voxelsBuffer = voxelsVolumesPool.create();
-    voxelsBuffer->setPosition(
-        chunk.x * CHUNK_W - VOXELS_BUFFER_PADDING, 0,
-        chunk.z * CHUNK_D - VOXELS_BUFFER_PADDING
-    );
+    int bottom, top;
+    get_volume_layers(sections, chunk.top, bottom, top);
+
+    auto voxelsBuffer = create_voxels_volume(chunk.x, chunk.z);
     chunks.getVoxels(
-        *voxelsBuffer, settings.graphics.backlight.get(), chunk.top + 1
+        *voxelsBuffer, settings.graphics.backlight.get(), top, bottom
     );
     return voxelsBuffer;
 }
 
+uint32_t ChunksRenderer::takeModifiedSections(Chunk& chunk) const {
+    uint32_t sections = chunk.modifiedSections;
+    if (chunk.flags.modified ||
+        meshes.find(glm::ivec2(chunk.x, chunk.z)) == meshes.end()) {
+        sections = BlocksRenderer::ALL_SECTIONS;
+    }
+    chunk.flags.modified = false;
+    chunk.modifiedSections = 0;
+    return sections;
+}
+
+std::shared_ptr<const ChunkSnapshot> ChunksRenderer::getSnapshot(
+    int x, int z, uint32_t sections
+) {
+    int lx = x - chunks.getOffsetX();
+    int lz = z - chunks.getOffsetY();
+    if (lx < 0 || lz < 0 || lx >= chunks.getWidth() ||
+        lz >= chunks.getHeight()) {
+        return nullptr;
+    }
+    const auto& chunk = chunks.getChunks()[lz * chunks.getWidth() + lx];
+    if (chunk == nullptr) {
+        return nullptr;
+    }
+    auto& entry = snapshots[{x, z}];
+    if (entry.snapshot == nullptr || entry.chunk.lock() != chunk) {
+        entry.chunk = chunk;
+        entry.snapshot = ChunkSnapshot::create(*chunk, sections);
+    } else if (!entry.snapshot->isActual(*chunk, sections)) {
+        // unmodified sections are shared with the previous snapshot
+        entry.snapshot =
+            ChunkSnapshot::create(*chunk, sections, entry.snapshot.get());
+    }
+    entry.lastUsedFrame = frameIndex;
+    return entry.snapshot;
+}
+
+void ChunksRenderer::evictSnapshots() {
+    for (auto it = snapshots.begin(); it != snapshots.end();) {
+        if (frameIndex - it->second.lastUsedFrame > SNAPSHOT_TTL_FRAMES ||
+            it->second.chunk.expired()) {
+            it = snapshots.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    size_t maxSnapshots = getMaxCachedSnapshots();
+    if (snapshots.size() <= maxSnapshots) {
+        return;
+    }
+    // release least recently used, snapshots still referenced by jobs
+    // are freed when the jobs are finished
+    std::vector<std::pair<uint64_t, glm::ivec2>> entries;
+    entries.reserve(snapshots.size());
+    for (const auto& [key, entry] : snapshots) {
+        entries.emplace_back(entry.lastUsedFrame, key);
+    }
+    size_t excess = entries.size() - maxSnapshots;
+    std::nth_element(
+        entries.begin(),
+        entries.begin() + excess,
+        entries.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; }
+    );
+    for (size_t i = 0; i < excess; i++) {
+        snapshots.erase(entries[i].second);
+    }
+}
+
+bool ChunksRenderer::isAreaLocked(int x, int z) const {
+    for (int oz = -1; oz <= 1; oz++) {
+        for (int ox = -1; ox <= 1; ox++) {
+            auto chunk = chunks.getChunk(x + ox, z + oz);
+            if (chunk && chunk->lightsLocked) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+size_t ChunksRenderer::getMaxCachedSnapshots() const {
+    // every chunk of the area may be required by a mesh job
+    return chunks.getVolume();
+}
+
+bool ChunksRenderer::isActual(const RendererResult& result) {
+    auto chunk = chunks.getChunk(result.key.x, result.key.y);
+    // locked chunk is modified by a lights worker, it will be marked
+    // modified when the lights are built
+    if (chunk == nullptr || chunk->lightsLocked ||
+        chunk->generation == result.generation) {
+        return true;
+    }
+    // outdated mesh is still better than no mesh
+    if (meshes.find(result.key) == meshes.end()) {
+        return true;
+    }
+    chunk->modifiedSections |= result.meshData.sectionsMask;
+    return false;
+}
+
+void ChunksRenderer::applyMesh(const glm::ivec2& key, ChunkMeshData&& data) {
+    auto found = meshes.find(key);
+    if (found == meshes.end()) {
+        // partial result of unloaded or cleared mesh
+        if (data.sectionsMask != BlocksRenderer::ALL_SECTIONS) {
+            return;
+        }
+        found = meshes.emplace(key, ChunkMesh {}).first;
+    }
+    auto& mesh = found->second;
+    uint32_t mask = data.sectionsMask;
+    for (int i = 0; i < CHUNK_SECTIONS; i++) {
+        if (mask & (1U << i)) {
+            mesh.sections[i] = nullptr;
+        }
+    }
+    auto& entries = mesh.sortingMeshData.entries;
+    entries.erase(
+        std::remove_if(
+            entries.begin(),
+            entries.end(),
+            [mask](const SortingMeshEntry& entry) {
+                int y = static_cast<int>(entry.position.y);
+                return mask & (1U << (y / CHUNK_SECTION_H));
+            }
+        ),
+        entries.end()
+    );
+    for (auto& section : data.sections) {
+        if (section.mesh.vertices.size()) {
+            mesh.sections[section.index] =
+                std::make_unique<Mesh<ChunkVertex>>(section.mesh);
+        }
+        auto& sectionEntries = section.sortingMesh.entries;
+        std::move(
+            sectionEntries.begin(),
+            sectionEntries.end(),
+            std::back_inserter(entries)
+        );
+    }
+    mesh.sortedMesh = nullptr;
+    mesh.meshAABB = data.meshAABB;
+}
+
 void ChunksRenderer::renderBlocking(const std::shared_ptr<Chunk>& chunk) {
-    glm::ivec2 key(chunk->x, chunk->z);
-    ChunkMesh mesh {};
-    auto voxelsBuffer = prepareVoxelsVolume(*chunk);
-    mesh = renderer->render(chunk.get(), *voxelsBuffer);
-    meshes[key] = std::move(mesh);
-    chunk->flags.modified = false;
+    uint32_t sections = takeModifiedSections(*chunk);
+    auto voxelsBuffer = prepareVoxelsVolume(*chunk, sections);
+    renderer->build(chunk.get(), *voxelsBuffer, sections);
+    if (!renderer->isCancelled()) {
+        applyMesh(glm::ivec2(chunk->x, chunk->z), renderer->createMesh());
+    }
 }
 
 void ChunksRenderer::render(
@@ -144,29 +345,50 @@ void ChunksRenderer::render(
          lowPriority)) {
         return;
     }
-    chunk->flags.modified = false;
+    uint32_t sections = takeModifiedSections(*chunk);
     enqueuedInFrame++;
-    auto voxelsBuffer = prepareVoxelsVolume(*chunk);
-    threadPool.enqueueJob({chunk, std::move(voxelsBuffer)});
+
+    int bottom, top;
+    get_volume_layers(sections, chunk->top, bottom, top);
+    uint32_t areaSections = get_layers_sections(bottom, top);
+
+    RendererJob job {
+        {chunk->x, chunk->z, {}},
+        sections,
+        settings.graphics.backlight.get()};
+    for (int lz = -1; lz <= 1; lz++) {
+        for (int lx = -1; lx <= 1; lx++) {
+            job.area.snapshots[(lz + 1) * 3 + lx + 1] =
+                getSnapshot(chunk->x + lx, chunk->z + lz, areaSections);
+        }
+    }
+    threadPool.enqueueJob(std::move(job));
     inwork[key] = true;
 }
 
 void ChunksRenderer::unload(const Chunk* chunk) {
-    auto found = meshes.find(glm::ivec2(chunk->x, chunk->z));
+    glm::ivec2 key(chunk->x, chunk->z);
+    auto found = meshes.find(key);
     if (found != meshes.end()) {
         meshes.erase(found);
     }
+    snapshots.erase(key);
 }
 
 void ChunksRenderer::clear() {
     meshes.clear();
     inwork.clear();
+    snapshots.clear();
     threadPool.clearQueue();
 }
 
 void ChunksRenderer::update() {
     threadPool.pullResults();
     enqueuedInFrame = 0;
+    if (++frameIndex % SNAPSHOT_TTL_FRAMES == 0 ||
+        snapshots.size() > getMaxCachedSnapshots()) {
+        evictSnapshots();
+    }
 
     int width = chunks.getWidth();
     int halfWidth = width / 2;
@@ -178,12 +400,14 @@ void ChunksRenderer::update() {
     auto& chunksArray = chunks.getChunks();
     for (int index = 0; index < chunks.getVolume(); index++) {
         const auto& chunk = chunks.getChunks()[index];
-        if (chunk == nullptr || !chunk->flags.lighted) {
+        if (chunk == nullptr || !chunk->flags.lighted ||
+            isAreaLocked(chunk->x, chunk->z)) {
             continue;
         }
         int x = chunk->x;
         int z = chunk->z;
-        if (chunk->flags.modified || meshes.find({x, z}) == meshes.end()) {
+        if (chunk->flags.modified || chunk->modifiedSections ||
+            meshes.find({x, z}) == meshes.end()) {
             meshBuildQueue.emplace_back(x - centerX, z - centerY);
         }
     }
@@ -268,9 +492,15 @@ void ChunksRenderer::drawShadowsPass(
         }
         glm::mat4 model = glm::translate(glm::mat4(1.0f), coord);
         shader.uniformMatrix("u_model", model);
-        found->second.mesh->draw(GL_TRIANGLES, 
-            glm::distance2(playerCamera.position * glm::vec3(1, 0, 1), 
-                           (min + max) * 0.5f * glm::vec3(1, 0, 1)) < denseDistance2);
+        bool dense = glm::distance2(
+            playerCamera.position * glm::vec3(1, 0, 1),
+            (min + max) * 0.5f * glm::vec3(1, 0, 1)
+        ) < denseDistance2;
+        for (const auto& section : found->second.sections) {
+            if (section) {
+                section->draw(GL_TRIANGLES, dense);
+            }
+        }
     }
 }
 
@@ -321,36 +551,44 @@ void ChunksRenderer::drawChunks(
             continue;
         }
         auto& mesh = found->second;
-        if (mesh.mesh == nullptr) {
+        const auto& meshAABB = mesh.meshAABB;
+        auto aabbMin = meshAABB.min();
+        auto aabbMax = meshAABB.max();
+        glm::vec3 min(
+            chunk->x * CHUNK_W + std::min(0.0f, aabbMin.x),
+            chunk->bottom,
+            chunk->z * CHUNK_D + std::min(0.0f, aabbMin.z)
+        );
+        glm::vec3 max(
+            chunk->x * CHUNK_W + aabbMax.x,
+            chunk->top,
+            chunk->z * CHUNK_D + aabbMax.z
+        );
+        if (culling && !frustum.isBoxVisible(min, max)) {
             continue;
         }
-        if (culling) {
-            const auto& meshAABB = mesh.meshAABB;
-            auto aabbMin = meshAABB.min();
-            auto aabbMax = meshAABB.max();
-            glm::vec3 min(
-                chunk->x * CHUNK_W + std::min(0.0f, aabbMin.x),
-                chunk->bottom,
-                chunk->z * CHUNK_D + std::min(0.0f, aabbMin.z)
-            );
-            glm::vec3 max(
-                chunk->x * CHUNK_W + aabbMax.x,
-                chunk->top,
-                chunk->z * CHUNK_D + aabbMax.z
-            );
-
-            if (!frustum.isBoxVisible(min, max)) {
-                continue;
-            }
-        }
 
         glm::vec3 coord(
             chunk->x * CHUNK_W + 0.5f, 0.5f, chunk->z * CHUNK_D + 0.5f
         );
         glm::mat4 model = glm::translate(glm::mat4(1.0f), coord);
         shader.uniformMatrix("u_model", model);
-        mesh.mesh->draw(GL_TRIANGLES, glm::distance2(camera.position * glm::vec3(1, 0, 1), 
-            (coord + glm::vec3(CHUNK_W * 0.5f, 0.0f, CHUNK_D * 0.5f))) < denseDistance2);
+        bool dense = glm::distance2(camera.position * glm::vec3(1, 0, 1), 
+            (coord + glm::vec3(CHUNK_W * 0.5f, 0.0f, CHUNK_D * 0.5f))) < denseDistance2;
+        for (int i = 0; i < CHUNK_SECTIONS; i++) {
+            const auto& section = mesh.sections[i];
+            if (section == nullptr) {
+                continue;
+            }
+            if (culling) {
+                min.y = i * CHUNK_SECTION_H;
+                max.y = (i + 1) * CHUNK_SECTION_H;
+                if (!frustum.isBoxVisible(min, max)) {
+                    continue;
+                }
+            }
+            section->draw(GL_TRIANGLES, dense);
+        }
         visibleChunks++;
     }
 }
@@ -381,7 +619,6 @@ void ChunksRenderer::drawSortedMeshes(const Camera& camera, Shader& shader) {
 
     shader.use();
     atlas.getTexture()->bind();
-    shader.uniformMatrix("u_model", glm::mat4(1.0f));
     shader.uniform1i("u_alphaClip", false);
     
     for (const auto& index : indices) {
@@ -405,6 +642,12 @@ void ChunksRenderer::drawSortedMeshes(const Camera& camera, Shader& shader) {
             if (!frustum.isBoxVisible(min, max)) continue;
         }
 
+        // sorting mesh vertices are chunk-local as well
+        glm::vec3 coord(
+            chunk->x * CHUNK_W + 0.5f, 0.5f, chunk->z * CHUNK_D + 0.5f
+        );
+        shader.uniformMatrix("u_model", glm::translate(glm::mat4(1.0f), coord));
+
         auto& chunkEntries = found->second.sortingMeshData.entries;
 
         if (chunkEntries.size() == 1) {
@@ -3,6 +3,7 @@
 #define GLM_ENABLE_EXPERIMENTAL
 
 #include "util/ThreadPool.hpp"
+#include "voxels/ChunkSnapshot.hpp"
 #include "commons.hpp"
 
 #include <memory>
@@ -36,12 +37,24 @@ struct ChunksSortEntry {
 struct RendererResult {
     glm::ivec2 key;
     bool cancelled;
+    /// @brief Generation of the chunk snapshot the mesh is built from
+    uint32_t generation;
     ChunkMeshData meshData;
 };
 
 struct RendererJob {
-    std::shared_ptr<Chunk> chunk;
-    std::shared_ptr<VoxelsRenderVolume> volume;
+    /// @brief Snapshots of the chunk and its neighbours
+    ChunkSnapshotsArea area;
+    /// @brief Bit mask of mesh sections to build
+    uint32_t sections;
+    bool backlight;
+};
+
+struct ChunkSnapshotEntry {
+    /// @brief Snapshot is not reused for another chunk at the same position
+    std::weak_ptr<const Chunk> chunk;
+    std::shared_ptr<const ChunkSnapshot> snapshot;
+    uint64_t lastUsedFrame;
 };
 
 class ChunksRenderer {
@@ -83,10 +96,43 @@ private:
     std::vector<ChunksSortEntry> indices;
     util::ThreadPool<RendererJob, RendererResult> threadPool;
     std::vector<glm::ivec2> meshBuildQueue;
+    /// @brief Chunks snapshots shared by mesh jobs of neighbour chunks
+    std::unordered_map<glm::ivec2, ChunkSnapshotEntry> snapshots;
 
     size_t enqueuedInFrame = 0;
+    uint64_t frameIndex = 0;
+
+    std::shared_ptr<VoxelsRenderVolume> prepareVoxelsVolume(
+        const Chunk& chunk, uint32_t sections
+    );
+
+    /// @return bit mask of mesh sections to rebuild, resets chunk flags
+    uint32_t takeModifiedSections(Chunk& chunk) const;
+
+    /// @param sections bit mask of sections the snapshot must contain
+    /// @return actual snapshot of the chunk or nullptr if chunk is missing
+    std::shared_ptr<const ChunkSnapshot> getSnapshot(
+        int x, int z, uint32_t sections
+    );
+
+    /// @brief Check if any chunk of 3x3 area is used by a lights worker
+    /// (see Chunk::lightsLocked), its voxels and lights are sampled for
+    /// the mesh of the central chunk
+    bool isAreaLocked(int x, int z) const;
+
+    /// @brief Snapshots cache limit, depends on the chunks area size
+    size_t getMaxCachedSnapshots() const;
+
+    /// @brief Release snapshots not used for a while and least recently
+    /// used ones over the cache limit
+    void evictSnapshots();
+
+    /// @brief Check if the mesh was built from the actual chunk voxels,
+    /// marks sections of outdated mesh modified again
+    bool isActual(const RendererResult& result);
 
-    std::shared_ptr<VoxelsRenderVolume> prepareVoxelsVolume(const Chunk& chunk);
+    /// @brief Replace built sections of the chunk mesh
+    void applyMesh(const glm::ivec2& key, ChunkMeshData&& data);
 
     void render(const std::shared_ptr<Chunk>& chunk, bool lowPriority);
 
@@ -107,7 +107,7 @@ private:
         const glm::vec3& normal
     ) {
         auto& vert = vertices[offset++];
-        vert.position = coord;
+        vert.position = ChunkVertex::packPosition(coord);
         vert.uv = {};
         vert.normal = {
             static_cast<uint8_t>(normal.r * 127 + 128),
@@ -125,7 +125,7 @@ void Decorator::updateAcoustics(const Camera& camera) {
         glm::ivec3 iend;
         blocks_agent::RaycastSettings raycast {};
         auto vox = chunks.rayCast(start, dir, length, end, norm, iend, raycast);
-        if (vox == nullptr) {
+        if (!vox) {
             continue;
         }
         auto distance = glm::distance(start, end);
@@ -183,7 +183,7 @@ void Decorator::updateRandom(
     );
     auto vox = chunks.get(pos);
     auto chunk = chunks.getChunkByVoxel(pos);
-    if (vox == nullptr || chunk == nullptr) {
+    if (!vox || chunk == nullptr) {
         return;
     }
 
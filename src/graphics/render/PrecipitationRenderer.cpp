@@ -37,12 +37,11 @@ int PrecipitationRenderer::getHeightAt(int x, int z) {
     if (chunk == nullptr) {
         return y;
     }
-    y = chunk->top;
+    y = std::min(chunk->top, CHUNK_H - 1);
     x -= cx * CHUNK_W;
     z -= cz * CHUNK_D;
     while (y > 0) {
-        const auto& vox = chunk->voxels[vox_index(x, y, z)];
-        if (vox.id == 0) {
+        if (chunk->get(x, y, z).id == 0) {
             y--;
             continue;
         }
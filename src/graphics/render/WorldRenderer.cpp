@@ -557,7 +557,7 @@ void WorldRenderer::renderBlockOverlay(const DrawContext& wctx) {
     int z = std::floor(player.currentCamera->position.z);
     auto block = player.chunks->get(x, y, z);
 
-    if (block == nullptr || block->id == BLOCK_AIR || block->id == BLOCK_VOID) {
+    if (!block || block->id == BLOCK_AIR || block->id == BLOCK_VOID) {
         return;
     }
     const auto& def = level.content.getIndices()->blocks.require(block->id);
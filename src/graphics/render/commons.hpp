@@ -6,25 +6,110 @@
 #include "util/Buffer.hpp"
 
 #include <vector>
+#include <algorithm>
 #include <array>
 #include <memory>
 #include <glm/vec2.hpp>
 #include <glm/vec3.hpp>
+#include <glm/vec4.hpp>
 
-/// @brief Chunk mesh vertex format
+/// @brief Chunk vertex layout: 1 - packed (20 bytes), 0 - float (32 bytes).
+/// Both layouts use the same shaders (res/shaders/lib/chunk_vertex.glsl)
+#ifndef VC_PACKED_CHUNK_VERTEX
+#define VC_PACKED_CHUNK_VERTEX 1
+#endif
+
+#if VC_PACKED_CHUNK_VERTEX
+/// @brief Chunk mesh vertex format (20 bytes)
 struct ChunkVertex {
-    glm::vec3 position;
+    /// @brief Chunk-local fixed point position (x, y, z).
+    /// w is texture tile size in atlas pixels (width | height << 8)
+    /// for faces repeating the texture, zero otherwise
+    std::array<uint16_t, 4> position;
+    /// @brief Normalized atlas coordinates, tile origin if position.w != 0
+    std::array<uint16_t, 2> uv;
+    std::array<uint8_t, 4> color;
+    std::array<uint8_t, 4> normal;
+
+    /// @brief Position units per block (res/shaders/lib/chunk_vertex.glsl)
+    static constexpr float POSITION_SCALE = 128.0f;
+    /// @brief Position offset allowing negative coordinates
+    static constexpr float POSITION_BIAS = 64.0f;
+
+    static constexpr VertexAttribute ATTRIBUTES[] = {
+        {VertexAttribute::Type::UNSIGNED_SHORT, false, 4},
+        {VertexAttribute::Type::UNSIGNED_SHORT, true, 2},
+        {VertexAttribute::Type::UNSIGNED_BYTE, true, 4},
+        {VertexAttribute::Type::UNSIGNED_BYTE, true, 4},
+        {{}, 0}};
+
+    static inline std::array<uint16_t, 4> packPosition(
+        const glm::vec3& pos, uint16_t tileSize = 0
+    ) {
+        return {
+            pack_coord(pos.x),
+            pack_coord(pos.y),
+            pack_coord(pos.z),
+            tileSize
+        };
+    }
+
+    static inline std::array<uint16_t, 2> packUV(float u, float v) {
+        return {
+            static_cast<uint16_t>(std::clamp(u, 0.0f, 1.0f) * 65535 + 0.5f),
+            static_cast<uint16_t>(std::clamp(v, 0.0f, 1.0f) * 65535 + 0.5f)
+        };
+    }
+
+    glm::vec3 getPosition() const {
+        return glm::vec3(position[0], position[1], position[2]) /
+                   POSITION_SCALE - POSITION_BIAS;
+    }
+private:
+    static inline uint16_t pack_coord(float value) {
+        return static_cast<uint16_t>(std::clamp(
+            (value + POSITION_BIAS) * POSITION_SCALE + 0.5f, 0.0f, 65535.0f
+        ));
+    }
+};
+static_assert(sizeof(ChunkVertex) == 20);
+#else
+/// @brief Chunk mesh vertex format (32 bytes)
+struct ChunkVertex {
+    /// @brief Chunk-local position (x, y, z) in the packed layout units,
+    /// not quantized. w is texture tile size as in the packed layout
+    glm::vec4 position;
+    /// @brief Atlas coordinates, tile origin if position.w != 0
     glm::vec2 uv;
     std::array<uint8_t, 4> color;
     std::array<uint8_t, 4> normal;
 
+    static constexpr float POSITION_SCALE = 128.0f;
+    static constexpr float POSITION_BIAS = 64.0f;
+
     static constexpr VertexAttribute ATTRIBUTES[] = {
-        {VertexAttribute::Type::FLOAT, false, 3},
+        {VertexAttribute::Type::FLOAT, false, 4},
         {VertexAttribute::Type::FLOAT, false, 2},
         {VertexAttribute::Type::UNSIGNED_BYTE, true, 4},
         {VertexAttribute::Type::UNSIGNED_BYTE, true, 4},
         {{}, 0}};
+
+    static inline glm::vec4 packPosition(
+        const glm::vec3& pos, uint16_t tileSize = 0
+    ) {
+        return glm::vec4((pos + POSITION_BIAS) * POSITION_SCALE, tileSize);
+    }
+
+    static inline glm::vec2 packUV(float u, float v) {
+        return glm::vec2(u, v);
+    }
+
+    glm::vec3 getPosition() const {
+        return glm::vec3(position) / POSITION_SCALE - POSITION_BIAS;
+    }
 };
+static_assert(sizeof(ChunkVertex) == 32);
+#endif
 
 template<typename VertexStructure>
 class Mesh;
@@ -43,14 +128,25 @@ struct SortingMeshData {
     std::vector<SortingMeshEntry> entries;
 };
 
-struct ChunkMeshData {
+struct ChunkSectionMeshData {
+    /// @brief Section index (section y = index * CHUNK_SECTION_H)
+    int index;
     MeshData<ChunkVertex> mesh;
     SortingMeshData sortingMesh;
+};
+
+struct ChunkMeshData {
+    /// @brief Bit mask of sections replaced by this data (empty sections
+    /// are not included into the sections list)
+    uint32_t sectionsMask;
+    std::vector<ChunkSectionMeshData> sections;
     AABB meshAABB;
 };
 
 struct ChunkMesh {
-    std::unique_ptr<Mesh<ChunkVertex>> mesh;
+    /// @brief Meshes of non-empty CHUNK_SECTION_H blocks high sections
+    std::unique_ptr<Mesh<ChunkVertex>> sections[CHUNK_SECTIONS];
+    /// @brief Translucent blocks of all sections
     SortingMeshData sortingMeshData;
     std::unique_ptr<Mesh<ChunkVertex> > sortedMesh;
     AABB meshAABB;
@@ -48,6 +48,33 @@ namespace io {
         size_t length() const;
     };
 
+    /// @brief Read-only memory-mapped file. Falls back to reading the whole
+    /// file into memory if mapping is not available
+    class mmfile {
+        const ubyte* bytes = nullptr;
+        size_t filelength = 0;
+        /// @brief Platform-specific mapping handle
+        void* handle = nullptr;
+        /// @brief Used if file was not mapped
+        std::unique_ptr<ubyte[]> buffer;
+    public:
+        mmfile(const path& filename);
+        mmfile(const mmfile&) = delete;
+        ~mmfile();
+
+        const ubyte* data() const {
+            return bytes;
+        }
+
+        size_t length() const {
+            return filelength;
+        }
+
+        bool isMapped() const {
+            return buffer == nullptr;
+        }
+    };
+
     class directory_iterator_impl {
     public:
         using iterator_category = std::input_iterator_tag;
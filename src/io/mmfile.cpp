@@ -0,0 +1,107 @@
+#include "io.hpp"
+
+#include <stdexcept>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "debug/Logger.hpp"
+
+static debug::Logger logger("mmfile");
+
+#ifdef _WIN32
+static const ubyte* map_file(
+    const std::filesystem::path& file, size_t& length, void*& handle
+) {
+    HANDLE hfile = CreateFileW(
+        file.wstring().c_str(),
+        GENERIC_READ,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+    if (hfile == INVALID_HANDLE_VALUE) {
+        return nullptr;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(hfile, &size) || size.QuadPart == 0) {
+        CloseHandle(hfile);
+        return nullptr;
+    }
+    HANDLE mapping =
+        CreateFileMappingW(hfile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    // mapping keeps the file open
+    CloseHandle(hfile);
+    if (mapping == nullptr) {
+        return nullptr;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    if (view == nullptr) {
+        CloseHandle(mapping);
+        return nullptr;
+    }
+    length = size.QuadPart;
+    handle = mapping;
+    return static_cast<const ubyte*>(view);
+}
+
+static void unmap_file(const ubyte* bytes, size_t, void* handle) {
+    UnmapViewOfFile(bytes);
+    CloseHandle(static_cast<HANDLE>(handle));
+}
+#else
+static const ubyte* map_file(
+    const std::filesystem::path& file, size_t& length, void*&
+) {
+    int fd = open(file.u8string().c_str(), O_RDONLY);
+    if (fd == -1) {
+        return nullptr;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size == 0) {
+        close(fd);
+        return nullptr;
+    }
+    void* ptr = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // mapping remains valid after the descriptor is closed
+    close(fd);
+    if (ptr == MAP_FAILED) {
+        return nullptr;
+    }
+    length = st.st_size;
+    return static_cast<const ubyte*>(ptr);
+}
+
+static void unmap_file(const ubyte* bytes, size_t length, void*) {
+    munmap(const_cast<ubyte*>(bytes), length);
+}
+#endif
+
+io::mmfile::mmfile(const path& filename) {
+    auto file = io::resolve(filename);
+    bytes = map_file(file, filelength, handle);
+    if (bytes) {
+        return;
+    }
+    logger.warning() << "could not map file " << filename.string();
+    rafile rfile(filename);
+    filelength = rfile.length();
+    buffer = std::make_unique<ubyte[]>(filelength);
+    rfile.read(reinterpret_cast<char*>(buffer.get()), filelength);
+    bytes = buffer.get();
+}
+
+io::mmfile::~mmfile() {
+    if (buffer == nullptr && bytes) {
+        unmap_file(bytes, filelength, handle);
+    }
+}
@@ -67,6 +67,9 @@ SettingsHandler::SettingsHandler(EngineSettings& settings) {
     builder.add("load-distance", &settings.chunks.loadDistance);
     builder.add("load-speed", &settings.chunks.loadSpeed);
     builder.add("padding", &settings.chunks.padding);
+    builder.add("generator-workers", &settings.chunks.generatorWorkers);
+    builder.add("lighting-workers", &settings.chunks.lightingWorkers);
+    builder.add("pack-voxels", &settings.chunks.packVoxels);
 
     builder.addSection("graphics");
     builder.add("fog-curve", &settings.graphics.fogCurve);
@@ -85,6 +88,7 @@ SettingsHandler::SettingsHandler(EngineSettings& settings) {
     builder.add("dense-render-distance", &settings.graphics.denseRenderDistance);
     builder.add("soft-lighting", &settings.graphics.softLighting);
     builder.add("clouds-quality", &settings.graphics.cloudsQuality);
+    builder.add("greedy-meshing", &settings.graphics.greedyMeshing);
 
     builder.addSection("ui");
     builder.add("language", &settings.ui.language);
@@ -93,12 +97,19 @@ SettingsHandler::SettingsHandler(EngineSettings& settings) {
     builder.addSection("pathfinding");
     builder.add("steps-per-async-agent", &settings.pathfinding.stepsPerAsyncAgent);
 
+    builder.addSection("physics");
+    builder.add("workers", &settings.physics.workers);
+
     builder.addSection("debug");
     builder.add("generator-test-mode", &settings.debug.generatorTestMode);
     builder.add("do-write-lights", &settings.debug.doWriteLights);
+    builder.add("lz4-regions", &settings.debug.lz4Regions);
     builder.add("do-trace-shaders", &settings.debug.doTraceShaders);
     builder.add("enable-experimental", &settings.debug.enableExperimental);
 
+    builder.addSection("network");
+    builder.add("tcp-receive-buffer", &settings.network.tcpReceiveBuffer);
+
     builder.addSection("system");
     builder.add("max-bg-asset-loaders", &settings.system.maxBgAssetLoaders);
     builder.add("preserve-assets-during-frame", &settings.system.preserveAssetsDuringFrame);
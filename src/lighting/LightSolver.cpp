@@ -30,7 +30,7 @@ void LightSolver::add(int x, int y, int z, int emission) {
 
     addqueue.push(lightentry {x, y, z, ubyte(emission)});
 
-    chunk->flags.modified = true;
+    chunk->setSectionsModified(y);
     lightmap.set(x-chunk->x*CHUNK_W, y, z-chunk->z*CHUNK_D, channel, emission);
 }
 
@@ -86,14 +86,14 @@ void LightSolver::solve(Chunk* prevailingChunk) {
 
             int lx = x - chunk->x * CHUNK_W;
             int lz = z - chunk->z * CHUNK_D;
-            chunk->flags.modified = true;
+            chunk->setSectionsModified(y);
 
             assert(chunk->lightmap != nullptr);
             auto& lightmap = *chunk->lightmap;
 
             ubyte light = lightmap.get(lx,y,lz, channel);
             if (light != 0 && light == entry.light-1) {
-                voxel* vox = chunks.get(x, y, z);
+                auto vox = chunks.get(x, y, z);
                 if (vox && vox->id != 0) {
                     const Block* block = blockDefs[vox->id];
                     if (uint8_t emission = block->emission[channel]) {
@@ -115,6 +115,21 @@ void LightSolver::solve(Chunk* prevailingChunk) {
         lightentry entry = std::move(addqueue.front());
         addqueue.pop();
 
+        // the source may be removed after it was queued, when removals
+        // of several blocks are solved at once
+        Chunk* source = prevailingChunk;
+        if (source == nullptr || !source->isBlockInside(entry.x, entry.z)) {
+            source = chunks.getChunkByVoxel(entry.x, entry.y, entry.z);
+        }
+        if (source && source->lightmap->get(
+                          entry.x - source->x * CHUNK_W,
+                          entry.y,
+                          entry.z - source->z * CHUNK_D,
+                          channel
+                      ) < entry.light) {
+            continue;
+        }
+
         for (int i = 0; i < 6; i++) {
             int imul3 = i*3;
             int x = entry.x+coords[imul3];
@@ -135,10 +150,10 @@ void LightSolver::solve(Chunk* prevailingChunk) {
             auto& lightmap = *chunk->lightmap;
             int lx = x - chunk->x * CHUNK_W;
             int lz = z - chunk->z * CHUNK_D;
-            chunk->flags.modified = true;
+            chunk->setSectionsModified(y);
 
             ubyte light = lightmap.get(lx, y, lz, channel);
-            voxel& v = chunk->voxels[vox_index(lx, y, lz)];
+            voxel v = chunk->get(lx, y, lz);
             const Block* block = blockDefs[v.id];
             if (block->lightPassing && light+2 <= entry.light){
                 lightmap.set(
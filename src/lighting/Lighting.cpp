@@ -1,6 +1,7 @@
 #include "Lighting.hpp"
 #include "LightSolver.hpp"
 #include "Lightmap.hpp"
+#include "sky_light_kernels.hpp"
 #include "content/Content.hpp"
 #include "voxels/Chunks.hpp"
 #include "voxels/Chunk.hpp"
@@ -10,6 +11,8 @@
 #include "util/timeutil.hpp"
 #include "debug/Logger.hpp"
 
+#include <algorithm>
+#include <iterator>
 #include <memory>
 
 static debug::Logger logger("lighting");
@@ -39,27 +42,71 @@ void Lighting::clear(){
     }
 }
 
-void Lighting::prebuildSkyLight(Chunk& chunk, const ContentIndices& indices) {
+void Lighting::prebuildSkyLight(
+    Chunk& chunk, const ContentIndices& indices, noise::SimdLevel level
+) {
+    using lighting::detail::LAYER_SIZE;
+
     assert(chunk.lightmap != nullptr);
     auto& lightmap = *chunk.lightmap;
-    
-    const auto* blockDefs = indices.blocks.getDefs();
+
+    const ubyte* passing = indices.blocksLightPassing.data();
+    level = std::min(level, noise::get_simd_level());
+
+    // Columns are processed by whole Y-layers top-down. Per-voxel branching
+    // is replaced with masks
+    // 0xFFFF if sky light is still passing through the column, 0 otherwise
+    light_t columnMasks[LAYER_SIZE];
+    light_t layerMasks[LAYER_SIZE];
+    voxel voxels[LAYER_SIZE];
+    std::fill(std::begin(columnMasks), std::end(columnMasks), 0xFFFF);
 
     int highestPoint = 0;
-    for (int z = 0; z < CHUNK_D; z++){
-        for (int x = 0; x < CHUNK_W; x++){
-            for (int y = CHUNK_H-1; y >= 0; y--){
-                int index = (y * CHUNK_D + z) * CHUNK_W + x;
-                voxel& vox = chunk.voxels[index];
-                const Block* block = blockDefs[vox.id];
-                if (!block->skyLightPassing) {
-                    if (highestPoint < y) {
-                        highestPoint = y;
-                    }
-                    break;
-                }
-                lightmap.setS(x, y, z, 15);
+    for (int y = CHUNK_H - 1; y >= 0; y--) {
+        chunk.copyVoxels(voxels, y * LAYER_SIZE, LAYER_SIZE);
+        light_t* lights = lightmap.map + y * LAYER_SIZE;
+
+        bool blocked = false;
+        bool active = false;
+        bool done = false;
+        switch (level) {
+            case noise::SimdLevel::AVX2:
+                done = lighting::detail::prebuild_sky_layer_avx2(
+                    voxels, passing, columnMasks, lights, blocked, active
+                );
+                break;
+            case noise::SimdLevel::SSE41:
+                done = lighting::detail::prebuild_sky_layer_sse41(
+                    voxels, passing, columnMasks, lights, blocked, active
+                );
+                break;
+            case noise::SimdLevel::NONE:
+                break;
+        }
+        if (!done) {
+            for (int i = 0; i < LAYER_SIZE; i++) {
+                layerMasks[i] = (passing[voxels[i].id] &
+                                 BLOCK_SKY_LIGHT_PASSING_BIT) ? 0xFFFF : 0;
             }
+            light_t blockedMask = 0;
+            light_t activeMask = 0;
+            for (int i = 0; i < LAYER_SIZE; i++) {
+                light_t mask = columnMasks[i];
+                light_t passed = mask & layerMasks[i];
+                blockedMask |= mask & ~passed;
+                activeMask |= passed;
+                columnMasks[i] = passed;
+                // same as setS(x, y, z, 15) for passed voxels
+                lights[i] |= passed & 0xF000;
+            }
+            blocked = blockedMask;
+            active = activeMask;
+        }
+        if (blocked && highestPoint < y) {
+            highestPoint = y;
+        }
+        if (!active) {
+            break;
         }
     }
     if (highestPoint < CHUNK_H-1) {
@@ -69,7 +116,7 @@ void Lighting::prebuildSkyLight(Chunk& chunk, const ContentIndices& indices) {
 }
 
 void Lighting::buildSkyLight(int cx, int cz){
-    const auto blockDefs = indices.blocks.getDefs();
+    const ubyte* passing = indices.blocksLightPassing.data();
 
     Chunk* chunk = chunks.getChunk(cx, cz);
     if (chunk == nullptr) {
@@ -84,7 +131,8 @@ void Lighting::buildSkyLight(int cx, int cz){
             int gx = x + cx * CHUNK_W;
             int gz = z + cz * CHUNK_D;
             for (int y = lightmap.highestPoint; y >= 0; y--){
-                while (y > 0 && !blockDefs[chunk->voxels[vox_index(x, y, z)].id]->lightPassing) {
+                while (y > 0 && !(passing[chunk->get(x, y, z).id] &
+                                  BLOCK_LIGHT_PASSING_BIT)) {
                     y--;
                 }
                 if (lightmap.getS(x, y, z) != 15) {
@@ -121,7 +169,7 @@ void Lighting::onChunkLoaded(int cx, int cz, bool expand) {
     for (uint y = 0; y < CHUNK_H; y++){
         for (uint z = 0; z < CHUNK_D; z++){
             for (uint x = 0; x < CHUNK_W; x++){
-                const voxel& vox = chunk->voxels[(y * CHUNK_D + z) * CHUNK_W + x];
+                voxel vox = chunk->get(x, y, z);
                 const Block* block = blockDefs[vox.id];
                 int gx = x + cx * CHUNK_W;
                 int gz = z + cz * CHUNK_D;
@@ -172,16 +220,12 @@ void Lighting::onChunkLoaded(int cx, int cz, bool expand) {
     solverS.solve(chunk);
 }
 
-void Lighting::onBlockSet(int x, int y, int z, blockid_t id){
-    const auto& block = indices.blocks.require(id);
-
-    auto chunk = chunks.getChunkByVoxel(glm::ivec3{x, y, z});
-
+void Lighting::removeLights(int x, int y, int z, const Block& block) {
     if (block.skyLightPassing) {
         if (chunks.getLight(x, y + 1, z, 3) == 0xF) {
             for (int i = y; i >= 0; i--) {
-                voxel* vox = chunks.get(x, i, z);
-                if (vox == nullptr ||
+                auto vox = chunks.get(x, i, z);
+                if (!vox ||
                     indices.blocks.require(vox->id).skyLightPassing ==
                         false)
                     break;
@@ -191,24 +235,21 @@ void Lighting::onBlockSet(int x, int y, int z, blockid_t id){
     } else {
         solverS->remove(x, y, z);
         for (int i = y - 1; i >= 0; i--) {
-            voxel* vox = chunks.get(x, i, z);
-            if (vox == nullptr ||
+            auto vox = chunks.get(x, i, z);
+            if (!vox ||
                 indices.blocks.require(vox->id).skyLightPassing == false) {
                 break;
             }
             solverS->remove(x, i, z);
         }
-        solverS->solve();
     }
 
     solverR->remove(x, y, z);
     solverG->remove(x, y, z);
     solverB->remove(x, y, z);
+}
 
-    solverR->solve(chunk);
-    solverG->solve(chunk);
-    solverB->solve(chunk);
-
+void Lighting::addLights(int x, int y, int z, const Block& block) {
     static const int coords[] = {
         0, 0, 1,
         0, 0,-1,
@@ -237,8 +278,66 @@ void Lighting::onBlockSet(int x, int y, int z, blockid_t id){
     if (block.emission[2]) {
         solverB->add(x, y, z, block.emission[2]);
     }
+}
+
+void Lighting::onBlockSet(int x, int y, int z, blockid_t id){
+    if (barrier) {
+        barrier();
+    }
+    const auto& block = indices.blocks.require(id);
+
+    auto chunk = chunks.getChunkByVoxel(glm::ivec3{x, y, z});
+
+    removeLights(x, y, z, block);
+    if (!block.skyLightPassing) {
+        solverS->solve();
+    }
+    solverR->solve(chunk);
+    solverG->solve(chunk);
+    solverB->solve(chunk);
+
+    addLights(x, y, z, block);
     solverR->solve(chunk);
     solverG->solve(chunk);
     solverB->solve(chunk);
     solverS->solve(chunk);
 }
+
+void Lighting::onBlocksSet(const std::vector<glm::ivec3>& positions) {
+    if (positions.empty()) {
+        return;
+    }
+    if (barrier) {
+        barrier();
+    }
+    // sky light removal goes first, so sky light columns of light passing
+    // blocks are checked against the updated light above
+    for (bool skyLightPassing : {false, true}) {
+        for (const auto& pos : positions) {
+            auto vox = chunks.get(pos.x, pos.y, pos.z);
+            if (!vox) {
+                continue;
+            }
+            const auto& block = indices.blocks.require(vox->id);
+            if (block.skyLightPassing == skyLightPassing) {
+                removeLights(pos.x, pos.y, pos.z, block);
+            }
+        }
+        if (!skyLightPassing) {
+            solverS->solve();
+        }
+    }
+    solverR->solve();
+    solverG->solve();
+    solverB->solve();
+
+    for (const auto& pos : positions) {
+        if (auto vox = chunks.get(pos.x, pos.y, pos.z)) {
+            addLights(pos.x, pos.y, pos.z, indices.blocks.require(vox->id));
+        }
+    }
+    solverR->solve();
+    solverG->solve();
+    solverB->solve();
+    solverS->solve();
+}
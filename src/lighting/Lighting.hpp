@@ -1,8 +1,15 @@
 #pragma once
 
+#include <memory>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include "delegates.hpp"
+#include "maths/noise_batch.hpp"
 #include "typedefs.hpp"
 
 class ContentIndices;
+class Block;
 class Chunk;
 class Chunks;
 class LightSolver;
@@ -14,14 +21,35 @@ class Lighting {
     std::unique_ptr<LightSolver> solverG;
     std::unique_ptr<LightSolver> solverB;
     std::unique_ptr<LightSolver> solverS;
+    runnable barrier;
+
+    /// @brief Queue light removal and sky light column at the changed block
+    void removeLights(int x, int y, int z, const Block& block);
+    /// @brief Queue light propagation from neighbours and block emission
+    void addLights(int x, int y, int z, const Block& block);
 public:
     Lighting(const ContentIndices& indices, Chunks& chunks);
     ~Lighting();
 
+    /// @brief Set function called before lights updates on blocks set,
+    /// used to wait for the lights being built in background
+    void setBarrier(runnable barrier) {
+        this->barrier = std::move(barrier);
+    }
+
     void clear();
     void buildSkyLight(int cx, int cz);
     void onChunkLoaded(int cx, int cz, bool expand);
     void onBlockSet(int x, int y, int z, blockid_t id);
+    /// @brief Update lights after a batch of blocks set. Light removal and
+    /// propagation are solved once for the whole batch
+    void onBlocksSet(const std::vector<glm::ivec3>& positions);
 
-    static void prebuildSkyLight(Chunk& chunk, const ContentIndices& indices);
+    /// @brief Set sky light to columns open to the sky
+    /// @param level instruction set limit (used by tests and benchmarks)
+    static void prebuildSkyLight(
+        Chunk& chunk,
+        const ContentIndices& indices,
+        noise::SimdLevel level = noise::get_simd_level()
+    );
 };
@@ -0,0 +1,81 @@
+#include "sky_light_kernels.hpp"
+
+// compiled with -mavx2 (see src/CMakeLists.txt)
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+#include "content/Content.hpp"
+
+bool lighting::detail::prebuild_sky_layer_avx2(
+    const voxel* voxels,
+    const ubyte* passing,
+    light_t* columnMasks,
+    light_t* lights,
+    bool& blocked,
+    bool& active
+) {
+    // voxel id is the low half of a 32-bit voxel
+    const __m256i idMask = _mm256_set1_epi32(0xFFFF);
+    const __m256i passingBit = _mm256_set1_epi32(BLOCK_SKY_LIGHT_PASSING_BIT);
+    const __m256i skyLight = _mm256_set1_epi16(static_cast<short>(0xF000));
+    // blocksLightPassing is padded to be read by 32-bit words at any id
+    const auto table = reinterpret_cast<const int*>(passing);
+
+    __m256i blockedMask = _mm256_setzero_si256();
+    __m256i activeMask = _mm256_setzero_si256();
+    for (int i = 0; i < LAYER_SIZE; i += 16) {
+        __m256i ids0 = _mm256_and_si256(
+            _mm256_loadu_si256(reinterpret_cast<const __m256i*>(voxels + i)),
+            idMask
+        );
+        __m256i ids1 = _mm256_and_si256(
+            _mm256_loadu_si256(
+                reinterpret_cast<const __m256i*>(voxels + i + 8)
+            ),
+            idMask
+        );
+        __m256i flags0 = _mm256_i32gather_epi32(table, ids0, 1);
+        __m256i flags1 = _mm256_i32gather_epi32(table, ids1, 1);
+        __m256i layer0 = _mm256_cmpeq_epi32(
+            _mm256_and_si256(flags0, passingBit), passingBit
+        );
+        __m256i layer1 = _mm256_cmpeq_epi32(
+            _mm256_and_si256(flags1, passingBit), passingBit
+        );
+        // pack 32-bit masks to 16-bit, packs works within 128-bit lanes
+        __m256i layer = _mm256_permute4x64_epi64(
+            _mm256_packs_epi32(layer0, layer1), _MM_SHUFFLE(3, 1, 2, 0)
+        );
+
+        auto masksPtr = reinterpret_cast<__m256i*>(columnMasks + i);
+        auto lightsPtr = reinterpret_cast<__m256i*>(lights + i);
+        __m256i mask = _mm256_loadu_si256(masksPtr);
+        __m256i passed = _mm256_and_si256(mask, layer);
+        blockedMask = _mm256_or_si256(
+            blockedMask, _mm256_andnot_si256(passed, mask)
+        );
+        activeMask = _mm256_or_si256(activeMask, passed);
+        _mm256_storeu_si256(masksPtr, passed);
+        _mm256_storeu_si256(
+            lightsPtr,
+            _mm256_or_si256(
+                _mm256_loadu_si256(lightsPtr),
+                _mm256_and_si256(passed, skyLight)
+            )
+        );
+    }
+    blocked = !_mm256_testz_si256(blockedMask, blockedMask);
+    active = !_mm256_testz_si256(activeMask, activeMask);
+    return true;
+}
+
+#else
+
+bool lighting::detail::prebuild_sky_layer_avx2(
+    const voxel*, const ubyte*, light_t*, light_t*, bool&, bool&
+) {
+    return false;
+}
+
+#endif
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "constants.hpp"
+#include "typedefs.hpp"
+#include "voxels/voxel.hpp"
+
+/// Sky light prebuild kernels processing a chunk Y-layer by 16 (AVX2) or
+/// 8 (SSE4.1) columns at once. Kernels are compiled in separate translation
+/// units with matching compiler flags, instruction set is selected at
+/// runtime (see noise::get_simd_level).
+namespace lighting::detail {
+    inline constexpr int LAYER_SIZE = CHUNK_W * CHUNK_D;
+    static_assert(LAYER_SIZE % 16 == 0);
+
+    /// @brief Pass sky light through a Y-layer of LAYER_SIZE voxels
+    /// @param voxels layer voxels
+    /// @param passing ContentIndices::blocksLightPassing
+    /// @param columnMasks 0xFFFF if sky light is still passing through the
+    /// column, 0 otherwise. Updated with the layer
+    /// @param lights layer of Lightmap::map. S channel of passed voxels is
+    /// set to 15
+    /// @param blocked set if the layer blocks sky light in any column
+    /// @param active set if sky light passes the layer in any column
+    /// @return false if the instruction set is not supported by the build
+    bool prebuild_sky_layer_sse41(
+        const voxel* voxels,
+        const ubyte* passing,
+        light_t* columnMasks,
+        light_t* lights,
+        bool& blocked,
+        bool& active
+    );
+    bool prebuild_sky_layer_avx2(
+        const voxel* voxels,
+        const ubyte* passing,
+        light_t* columnMasks,
+        light_t* lights,
+        bool& blocked,
+        bool& active
+    );
+}
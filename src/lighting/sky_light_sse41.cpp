@@ -0,0 +1,70 @@
+#include "sky_light_kernels.hpp"
+
+// compiled with -msse4.1 (see src/CMakeLists.txt)
+#if defined(__SSE4_1__) || \
+    (defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64))
+
+#include <smmintrin.h>
+
+#include "content/Content.hpp"
+
+/// @brief No gather instruction in SSE, flags are loaded one by one
+static inline __m128i load_flags(const voxel* voxels, const ubyte* passing) {
+    return _mm_setr_epi16(
+        passing[voxels[0].id],
+        passing[voxels[1].id],
+        passing[voxels[2].id],
+        passing[voxels[3].id],
+        passing[voxels[4].id],
+        passing[voxels[5].id],
+        passing[voxels[6].id],
+        passing[voxels[7].id]
+    );
+}
+
+bool lighting::detail::prebuild_sky_layer_sse41(
+    const voxel* voxels,
+    const ubyte* passing,
+    light_t* columnMasks,
+    light_t* lights,
+    bool& blocked,
+    bool& active
+) {
+    const __m128i passingBit = _mm_set1_epi16(BLOCK_SKY_LIGHT_PASSING_BIT);
+    const __m128i skyLight = _mm_set1_epi16(static_cast<short>(0xF000));
+
+    __m128i blockedMask = _mm_setzero_si128();
+    __m128i activeMask = _mm_setzero_si128();
+    for (int i = 0; i < LAYER_SIZE; i += 8) {
+        __m128i layer = _mm_cmpeq_epi16(
+            _mm_and_si128(load_flags(voxels + i, passing), passingBit),
+            passingBit
+        );
+        auto masksPtr = reinterpret_cast<__m128i*>(columnMasks + i);
+        auto lightsPtr = reinterpret_cast<__m128i*>(lights + i);
+        __m128i mask = _mm_loadu_si128(masksPtr);
+        __m128i passed = _mm_and_si128(mask, layer);
+        blockedMask = _mm_or_si128(blockedMask, _mm_andnot_si128(passed, mask));
+        activeMask = _mm_or_si128(activeMask, passed);
+        _mm_storeu_si128(masksPtr, passed);
+        _mm_storeu_si128(
+            lightsPtr,
+            _mm_or_si128(
+                _mm_loadu_si128(lightsPtr), _mm_and_si128(passed, skyLight)
+            )
+        );
+    }
+    blocked = !_mm_testz_si128(blockedMask, blockedMask);
+    active = !_mm_testz_si128(activeMask, activeMask);
+    return true;
+}
+
+#else
+
+bool lighting::detail::prebuild_sky_layer_sse41(
+    const voxel*, const ubyte*, light_t*, light_t*, bool&, bool&
+) {
+    return false;
+}
+
+#endif
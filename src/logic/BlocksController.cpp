@@ -16,8 +16,10 @@
 #include "world/World.hpp"
 #include "objects/Player.hpp"
 #include "objects/Players.hpp"
+#include "physics/PhysicsSolver.hpp"
 #include "util/random.hpp"
 
+#include <algorithm>
 #include <random>
 
 static inline constexpr int CHUNK_RANDOM_TICK_SEGMENTS = 4;
@@ -32,6 +34,9 @@ BlocksController::BlocksController(const Level& level, Lighting* lighting)
 }
 
 void BlocksController::updateSides(int x, int y, int z) {
+    level.physics->addWakeArea(
+        AABB(glm::vec3(x - 1, y - 1, z - 1), glm::vec3(x + 2, y + 2, z + 2))
+    );
     updateBlock(x - 1, y, z);
     updateBlock(x + 1, y, z);
     updateBlock(x, y - 1, z);
@@ -41,12 +46,17 @@ void BlocksController::updateSides(int x, int y, int z) {
 }
 
 void BlocksController::updateSides(int x, int y, int z, int w, int h, int d) {
-    voxel* vox = blocks_agent::get(chunks, x, y, z);
+    auto vox = blocks_agent::get(chunks, x, y, z);
     const auto& def = level.content.getIndices()->blocks.require(vox->id);
     const auto& rot = def.rotations.variants[vox->state.rotation];
     const auto& xaxis = rot.axes[0];
     const auto& yaxis = rot.axes[1];
     const auto& zaxis = rot.axes[2];
+    int size = std::max(w, std::max(h, d)) + 1;
+    level.physics->addWakeArea(AABB(
+        glm::vec3(x - size, y - size, z - size),
+        glm::vec3(x + size + 1, y + size + 1, z + size + 1)
+    ));
     for (int ly = -1; ly <= h; ly++) {
         for (int lz = -1; lz <= d; lz++) {
             for (int lx = -1; lx <= w; lx++) {
@@ -85,7 +95,7 @@ void BlocksController::placeBlock(
     Player* player, const Block& def, blockstate state, int x, int y, int z
 ) {
     auto voxel = blocks_agent::get(chunks, x, y, z);
-    if (voxel == nullptr) {
+    if (!voxel) {
         return;
     }
     const auto& prevDef = level.content.getIndices()->blocks.require(voxel->id);
@@ -107,8 +117,8 @@ void BlocksController::placeBlock(
 }
 
 void BlocksController::updateBlock(int x, int y, int z) {
-    voxel* vox = blocks_agent::get(chunks, x, y, z);
-    if (vox == nullptr) return;
+    auto vox = blocks_agent::get(chunks, x, y, z);
+    if (!vox) return;
     const auto& def = level.content.getIndices()->blocks.require(vox->id);
     if (def.grounded) {
         if (def.rt.extended) {
@@ -140,6 +150,9 @@ void BlocksController::update(float delta, uint padding) {
             onBlocksTick(blocksTickClock.convertPart(i), blocksTickClock.getParts());
         }
     }
+    blocks_agent::get_ticks_scheduler().update(
+        delta, blocksTickClock.getTickRate(), scripting::on_block_events
+    );
     if (worldTickClock.update(delta)) {
         scripting::on_world_tick(worldTickClock.getTickRate());
     }
@@ -188,7 +201,7 @@ void BlocksController::randomTick(
             int bx = index % CHUNK_W;
             int bz = (index / CHUNK_W) % CHUNK_D;
             int by = (index / (CHUNK_W * CHUNK_D)) + segmentY;
-            const voxel& vox = chunk.voxels[index + segmentY * CHUNK_W * CHUNK_D];
+            voxel vox = chunk.get(index + segmentY * CHUNK_W * CHUNK_D);
             auto& block = indices->blocks.require(vox.id);
             if (block.rt.funcsset.randupdate) {
                 scripting::random_update_block(
@@ -243,7 +256,7 @@ int64_t BlocksController::createBlockInventory(int x, int y, int z) {
     auto inv = chunk->getBlockInventory(lx, y, lz);
     if (inv == nullptr) {
         const auto& indices = level.content.getIndices()->blocks;
-        auto& def = indices.require(chunk->voxels[vox_index(lx, y, lz)].id);
+        auto& def = indices.require(chunk->get(lx, y, lz).id);
         int invsize = def.inventorySize;
         if (invsize == 0) {
             return 0;
@@ -1,7 +1,9 @@
 #include "ChunksController.hpp"
 
 #include <limits.h>
+#include <algorithm>
 #include <memory>
+#include <thread>
 
 #include "content/Content.hpp"
 #include "world/files/WorldFiles.hpp"
@@ -10,6 +12,7 @@
 #include "maths/voxmaths.hpp"
 #include "util/timeutil.hpp"
 #include "objects/Player.hpp"
+#include "objects/Players.hpp"
 #include "voxels/Block.hpp"
 #include "voxels/Chunk.hpp"
 #include "voxels/Chunks.hpp"
@@ -21,37 +24,180 @@
 
 const uint MAX_WORK_PER_FRAME = 128;
 const uint MIN_SURROUNDING = 9;
+/// @brief Max number of chunks enqueued for generation or lights building
+/// per worker
+const uint MAX_PENDING_PER_WORKER = 4;
 
-ChunksController::ChunksController(Level& level)
+class ChunkGenWorker : public util::Worker<ChunkGenJob, ChunkGenResult> {
+    const WorldGenerator& generator;
+public:
+    ChunkGenWorker(const WorldGenerator& generator) : generator(generator) {
+    }
+
+    ChunkGenResult operator()(const ChunkGenJob& job) override {
+        auto& chunk = *job.chunk;
+        generator.generate(chunk.getVoxels(), *job.prototype, chunk.x, chunk.z);
+        return ChunkGenResult {job.chunk};
+    }
+};
+
+class ChunkLightsWorker
+    : public util::Worker<ChunkLightsJob, ChunkLightsResult> {
+    /// @brief Job chunks neighbourhood. Players chunks matrices are not
+    /// used as they are modified by the main thread
+    Chunks chunks;
+    Lighting lighting;
+public:
+    ChunkLightsWorker(const ContentIndices& indices)
+        : chunks(3, 3, 0, 0, nullptr, indices), lighting(indices, chunks) {
+    }
+
+    ChunkLightsResult operator()(const ChunkLightsJob& job) override {
+        int x = job.chunks[4]->x;
+        int z = job.chunks[4]->z;
+        chunks.setCenter(x * CHUNK_W, z * CHUNK_D);
+        for (const auto& chunk : job.chunks) {
+            chunks.putChunk(chunk);
+        }
+        if (job.buildSkyLight) {
+            lighting.buildSkyLight(x, z);
+        }
+        lighting.onChunkLoaded(x, z, job.buildSkyLight);
+        for (const auto& chunk : job.chunks) {
+            chunks.remove(chunk->x, chunk->z);
+        }
+        return ChunkLightsResult {job.chunks};
+    }
+};
+
+static bool is_surrounded(const Chunks& chunks, int x, int z) {
+    int surrounding = 0;
+    for (int oz = -1; oz <= 1; oz++) {
+        for (int ox = -1; ox <= 1; ox++) {
+            if (chunks.getChunk(x + ox, z + oz)) {
+                surrounding++;
+            }
+        }
+    }
+    return surrounding == MIN_SURROUNDING;
+}
+
+/// @return false if some of the chunks is missing or locked
+static bool get_neighbourhood(
+    const Chunks& chunks, int x, int z, ChunksNeighbourhood& dst
+) {
+    const auto& area = chunks.getChunks();
+    int width = chunks.getWidth();
+    int lx = x - chunks.getOffsetX();
+    int lz = z - chunks.getOffsetY();
+    if (lx < 1 || lz < 1 || lx >= width - 1 || lz >= chunks.getHeight() - 1) {
+        return false;
+    }
+    for (int oz = -1; oz <= 1; oz++) {
+        for (int ox = -1; ox <= 1; ox++) {
+            const auto& chunk = area[(lz + oz) * width + lx + ox];
+            if (chunk == nullptr || chunk->lightsLocked) {
+                return false;
+            }
+            dst[(oz + 1) * 3 + ox + 1] = chunk;
+        }
+    }
+    return true;
+}
+
+ChunksController::ChunksController(
+    Level& level, uint generatorWorkers, uint lightingWorkers
+)
     : level(level),
       generator(std::make_unique<WorldGenerator>(
           level.content.generators.require(level.environment.generator),
           level.content,
-          level.getWorld().getSeed()
-      )) {}
+          level.getWorld().getSeed(),
+          generatorWorkers
+      )) {
+    if (generatorWorkers) {
+        generatorPool =
+            std::make_unique<util::ThreadPool<ChunkGenJob, ChunkGenResult>>(
+                "chunks-gen-pool",
+                [this]() {
+                    return std::make_unique<ChunkGenWorker>(*generator);
+                },
+                [this](ChunkGenResult&& result) {
+                    onChunkGenerated(std::move(result));
+                },
+                generatorWorkers
+            );
+    }
+    if (lightingWorkers) {
+        lightingPool = std::make_unique<
+            util::ThreadPool<ChunkLightsJob, ChunkLightsResult>>(
+            "chunks-lights-pool",
+            [this]() {
+                return std::make_unique<ChunkLightsWorker>(
+                    *this->level.content.getIndices()
+                );
+            },
+            [this](ChunkLightsResult&& result) {
+                onChunkLighted(std::move(result));
+            },
+            lightingWorkers
+        );
+        level.chunks->setBarrier([this]() { waitLights(); });
+    }
+}
+
+ChunksController::~ChunksController() {
+    if (lightingPool) {
+        level.chunks->setBarrier(nullptr);
+    }
+}
 
-ChunksController::~ChunksController() = default;
+void ChunksController::updateInterest(int loadDistance) {
+    for (const auto& [id, player] : *level.players) {
+        if (player->isSuspended() || !player->isLoadingChunks()) {
+            interest.removeArea(id);
+            continue;
+        }
+        const auto& position = player->getPosition();
+        interest.setArea(
+            id,
+            floordiv<CHUNK_W>(glm::floor(position.x)),
+            floordiv<CHUNK_D>(glm::floor(position.z)),
+            loadDistance
+        );
+    }
+    for (auto id : interest.getAreasIds()) {
+        if (level.players->get(id) == nullptr) {
+            interest.removeArea(id);
+        }
+    }
+    generator->update(interest);
+}
 
 void ChunksController::update(
     int64_t maxDuration,
-    int loadDistance,
     uint padding,
     Player& player,
     bool isLocalPlayer
-) const {
-    const auto& position = player.getPosition();
-    int centerX = floordiv<CHUNK_W>(glm::floor(position.x));
-    int centerY = floordiv<CHUNK_D>(glm::floor(position.z));
-    
-    if (player.isLoadingChunks()) {
-        /// FIXME: one generator for multiple players
-        generator->update(centerX, centerY, loadDistance);
-    } else {
+) {
+    if (generatorPool) {
+        generatorPool->pullResults();
+    }
+    if (lightingPool) {
+        lightingPool->pullResults();
+    }
+    if (!player.isLoadingChunks()) {
         return;
     }
 
     int64_t mcstotal = 0;
 
+    if (isLocalPlayer && lighting && lightingPool) {
+        timeutil::Timer timer;
+        buildLightsBatch(player, padding);
+        mcstotal += timer.stop();
+    }
+
     for (uint i = 0; i < MAX_WORK_PER_FRAME; i++) {
         timeutil::Timer timer;
         if (loadVisible(player, padding, isLocalPlayer)) {
@@ -83,79 +229,95 @@ bool ChunksController::isInLoadingZone(
 
 bool ChunksController::loadVisible(
     const Player& player, uint padding, bool isLocalPlayer
-) const {
+) {
     auto& chunks = *player.chunks;
+    auto& frontier = chunks.getFrontier();
+    const auto& cells = frontier.getCells();
+    const auto& area = chunks.getChunks();
     int sizeX = chunks.getWidth();
     int sizeY = chunks.getHeight();
 
-    int nearX = 0;
-    int nearZ = 0;
-    bool assigned = false;
-    int minDistance = ((sizeX - padding * 2) / 2) * ((sizeY - padding * 2) / 2);
-    int maxDistance = ((sizeX) / 2) * ((sizeY) / 2);
-    for (uint z = 0; z < sizeY; z++) {
-        for (uint x = 0; x < sizeX; x++) {
-            int index = z * sizeX + x;
-            int lx = x - sizeX / 2;
-            int lz = z - sizeY / 2;
-            int distance = (lx * lx + lz * lz);
-            auto& chunk = chunks.getChunks()[index];
-            if (chunk != nullptr) {
-                if (distance >= maxDistance) {
-                    chunks.remove(
-                        x + chunks.getOffsetX(), z + chunks.getOffsetY()
-                    );
-                }
-                continue;
+    if (frontier.trimRequired) {
+        int maxDistance = frontier.getTrimDistance();
+        for (auto it = cells.rbegin();
+             it != cells.rend() && it->distance >= maxDistance;
+             ++it) {
+            if (area[it->index] != nullptr) {
+                chunks.remove(
+                    it->x + chunks.getOffsetX(), it->z + chunks.getOffsetY()
+                );
             }
         }
+        frontier.trimRequired = false;
     }
-    for (uint z = padding; z < sizeY - padding; z++) {
-        for (uint x = padding; x < sizeX - padding; x++) {
-            int index = z * sizeX + x;
-            int lx = x - sizeX / 2;
-            int lz = z - sizeY / 2;
-            int distance = (lx * lx + lz * lz);
-            auto& chunk = chunks.getChunks()[index];
-            if (chunk != nullptr) {
-                if (chunk->flags.loaded && !chunk->flags.lighted) {
-                    if (isLocalPlayer && buildLights(player, chunk)) {
-                        return true;
-                    }
+
+    int minDistance = ((sizeX - padding * 2) / 2) * ((sizeY - padding * 2) / 2);
+    if (isLocalPlayer && lightingPool == nullptr) {
+        bool advance = true;
+        for (size_t i = frontier.lightsCursor; i < cells.size(); i++) {
+            const auto& cell = cells[i];
+            if (cell.distance >= minDistance) {
+                break;
+            }
+            const auto& chunk = area[cell.index];
+            if (chunk == nullptr || chunk->flags.lighted) {
+                if (advance) {
+                    frontier.lightsCursor = i + 1;
                 }
                 continue;
             }
-
-            if (distance < minDistance) {
-                minDistance = distance;
-                nearX = x;
-                nearZ = z;
-                assigned = true;
+            advance = false;
+            if (chunk->flags.loaded && buildLights(player, chunk)) {
+                return true;
             }
         }
     }
 
-    const auto& chunk = chunks.getChunks()[nearZ * sizeX + nearX];
-    if (chunk != nullptr || !assigned || !player.isLoadingChunks()) {
+    std::vector<glm::ivec2> batch;
+    bool advance = true;
+    for (size_t i = frontier.loadCursor; i < cells.size(); i++) {
+        const auto& cell = cells[i];
+        if (cell.distance >= minDistance) {
+            break;
+        }
+        if (area[cell.index] != nullptr) {
+            if (advance) {
+                frontier.loadCursor = i + 1;
+            }
+            continue;
+        }
+        advance = false;
+        int x = cell.x + chunks.getOffsetX();
+        int z = cell.z + chunks.getOffsetY();
+        if (!pendingChunks.empty() &&
+            pendingChunks.find(glm::ivec2(x, z)) != pendingChunks.end()) {
+            continue;
+        }
+        if (!player.isLoadingChunks()) {
+            return false;
+        }
+        if (generatorPool == nullptr) {
+            createChunk(player, x, z);
+            return true;
+        }
+        // nearest chunks fitting into the pool are created at once
+        if (pendingChunks.size() + batch.size() >=
+            generatorPool->getWorkersCount() * MAX_PENDING_PER_WORKER) {
+            break;
+        }
+        batch.emplace_back(x, z);
+    }
+    if (batch.empty()) {
         return false;
     }
-    int offsetX = chunks.getOffsetX();
-    int offsetY = chunks.getOffsetY();
-    createChunk(player, nearX + offsetX, nearZ + offsetY);
+    createChunks(player, batch);
     return true;
 }
 
 bool ChunksController::buildLights(
     const Player& player, const std::shared_ptr<Chunk>& chunk
 ) const {
-    int surrounding = 0;
-    for (int oz = -1; oz <= 1; oz++) {
-        for (int ox = -1; ox <= 1; ox++) {
-            if (player.chunks->getChunk(chunk->x + ox, chunk->z + oz))
-                surrounding++;
-        }
-    }
-    if (surrounding == MIN_SURROUNDING) {
+    if (is_surrounded(*player.chunks, chunk->x, chunk->z)) {
         if (lighting && chunk->lightmap) {
             bool lightsCache = chunk->flags.loadedLights;
             if (!lightsCache) {
@@ -169,7 +331,76 @@ bool ChunksController::buildLights(
     return false;
 }
 
-void ChunksController::createChunk(const Player& player, int x, int z) const {
+size_t ChunksController::buildLightsBatch(const Player& player, uint padding) {
+    auto& chunks = *player.chunks;
+    int sizeX = chunks.getWidth();
+    int sizeY = chunks.getHeight();
+    int minDistance = ((sizeX - padding * 2) / 2) * ((sizeY - padding * 2) / 2);
+
+    auto& frontier = chunks.getFrontier();
+    const auto& cells = frontier.getCells();
+    const auto& area = chunks.getChunks();
+
+    size_t maxJobs = lightingPool->getWorkersCount() * MAX_PENDING_PER_WORKER;
+    size_t enqueued = 0;
+    bool advance = true;
+    for (size_t i = frontier.lightsCursor; i < cells.size(); i++) {
+        if (lightsJobs >= maxJobs || cells[i].distance >= minDistance) {
+            break;
+        }
+        const auto& chunk = area[cells[i].index];
+        if (chunk == nullptr || chunk->flags.lighted) {
+            if (advance) {
+                frontier.lightsCursor = i + 1;
+            }
+            continue;
+        }
+        advance = false;
+        ChunkLightsJob job {{}, !chunk->flags.loadedLights};
+        // neighbourhoods of the jobs in progress are locked, so jobs never
+        // overlap
+        if (!chunk->flags.loaded ||
+            !get_neighbourhood(chunks, chunk->x, chunk->z, job.chunks)) {
+            continue;
+        }
+        if (chunk->lightmap == nullptr) {
+            chunk->flags.lighted = true;
+            continue;
+        }
+        for (const auto& neighbour : job.chunks) {
+            neighbour->lightsLocked = true;
+            // voxels are unpacked now as the main thread must not change
+            // voxels storage of locked chunks
+            neighbour->getVoxels();
+        }
+        lightingPool->enqueueJob(std::move(job));
+        lightsJobs++;
+        enqueued++;
+    }
+    return enqueued;
+}
+
+void ChunksController::onChunkLighted(ChunkLightsResult&& result) {
+    lightsJobs--;
+    for (const auto& chunk : result.chunks) {
+        chunk->lightsLocked = false;
+        // meshes of locked chunks were not built while the worker was
+        // modifying lights
+        chunk->setModified();
+    }
+    result.chunks[4]->flags.lighted = true;
+}
+
+void ChunksController::waitLights() {
+    while (lightsJobs) {
+        lightingPool->pullResults();
+        if (lightsJobs) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void ChunksController::createChunk(const Player& player, int x, int z) {
     if (!player.isLoadingChunks()) {
         if (auto chunk = level.chunks->fetch(x, z)) {
             player.chunks->putChunk(chunk);
@@ -178,15 +409,80 @@ void ChunksController::createChunk(const Player& player, int x, int z) const {
     }
     auto chunk = level.chunks->create(x, z, lighting != nullptr);
     player.chunks->putChunk(chunk);
-    auto& chunkFlags = chunk->flags;
-    if (!chunkFlags.loaded) {
-        generator->generate(chunk->voxels, x, z);
-        chunkFlags.unsaved = true;
-    }
-    chunk->updateHeights();
-    level.events->trigger(LevelEventType::CHUNK_PRESENT, chunk.get());
-    if (!chunkFlags.loadedLights && chunk->lightmap) {
-        Lighting::prebuildSkyLight(*chunk, *level.content.getIndices());
+    if (!chunk->flags.loaded) {
+        generator->generate(chunk->getVoxels(), x, z);
+        chunk->flags.unsaved = true;
+    }
+    finishChunk(*chunk);
+}
+
+void ChunksController::createChunks(
+    const Player& player, const std::vector<glm::ivec2>& positions
+) {
+    std::vector<std::shared_ptr<Chunk>> generated;
+    std::vector<glm::ivec2> prototypes;
+    for (const auto& pos : positions) {
+        auto chunk = level.chunks->create(pos.x, pos.y, lighting != nullptr);
+        if (chunk->flags.loaded) {
+            player.chunks->putChunk(chunk);
+            finishChunk(*chunk);
+            continue;
+        }
+        // hide the chunk until its voxels are generated
+        level.chunks->erase(pos.x, pos.y);
+        pendingChunks.insert(pos);
+        generated.push_back(std::move(chunk));
+        prototypes.push_back(pos);
+    }
+    // prototype levels of the batch are generated in parallel
+    try {
+        generator->complete(prototypes);
+    } catch (...) {
+        // hidden chunks are created again by the next update
+        for (const auto& pos : prototypes) {
+            pendingChunks.erase(pos);
+        }
+        throw;
+    }
+    for (auto& chunk : generated) {
+        auto prototype = generator->prepare(chunk->x, chunk->z);
+        generatorPool->enqueueJob(
+            ChunkGenJob {std::move(chunk), std::move(prototype)}
+        );
+    }
+}
+
+void ChunksController::onChunkGenerated(ChunkGenResult&& result) {
+    auto& chunk = result.chunk;
+    int x = chunk->x;
+    int z = chunk->z;
+    pendingChunks.erase({x, z});
+
+    if (!interest.isDemanded(x, z) || level.chunks->fetch(x, z)) {
+        return;
+    }
+    level.chunks->putChunk(chunk);
+    // show the chunk to all players interested in it at once
+    bool shown = false;
+    for (const auto& [_, player] : *level.players) {
+        if (player->isLoadingChunks()) {
+            shown |= player->chunks->putChunk(chunk);
+        }
+    }
+    if (!shown) {
+        level.chunks->erase(x, z);
+        return;
+    }
+    chunk->flags.unsaved = true;
+    finishChunk(*chunk);
+}
+
+void ChunksController::finishChunk(Chunk& chunk) {
+    auto& chunkFlags = chunk.flags;
+    chunk.updateHeights();
+    level.events->trigger(LevelEventType::CHUNK_PRESENT, &chunk);
+    if (!chunkFlags.loadedLights && chunk.lightmap) {
+        Lighting::prebuildSkyLight(chunk, *level.content.getIndices());
     }
     chunkFlags.loaded = true;
     chunkFlags.ready = true;
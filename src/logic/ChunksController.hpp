@@ -1,8 +1,16 @@
 #pragma once
 
+#include <array>
 #include <memory>
+#include <unordered_set>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
 
 #include "typedefs.hpp"
+#include "util/ThreadPool.hpp"
+#include "voxels/ChunksInterest.hpp"
 
 class Level;
 class Chunk;
@@ -10,34 +18,107 @@ class Chunks;
 class Player;
 class Lighting;
 class WorldGenerator;
+struct ChunkPrototype;
+
+struct ChunkGenJob {
+    /// @brief Target chunk, not available for others until generated
+    std::shared_ptr<Chunk> chunk;
+    /// @brief Prepared prototype copy (see WorldGenerator::prepare)
+    std::shared_ptr<ChunkPrototype> prototype;
+};
+
+struct ChunkGenResult {
+    std::shared_ptr<Chunk> chunk;
+};
+
+/// @brief 3x3 chunks neighbourhood, the target chunk is in the centre
+using ChunksNeighbourhood = std::array<std::shared_ptr<Chunk>, 9>;
+
+struct ChunkLightsJob {
+    /// @brief Target chunk and its neighbours, locked until the job result
+    /// is processed (see Chunk::lightsLocked)
+    ChunksNeighbourhood chunks;
+    /// @brief Build sky light before lights propagation (no lights cache)
+    bool buildSkyLight;
+};
+
+struct ChunkLightsResult {
+    ChunksNeighbourhood chunks;
+};
 
 /// @brief ChunksController manages chunks dynamic loading/unloading
 class ChunksController {
 private:
     Level& level;
     std::unique_ptr<WorldGenerator> generator;
+    /// @brief Merged load areas of all players
+    ChunksInterest interest;
+    /// @brief Chunks voxels generation pool. nullptr if chunks are generated
+    /// in the main thread. Only the voxels stage runs in the pool:
+    /// prototypes are completed by the main thread before a job is
+    /// enqueued (see WorldGenerator::complete)
+    std::unique_ptr<util::ThreadPool<ChunkGenJob, ChunkGenResult>> generatorPool;
+    /// @brief Chunks being generated in the generator pool
+    std::unordered_set<glm::ivec2> pendingChunks;
+    /// @brief Lights building pool. nullptr if lights are built in the
+    /// main thread
+    std::unique_ptr<util::ThreadPool<ChunkLightsJob, ChunkLightsResult>>
+        lightingPool;
+    /// @brief Number of lights building jobs not processed yet
+    size_t lightsJobs = 0;
 
     /// @brief Process one chunk: load it or calculate lights for it
-    bool loadVisible(const Player& player, uint padding, bool isLocalPlayer) const;
+    bool loadVisible(const Player& player, uint padding, bool isLocalPlayer);
     bool buildLights(const Player& player, const std::shared_ptr<Chunk>& chunk) const;
-    void createChunk(const Player& player, int x, int y) const;
+    /// @brief Enqueue lights building for the nearest chunks. Chunks with
+    /// overlapping 3x3 neighbourhoods are never processed at the same time.
+    /// Results are processed on the next updates
+    /// @return number of jobs enqueued
+    size_t buildLightsBatch(const Player& player, uint padding);
+    void createChunk(const Player& player, int x, int y);
+    /// @brief Create chunks, enqueue not saved ones for generation.
+    /// Prototypes of the whole batch are completed at once
+    void createChunks(
+        const Player& player, const std::vector<glm::ivec2>& positions
+    );
+    /// @brief Make loaded or generated chunk available
+    void finishChunk(Chunk& chunk);
+    void onChunkGenerated(ChunkGenResult&& result);
+    void onChunkLighted(ChunkLightsResult&& result);
 public:
     std::unique_ptr<Lighting> lighting;
 
-    ChunksController(Level& level);
+    /// @param generatorWorkers number of chunks generation threads,
+    /// 0 - generate chunks in the main thread
+    /// @param lightingWorkers number of lights building threads,
+    /// 0 - build lights in the main thread
+    ChunksController(
+        Level& level, uint generatorWorkers = 0, uint lightingWorkers = 0
+    );
     ~ChunksController();
 
+    /// @brief Update chunks demand by load areas of all players and move
+    /// the generator prototypes areas. Called once per frame before update
+    void updateInterest(int loadDistance);
+
     /// @param maxDuration milliseconds reserved for chunks loading
     void update(
         int64_t maxDuration,
-        int loadDistance,
         uint padding,
         Player& player,
         bool isLocalPlayer
-    ) const;
+    );
+
+    /// @brief Wait for the lights building jobs in progress. Must be called
+    /// before the main thread modifies lights or voxels of locked chunks
+    void waitLights();
 
     bool isInLoadingZone(const Player& player, uint padding, int x, int z) const;
 
+    const ChunksInterest& getInterest() const {
+        return interest;
+    }
+
     const WorldGenerator* getGenerator() const {
         return generator.get();
     }
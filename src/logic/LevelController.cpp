@@ -12,7 +12,9 @@
 #include "objects/Players.hpp"
 #include "objects/Player.hpp"
 #include "physics/Hitbox.hpp"
+#include "physics/PhysicsSolver.hpp"
 #include "voxels/Chunks.hpp"
+#include "voxels/GlobalChunks.hpp"
 #include "voxels/Pathfinding.hpp"
 #include "scripting/scripting.hpp"
 #include "lighting/Lighting.hpp"
@@ -20,16 +22,26 @@
 #include "world/LevelEvents.hpp"
 #include "world/Level.hpp"
 #include "world/World.hpp"
+#include "interfaces/Task.hpp"
 
 static debug::Logger logger("level-control");
 
+/// @brief Max number of chunks voxels packed per update
+const uint MAX_PACKED_PER_UPDATE = 8;
+/// @brief Max number of chunks checked for packing per update
+const uint MAX_PACK_CHECKED_PER_UPDATE = 256;
+
 LevelController::LevelController(
     Engine& engine, std::unique_ptr<Level> levelPtr, Player* clientPlayer
 )
     : engine(engine),
       settings(engine.getSettings()),
       level(std::move(levelPtr)),
-      chunks(std::make_unique<ChunksController>(*level)),
+      chunks(std::make_unique<ChunksController>(
+          *level,
+          settings.chunks.generatorWorkers.get(),
+          settings.chunks.lightingWorkers.get()
+      )),
       playerTickClock(20, 3),
       clientPlayer(clientPlayer) {
     
@@ -44,16 +56,28 @@ LevelController::LevelController(
         chunks->lighting = std::make_unique<Lighting>(
             *level->content.getIndices(), *clientPlayer->chunks
         );
+        chunks->lighting->setBarrier([controller = chunks.get()]() {
+            controller->waitLights();
+        });
     }
     blocks = std::make_unique<BlocksController>(
         *level, chunks ? chunks->lighting.get() : nullptr
     );
+    // steps are done on the main thread, so workers are replaced between
+    // steps
+    physicsWorkersObserver = settings.physics.workers.observe(
+        [physics = level->physics.get()](auto workers) {
+            physics->setWorkers(workers);
+        },
+        true
+    );
     scripting::on_world_load(this);
 
     // TODO: do something to players added later
     int confirmed;
     do {
         confirmed = 0;
+        chunks->updateInterest(1);
         for (const auto& [_, player] : *level->players) {
             if (!player->isLoadingChunks()) {
                 confirmed++;
@@ -63,7 +87,7 @@ LevelController::LevelController(
             player->chunks->configure(
                 std::floor(position.x), std::floor(position.z), 1
             );
-            chunks->update(16, 1, 0, *player, player.get() == clientPlayer);
+            chunks->update(16, 0, *player, player.get() == clientPlayer);
             if (player->chunks->get(
                     std::floor(position.x), 0, std::floor(position.z)
                 )) {
@@ -73,10 +97,37 @@ LevelController::LevelController(
     } while (confirmed < level->players->size());
 }
 
+LevelController::~LevelController() {
+    try {
+        waitForSave();
+    } catch (const std::exception& err) {
+        logger.error() << "world saving failed: " << err.what();
+    }
+}
+
+void LevelController::waitForSave() {
+    if (saveTask) {
+        auto task = std::move(saveTask);
+        task->waitForEnd();
+    }
+}
+
 void LevelController::update(float delta, bool pause) {
+    if (saveTask) {
+        try {
+            saveTask->update();
+            if (!saveTask->isActive()) {
+                saveTask = nullptr;
+            }
+        } catch (const std::exception& err) {
+            logger.error() << "world saving failed: " << err.what();
+            saveTask = nullptr;
+        }
+    }
     level->pathfinding->performAllAsync(
         settings.pathfinding.stepsPerAsyncAgent.get()
     );
+    chunks->updateInterest(settings.chunks.loadDistance.get());
     for (const auto& [_, player] : *level->players) {
         if (player->isSuspended()) {
             continue;
@@ -90,13 +141,17 @@ void LevelController::update(float delta, bool pause) {
         );
         chunks->update(
             settings.chunks.loadSpeed.get(),
-            settings.chunks.loadDistance.get(),
             settings.chunks.padding.get(),
             *player,
             player.get() == clientPlayer
         );
         player->updateEntity();
     }
+    if (settings.chunks.packVoxels.get()) {
+        level->chunks->packIdle(
+            MAX_PACKED_PER_UPDATE, MAX_PACK_CHECKED_PER_UPDATE
+        );
+    }
     if (!pause) {
         blocks->update(delta, settings.chunks.padding.get());
         level->entities->update(delta);
@@ -139,17 +194,24 @@ void LevelController::processBeforeQuit() {
     scripting::process_before_quit();
 }
 
-void LevelController::saveWorld() {
+void LevelController::saveWorld(bool async) {
     auto& world = level->getWorld();
     if (world.isNameless()) {
         logger.info() << "nameless world will not be saved";
         return;
     }
+    // regions must be written in order
+    waitForSave();
+
     logger.info() << "writing world '" << world.getName() << "'";
     world.wfile->createDirectories();
     scripting::on_world_save();
     level->onSave();
-    level->getWorld().write(*level);
+    if (async) {
+        saveTask = world.writeAsync(*level);
+    } else {
+        world.write(*level);
+    }
 }
 
 void LevelController::onWorldQuit() {
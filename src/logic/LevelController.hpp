@@ -6,8 +6,10 @@
 #include "ChunksController.hpp"
 #include "util/Clock.hpp"
 #include "util/CallbacksSet.hpp"
+#include "util/observer_handler.hpp"
 
 class Engine;
+class Task;
 class Level;
 class Player;
 struct EngineSettings;
@@ -24,17 +26,29 @@ class LevelController {
     util::Clock playerTickClock;
 
     Player* clientPlayer;
+
+    /// @brief Background world saving task
+    std::shared_ptr<Task> saveTask;
+
+    /// @brief Applies physics workers setting changes to the level
+    ObserverHandler physicsWorkersObserver;
+
+    void waitForSave();
 public:
     CallbacksSet<> preQuitCallbacks;
 
     LevelController(Engine& engine, std::unique_ptr<Level> level, Player* clientPlayer);
+    ~LevelController();
 
     /// @param delta time elapsed since the last update
     /// @param pause is world and player simulation paused
     void update(float delta, bool pause);
 
     void processBeforeQuit();
-    void saveWorld();
+
+    /// @param async compress and write regions in a background thread.
+    /// Synchronous saving waits for the previous background saving to end
+    void saveWorld(bool async = false);
 
     void onWorldQuit();
 
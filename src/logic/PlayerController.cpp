@@ -358,7 +358,7 @@ static int determine_rotation(
     return 0;
 }
 
-voxel* PlayerController::updateSelection(float maxDistance) {
+std::optional<voxel> PlayerController::updateSelection(float maxDistance) {
     auto indices = level.content.getIndices();
     auto& chunks = *player.chunks;
     auto camera = player.fpCamera.get();
@@ -367,7 +367,7 @@ voxel* PlayerController::updateSelection(float maxDistance) {
     glm::vec3 end;
     glm::ivec3 iend;
     glm::ivec3 norm;
-    voxel* vox = chunks.rayCast(
+    auto vox = chunks.rayCast(
         camera->position,
         camera->front,
         maxDistance,
@@ -408,9 +408,9 @@ voxel* PlayerController::updateSelection(float maxDistance) {
             }
         }
     }
-    if (vox == nullptr || selection.entity) {
+    if (!vox || selection.entity) {
         selection.vox = {BLOCK_VOID, {}};
-        return nullptr;
+        return std::nullopt;
     }
     blockstate selectedState = vox->state;
     selection.vox = *vox;
@@ -466,7 +466,7 @@ void PlayerController::processRightClick(
         }
     }
     auto vox = chunks.get(coord);
-    if (vox == nullptr) {
+    if (!vox) {
         return;
     }
     if (!chunks.checkReplaceability(def, state, coord)) {
@@ -532,7 +532,7 @@ void PlayerController::updateInteraction(const Input& inputEvents, float delta)
     auto& item = indices->items.require(stack.getItemId());
 
     auto vox = updateSelection(maxDistance);
-    if (vox == nullptr) {
+    if (!vox) {
         if (rclick && item.rt.funcsset.on_use) {
             scripting::on_item_use(&player, item);
         }
@@ -2,6 +2,7 @@
 
 #include <glm/glm.hpp>
 #include <memory>
+#include <optional>
 #include <vector>
 
 #include "objects/Player.hpp"
@@ -71,7 +72,7 @@ class PlayerController {
     void updateFootsteps(float delta);
     void processRightClick(const Block& def, const Block& target);
 
-    voxel* updateSelection(float maxDistance);
+    std::optional<voxel> updateSelection(float maxDistance);
 public:
     PlayerController(
         const EngineSettings& settings,
@@ -40,7 +40,9 @@ static int l_get_size(lua::State* L) {
 
 static int l_set_size(lua::State* L) {
     if (auto entity = get_entity(L, 1)) {
-        entity->getRigidbody().hitbox.halfsize = lua::tovec3(L, 2) * 0.5f;
+        auto& hitbox = entity->getRigidbody().hitbox;
+        hitbox.halfsize = lua::tovec3(L, 2) * 0.5f;
+        hitbox.wakeUp();
     }
     return 0;
 }
@@ -60,6 +62,7 @@ static int l_set_gravity_scale(lua::State* L) {
         } else {
             hitbox.gravityScale = lua::tonumber(L, 2);
         }
+        hitbox.wakeUp();
     }
     return 0;
 }
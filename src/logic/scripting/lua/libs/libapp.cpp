@@ -297,7 +297,7 @@ static int l_save_world(lua::State* L) {
     if (controller == nullptr) {
         throw std::runtime_error("no world open");
     }
-    controller->saveWorld();
+    controller->saveWorld(true);
     return 0;
 }
 
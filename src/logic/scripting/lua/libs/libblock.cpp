@@ -90,7 +90,7 @@ static int l_is_segment(lua::State* L) {
     auto x = lua::tointeger(L, 1);
     auto y = lua::tointeger(L, 2);
     auto z = lua::tointeger(L, 3);
-    const auto& vox = blocks_agent::require(*require_level().chunks, x, y, z);
+    auto vox = blocks_agent::require(*require_level().chunks, x, y, z);
     return lua::pushboolean(L, vox.state.segment);
 }
 
@@ -99,7 +99,7 @@ static int l_seek_origin(lua::State* L) {
     auto y = lua::tointeger(L, 2);
     auto z = lua::tointeger(L, 3);
     const auto& level = require_level();
-    const auto& vox = blocks_agent::require(*level.chunks, x, y, z);
+    auto vox = blocks_agent::require(*level.chunks, x, y, z);
     const auto& def = indices->blocks.require(vox.id);
     return lua::pushivec_stack(
         L, blocks_agent::seek_origin(*level.chunks, {x, y, z}, def, vox.state)
@@ -141,7 +141,7 @@ static int l_get(lua::State* L) {
     auto y = lua::tointeger(L, 2);
     auto z = lua::tointeger(L, 3);
     auto vox = blocks_agent::get(*require_level().chunks, x, y, z);
-    int id = vox == nullptr ? -1 : vox->id;
+    int id = vox ? vox->id : -1;
     return lua::pushinteger(L, id);
 }
 
@@ -166,7 +166,7 @@ static int get_axis(lua::State* L) {
     defAxis[n] = 1;
 
     auto vox = blocks_agent::get(*level.chunks, x, y, z);
-    if (vox == nullptr) {
+    if (!vox) {
         return lua::pushivec_stack(L, defAxis);
     }
     const auto& def = level.content.getIndices()->blocks.require(vox->id);
@@ -194,7 +194,7 @@ static int l_get_rotation(lua::State* L) {
     auto y = lua::tointeger(L, 2);
     auto z = lua::tointeger(L, 3);
     auto vox = blocks_agent::get(*require_level().chunks, x, y, z);
-    int rotation = vox == nullptr ? 0 : vox->state.rotation;
+    int rotation = vox ? vox->state.rotation : 0;
     return lua::pushinteger(L, rotation);
 }
 
@@ -212,7 +212,7 @@ static int l_get_states(lua::State* L) {
     auto y = lua::tointeger(L, 2);
     auto z = lua::tointeger(L, 3);
     auto vox = blocks_agent::get(*require_level().chunks, x, y, z);
-    int states = vox == nullptr ? 0 : blockstate2int(vox->state);
+    int states = vox ? blockstate2int(vox->state) : 0;
     return lua::pushinteger(L, states);
 }
 
@@ -232,11 +232,206 @@ static int l_set_states(lua::State* L) {
     }
     int lx = x - cx * CHUNK_W;
     int lz = z - cz * CHUNK_D;
-    chunk->voxels[vox_index(lx, y, lz)].state = int2blockstate(states);
+    uint index = vox_index(lx, y, lz);
+    require_level().chunks->waitWorkers();
+    chunk->set(index, {chunk->get(index).id, int2blockstate(states)});
     chunk->setModifiedAndUnsaved();
     return 0;
 }
 
+/// @brief Max number of voxels in region processed by bulk functions
+static constexpr int64_t MAX_REGION_VOLUME = 1 << 24;
+/// @brief Region voxel is encoded as little-endian uint16 id and uint16
+/// states, voxels are ordered as in vox_index (x, then z, then y)
+static constexpr size_t REGION_VOXEL_SIZE = 4;
+
+static glm::ivec3 require_region_size(lua::State* L, int idx) {
+    glm::ivec3 size(
+        lua::tointeger(L, idx),
+        lua::tointeger(L, idx + 1),
+        lua::tointeger(L, idx + 2)
+    );
+    if (size.x <= 0 || size.y <= 0 || size.z <= 0 ||
+        static_cast<int64_t>(size.x) * size.y * size.z > MAX_REGION_VOLUME) {
+        throw lua::luaerror("invalid region size");
+    }
+    return size;
+}
+
+/// @brief Update lights of blocks set by a region operation in one batch
+static void update_lights(const std::vector<glm::ivec3>& positions) {
+    auto chunksController = controller->getChunksController();
+    if (chunksController && chunksController->lighting) {
+        chunksController->lighting->onBlocksSet(positions);
+    }
+}
+
+/// @brief Call func(vox, x, y, z) for every loaded voxel of the region
+/// looking up each chunk once
+template <typename Func>
+static void foreach_region_voxel(
+    const GlobalChunks& chunks,
+    const glm::ivec3& pos,
+    const glm::ivec3& size,
+    const Func& func
+) {
+    int y1 = std::max(pos.y, 0);
+    int y2 = std::min(pos.y + size.y, CHUNK_H);
+    int scx = floordiv<CHUNK_W>(pos.x);
+    int scz = floordiv<CHUNK_D>(pos.z);
+    int ecx = floordiv<CHUNK_W>(pos.x + size.x - 1);
+    int ecz = floordiv<CHUNK_D>(pos.z + size.z - 1);
+    for (int cz = scz; cz <= ecz; cz++) {
+        for (int cx = scx; cx <= ecx; cx++) {
+            auto chunk = blocks_agent::get_chunk(chunks, cx, cz);
+            if (chunk == nullptr) {
+                continue;
+            }
+            int x1 = std::max(pos.x, cx * CHUNK_W);
+            int x2 = std::min(pos.x + size.x, (cx + 1) * CHUNK_W);
+            int z1 = std::max(pos.z, cz * CHUNK_D);
+            int z2 = std::min(pos.z + size.z, (cz + 1) * CHUNK_D);
+            for (int y = y1; y < y2; y++) {
+                for (int z = z1; z < z2; z++) {
+                    for (int x = x1; x < x2; x++) {
+                        auto vox = chunk->get(
+                            x - cx * CHUNK_W, y, z - cz * CHUNK_D
+                        );
+                        func(vox, x, y, z);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/// @brief block.get_region(x, y, z, w, h, d) -> Bytearray
+static int l_get_region(lua::State* L) {
+    glm::ivec3 pos(
+        lua::tointeger(L, 1), lua::tointeger(L, 2), lua::tointeger(L, 3)
+    );
+    auto size = require_region_size(L, 4);
+
+    std::vector<ubyte> bytes(
+        static_cast<size_t>(size.x) * size.y * size.z * REGION_VOXEL_SIZE,
+        0xFF  // BLOCK_VOID for not loaded voxels
+    );
+    foreach_region_voxel(
+        *require_level().chunks,
+        pos,
+        size,
+        [&bytes, &pos, &size](const voxel& vox, int x, int y, int z) {
+            size_t index = vox_index(
+                x - pos.x, y - pos.y, z - pos.z, size.x, size.z
+            ) * REGION_VOXEL_SIZE;
+            blockstate_t states = blockstate2int(vox.state);
+            bytes[index] = vox.id & 0xFF;
+            bytes[index + 1] = vox.id >> 8;
+            bytes[index + 2] = states & 0xFF;
+            bytes[index + 3] = states >> 8;
+        }
+    );
+    return lua::create_bytearray(L, std::move(bytes));
+}
+
+static void update_sides(const std::vector<glm::ivec3>& positions) {
+    for (const auto& pos : positions) {
+        blocks->updateSides(pos.x, pos.y, pos.z);
+    }
+}
+
+/// @brief block.set_region(x, y, z, w, h, d, data, noupdate=false) -> int
+static int l_set_region(lua::State* L) {
+    glm::ivec3 pos(
+        lua::tointeger(L, 1), lua::tointeger(L, 2), lua::tointeger(L, 3)
+    );
+    auto size = require_region_size(L, 4);
+    // copied as the view may be invalidated by Lua GC
+    std::string data(lua::bytearray_as_string(L, 7));
+    bool noupdate = lua::toboolean(L, 8);
+    if (data.size() <
+        static_cast<size_t>(size.x) * size.y * size.z * REGION_VOXEL_SIZE) {
+        throw lua::luaerror("region data is too small");
+    }
+    auto& level = require_level();
+    size_t count = require_content().getIndices()->blocks.count();
+    auto bytes = reinterpret_cast<const ubyte*>(data.data());
+
+    std::vector<glm::ivec3> changed;
+    foreach_region_voxel(
+        *level.chunks,
+        pos,
+        size,
+        [&](const voxel& vox, int x, int y, int z) {
+            size_t index = vox_index(
+                x - pos.x, y - pos.y, z - pos.z, size.x, size.z
+            ) * REGION_VOXEL_SIZE;
+            blockid_t id = bytes[index] | bytes[index + 1] << 8;
+            blockstate_t states = bytes[index + 2] | bytes[index + 3] << 8;
+            auto state = int2blockstate(states);
+            // segments are restored by extended blocks origins
+            if (id >= count || state.segment ||
+                (vox.id == id && blockstate2int(vox.state) == states)) {
+                return;
+            }
+            if (blocks_agent::set(*level.chunks, x, y, z, id, state)) {
+                changed.emplace_back(x, y, z);
+            }
+        }
+    );
+    update_lights(changed);
+    if (!noupdate) {
+        update_sides(changed);
+    }
+    return lua::pushinteger(L, changed.size());
+}
+
+/// @brief block.fill(x, y, z, w, h, d, id, states=0, replace=nil) -> int
+static int l_fill(lua::State* L) {
+    glm::ivec3 pos(
+        lua::tointeger(L, 1), lua::tointeger(L, 2), lua::tointeger(L, 3)
+    );
+    auto size = require_region_size(L, 4);
+    auto id = lua::tointeger(L, 7);
+    auto states = static_cast<blockstate_t>(lua::tointeger(L, 8));
+    bool replaceOnly = !lua::isnoneornil(L, 9);
+    auto replaced = replaceOnly ? lua::tointeger(L, 9) : 0;
+    bool noupdate = lua::toboolean(L, 10);
+
+    auto& level = require_level();
+    auto& indices = require_content().getIndices()->blocks;
+    if (static_cast<size_t>(id) >= indices.count()) {
+        return lua::pushinteger(L, 0);
+    }
+    // segments of placed extended blocks would be overwritten by the
+    // following voxels
+    if (indices.require(id).rt.extended) {
+        throw lua::luaerror("extended blocks are not supported by block.fill");
+    }
+    auto state = int2blockstate(states);
+
+    std::vector<glm::ivec3> changed;
+    foreach_region_voxel(
+        *level.chunks,
+        pos,
+        size,
+        [&](const voxel& vox, int x, int y, int z) {
+            if ((replaceOnly && vox.id != replaced) ||
+                (vox.id == id && blockstate2int(vox.state) == states)) {
+                return;
+            }
+            if (blocks_agent::set(*level.chunks, x, y, z, id, state)) {
+                changed.emplace_back(x, y, z);
+            }
+        }
+    );
+    update_lights(changed);
+    if (!noupdate) {
+        update_sides(changed);
+    }
+    return lua::pushinteger(L, changed.size());
+}
+
 static int l_get_user_bits(lua::State* L) {
     auto x = lua::tointeger(L, 1);
     auto y = lua::tointeger(L, 2);
@@ -247,7 +442,7 @@ static int l_get_user_bits(lua::State* L) {
 
     auto& level = require_level();
     auto vox = blocks_agent::get(*level.chunks, x, y, z);
-    if (vox == nullptr) {
+    if (!vox) {
         return lua::pushinteger(L, 0);
     }
     const auto& def = level.content.getIndices()->blocks.require(vox->id);
@@ -256,7 +451,7 @@ static int l_get_user_bits(lua::State* L) {
             *level.chunks, {x, y, z}, def, vox->state
         );
         vox = blocks_agent::get(*level.chunks, origin.x, origin.y, origin.z);
-        if (vox == nullptr) {
+        if (!vox) {
             return lua::pushinteger(L, 0);
         }
     }
@@ -273,7 +468,7 @@ static int l_get_variant(lua::State* L) {
     auto z = lua::tointeger(L, 3);
 
     auto vox = blocks_agent::get(chunks, x, y, z);
-    if (vox == nullptr) {
+    if (!vox) {
         return lua::pushinteger(L, 0);
     }
     const auto& def = level.content.getIndices()->blocks.require(vox->id);
@@ -283,7 +478,7 @@ static int l_get_variant(lua::State* L) {
     if (def.rt.extended) {
         auto origin = blocks_agent::seek_origin(chunks, {x, y, z}, def, vox->state);
         vox = blocks_agent::get(chunks, origin.x, origin.y, origin.z);
-        if (vox == nullptr) {
+        if (!vox) {
             return lua::pushinteger(L, 0);
         }
     }
@@ -313,14 +508,16 @@ static int l_set_user_bits(lua::State* L) {
     }
     int lx = x - cx * CHUNK_W;
     int lz = z - cz * CHUNK_D;
-    auto vox = &chunk->voxels[vox_index(lx, y, lz)];
-    const auto& def = level.content.getIndices()->blocks.require(vox->id);
+    uint index = vox_index(lx, y, lz);
+    auto vox = chunk->get(index);
+    const auto& def = level.content.getIndices()->blocks.require(vox.id);
     if (def.rt.extended) {
-        auto origin = blocks_agent::seek_origin(chunks, {x, y, z}, def, vox->state);
-        vox = blocks_agent::get(chunks, origin.x, origin.y, origin.z);
-        if (vox == nullptr) {
+        auto origin = blocks_agent::seek_origin(chunks, {x, y, z}, def, vox.state);
+        auto originVox = blocks_agent::get(chunks, origin.x, origin.y, origin.z);
+        if (!originVox) {
             return 0;
         }
+        vox = *originVox;
         int ocx = floordiv<CHUNK_W>(origin.x);
         int ocz = floordiv<CHUNK_D>(origin.z);
         if (cx != ocx || cz != ocz) {
@@ -329,8 +526,13 @@ static int l_set_user_bits(lua::State* L) {
                 return 0;
             }
         }
+        index = vox_index(
+            origin.x - ocx * CHUNK_W, origin.y, origin.z - ocz * CHUNK_D
+        );
     }
-    vox->state.userbits = (vox->state.userbits & (~mask)) | value;
+    vox.state.userbits = (vox.state.userbits & (~mask)) | value;
+    chunks.waitWorkers();
+    chunk->set(index, vox);
     chunk->setModifiedAndUnsaved();
     return 0;
 }
@@ -351,8 +553,9 @@ static int l_set_variant(lua::State* L) {
     }
     int lx = x - cx * CHUNK_W;
     int lz = z - cz * CHUNK_D;
-    auto vox = &chunk->voxels[vox_index(lx, y, lz)];
-    const auto& def = level.content.getIndices()->blocks.require(vox->id);
+    uint index = vox_index(lx, y, lz);
+    auto vox = chunk->get(index);
+    const auto& def = level.content.getIndices()->blocks.require(vox.id);
 
     if (def.variants == nullptr) {
         return 0;
@@ -363,11 +566,12 @@ static int l_set_variant(lua::State* L) {
     auto value = (lua::tointeger(L, 4) << offset);
 
     if (def.rt.extended) {
-        auto origin = blocks_agent::seek_origin(chunks, {x, y, z}, def, vox->state);
-        vox = blocks_agent::get(chunks, origin.x, origin.y, origin.z);
-        if (vox == nullptr) {
+        auto origin = blocks_agent::seek_origin(chunks, {x, y, z}, def, vox.state);
+        auto originVox = blocks_agent::get(chunks, origin.x, origin.y, origin.z);
+        if (!originVox) {
             return 0;
         }
+        vox = *originVox;
         int ocx = floordiv<CHUNK_W>(origin.x);
         int ocz = floordiv<CHUNK_D>(origin.z);
         if (cx != ocx || cz != ocz) {
@@ -376,8 +580,13 @@ static int l_set_variant(lua::State* L) {
                 return 0;
             }
         }
+        index = vox_index(
+            origin.x - ocx * CHUNK_W, origin.y, origin.z - ocz * CHUNK_D
+        );
     }
-    vox->state.userbits = (vox->state.userbits & (~mask)) | value;
+    vox.state.userbits = (vox.state.userbits & (~mask)) | value;
+    chunks.waitWorkers();
+    chunk->set(index, vox);
     chunk->setModifiedAndUnsaved();
     return 0;
 }
@@ -533,7 +742,7 @@ static int l_destruct(lua::State* L) {
     auto playerid = lua::isnumber(L, 4) ? lua::tointeger(L, 4) : -1;
 
     auto vox = blocks_agent::get(*level.chunks, x, y, z);
-    if (vox == nullptr) {
+    if (!vox) {
         return 0;
     }
     auto& def = level.content.getIndices()->blocks.require(vox->id);
@@ -685,7 +894,7 @@ static int l_get_field(lua::State* L) {
     auto lz = z - cz * CHUNK_W;
     size_t voxelIndex = vox_index(lx, y, lz);
 
-    const auto& vox = chunk->voxels[voxelIndex];
+    auto vox = chunk->get(voxelIndex);
     const auto& def = content->getIndices()->blocks.require(vox.id);
     if (def.dataStruct == nullptr) {
         return 0;
@@ -757,7 +966,7 @@ static int l_set_field(lua::State* L) {
         return 0;
     }
     size_t voxelIndex = vox_index(lx, y, lz);
-    const auto& vox = chunk->voxels[voxelIndex];
+    auto vox = chunk->get(voxelIndex);
 
     const auto& def = content->getIndices()->blocks.require(vox.id);
     if (def.dataStruct == nullptr) {
@@ -816,25 +1025,6 @@ static int l_get_tags(lua::State* L) {
     return 0;
 }
 
-static int l_pull_register_events(lua::State* L) {
-    auto events = blocks_agent::pull_register_events();
-    if (events.empty())
-        return 0;
-
-    lua::createtable(L, events.size() * 4, 0);
-    for (int i = 0; i < events.size(); i++) {
-        const auto& event = events[i];
-        lua::pushinteger(L, static_cast<int>(event.bits) | event.id << 16);
-        lua::rawseti(L, i * 4 + 1);
-
-        for (int j = 0; j < 3; j++) {
-            lua::pushinteger(L, event.coord[j]);
-            lua::rawseti(L, i * 4 + j + 2);
-        }
-    }
-    return 1;
-}
-
 const luaL_Reg blocklib[] = {
     {"index", lua::wrap<l_index>},
     {"name", lua::wrap<l_get_def>},
@@ -845,6 +1035,9 @@ const luaL_Reg blocklib[] = {
     {"is_replaceable_at", lua::wrap<l_is_replaceable_at>},
     {"set", lua::wrap<l_set>},
     {"get", lua::wrap<l_get>},
+    {"get_region", lua::wrap<l_get_region>},
+    {"set_region", lua::wrap<l_set_region>},
+    {"fill", lua::wrap<l_fill>},
     {"get_X", lua::wrap<l_get_x>},
     {"get_Y", lua::wrap<l_get_y>},
     {"get_Z", lua::wrap<l_get_z>},
@@ -876,6 +1069,5 @@ const luaL_Reg blocklib[] = {
     {"reload_script", lua::wrap<l_reload_script>},
     {"has_tag", lua::wrap<l_has_tag>},
     {"__get_tags", lua::wrap<l_get_tags>},
-    {"__pull_register_events", lua::wrap<l_pull_register_events>},
     {nullptr, nullptr}
 };
@@ -13,6 +13,8 @@
 #include "engine/EnginePaths.hpp"
 #include "io/io.hpp"
 #include "lighting/Lighting.hpp"
+#include "objects/Player.hpp"
+#include "objects/Players.hpp"
 #include "voxels/Chunk.hpp"
 #include "voxels/Chunks.hpp"
 #include "voxels/GlobalChunks.hpp"
@@ -163,6 +165,9 @@ static void integrate_chunk_client(Chunk& chunk) {
         chunk.lightmap->clear();
         Lighting::prebuildSkyLight(chunk, *indices);
     }
+    for (const auto& [_, player] : *level->players) {
+        player->chunks->invalidateFrontier(x, z);
+    }
 
     for (int lz = -1; lz <= 1; lz++) {
         for (int lx = -1; lx <= 1; lx++) {
@@ -170,7 +175,7 @@ static void integrate_chunk_client(Chunk& chunk) {
                 continue;
             }
             if (auto other = level->chunks->getChunk(x + lx, z + lz)) {
-                other->flags.modified = true;
+                other->setModified();
             }
         }
     }
@@ -189,6 +194,7 @@ static int l_set_chunk_data(lua::State* L) {
     if (chunk == nullptr) {
         return lua::pushboolean(L, false);
     }
+    controller->getChunksController()->waitLights();
     compressed_chunks::decode(
         *chunk,
         reinterpret_cast<const ubyte*>(buffer.data()),
@@ -1,8 +1,8 @@
 #include "lua_type_heightmap.hpp"
 
 #include "util/functional_util.hpp"
-#define FNL_IMPL
 #include "maths/FastNoiseLite.h"
+#include "maths/noise_batch.hpp"
 #include "coders/imageio.hpp"
 #include "io/util.hpp"
 #include "graphics/core/ImageData.hpp"
@@ -89,7 +89,7 @@ static int l_noise(lua::State* L) {
         uint w = heightmap->getWidth();
         uint h = heightmap->getHeight();
         auto heights = heightmap->getValues();
-        auto noise = heightmap->getNoise();
+        auto state = heightmap->getNoise();
 
         auto offset = tovec<2>(L, 2);
 
@@ -110,13 +110,17 @@ static int l_noise(lua::State* L) {
         if (gettop(L) > 6) {
             shiftMapY = touserdata<LuaHeightmap>(L, 7);
         }
-        noise->noise_type = noise_type;
-        for (uint y = 0; y < h; y++) {
-            for (uint x = 0; x < w; x++) {
-                uint i = y * w + x;
-                for (uint c = 0; c < octaves; c++) {
-                    float m = s * (1 << c);
-                    float value = heights[i];
+        state->noise_type = noise_type;
+        // coordinates of a row, noise is evaluated in bulk
+        std::vector<float> us(w);
+        std::vector<float> vs(w);
+        for (uint c = 0; c < octaves; c++) {
+            float m = s * (1 << c);
+            // exactly noise / (1 << c) * multiplier
+            float amplitude = multiplier / static_cast<float>(1 << c);
+            for (uint y = 0; y < h; y++) {
+                for (uint x = 0; x < w; x++) {
+                    uint i = y * w + x;
                     float u = (x + offset.x) * m;
                     float v = (y + offset.y) * m;
                     if (shiftMapX) {
@@ -125,11 +129,12 @@ static int l_noise(lua::State* L) {
                     if (shiftMapY) {
                         v += shiftMapY->getValues()[i];
                     }
-
-                    value += fnlGetNoise2D(noise, u, v) /
-                            static_cast<float>(1 << c) * multiplier;
-                    heights[i] = value;
+                    us[x] = u;
+                    vs[x] = v;
                 }
+                noise::add_noise_2d(
+                    *state, us.data(), vs.data(), amplitude, heights + y * w, w
+                );
             }
         }
     }
@@ -354,10 +354,7 @@ void scripting::on_world_save() {
 }
 
 void scripting::process_before_quit() {
-    auto L = lua::get_main_state();
-    if (lua::getglobal(L, "__vc_process_before_quit")) {
-        lua::call_nothrow(L, 0, 0);
-    }
+    blocks_agent::get_ticks_scheduler().flushRemoved(on_block_events);
 }
 
 void scripting::on_world_quit() {
@@ -368,6 +365,7 @@ void scripting::on_world_quit() {
     if (lua::getglobal(L, "__vc_on_world_quit")) {
         lua::call_nothrow(L, 0, 0);
     }
+    blocks_agent::get_ticks_scheduler().clear();
     scripting::level = nullptr;
     scripting::content = nullptr;
     scripting::indices = nullptr;
@@ -402,6 +400,47 @@ void scripting::on_blocks_tick(const Block& block, int tps) {
     });
 }
 
+void scripting::on_block_events(
+    const Block& block,
+    BlockEventType type,
+    util::span<glm::ivec3> positions,
+    float tps
+) {
+    const std::string* name;
+    switch (type) {
+        case BlockEventType::TICK:
+            name = &block.rt.eventNames.blockTick;
+            break;
+        case BlockEventType::PRESENT:
+            name = &block.rt.eventNames.blockPresent;
+            break;
+        case BlockEventType::REMOVED:
+            name = &block.rt.eventNames.blockRemoved;
+            break;
+        default:
+            return;
+    }
+    auto L = lua::get_main_state();
+    if (!lua::getglobal(L, "__vc_emit_block_events")) {
+        return;
+    }
+    lua::pushstring(L, *name);
+    lua::createtable(L, positions.size() * 3, 0);
+    for (size_t i = 0; i < positions.size(); i++) {
+        for (int j = 0; j < 3; j++) {
+            lua::pushinteger(L, positions[i][j]);
+            lua::rawseti(L, i * 3 + j + 1);
+        }
+    }
+    lua::pushinteger(L, positions.size());
+    if (type == BlockEventType::TICK) {
+        lua::pushnumber(L, tps);
+        lua::call_nothrow(L, 4, 0);
+    } else {
+        lua::call_nothrow(L, 3, 0);
+    }
+}
+
 void scripting::update_block(const Block& block, const glm::ivec3& pos) {
     lua::emit_event(lua::get_main_state(), block.rt.eventNames.update,
     [pos](auto L) {
@@ -732,6 +771,9 @@ void scripting::load_content_script(
 
     namesCache.update = prefix + ".update";
     namesCache.randomUpdate = prefix + ".randupdate";
+    namesCache.blockTick = prefix + ".blocktick";
+    namesCache.blockPresent = prefix + ".blockpresent";
+    namesCache.blockRemoved = prefix + ".blockremoved";
 }
 
 void scripting::load_content_script(
@@ -8,6 +8,7 @@
 #include "data/dv.hpp"
 #include "delegates.hpp"
 #include "typedefs.hpp"
+#include "util/span.hpp"
 #include "scripting_functional.hpp"
 
 class Engine;
@@ -36,6 +37,7 @@ struct EntityDef;
 class GeneratorScript;
 struct GeneratorDef;
 class Process;
+enum class BlockEventType;
 
 namespace scripting {
     extern Engine* engine;
@@ -87,6 +89,14 @@ namespace scripting {
     void on_world_quit();
     void cleanup(const std::vector<std::string>& nonReset);
     void on_blocks_tick(const Block& block, int tps);
+    /// @brief Emit on_block_tick, on_block_present or on_block_removed
+    /// events batch of the block type
+    void on_block_events(
+        const Block& block,
+        BlockEventType type,
+        util::span<glm::ivec3> positions,
+        float tps
+    );
     void update_block(const Block& block, const glm::ivec3& pos);
     void random_update_block(const Block& block, const glm::ivec3& pos);
     void on_block_placed(
@@ -0,0 +1,82 @@
+#include "noise_batch.hpp"
+
+#include <algorithm>
+
+#define FNL_IMPL
+#include "noise_batch_kernels.hpp"
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+using namespace noise;
+
+const float* const detail::gradients2D = GRADIENTS_2D;
+const float* const detail::randVecs2D = RAND_VECS_2D;
+
+static SimdLevel detect_simd_level() {
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return SimdLevel::AVX2;
+    }
+    if (__builtin_cpu_supports("sse4.1")) {
+        return SimdLevel::SSE41;
+    }
+#elif defined(_MSC_VER) && defined(_M_X64)
+    int info[4];
+    __cpuid(info, 0);
+    int maxLeaf = info[0];
+    __cpuid(info, 1);
+    bool sse41 = info[2] & (1 << 19);
+    bool osxsave = info[2] & (1 << 27);
+    bool avx = info[2] & (1 << 28);
+    // AVX registers state must be saved by OS
+    if (maxLeaf >= 7 && osxsave && avx && (_xgetbv(0) & 6) == 6) {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5)) {
+            return SimdLevel::AVX2;
+        }
+    }
+    if (sse41) {
+        return SimdLevel::SSE41;
+    }
+#endif
+    return SimdLevel::NONE;
+}
+
+SimdLevel noise::get_simd_level() {
+    static const SimdLevel level = detect_simd_level();
+    return level;
+}
+
+void noise::add_noise_2d(
+    const fnl_state& state,
+    const float* xs,
+    const float* ys,
+    float amplitude,
+    float* dst,
+    size_t count,
+    SimdLevel level
+) {
+    size_t done = 0;
+    switch (std::min(level, get_simd_level())) {
+        case SimdLevel::AVX2:
+            done = detail::add_noise_2d_avx2(
+                state, xs, ys, amplitude, dst, count
+            );
+            break;
+        case SimdLevel::SSE41:
+            done = detail::add_noise_2d_sse41(
+                state, xs, ys, amplitude, dst, count
+            );
+            break;
+        case SimdLevel::NONE:
+            break;
+    }
+    // fnlGetNoise2D does not modify the state
+    auto noiseState = const_cast<fnl_state*>(&state);
+    for (size_t i = done; i < count; i++) {
+        dst[i] += fnlGetNoise2D(noiseState, xs[i], ys[i]) * amplitude;
+    }
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+
+struct fnl_state;
+
+/// @brief Bulk 2D noise evaluation.
+/// OpenSimplex2, Perlin and Cellular noise without fractal are computed by
+/// SSE4.1 or AVX2 kernels (selected at runtime), other settings fall back to
+/// FastNoiseLite. All paths give bit-identical results to fnlGetNoise2D,
+/// so generated terrain does not depend on the CPU.
+namespace noise {
+    enum class SimdLevel {
+        NONE,
+        SSE41,
+        AVX2,
+    };
+
+    /// @return the best instruction set supported by CPU and build
+    SimdLevel get_simd_level();
+
+    /// @brief Add noise at count points to dst:
+    /// dst[i] += fnlGetNoise2D(state, xs[i], ys[i]) * amplitude
+    /// @param level instruction set limit (used by tests and benchmarks)
+    void add_noise_2d(
+        const fnl_state& state,
+        const float* xs,
+        const float* ys,
+        float amplitude,
+        float* dst,
+        size_t count,
+        SimdLevel level = get_simd_level()
+    );
+}
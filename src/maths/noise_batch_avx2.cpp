@@ -0,0 +1,78 @@
+#include "noise_batch_kernels.hpp"
+
+// compiled with -mavx2 (see src/CMakeLists.txt)
+#if defined(__AVX2__)
+
+#include <immintrin.h>
+
+namespace {
+    struct AVX2 {
+        static constexpr size_t WIDTH = 8;
+        using f32 = __m256;
+        using i32 = __m256i;
+
+        static f32 load(const float* src) { return _mm256_loadu_ps(src); }
+        static void store(float* dst, f32 a) { _mm256_storeu_ps(dst, a); }
+        static f32 set(float a) { return _mm256_set1_ps(a); }
+        static i32 seti(int a) { return _mm256_set1_epi32(a); }
+
+        static f32 add(f32 a, f32 b) { return _mm256_add_ps(a, b); }
+        static f32 sub(f32 a, f32 b) { return _mm256_sub_ps(a, b); }
+        static f32 mul(f32 a, f32 b) { return _mm256_mul_ps(a, b); }
+        static f32 div(f32 a, f32 b) { return _mm256_div_ps(a, b); }
+        static f32 min(f32 a, f32 b) { return _mm256_min_ps(a, b); }
+        static f32 max(f32 a, f32 b) { return _mm256_max_ps(a, b); }
+        static f32 abs(f32 a) {
+            return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a);
+        }
+
+        static f32 lt(f32 a, f32 b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+        static f32 gt(f32 a, f32 b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+        static f32 ge(f32 a, f32 b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+        static f32 mask(f32 m, f32 a) { return _mm256_and_ps(m, a); }
+        static f32 select(f32 m, f32 a, f32 b) {
+            return _mm256_blendv_ps(b, a, m);
+        }
+        static i32 selecti(f32 m, i32 a, i32 b) {
+            return _mm256_blendv_epi8(b, a, _mm256_castps_si256(m));
+        }
+
+        static i32 trunc(f32 a) { return _mm256_cvttps_epi32(a); }
+        static f32 tofloat(i32 a) { return _mm256_cvtepi32_ps(a); }
+        static i32 asint(f32 a) { return _mm256_castps_si256(a); }
+        static f32 asfloat(i32 a) { return _mm256_castsi256_ps(a); }
+
+        static i32 iadd(i32 a, i32 b) { return _mm256_add_epi32(a, b); }
+        static i32 isub(i32 a, i32 b) { return _mm256_sub_epi32(a, b); }
+        static i32 imul(i32 a, i32 b) { return _mm256_mullo_epi32(a, b); }
+        static i32 ixor(i32 a, i32 b) { return _mm256_xor_si256(a, b); }
+        static i32 iand(i32 a, i32 b) { return _mm256_and_si256(a, b); }
+        template <int n>
+        static i32 sra(i32 a) { return _mm256_srai_epi32(a, n); }
+
+        static f32 gather(const float* table, i32 indices) {
+            return _mm256_i32gather_ps(table, indices, 4);
+        }
+    };
+}
+
+size_t noise::detail::add_noise_2d_avx2(
+    const fnl_state& state,
+    const float* xs,
+    const float* ys,
+    float amplitude,
+    float* dst,
+    size_t count
+) {
+    return add_noise_2d<AVX2>(state, xs, ys, amplitude, dst, count);
+}
+
+#else
+
+size_t noise::detail::add_noise_2d_avx2(
+    const fnl_state&, const float*, const float*, float, float*, size_t
+) {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,425 @@
+#pragma once
+
+#include <cfloat>
+#include <cstddef>
+
+#include "FastNoiseLite.h"
+
+/// Vectorized ports of FastNoiseLite 2D noise functions.
+/// Kernels are written once over an instruction set wrapper S and compiled
+/// in separate translation units with matching compiler flags.
+/// Every operation repeats the reference implementation order, contracting
+/// multiply-add into FMA is not allowed as it would change the results.
+namespace noise::detail {
+    extern const float* const gradients2D;
+    extern const float* const randVecs2D;
+
+    /// @return number of processed points (a multiple of the vector width)
+    /// or 0 if the noise settings or instruction set are not supported
+    size_t add_noise_2d_sse41(
+        const fnl_state& state,
+        const float* xs,
+        const float* ys,
+        float amplitude,
+        float* dst,
+        size_t count
+    );
+    size_t add_noise_2d_avx2(
+        const fnl_state& state,
+        const float* xs,
+        const float* ys,
+        float amplitude,
+        float* dst,
+        size_t count
+    );
+
+    inline constexpr int PRIME_X = 501125321;
+    inline constexpr int PRIME_Y = 1136930381;
+    inline constexpr int HASH_MULTIPLIER = 0x27d4eb2d;
+
+    inline constexpr float SQRT3 = 1.7320508075688772935274463415059f;
+    inline constexpr float F2 = 0.5f * (SQRT3 - 1);
+    inline constexpr float G2 = (3 - SQRT3) / 6;
+
+    /// @brief (f >= 0 ? (int)f : (int)f - 1), not a true floor for negative
+    /// integers
+    template <class S>
+    inline typename S::i32 fast_floor(typename S::f32 f) {
+        // all-ones mask is -1
+        return S::iadd(S::trunc(f), S::asint(S::lt(f, S::set(0.0f))));
+    }
+
+    template <class S>
+    inline typename S::i32 fast_round(typename S::f32 f) {
+        auto bias = S::select(
+            S::ge(f, S::set(0.0f)), S::set(0.5f), S::set(-0.5f)
+        );
+        return S::trunc(S::add(f, bias));
+    }
+
+    template <class S>
+    inline typename S::f32 fast_sqrt(typename S::f32 a) {
+        auto xhalf = S::mul(S::set(0.5f), a);
+        auto inv = S::asfloat(
+            S::isub(S::seti(0x5f3759df), S::template sra<1>(S::asint(a)))
+        );
+        inv = S::mul(
+            inv, S::sub(S::set(1.5f), S::mul(S::mul(xhalf, inv), inv))
+        );
+        return S::mul(a, inv);
+    }
+
+    template <class S>
+    inline typename S::i32 hash_2d(
+        typename S::i32 seed, typename S::i32 xPrimed, typename S::i32 yPrimed
+    ) {
+        return S::imul(
+            S::ixor(S::ixor(seed, xPrimed), yPrimed),
+            S::seti(HASH_MULTIPLIER)
+        );
+    }
+
+    template <class S>
+    inline typename S::f32 grad_coord_2d(
+        typename S::i32 seed,
+        typename S::i32 xPrimed,
+        typename S::i32 yPrimed,
+        typename S::f32 xd,
+        typename S::f32 yd
+    ) {
+        auto hash = hash_2d<S>(seed, xPrimed, yPrimed);
+        hash = S::ixor(hash, S::template sra<15>(hash));
+        hash = S::iand(hash, S::seti(127 << 1));
+        auto gx = S::gather(gradients2D, hash);
+        auto gy = S::gather(gradients2D, S::iadd(hash, S::seti(1)));
+        return S::add(S::mul(xd, gx), S::mul(yd, gy));
+    }
+
+    /// @brief (a > 0 ? (a * a) * (a * a) * grad : 0)
+    template <class S>
+    inline typename S::f32 attenuate(typename S::f32 a, typename S::f32 grad) {
+        auto a2 = S::mul(a, a);
+        return S::mask(
+            S::gt(a, S::set(0.0f)), S::mul(S::mul(a2, a2), grad)
+        );
+    }
+
+    /// @brief _fnlSingleSimplex2D with the coordinates transform
+    template <class S>
+    inline typename S::f32 opensimplex2(
+        typename S::i32 seed,
+        float frequency,
+        typename S::f32 x,
+        typename S::f32 y
+    ) {
+        constexpr float C0 = 2 * (1 - 2 * G2) * (1 / G2 - 2);
+        constexpr float C1 = -2 * (1 - 2 * G2) * (1 - 2 * G2);
+
+        x = S::mul(x, S::set(frequency));
+        y = S::mul(y, S::set(frequency));
+        auto s = S::mul(S::add(x, y), S::set(F2));
+        x = S::add(x, s);
+        y = S::add(y, s);
+
+        auto i = fast_floor<S>(x);
+        auto j = fast_floor<S>(y);
+        auto xi = S::sub(x, S::tofloat(i));
+        auto yi = S::sub(y, S::tofloat(j));
+
+        auto t = S::mul(S::add(xi, yi), S::set(G2));
+        auto x0 = S::sub(xi, t);
+        auto y0 = S::sub(yi, t);
+
+        i = S::imul(i, S::seti(PRIME_X));
+        j = S::imul(j, S::seti(PRIME_Y));
+
+        auto a = S::sub(
+            S::sub(S::set(0.5f), S::mul(x0, x0)), S::mul(y0, y0)
+        );
+        auto n0 = attenuate<S>(a, grad_coord_2d<S>(seed, i, j, x0, y0));
+
+        auto c = S::add(
+            S::mul(S::set(C0), t), S::add(S::set(C1), a)
+        );
+        auto x2 = S::add(x0, S::set(2 * G2 - 1));
+        auto y2 = S::add(y0, S::set(2 * G2 - 1));
+        auto n2 = attenuate<S>(
+            c,
+            grad_coord_2d<S>(
+                seed,
+                S::iadd(i, S::seti(PRIME_X)),
+                S::iadd(j, S::seti(PRIME_Y)),
+                x2,
+                y2
+            )
+        );
+
+        auto upper = S::gt(y0, x0);
+        auto x1 = S::add(x0, S::select(upper, S::set(G2), S::set(G2 - 1)));
+        auto y1 = S::add(y0, S::select(upper, S::set(G2 - 1), S::set(G2)));
+        auto b = S::sub(
+            S::sub(S::set(0.5f), S::mul(x1, x1)), S::mul(y1, y1)
+        );
+        auto n1 = attenuate<S>(
+            b,
+            grad_coord_2d<S>(
+                seed,
+                S::selecti(upper, i, S::iadd(i, S::seti(PRIME_X))),
+                S::selecti(upper, S::iadd(j, S::seti(PRIME_Y)), j),
+                x1,
+                y1
+            )
+        );
+        return S::mul(
+            S::add(S::add(n0, n1), n2), S::set(99.83685446303647f)
+        );
+    }
+
+    template <class S>
+    inline typename S::f32 interp_quintic(typename S::f32 t) {
+        auto t3 = S::mul(S::mul(t, t), t);
+        auto p = S::add(
+            S::mul(t, S::sub(S::mul(t, S::set(6.0f)), S::set(15.0f))),
+            S::set(10.0f)
+        );
+        return S::mul(t3, p);
+    }
+
+    template <class S>
+    inline typename S::f32 lerp(
+        typename S::f32 a, typename S::f32 b, typename S::f32 t
+    ) {
+        return S::add(a, S::mul(t, S::sub(b, a)));
+    }
+
+    /// @brief _fnlSinglePerlin2D with the coordinates transform
+    template <class S>
+    inline typename S::f32 perlin(
+        typename S::i32 seed,
+        float frequency,
+        typename S::f32 x,
+        typename S::f32 y
+    ) {
+        x = S::mul(x, S::set(frequency));
+        y = S::mul(y, S::set(frequency));
+
+        auto x0 = fast_floor<S>(x);
+        auto y0 = fast_floor<S>(y);
+
+        auto xd0 = S::sub(x, S::tofloat(x0));
+        auto yd0 = S::sub(y, S::tofloat(y0));
+        auto xd1 = S::sub(xd0, S::set(1.0f));
+        auto yd1 = S::sub(yd0, S::set(1.0f));
+
+        auto xs = interp_quintic<S>(xd0);
+        auto ys = interp_quintic<S>(yd0);
+
+        x0 = S::imul(x0, S::seti(PRIME_X));
+        y0 = S::imul(y0, S::seti(PRIME_Y));
+        auto x1 = S::iadd(x0, S::seti(PRIME_X));
+        auto y1 = S::iadd(y0, S::seti(PRIME_Y));
+
+        auto xf0 = lerp<S>(
+            grad_coord_2d<S>(seed, x0, y0, xd0, yd0),
+            grad_coord_2d<S>(seed, x1, y0, xd1, yd0),
+            xs
+        );
+        auto xf1 = lerp<S>(
+            grad_coord_2d<S>(seed, x0, y1, xd0, yd1),
+            grad_coord_2d<S>(seed, x1, y1, xd1, yd1),
+            xs
+        );
+        return S::mul(lerp<S>(xf0, xf1, ys), S::set(1.4247691104677813f));
+    }
+
+    template <class S, fnl_cellular_distance_func func>
+    inline typename S::f32 cellular_distance(
+        typename S::f32 vecX, typename S::f32 vecY
+    ) {
+        if constexpr (func == FNL_CELLULAR_DISTANCE_MANHATTAN) {
+            return S::add(S::abs(vecX), S::abs(vecY));
+        }
+        auto sq = S::add(S::mul(vecX, vecX), S::mul(vecY, vecY));
+        if constexpr (func == FNL_CELLULAR_DISTANCE_HYBRID) {
+            return S::add(S::add(S::abs(vecX), S::abs(vecY)), sq);
+        }
+        return sq;
+    }
+
+    /// @brief _fnlSingleCellular2D with the coordinates transform
+    template <class S, fnl_cellular_distance_func func>
+    inline typename S::f32 cellular(
+        const fnl_state& state,
+        typename S::i32 seed,
+        typename S::f32 x,
+        typename S::f32 y
+    ) {
+        x = S::mul(x, S::set(state.frequency));
+        y = S::mul(y, S::set(state.frequency));
+
+        auto xr = fast_round<S>(x);
+        auto yr = fast_round<S>(y);
+
+        auto distance0 = S::set(FLT_MAX);
+        auto distance1 = S::set(FLT_MAX);
+        auto closestHash = S::seti(0);
+
+        auto cellularJitter = S::set(0.5f * state.cellular_jitter_mod);
+
+        auto xPrimed = S::imul(S::iadd(xr, S::seti(-1)), S::seti(PRIME_X));
+        auto yPrimedBase = S::imul(S::iadd(yr, S::seti(-1)), S::seti(PRIME_Y));
+
+        for (int xi = -1; xi <= 1; xi++) {
+            auto yPrimed = yPrimedBase;
+            auto cellX = S::sub(S::tofloat(S::iadd(xr, S::seti(xi))), x);
+            for (int yi = -1; yi <= 1; yi++) {
+                auto hash = hash_2d<S>(seed, xPrimed, yPrimed);
+                auto idx = S::iand(hash, S::seti(255 << 1));
+
+                auto cellY = S::sub(S::tofloat(S::iadd(yr, S::seti(yi))), y);
+                auto vecX = S::add(
+                    cellX, S::mul(S::gather(randVecs2D, idx), cellularJitter)
+                );
+                auto vecY = S::add(
+                    cellY,
+                    S::mul(
+                        S::gather(randVecs2D, S::iadd(idx, S::seti(1))),
+                        cellularJitter
+                    )
+                );
+                auto newDistance = cellular_distance<S, func>(vecX, vecY);
+
+                distance1 = S::max(S::min(distance1, newDistance), distance0);
+                auto closer = S::lt(newDistance, distance0);
+                distance0 = S::select(closer, newDistance, distance0);
+                closestHash = S::selecti(closer, hash, closestHash);
+
+                yPrimed = S::iadd(yPrimed, S::seti(PRIME_Y));
+            }
+            xPrimed = S::iadd(xPrimed, S::seti(PRIME_X));
+        }
+
+        auto returnType = state.cellular_return_type;
+        if (func == FNL_CELLULAR_DISTANCE_EUCLIDEAN &&
+            returnType >= FNL_CELLULAR_RETURN_VALUE_DISTANCE) {
+            distance0 = fast_sqrt<S>(distance0);
+            if (returnType >= FNL_CELLULAR_RETURN_VALUE_DISTANCE2) {
+                distance1 = fast_sqrt<S>(distance1);
+            }
+        }
+        auto one = S::set(1.0f);
+        auto half = S::set(0.5f);
+        switch (returnType) {
+            case FNL_CELLULAR_RETURN_VALUE_CELLVALUE:
+                return S::mul(
+                    S::tofloat(closestHash), S::set(1 / 2147483648.0f)
+                );
+            case FNL_CELLULAR_RETURN_VALUE_DISTANCE:
+                return S::sub(distance0, one);
+            case FNL_CELLULAR_RETURN_VALUE_DISTANCE2:
+                return S::sub(distance1, one);
+            case FNL_CELLULAR_RETURN_VALUE_DISTANCE2ADD:
+                return S::sub(
+                    S::mul(S::add(distance1, distance0), half), one
+                );
+            case FNL_CELLULAR_RETURN_VALUE_DISTANCE2SUB:
+                return S::sub(S::sub(distance1, distance0), one);
+            case FNL_CELLULAR_RETURN_VALUE_DISTANCE2MUL:
+                return S::sub(
+                    S::mul(S::mul(distance1, distance0), half), one
+                );
+            case FNL_CELLULAR_RETURN_VALUE_DISTANCE2DIV:
+                return S::sub(S::div(distance0, distance1), one);
+            default:
+                return S::set(0.0f);
+        }
+    }
+
+    template <class S, class Noise>
+    inline size_t add_noise_rows(
+        const float* xs,
+        const float* ys,
+        float amplitude,
+        float* dst,
+        size_t count,
+        const Noise& noise
+    ) {
+        size_t end = count - count % S::WIDTH;
+        auto amp = S::set(amplitude);
+        for (size_t i = 0; i < end; i += S::WIDTH) {
+            auto value = noise(S::load(xs + i), S::load(ys + i));
+            S::store(dst + i, S::add(S::load(dst + i), S::mul(value, amp)));
+        }
+        return end;
+    }
+
+    template <class S>
+    inline size_t add_noise_2d(
+        const fnl_state& state,
+        const float* xs,
+        const float* ys,
+        float amplitude,
+        float* dst,
+        size_t count
+    ) {
+        using f32 = typename S::f32;
+
+        if (state.fractal_type != FNL_FRACTAL_NONE) {
+            return 0;
+        }
+        auto seed = S::seti(state.seed);
+        float frequency = state.frequency;
+        switch (state.noise_type) {
+            case FNL_NOISE_OPENSIMPLEX2:
+                return add_noise_rows<S>(
+                    xs, ys, amplitude, dst, count, [=](f32 x, f32 y) {
+                        return opensimplex2<S>(seed, frequency, x, y);
+                    }
+                );
+            case FNL_NOISE_PERLIN:
+                return add_noise_rows<S>(
+                    xs, ys, amplitude, dst, count, [=](f32 x, f32 y) {
+                        return perlin<S>(seed, frequency, x, y);
+                    }
+                );
+            case FNL_NOISE_CELLULAR:
+                break;
+            default:
+                return 0;
+        }
+        switch (state.cellular_distance_func) {
+            case FNL_CELLULAR_DISTANCE_MANHATTAN:
+                return add_noise_rows<S>(
+                    xs, ys, amplitude, dst, count, [&](f32 x, f32 y) {
+                        return cellular<S, FNL_CELLULAR_DISTANCE_MANHATTAN>(
+                            state, seed, x, y
+                        );
+                    }
+                );
+            case FNL_CELLULAR_DISTANCE_HYBRID:
+                return add_noise_rows<S>(
+                    xs, ys, amplitude, dst, count, [&](f32 x, f32 y) {
+                        return cellular<S, FNL_CELLULAR_DISTANCE_HYBRID>(
+                            state, seed, x, y
+                        );
+                    }
+                );
+            case FNL_CELLULAR_DISTANCE_EUCLIDEAN:
+                return add_noise_rows<S>(
+                    xs, ys, amplitude, dst, count, [&](f32 x, f32 y) {
+                        return cellular<S, FNL_CELLULAR_DISTANCE_EUCLIDEAN>(
+                            state, seed, x, y
+                        );
+                    }
+                );
+            default:
+                return add_noise_rows<S>(
+                    xs, ys, amplitude, dst, count, [&](f32 x, f32 y) {
+                        return cellular<S, FNL_CELLULAR_DISTANCE_EUCLIDEANSQ>(
+                            state, seed, x, y
+                        );
+                    }
+                );
+        }
+    }
+}
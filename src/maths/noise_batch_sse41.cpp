@@ -0,0 +1,83 @@
+#include "noise_batch_kernels.hpp"
+
+// compiled with -msse4.1 (see src/CMakeLists.txt)
+#if defined(__SSE4_1__) || \
+    (defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64))
+
+#include <smmintrin.h>
+
+namespace {
+    struct SSE41 {
+        static constexpr size_t WIDTH = 4;
+        using f32 = __m128;
+        using i32 = __m128i;
+
+        static f32 load(const float* src) { return _mm_loadu_ps(src); }
+        static void store(float* dst, f32 a) { _mm_storeu_ps(dst, a); }
+        static f32 set(float a) { return _mm_set1_ps(a); }
+        static i32 seti(int a) { return _mm_set1_epi32(a); }
+
+        static f32 add(f32 a, f32 b) { return _mm_add_ps(a, b); }
+        static f32 sub(f32 a, f32 b) { return _mm_sub_ps(a, b); }
+        static f32 mul(f32 a, f32 b) { return _mm_mul_ps(a, b); }
+        static f32 div(f32 a, f32 b) { return _mm_div_ps(a, b); }
+        static f32 min(f32 a, f32 b) { return _mm_min_ps(a, b); }
+        static f32 max(f32 a, f32 b) { return _mm_max_ps(a, b); }
+        static f32 abs(f32 a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a); }
+
+        static f32 lt(f32 a, f32 b) { return _mm_cmplt_ps(a, b); }
+        static f32 gt(f32 a, f32 b) { return _mm_cmpgt_ps(a, b); }
+        static f32 ge(f32 a, f32 b) { return _mm_cmpge_ps(a, b); }
+        static f32 mask(f32 m, f32 a) { return _mm_and_ps(m, a); }
+        static f32 select(f32 m, f32 a, f32 b) {
+            return _mm_blendv_ps(b, a, m);
+        }
+        static i32 selecti(f32 m, i32 a, i32 b) {
+            return _mm_castps_si128(_mm_blendv_ps(
+                _mm_castsi128_ps(b), _mm_castsi128_ps(a), m
+            ));
+        }
+
+        static i32 trunc(f32 a) { return _mm_cvttps_epi32(a); }
+        static f32 tofloat(i32 a) { return _mm_cvtepi32_ps(a); }
+        static i32 asint(f32 a) { return _mm_castps_si128(a); }
+        static f32 asfloat(i32 a) { return _mm_castsi128_ps(a); }
+
+        static i32 iadd(i32 a, i32 b) { return _mm_add_epi32(a, b); }
+        static i32 isub(i32 a, i32 b) { return _mm_sub_epi32(a, b); }
+        static i32 imul(i32 a, i32 b) { return _mm_mullo_epi32(a, b); }
+        static i32 ixor(i32 a, i32 b) { return _mm_xor_si128(a, b); }
+        static i32 iand(i32 a, i32 b) { return _mm_and_si128(a, b); }
+        template <int n>
+        static i32 sra(i32 a) { return _mm_srai_epi32(a, n); }
+
+        static f32 gather(const float* table, i32 indices) {
+            alignas(16) int idx[WIDTH];
+            _mm_store_si128(reinterpret_cast<i32*>(idx), indices);
+            return _mm_setr_ps(
+                table[idx[0]], table[idx[1]], table[idx[2]], table[idx[3]]
+            );
+        }
+    };
+}
+
+size_t noise::detail::add_noise_2d_sse41(
+    const fnl_state& state,
+    const float* xs,
+    const float* ys,
+    float amplitude,
+    float* dst,
+    size_t count
+) {
+    return add_noise_2d<SSE41>(state, xs, ys, amplitude, dst, count);
+}
+
+#else
+
+size_t noise::detail::add_noise_2d_sse41(
+    const fnl_state&, const float*, const float*, float, float*, size_t
+) {
+    return 0;
+}
+
+#endif
@@ -1,4 +1,5 @@
 #include "Network.hpp"
+#include "Reactor.hpp"
 
 #include <stdexcept>
 #include <limits>
@@ -16,6 +17,8 @@ namespace network {
     std::unique_ptr<Requests> create_curl_requests();
 
     std::shared_ptr<TcpConnection> connect_tcp(
+        Reactor& reactor,
+        size_t receiveBufferSize,
         const std::string& address,
         int port,
         runnable callback,
@@ -23,11 +26,17 @@ namespace network {
     );
 
     std::shared_ptr<TcpServer> open_tcp_server(
-        u64id_t id, Network* network, int port, ConnectCallback handler
+        u64id_t id,
+        Network* network,
+        Reactor& reactor,
+        size_t receiveBufferSize,
+        int port,
+        ConnectCallback handler
     );
 
     std::shared_ptr<UdpConnection> connect_udp(
         u64id_t id,
+        Reactor& reactor,
         const std::string& address,
         int port,
         ClientDatagramCallback handler,
@@ -36,7 +45,7 @@ namespace network {
 
     std::shared_ptr<UdpServer> open_udp_server(
         u64id_t id,
-        Network* network,
+        Reactor& reactor,
         int port,
         const ServerDatagramCallback& handler
     );
@@ -45,8 +54,12 @@ namespace network {
 }
 
 
-Network::Network(std::unique_ptr<Requests> requests)
-: requests(std::move(requests)) {
+Network::Network(
+    std::unique_ptr<Requests> requests, size_t tcpReceiveBufferSize
+)
+    : requests(std::move(requests)),
+      reactor(std::make_unique<Reactor>()),
+      tcpReceiveBufferSize(tcpReceiveBufferSize) {
 }
 
 Network::~Network() = default;
@@ -105,7 +118,7 @@ u64id_t Network::connectTcp(
     std::lock_guard lock(connectionsMutex);
     
     u64id_t id = nextConnection++;
-    auto socket = connect_tcp(address, port, [id, callback]() {
+    auto socket = connect_tcp(*reactor, tcpReceiveBufferSize, address, port, [id, callback]() {
         callback(id);
     }, [id, errorCallback](auto errorMessage) {
         errorCallback(id, errorMessage);
@@ -116,7 +129,9 @@ u64id_t Network::connectTcp(
 
 u64id_t Network::openTcpServer(int port, ConnectCallback handler) {
     u64id_t id = nextServer++;
-    auto server = open_tcp_server(id, this, port, handler);
+    auto server = open_tcp_server(
+        id, this, *reactor, tcpReceiveBufferSize, port, handler
+    );
     servers[id] = std::move(server);
     return id;
 }
@@ -130,7 +145,7 @@ u64id_t Network::connectUdp(
     std::lock_guard lock(connectionsMutex);
 
     u64id_t id = nextConnection++;
-    auto socket = connect_udp(id, address, port, std::move(handler), [id, callback]() {
+    auto socket = connect_udp(id, *reactor, address, port, std::move(handler), [id, callback]() {
         callback(id);
     });
     connections[id] = std::move(socket);
@@ -139,7 +154,7 @@ u64id_t Network::connectUdp(
 
 u64id_t Network::openUdpServer(int port, const ServerDatagramCallback& handler) {
     u64id_t id = nextServer++;
-    auto server = open_udp_server(id, this, port, handler);
+    auto server = open_udp_server(id, *reactor, port, handler);
     servers[id] = std::move(server);
     return id;
 }
@@ -195,5 +210,7 @@ void Network::update() {
 
 std::unique_ptr<Network> Network::create(const NetworkSettings& settings) {
     logger.info() << "initializing network";
-    return std::make_unique<Network>(network::create_curl_requests());
+    return std::make_unique<Network>(
+        network::create_curl_requests(), settings.tcpReceiveBuffer.get()
+    );
 }
@@ -52,8 +52,12 @@ namespace network {
         }
     };
 
+    class Reactor;
+
     class Network {
         std::unique_ptr<Requests> requests;
+        /// @brief Sockets event loop, must outlive connections and servers
+        std::unique_ptr<Reactor> reactor;
 
         std::unordered_map<u64id_t, std::shared_ptr<Connection>> connections;
         std::mutex connectionsMutex {};
@@ -64,8 +68,13 @@ namespace network {
 
         size_t totalDownload = 0;
         size_t totalUpload = 0;
+        /// @brief Max bytes received by a TCP connection but not read yet
+        size_t tcpReceiveBufferSize;
     public:
-        Network(std::unique_ptr<Requests> requests);
+        Network(
+            std::unique_ptr<Requests> requests,
+            size_t tcpReceiveBufferSize = 1'048'576
+        );
         ~Network();
 
         void get(
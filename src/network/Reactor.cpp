@@ -0,0 +1,372 @@
+#include "Reactor.hpp"
+
+#include <stdexcept>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <winsock2.h>
+#define poll WSAPoll
+#elif defined(__linux__)
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#else
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#endif
+
+#include "debug/Logger.hpp"
+
+using namespace network;
+
+static debug::Logger logger("reactor");
+
+#ifdef __linux__
+static constexpr int MAX_EVENTS = 256;
+
+static uint32_t to_epoll_events(uint events) {
+    uint32_t result = 0;
+    if (events & EVENT_READ) {
+        result |= EPOLLIN;
+    }
+    if (events & EVENT_WRITE) {
+        result |= EPOLLOUT;
+    }
+    return result;
+}
+
+static uint from_epoll_events(uint32_t events) {
+    uint result = 0;
+    if (events & EPOLLIN) {
+        result |= EVENT_READ;
+    }
+    if (events & EPOLLOUT) {
+        result |= EVENT_WRITE;
+    }
+    if (events & (EPOLLERR | EPOLLHUP)) {
+        result |= EVENT_ERROR;
+    }
+    return result;
+}
+
+Reactor::Reactor() {
+    epollfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollfd == -1) {
+        throw std::runtime_error(
+            "epoll_create1 failed: " + std::string(strerror(errno))
+        );
+    }
+    wakeupfd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeupfd == -1) {
+        close(epollfd);
+        throw std::runtime_error(
+            "eventfd failed: " + std::string(strerror(errno))
+        );
+    }
+    // registration ids start with 1, so 0 is the wakeup event
+    epoll_event event {};
+    event.events = EPOLLIN;
+    event.data.u64 = 0;
+    epoll_ctl(epollfd, EPOLL_CTL_ADD, wakeupfd, &event);
+
+    thread = std::thread([this]() { loop(); });
+}
+
+Reactor::~Reactor() {
+    {
+        std::lock_guard lock(mutex);
+        running = false;
+    }
+    wakeup();
+    thread.join();
+    close(wakeupfd);
+    close(epollfd);
+}
+
+void Reactor::wakeup() {
+    uint64_t value = 1;
+    if (write(wakeupfd, &value, sizeof(value)) < 0 && errno != EAGAIN) {
+        logger.error() << "could not wake up reactor: " << strerror(errno);
+    }
+}
+
+void Reactor::loop() {
+    epoll_event events[MAX_EVENTS];
+    while (true) {
+        {
+            std::lock_guard lock(mutex);
+            if (!running) {
+                break;
+            }
+        }
+        int count = epoll_wait(epollfd, events, MAX_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            logger.error() << "epoll_wait failed: " << strerror(errno);
+            break;
+        }
+        for (int i = 0; i < count; i++) {
+            u64id_t id = events[i].data.u64;
+            if (id == 0) {
+                uint64_t value;
+                while (read(wakeupfd, &value, sizeof(value)) > 0);
+                continue;
+            }
+            dispatch(id, from_epoll_events(events[i].events));
+        }
+    }
+}
+
+u64id_t Reactor::add(socket_t descriptor, uint events, ReactorHandler handler) {
+    std::lock_guard lock(mutex);
+    u64id_t id = nextId++;
+    registrations[id] = Registration {
+        descriptor,
+        events,
+        std::make_shared<ReactorHandler>(std::move(handler))
+    };
+    epoll_event event {};
+    event.events = to_epoll_events(events);
+    event.data.u64 = id;
+    if (epoll_ctl(epollfd, EPOLL_CTL_ADD, descriptor, &event) == -1) {
+        registrations.erase(id);
+        throw std::runtime_error(
+            "epoll_ctl(ADD) failed: " + std::string(strerror(errno))
+        );
+    }
+    return id;
+}
+
+void Reactor::modify(u64id_t id, uint events) {
+    std::lock_guard lock(mutex);
+    const auto& found = registrations.find(id);
+    if (found == registrations.end() || found->second.events == events) {
+        return;
+    }
+    found->second.events = events;
+    epoll_event event {};
+    event.events = to_epoll_events(events);
+    event.data.u64 = id;
+    if (epoll_ctl(epollfd, EPOLL_CTL_MOD, found->second.descriptor, &event)) {
+        logger.error() << "epoll_ctl(MOD) failed: " << strerror(errno);
+    }
+}
+
+#else
+
+#ifdef _WIN32
+static inline int close_wakeup(socket_t descriptor) {
+    return closesocket(descriptor);
+}
+#else
+static inline int close_wakeup(socket_t descriptor) {
+    return close(descriptor);
+}
+#endif
+
+/// @brief Create socket pair interrupting poll when written. Windows has no
+/// pipes pollable with WSAPoll, so a loopback UDP socket connected to itself
+/// is used there
+static void create_wakeup_pair(socket_t& reader, socket_t& writer) {
+#ifdef _WIN32
+    SOCKET descriptor = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (descriptor == INVALID_SOCKET) {
+        throw std::runtime_error("could not create reactor wakeup socket");
+    }
+    sockaddr_in address {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    int length = sizeof(address);
+    u_long mode = 1;
+    if (bind(descriptor, reinterpret_cast<sockaddr*>(&address), length) ||
+        getsockname(
+            descriptor, reinterpret_cast<sockaddr*>(&address), &length
+        ) ||
+        connect(descriptor, reinterpret_cast<sockaddr*>(&address), length) ||
+        ioctlsocket(descriptor, FIONBIO, &mode)) {
+        closesocket(descriptor);
+        throw std::runtime_error("could not set up reactor wakeup socket");
+    }
+    reader = descriptor;
+    writer = descriptor;
+#else
+    int fds[2];
+    if (pipe(fds) == -1) {
+        throw std::runtime_error(
+            "pipe failed: " + std::string(strerror(errno))
+        );
+    }
+    for (int fd : fds) {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    reader = fds[0];
+    writer = fds[1];
+#endif
+}
+
+Reactor::Reactor() {
+    create_wakeup_pair(wakeupReader, wakeupWriter);
+    thread = std::thread([this]() { loop(); });
+}
+
+Reactor::~Reactor() {
+    {
+        std::lock_guard lock(mutex);
+        running = false;
+    }
+    wakeup();
+    thread.join();
+    close_wakeup(wakeupReader);
+    if (wakeupWriter != wakeupReader) {
+        close_wakeup(wakeupWriter);
+    }
+}
+
+void Reactor::wakeup() {
+    char value = 1;
+#ifdef _WIN32
+    send(wakeupWriter, &value, 1, 0);
+#else
+    if (write(wakeupWriter, &value, 1) < 0 && errno != EAGAIN) {
+        logger.error() << "could not wake up reactor: " << strerror(errno);
+    }
+#endif
+}
+
+void Reactor::loop() {
+    std::vector<pollfd> fds;
+    std::vector<u64id_t> ids;
+    while (true) {
+        {
+            std::lock_guard lock(mutex);
+            if (!running) {
+                break;
+            }
+            // poll set is rebuilt only after registrations changed
+            if (modified) {
+                modified = false;
+                fds.resize(1);
+                ids.resize(1);
+                fds[0] = pollfd {};
+                fds[0].fd = wakeupReader;
+                fds[0].events = POLLIN;
+                ids[0] = 0;
+                for (const auto& [id, registration] : registrations) {
+                    pollfd fd {};
+                    fd.fd = registration.descriptor;
+                    fd.events =
+                        ((registration.events & EVENT_READ) ? POLLIN : 0) |
+                        ((registration.events & EVENT_WRITE) ? POLLOUT : 0);
+                    fds.push_back(fd);
+                    ids.push_back(id);
+                }
+            }
+        }
+        int count = poll(fds.data(), fds.size(), -1);
+        if (count < 0) {
+#ifndef _WIN32
+            if (errno == EINTR) {
+                continue;
+            }
+#endif
+            logger.error() << "poll failed";
+            break;
+        }
+        if (fds[0].revents & POLLIN) {
+            char buffer[64];
+#ifdef _WIN32
+            while (recv(wakeupReader, buffer, sizeof(buffer), 0) > 0);
+#else
+            while (read(wakeupReader, buffer, sizeof(buffer)) > 0);
+#endif
+        }
+        for (size_t i = 1; i < fds.size(); i++) {
+            auto revents = fds[i].revents;
+            uint events = ((revents & POLLIN) ? EVENT_READ : 0) |
+                          ((revents & POLLOUT) ? EVENT_WRITE : 0) |
+                          ((revents & (POLLERR | POLLHUP | POLLNVAL))
+                               ? EVENT_ERROR
+                               : 0);
+            if (events) {
+                dispatch(ids[i], events);
+            }
+        }
+    }
+}
+
+u64id_t Reactor::add(socket_t descriptor, uint events, ReactorHandler handler) {
+    std::lock_guard lock(mutex);
+    u64id_t id = nextId++;
+    registrations[id] = Registration {
+        descriptor,
+        events,
+        std::make_shared<ReactorHandler>(std::move(handler))
+    };
+    modified = true;
+    wakeup();
+    return id;
+}
+
+void Reactor::modify(u64id_t id, uint events) {
+    std::lock_guard lock(mutex);
+    const auto& found = registrations.find(id);
+    if (found == registrations.end() || found->second.events == events) {
+        return;
+    }
+    found->second.events = events;
+    modified = true;
+    wakeup();
+}
+
+#endif
+
+void Reactor::dispatch(u64id_t id, uint events) {
+    std::shared_ptr<ReactorHandler> handler;
+    {
+        std::lock_guard lock(mutex);
+        const auto& found = registrations.find(id);
+        // events of the removed registration may be left in the batch
+        if (found == registrations.end()) {
+            return;
+        }
+        handler = found->second.handler;
+        dispatching = id;
+    }
+    try {
+        (*handler)(events);
+    } catch (const std::exception& err) {
+        logger.error() << "socket events handler failed: " << err.what();
+    }
+    {
+        std::lock_guard lock(mutex);
+        dispatching = 0;
+    }
+    dispatchCv.notify_all();
+}
+
+void Reactor::remove(u64id_t id) {
+    std::unique_lock lock(mutex);
+    const auto& found = registrations.find(id);
+    if (found != registrations.end()) {
+#ifdef __linux__
+        epoll_ctl(epollfd, EPOLL_CTL_DEL, found->second.descriptor, nullptr);
+#else
+        modified = true;
+        wakeup();
+#endif
+        registrations.erase(found);
+    }
+    // handler may be still running even if removed by itself
+    if (std::this_thread::get_id() != thread.get_id()) {
+        dispatchCv.wait(lock, [this, id]() { return dispatching != id; });
+    }
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "typedefs.hpp"
+
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace network {
+#ifdef _WIN32
+    using socket_t = uintptr_t;
+#else
+    using socket_t = int;
+#endif
+
+    /// @brief Socket readiness events mask bits
+    enum ReactorEvent : uint {
+        EVENT_READ = 1,
+        EVENT_WRITE = 2,
+        /// @brief Error or hang up, reported regardless of watched events
+        EVENT_ERROR = 4,
+    };
+
+    using ReactorHandler = std::function<void(uint events)>;
+
+    /// @brief Single thread event loop dispatching readiness events of
+    /// non-blocking sockets (epoll on Linux, poll on other platforms).
+    /// Handlers are called in the reactor thread and must not block
+    class Reactor {
+        struct Registration {
+            socket_t descriptor;
+            uint events;
+            std::shared_ptr<ReactorHandler> handler;
+        };
+        std::unordered_map<u64id_t, Registration> registrations;
+        u64id_t nextId = 1;
+        /// @brief Id of registration which handler is being called
+        u64id_t dispatching = 0;
+        std::mutex mutex;
+        std::condition_variable dispatchCv;
+        bool running = true;
+        std::thread thread;
+#ifdef __linux__
+        int epollfd;
+        int wakeupfd;
+#else
+        /// @brief Self-pipe interrupting poll (see create_wakeup_pair)
+        socket_t wakeupReader;
+        socket_t wakeupWriter;
+        /// @brief Registrations changed since the poll set was built
+        bool modified = true;
+#endif
+        void loop();
+        void dispatch(u64id_t id, uint events);
+        void wakeup();
+    public:
+        Reactor();
+        ~Reactor();
+
+        /// @brief Start watching socket events
+        /// @param descriptor non-blocking socket
+        /// @param events watched events mask
+        /// @param handler events handler
+        /// @return registration id
+        u64id_t add(socket_t descriptor, uint events, ReactorHandler handler);
+
+        /// @brief Change watched events of the registration
+        void modify(u64id_t id, uint events);
+
+        /// @brief Stop watching socket events. Must be called before the
+        /// socket is closed. When called outside of the reactor thread,
+        /// waits until the registration handler returns
+        void remove(u64id_t id);
+    };
+}
@@ -3,10 +3,10 @@
 #pragma comment(lib, "Ws2_32.lib")
 
 #define NOMINMAX
+#include <atomic>
 #include <stdexcept>
 #include <limits>
 #include <queue>
-#include <thread>
 
 #ifdef _WIN32
 #include <curl/curl.h>
@@ -26,6 +26,8 @@ using SOCKET = int;
 #endif // _WIN32
 
 #include "Network.hpp"
+#include "Reactor.hpp"
+#include "util/RingBuffer.hpp"
 #include "util/stringutil.hpp"
 #include "debug/Logger.hpp"
 
@@ -37,16 +39,49 @@ static debug::Logger logger("sockets");
 static inline int closesocket(int descriptor) noexcept {
     return close(descriptor);
 }
-static inline std::runtime_error handle_socket_error(const std::string& message) {
-    int err = errno;
+static inline int socket_error() noexcept {
+    return errno;
+}
+static inline bool would_block(int err) noexcept {
+    return err == EAGAIN || err == EWOULDBLOCK;
+}
+static inline bool connect_in_progress(int err) noexcept {
+    return err == EINPROGRESS;
+}
+static void set_nonblocking(SOCKET descriptor, bool flag=true) {
+    int flags = fcntl(descriptor, F_GETFL, 0);
+    if (flags == -1 || fcntl(descriptor, F_SETFL, flag ? (flags | O_NONBLOCK)
+                                                       : (flags & ~O_NONBLOCK))) {
+        throw std::runtime_error("fcntl(O_NONBLOCK) failed");
+    }
+}
+static inline std::runtime_error make_socket_error(
+    const std::string& message, int err
+) {
     return std::runtime_error(
         message+" [errno=" + std::to_string(err) + "]: " + 
         std::string(strerror(err))
     );
 }
 #else
-static inline std::runtime_error handle_socket_error(const std::string& message) {
-    int errorCode = WSAGetLastError();
+static inline int socket_error() noexcept {
+    return WSAGetLastError();
+}
+static inline bool would_block(int err) noexcept {
+    return err == WSAEWOULDBLOCK;
+}
+static inline bool connect_in_progress(int err) noexcept {
+    return err == WSAEWOULDBLOCK;
+}
+static void set_nonblocking(SOCKET descriptor, bool flag=true) {
+    u_long mode = flag ? 1 : 0;
+    if (ioctlsocket(descriptor, FIONBIO, &mode)) {
+        throw std::runtime_error("ioctlsocket(FIONBIO) failed");
+    }
+}
+static inline std::runtime_error make_socket_error(
+    const std::string& message, int errorCode
+) {
     wchar_t* s = nullptr;
     size_t size = FormatMessageW(
         FORMAT_MESSAGE_ALLOCATE_BUFFER | FORMAT_MESSAGE_FROM_SYSTEM |
@@ -69,6 +104,16 @@ static inline std::runtime_error handle_socket_error(const std::string& message)
 }
 #endif
 
+static inline std::runtime_error handle_socket_error(const std::string& message) {
+    return make_socket_error(message, socket_error());
+}
+
+#ifdef MSG_NOSIGNAL
+static constexpr int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+static constexpr int SEND_FLAGS = 0;
+#endif
+
 static inline int connectsocket(
     int descriptor, const sockaddr* addr, socklen_t len
 ) noexcept {
@@ -97,43 +142,210 @@ static std::string to_string(const sockaddr_in& addr, bool port=true) {
 }
 
 class SocketTcpConnection : public TcpConnection {
+    Reactor& reactor;
     SOCKET descriptor;
     sockaddr_in addr;
-    size_t totalUpload = 0;
-    size_t totalDownload = 0;
-    ConnectionState state = ConnectionState::INITIAL;
-    std::unique_ptr<std::thread> thread = nullptr;
-    std::vector<char> readBatch;
+    u64id_t registration = 0;
+    std::atomic<size_t> totalUpload = 0;
+    std::atomic<size_t> totalDownload = 0;
+    std::atomic<ConnectionState> state = ConnectionState::INITIAL;
+    bool socketClosed = false;
+    /// @brief Reading is paused until the receive queue has free space
+    bool readPaused = false;
+    /// @brief Receive queue filled by the reactor thread
+    util::RingBuffer<char> readBatch;
+    /// @brief Data not accepted by the socket yet
+    std::vector<char> writeBatch;
+    /// @brief Bytes of writeBatch already sent
+    size_t writeOffset = 0;
+    /// @brief Receive buffer used in the reactor thread
     util::Buffer<char> buffer;
     std::mutex mutex;
-    std::string errorMessage;
+    runnable connectCallback;
+    stringconsumer connectErrorCallback;
 
-    void connectSocket() {
-        state = ConnectionState::CONNECTING;
-        logger.info() << "connecting to " << to_string(addr);
-        int res = connectsocket(descriptor, (const sockaddr*)&addr, sizeof(sockaddr_in));
-        if (res < 0) {
-            auto error = handle_socket_error("Connect failed");
+    /// @brief Events to watch for connected socket (mutex must be locked)
+    uint watchedEvents() const {
+        return (readPaused ? 0u : static_cast<uint>(EVENT_READ)) |
+               (writeBatch.empty() ? 0u : static_cast<uint>(EVENT_WRITE));
+    }
+
+    void registerSocket(uint events) {
+        std::lock_guard lock(mutex);
+        registration = reactor.add(descriptor, events, [this](uint events) {
+            handleEvents(events);
+        });
+    }
+
+    void closeSocket() {
+        u64id_t registration;
+        {
+            std::lock_guard lock(mutex);
+            registration = this->registration;
+        }
+        reactor.remove(registration);
+
+        std::lock_guard lock(mutex);
+        if (!socketClosed) {
+            socketClosed = true;
+            shutdown(descriptor, SHUT_RDWR);
             closesocket(descriptor);
-            state = ConnectionState::CLOSED;
-            errorMessage = error.what();
+        }
+        state = ConnectionState::CLOSED;
+    }
+
+    void handleEvents(uint events) {
+        if (state == ConnectionState::CONNECTING) {
+            finishConnect();
+            return;
+        }
+        if (events & EVENT_WRITE) {
+            flush();
+        }
+        if (events & (EVENT_READ | EVENT_ERROR)) {
+            bool paused;
+            {
+                std::lock_guard lock(mutex);
+                paused = readPaused;
+            }
+            if (!paused) {
+                receive();
+            } else if (events & EVENT_ERROR) {
+                // connection is broken, received data is still available
+                closeSocket();
+            }
+        }
+    }
+
+    /// @brief Stop reading the socket if the receive queue is full,
+    /// so the sender is slowed down by TCP flow control
+    /// @return true if paused
+    bool pauseIfFull() {
+        std::lock_guard lock(mutex);
+        if (readBatch.freeSpace() > 0) {
+            return false;
+        }
+        readPaused = true;
+        reactor.modify(registration, watchedEvents());
+        return true;
+    }
+
+    void finishConnect() {
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (getsockopt(
+                descriptor, SOL_SOCKET, SO_ERROR, (char*)&error, &len
+            ) < 0) {
+            error = socket_error();
+        }
+        if (error) {
+            closeSocket();
+            std::string errorMessage =
+                make_socket_error("Connect failed", error).what();
             logger.error() << errorMessage;
+            if (connectErrorCallback) {
+                connectErrorCallback(errorMessage);
+            }
             return;
         }
         logger.info() << "connected to " << to_string(addr);
-        state = ConnectionState::CONNECTED;
+        {
+            std::lock_guard lock(mutex);
+            state = ConnectionState::CONNECTED;
+            reactor.modify(registration, watchedEvents());
+        }
+        if (connectCallback) {
+            connectCallback();
+        }
     }
-public:
-    SocketTcpConnection(SOCKET descriptor, sockaddr_in addr)
-        : descriptor(descriptor), addr(std::move(addr)), buffer(16'384) {}
 
-    ~SocketTcpConnection() {
-        if (state != ConnectionState::CLOSED) {
-            shutdown(descriptor, 2);
+    void receive() {
+        if (pauseIfFull()) {
+            return;
         }
-        if (thread) {
-            thread->join();
+        // single read per event, level-triggered reactor reports the rest
+        int size = recvsocket(
+            descriptor,
+            buffer.data(),
+            std::min(buffer.size(), readBatch.freeSpace())
+        );
+        if (size > 0) {
+            readBatch.write(buffer.data(), size);
+            totalDownload += size;
+            pauseIfFull();
+            return;
         }
+        if (size == 0) {
+            logger.info() << "closed connection with " << to_string(addr);
+            closeSocket();
+            return;
+        }
+        int err = socket_error();
+        if (would_block(err)) {
+            return;
+        }
+        logger.warning() << "an error ocurred while receiving from "
+                         << to_string(addr);
+        logger.error() << make_socket_error("recv(...) error", err).what();
+        closeSocket();
+    }
+
+    void flush() {
+        bool failed = false;
+        {
+            std::lock_guard lock(mutex);
+            if (socketClosed) {
+                return;
+            }
+            size_t& offset = writeOffset;
+            while (offset < writeBatch.size()) {
+                int len = sendsocket(
+                    descriptor,
+                    writeBatch.data() + offset,
+                    writeBatch.size() - offset,
+                    SEND_FLAGS
+                );
+                if (len < 0) {
+                    int err = socket_error();
+                    if (!would_block(err)) {
+                        logger.error()
+                            << make_socket_error("send failed", err).what();
+                        failed = true;
+                    }
+                    break;
+                }
+                offset += len;
+                totalUpload += len;
+            }
+            if (offset == writeBatch.size()) {
+                writeBatch.clear();
+                offset = 0;
+            } else if (offset > writeBatch.size() / 2) {
+                // sent bytes are dropped when it's amortized
+                writeBatch.erase(writeBatch.begin(), writeBatch.begin() + offset);
+                offset = 0;
+            }
+            reactor.modify(registration, watchedEvents());
+        }
+        if (failed) {
+            closeSocket();
+        }
+    }
+public:
+    SocketTcpConnection(
+        Reactor& reactor,
+        SOCKET descriptor,
+        sockaddr_in addr,
+        size_t receiveBufferSize
+    )
+        : reactor(reactor),
+          descriptor(descriptor),
+          addr(std::move(addr)),
+          readBatch(receiveBufferSize),
+          buffer(16'384) {}
+
+    ~SocketTcpConnection() {
+        closeSocket();
     }
 
     void setNoDelay(bool noDelay) override {
@@ -152,110 +364,114 @@ public:
         return opt != 0;
     }
 
-    void startListen() {
-        while (state == ConnectionState::CONNECTED) {
-            int size = recvsocket(descriptor, buffer.data(), buffer.size());
-            if (size == 0) {
-                logger.info() << "closed connection with " << to_string(addr);
-                closesocket(descriptor);
-                state = ConnectionState::CLOSED;
-                break;
-            } else if (size < 0) {
-                logger.warning() << "an error ocurred while receiving from "
-                            << to_string(addr);
-                auto error = handle_socket_error("recv(...) error");
-                closesocket(descriptor);
-                state = ConnectionState::CLOSED;
-                logger.error() << error.what();
-                break;
-            }
-            {
-                std::lock_guard lock(mutex);
-                for (size_t i = 0; i < size; i++) {
-                    readBatch.emplace_back(buffer[i]);
-                }
-                totalDownload += size;
-            }
-        }
-    }
-
     void startClient() {
+        set_nonblocking(descriptor);
         state = ConnectionState::CONNECTED;
-        thread = std::make_unique<std::thread>([this]() { startListen();});
+        registerSocket(EVENT_READ);
     }
 
     void connect(runnable callback, stringconsumer errorCallback) override {
-        thread = std::make_unique<std::thread>([this, callback, errorCallback]() {
-            connectSocket();
-            if (state == ConnectionState::CONNECTED) {
-                callback();
-                startListen();
-            } else {
-                errorCallback(errorMessage);
+        connectCallback = std::move(callback);
+        connectErrorCallback = std::move(errorCallback);
+
+        set_nonblocking(descriptor);
+        state = ConnectionState::CONNECTING;
+        logger.info() << "connecting to " << to_string(addr);
+        int res = connectsocket(descriptor, (const sockaddr*)&addr, sizeof(sockaddr_in));
+        if (res < 0 && !connect_in_progress(socket_error())) {
+            auto error = handle_socket_error("Connect failed");
+            closeSocket();
+            logger.error() << error.what();
+            if (connectErrorCallback) {
+                connectErrorCallback(error.what());
             }
-        });
+            return;
+        }
+        // connection is established when the socket becomes writable
+        registerSocket(EVENT_WRITE);
     }
 
     int recv(char* buffer, size_t length) override {
-        std::lock_guard lock(mutex);
-
         if (state != ConnectionState::CONNECTED && readBatch.empty()) {
             return -1;
         }
-        int size = std::min(readBatch.size(), length);
-        std::memcpy(buffer, readBatch.data(), size);
-        readBatch.erase(readBatch.begin(), readBatch.begin() + size);
+        int size = readBatch.read(buffer, length);
+
+        std::lock_guard lock(mutex);
+        if (readPaused && readBatch.freeSpace() > 0) {
+            readPaused = false;
+            reactor.modify(registration, watchedEvents());
+        }
         return size;
     }
 
     int send(const char* buffer, size_t length) override {
-        if (state == ConnectionState::CLOSED) {
+        std::unique_lock lock(mutex);
+        if (state == ConnectionState::CLOSED || socketClosed) {
             return 0;
         }
-        int len = sendsocket(descriptor, buffer, length, 0);
-        if (len == -1) {
-            int err = errno;
-            close();
-            throw std::runtime_error(
-                "Send failed [errno=" + std::to_string(err) + "]: "
-                 + std::string(strerror(err))
-            );
+        size_t sent = 0;
+        if (state == ConnectionState::CONNECTED && writeBatch.empty()) {
+            int len = sendsocket(descriptor, buffer, length, SEND_FLAGS);
+            if (len < 0) {
+                int err = socket_error();
+                if (!would_block(err)) {
+                    lock.unlock();
+                    close();
+                    throw make_socket_error("Send failed", err);
+                }
+                len = 0;
+            }
+            sent = len;
+            totalUpload += len;
         }
-        totalUpload += len;
-        return len;
+        if (sent < length) {
+            // sent by the reactor when the socket becomes writable
+            writeBatch.insert(writeBatch.end(), buffer + sent, buffer + length);
+            if (state == ConnectionState::CONNECTED) {
+                reactor.modify(registration, watchedEvents());
+            }
+        }
+        return length;
     }
 
     int available() override {
-        std::lock_guard lock(mutex);
         return readBatch.size();
     }
 
     void close(bool discardAll=false) override {
+        u64id_t registration;
+        {
+            std::lock_guard lock(mutex);
+            registration = this->registration;
+        }
+        reactor.remove(registration);
         {
             std::lock_guard lock(mutex);
             readBatch.clear();
-
-            if (state != ConnectionState::CLOSED) {
-                shutdown(descriptor, SHUT_RDWR);
-                closesocket(descriptor);
+            if (!discardAll && !socketClosed && !writeBatch.empty() &&
+                state == ConnectionState::CONNECTED) {
+                // send the rest of queued data before closing
+                set_nonblocking(descriptor, false);
+                sendsocket(
+                    descriptor,
+                    writeBatch.data() + writeOffset,
+                    writeBatch.size() - writeOffset,
+                    SEND_FLAGS
+                );
             }
+            writeBatch.clear();
+            writeOffset = 0;
         }
-        if (thread) {
-            thread->join();
-            thread = nullptr;
-        }
+        closeSocket();
     }
 
     size_t pullUpload() override {
-        size_t size = totalUpload;
-        totalUpload = 0;
-        return size;
+        return totalUpload.exchange(0);
     }
 
     size_t pullDownload() override {
-        size_t size = totalDownload;
-        totalDownload = 0;
-        return size;
+        return totalDownload.exchange(0);
     }
 
     int getPort() const override {
@@ -267,6 +483,8 @@ public:
     }
 
     static std::shared_ptr<SocketTcpConnection> connect(
+        Reactor& reactor,
+        size_t receiveBufferSize,
         const std::string& address,
         int port,
         runnable callback,
@@ -301,7 +519,9 @@ public:
             }
             throw std::runtime_error(errorMessage);
         }
-        auto socket = std::make_shared<SocketTcpConnection>(descriptor, std::move(serverAddress));
+        auto socket = std::make_shared<SocketTcpConnection>(
+            reactor, descriptor, std::move(serverAddress), receiveBufferSize
+        );
         socket->connect(std::move(callback), std::move(errorCallback));
         return socket;
     }
@@ -314,19 +534,75 @@ public:
 class SocketTcpServer : public TcpServer {
     u64id_t id;
     Network* network;
+    Reactor& reactor;
     SOCKET descriptor;
+    u64id_t registration = 0;
     std::vector<u64id_t> clients;
     std::mutex clientsMutex;
-    bool open = true;
-    std::unique_ptr<std::thread> thread = nullptr;
+    std::atomic<bool> open = true;
+    bool closing = false;
     int port;
-    int maxConnected = -1;
+    std::atomic<int> maxConnected = -1;
+    size_t receiveBufferSize;
+    ConnectCallback handler;
+
+    void acceptClients() {
+        while (true) {
+            socklen_t addrlen = sizeof(sockaddr_in);
+            SOCKET clientDescriptor;
+            sockaddr_in address;
+            if ((clientDescriptor = accept(descriptor, (sockaddr*)&address, &addrlen)) == -1) {
+                int err = socket_error();
+                if (would_block(err)) {
+                    return;
+                }
+                logger.error() << make_socket_error("accept failed", err).what();
+                closeSocket();
+                return;
+            }
+            size_t connected;
+            {
+                std::lock_guard lock(clientsMutex);
+                connected = clients.size();
+            }
+            if (maxConnected >= 0 && connected >= maxConnected) {
+                logger.info() << "refused connection attempt from " << to_string(address);
+                closesocket(clientDescriptor);
+                continue;
+            }
+            logger.info() << "client connected: " << to_string(address);
+            auto socket = std::make_shared<SocketTcpConnection>(
+                reactor, clientDescriptor, address, receiveBufferSize
+            );
+            socket->startClient();
+            u64id_t id = network->addConnection(socket);
+            {
+                std::lock_guard lock(clientsMutex);
+                clients.push_back(id);
+            }
+            handler(this->id, id);
+        }
+    }
 public:
-    SocketTcpServer(u64id_t id, Network* network, SOCKET descriptor, int port)
-    : id(id), network(network), descriptor(descriptor), port(port) {}
+    SocketTcpServer(
+        u64id_t id,
+        Network* network,
+        Reactor& reactor,
+        SOCKET descriptor,
+        int port,
+        size_t receiveBufferSize
+    )
+    : id(id),
+      network(network),
+      reactor(reactor),
+      descriptor(descriptor),
+      port(port),
+      receiveBufferSize(receiveBufferSize) {}
 
     ~SocketTcpServer() {
         closeSocket();
+        // wait for the accepting handler if closing from the reactor thread
+        reactor.remove(registration);
     }
 
     void setMaxClientsConnected(int count) override {
@@ -334,6 +610,7 @@ public:
     }
 
     void update() override {
+        std::lock_guard lock(clientsMutex);
         std::vector<u64id_t> clients;
         for (u64id_t cid : this->clients) {
             if (auto client = network->getConnection(cid, true)) {
@@ -346,61 +623,42 @@ public:
     }
 
     void startListen(ConnectCallback handler) override {
-        thread = std::make_unique<std::thread>([this, handler]() {
-            while (open) {
-                logger.info() << "listening for connections";
-                if (listen(descriptor, 2) < 0) {
-                    close();
-                    break;
-                }
-                socklen_t addrlen = sizeof(sockaddr_in);
-                SOCKET clientDescriptor;
-                sockaddr_in address;
-                logger.info() << "accepting clients";
-                if ((clientDescriptor = accept(descriptor, (sockaddr*)&address, &addrlen)) == -1) {
-                    close();
-                    break;
-                }
-                if (maxConnected >= 0 && clients.size() >= maxConnected) {
-                    logger.info() << "refused connection attempt from " << to_string(address);
-                    closesocket(clientDescriptor);
-                    continue;
-                }
-                logger.info() << "client connected: " << to_string(address);
-                auto socket = std::make_shared<SocketTcpConnection>(
-                    clientDescriptor, address
-                );
-                socket->startClient();
-                u64id_t id = network->addConnection(socket);
-                {
-                    std::lock_guard lock(clientsMutex);
-                    clients.push_back(id);
-                }
-                handler(this->id, id);
-            }
+        this->handler = std::move(handler);
+
+        logger.info() << "listening for connections";
+        if (listen(descriptor, SOMAXCONN) < 0) {
+            throw handle_socket_error("listen failed");
+        }
+        set_nonblocking(descriptor);
+        std::lock_guard lock(clientsMutex);
+        registration = reactor.add(descriptor, EVENT_READ, [this](uint) {
+            acceptClients();
         });
     }
     
     void closeSocket() {
-        if (!open) {
-            return;
-        }
-        logger.info() << "closing server";
-        open = false;
-
+        std::vector<u64id_t> clients;
+        u64id_t registration;
         {
             std::lock_guard lock(clientsMutex);
-            for (u64id_t clientid : clients) {
-                if (auto client = network->getConnection(clientid, true)) {
-                    client->close();
-                }
+            if (closing) {
+                return;
             }
+            closing = true;
+            registration = this->registration;
+            std::swap(clients, this->clients);
         }
-        clients.clear();
+        logger.info() << "closing server";
+        reactor.remove(registration);
 
+        for (u64id_t clientid : clients) {
+            if (auto client = network->getConnection(clientid, true)) {
+                client->close();
+            }
+        }
         shutdown(descriptor, 2);
         closesocket(descriptor);
-        thread->join();
+        open = false;
     }
 
     void close() override {
@@ -416,7 +674,12 @@ public:
     }
 
     static std::shared_ptr<SocketTcpServer> openServer(
-        u64id_t id, Network* network, int port, ConnectCallback handler
+        u64id_t id,
+        Network* network,
+        Reactor& reactor,
+        size_t receiveBufferSize,
+        int port,
+        ConnectCallback handler
     ) {
         SOCKET descriptor = socket(
             AF_INET, SOCK_STREAM, 0
@@ -445,8 +708,9 @@ public:
         }
         port = ntohs(address.sin_port);
         logger.info() << "opened server at port " << port;
-        auto server =
-            std::make_shared<SocketTcpServer>(id, network, descriptor, port);
+        auto server = std::make_shared<SocketTcpServer>(
+            id, network, reactor, descriptor, port, receiveBufferSize
+        );
         server->startListen(std::move(handler));
         return server;
     }
@@ -474,26 +738,75 @@ static sockaddr_in resolve_address_dgram(const std::string& address, int port) {
 
 class SocketUdpConnection : public UdpConnection {
     u64id_t id;
+    Reactor& reactor;
     SOCKET descriptor;
     sockaddr_in addr{};
-    bool open = true;
-    std::unique_ptr<std::thread> thread;
+    std::atomic<bool> open = true;
+    bool socketClosed = false;
+    u64id_t registration = 0;
+    std::mutex mutex;
     ClientDatagramCallback callback;
+    /// @brief Receive buffer used in the reactor thread
+    util::Buffer<char> buffer;
 
-    size_t totalUpload = 0;
-    size_t totalDownload = 0;
-    ConnectionState state = ConnectionState::INITIAL;
+    std::atomic<size_t> totalUpload = 0;
+    std::atomic<size_t> totalDownload = 0;
+    std::atomic<ConnectionState> state = ConnectionState::INITIAL;
 
+    void closeSocket() {
+        u64id_t registration;
+        {
+            std::lock_guard lock(mutex);
+            registration = this->registration;
+        }
+        reactor.remove(registration);
+
+        std::lock_guard lock(mutex);
+        if (!socketClosed) {
+            socketClosed = true;
+            shutdown(descriptor, 2);
+            closesocket(descriptor);
+        }
+        state = ConnectionState::CLOSED;
+    }
+
+    void receive() {
+        while (true) {
+            int size = recv(descriptor, buffer.data(), buffer.size(), 0);
+            if (size < 0) {
+                int err = socket_error();
+                if (would_block(err)) {
+                    return;
+                }
+                logger.error() << "udp connection " << id
+                               << make_socket_error(" recv error", err).what();
+                closeSocket();
+                return;
+            }
+            totalDownload += size;
+            if (callback) {
+                callback(id, buffer.data(), size);
+            }
+        }
+    }
 public:
-    SocketUdpConnection(u64id_t id, SOCKET descriptor, sockaddr_in addr)
-        : id(id), descriptor(descriptor), addr(std::move(addr)) {}
+    SocketUdpConnection(
+        u64id_t id, Reactor& reactor, SOCKET descriptor, sockaddr_in addr
+    )
+        : id(id),
+          reactor(reactor),
+          descriptor(descriptor),
+          addr(std::move(addr)),
+          buffer(16'384) {}
 
     ~SocketUdpConnection() override {
         SocketUdpConnection::close();
+        closeSocket();
     }
 
     static std::shared_ptr<SocketUdpConnection> connect(
         u64id_t id,
+        Reactor& reactor,
         const std::string& address,
         int port,
         ClientDatagramCallback handler,
@@ -512,7 +825,9 @@ public:
             throw err;
         }
 
-        auto socket = std::make_shared<SocketUdpConnection>(id, descriptor, serverAddr);
+        auto socket = std::make_shared<SocketUdpConnection>(
+            id, reactor, descriptor, serverAddr
+        );
         socket->connect(std::move(handler));
 
         callback();
@@ -524,65 +839,46 @@ public:
         callback = std::move(handler);
         state = ConnectionState::CONNECTED;
 
-        thread = std::make_unique<std::thread>([this]() {
-            util::Buffer<char> buffer(16'384);
-            while (open) {
-                int size = recv(descriptor, buffer.data(), buffer.size(), 0);
-                if (size <= 0) {
-                    logger.error() << "udp connection " << id
-                                   << handle_socket_error(" recv error").what();
-                    if (!open) break;
-                    closesocket(descriptor);
-                    state = ConnectionState::CLOSED;
-                    break;
-                }
-                totalDownload += size;
-                if (callback) {
-                    callback(id, buffer.data(), size);
-                }
-            }
+        set_nonblocking(descriptor);
+        std::lock_guard lock(mutex);
+        registration = reactor.add(descriptor, EVENT_READ, [this](uint) {
+            receive();
         });
     }
 
     int send(const char* buffer, size_t length) override {
-        int len = ::send(descriptor, buffer, length, 0);
+        std::unique_lock lock(mutex);
+        if (socketClosed) {
+            return -1;
+        }
+        int len = ::send(descriptor, buffer, length, SEND_FLAGS);
         if (len < 0) {
-            auto err = handle_socket_error(" send failed");
-            closesocket(descriptor);
-            state = ConnectionState::CLOSED;
-            logger.error() << "udp connection " << id << err.what();
+            int err = socket_error();
+            if (would_block(err)) {
+                // datagram is dropped as if lost in the network
+                return 0;
+            }
+            lock.unlock();
+            closeSocket();
+            logger.error() << "udp connection " << id
+                           << make_socket_error(" send failed", err).what();
         } else totalUpload += len;
 
         return len;
     }
 
     void close(bool discardAll=false) override {
-        if (!open) return;
-        open = false;
+        if (!open.exchange(false)) return;
         logger.info() << "closing udp connection "<< id;
-
-        if (state != ConnectionState::CLOSED) {
-            shutdown(descriptor, 2);
-            closesocket(descriptor);
-        }
-
-        if (thread) {
-            thread->join();
-            thread.reset();
-        }
-        state = ConnectionState::CLOSED;
+        closeSocket();
     }
 
     size_t pullUpload() override {
-        size_t s = totalUpload;
-        totalUpload = 0;
-        return s;
+        return totalUpload.exchange(0);
     }
 
     size_t pullDownload() override {
-        size_t s = totalDownload;
-        totalDownload = 0;
-        return s;
+        return totalDownload.exchange(0);
     }
 
     [[nodiscard]] int getPort() const override {
@@ -600,15 +896,40 @@ public:
 
 class SocketUdpServer : public UdpServer {
     u64id_t id;
+    Reactor& reactor;
     SOCKET descriptor;
-    bool open = true;
-    std::unique_ptr<std::thread> thread = nullptr;
+    std::atomic<bool> open = true;
+    u64id_t registration = 0;
     int port;
     ServerDatagramCallback callback;
+    /// @brief Receive buffer used in the reactor thread
+    util::Buffer<char> buffer;
 
+    void receive() {
+        while (true) {
+            sockaddr_in clientAddr{};
+            socklen_t addrlen = sizeof(clientAddr);
+            int size = recvfrom(descriptor, buffer.data(), buffer.size(), 0,
+                                reinterpret_cast<sockaddr*>(&clientAddr), &addrlen);
+            if (size < 0) {
+                if (would_block(socket_error())) {
+                    return;
+                }
+                continue;
+            }
+            std::string addrStr = to_string(clientAddr, false);
+            int port = ntohs(clientAddr.sin_port);
+
+            callback(id, addrStr, port, buffer.data(), size);
+        }
+    }
 public:
-    SocketUdpServer(u64id_t id, Network* network, SOCKET descriptor, int port)
-        : id(id), descriptor(descriptor), port(port) {}
+    SocketUdpServer(u64id_t id, Reactor& reactor, SOCKET descriptor, int port)
+        : id(id),
+          reactor(reactor),
+          descriptor(descriptor),
+          port(port),
+          buffer(16'384) {}
 
     ~SocketUdpServer() override {
         SocketUdpServer::close();
@@ -619,51 +940,32 @@ public:
     void startListen(ServerDatagramCallback handler) override {
         callback = std::move(handler);
 
-        thread = std::make_unique<std::thread>([this]() {
-            util::Buffer<char> buffer(16384);
-            sockaddr_in clientAddr{};
-            socklen_t addrlen = sizeof(clientAddr);
-
-            while (open) {
-                int size = recvfrom(descriptor, buffer.data(), buffer.size(), 0,
-                                    reinterpret_cast<sockaddr*>(&clientAddr), &addrlen);
-                if (size <= 0) {
-                    if (!open) break;
-                    continue;
-                }
-
-                std::string addrStr = to_string(clientAddr, false);
-                int port = ntohs(clientAddr.sin_port);
-
-                callback(id, addrStr, port, buffer.data(), size);
-            }
+        set_nonblocking(descriptor);
+        registration = reactor.add(descriptor, EVENT_READ, [this](uint) {
+            receive();
         });
     }
 
     void sendTo(const std::string& addr, int port, const char* buffer, size_t length) override {
         sockaddr_in client = resolve_address_dgram(addr, port);
-        if (sendto(descriptor, buffer, length, 0,
+        if (sendto(descriptor, buffer, length, SEND_FLAGS,
                reinterpret_cast<sockaddr*>(&client), sizeof(client)) < 0) {
             logger.error() << handle_socket_error("sendto").what();
         }
     }
 
     void close() override {
-        if (!open) return;
-        open = false;
+        if (!open.exchange(false)) return;
+        reactor.remove(registration);
         shutdown(descriptor, 2);
         closesocket(descriptor);
-        if (thread) {
-            thread->join();
-            thread = nullptr;
-        }
     }
 
     bool isOpen() override { return open; }
     int getPort() const override { return port; }
 
     static std::shared_ptr<SocketUdpServer> openServer(
-        u64id_t id, Network* network, int port, const ServerDatagramCallback& handler
+        u64id_t id, Reactor& reactor, int port, const ServerDatagramCallback& handler
     ) {
         SOCKET descriptor = socket(AF_INET, SOCK_DGRAM, 0);
         if (descriptor == -1) throw std::runtime_error("could not create udp socket");
@@ -678,7 +980,7 @@ public:
             throw std::runtime_error("could not bind udp port " + std::to_string(port));
         }
 
-        auto server = std::make_shared<SocketUdpServer>(id, network, descriptor, port);
+        auto server = std::make_shared<SocketUdpServer>(id, reactor, descriptor, port);
         server->startListen(std::move(handler));
         return server;
     }
@@ -686,41 +988,51 @@ public:
 
 namespace network {
     std::shared_ptr<TcpConnection> connect_tcp(
+        Reactor& reactor,
+        size_t receiveBufferSize,
         const std::string& address,
         int port,
         runnable callback,
         stringconsumer errorCallback
     ) {
         return SocketTcpConnection::connect(
-            address, port, std::move(callback), std::move(errorCallback)
+            reactor, receiveBufferSize, address, port, std::move(callback), std::move(errorCallback)
         );
     }
 
     std::shared_ptr<TcpServer> open_tcp_server(
-        u64id_t id, Network* network, int port, ConnectCallback handler
+        u64id_t id,
+        Network* network,
+        Reactor& reactor,
+        size_t receiveBufferSize,
+        int port,
+        ConnectCallback handler
     ) {
-        return SocketTcpServer::openServer(id, network, port, std::move(handler));
+        return SocketTcpServer::openServer(
+            id, network, reactor, receiveBufferSize, port, std::move(handler)
+        );
     }
 
     std::shared_ptr<UdpConnection> connect_udp(
         u64id_t id,
+        Reactor& reactor,
         const std::string& address,
         int port,
         ClientDatagramCallback handler,
         runnable callback
     ) {
         return SocketUdpConnection::connect(
-            id, address, port, std::move(handler), std::move(callback)
+            id, reactor, address, port, std::move(handler), std::move(callback)
         );
     }
 
     std::shared_ptr<UdpServer> open_udp_server(
         u64id_t id,
-        Network* network,
+        Reactor& reactor,
         int port,
         const ServerDatagramCallback& handler
     ) {
-        return SocketUdpServer::openServer(id, network, port, handler);
+        return SocketUdpServer::openServer(id, reactor, port, handler);
     }
 
     int find_free_port() {
@@ -295,6 +295,7 @@ void Entities::preparePhysics(float delta) {
     auto& physics = *level.physics;
     auto& hitboxes = physics.getHitboxesWriteable();
     auto& solidHitboxes = physics.getSolidHitboxesWriteable();
+    auto& sleepingHitboxes = physics.getSleepingHitboxesWriteable();
 
     if (int parts = sensorsTickClock.update(delta)) {
         for (int i = 0; i < parts; i++) {
@@ -319,6 +320,7 @@ void Entities::preparePhysics(float delta) {
 
     hitboxes.clear();
     solidHitboxes.clear();
+    sleepingHitboxes.clear();
 
     auto view = registry->view<EntityId, Rigidbody>();
     for (auto [entity, eid, rigidbody] : view.each()) {
@@ -330,6 +332,14 @@ void Entities::preparePhysics(float delta) {
                             ? rigidbody.mass
                             : std::numeric_limits<float>::infinity();
         rigidbody.hitbox.elasticity = rigidbody.elasticity;
+        // sleeping bodies are obstacles only
+        if (physics.updateSleeping(rigidbody.hitbox)) {
+            sleepingHitboxes.emplace_back(&rigidbody.hitbox);
+            if (eid.def.solid) {
+                solidHitboxes.emplace_back(&rigidbody.hitbox);
+            }
+            continue;
+        }
         hitboxes.emplace_back(&rigidbody.hitbox);
         if (!eid.def.solid) {
             continue;
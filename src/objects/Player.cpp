@@ -14,6 +14,7 @@
 #include "physics/Hitbox.hpp"
 #include "physics/PhysicsSolver.hpp"
 #include "voxels/Chunks.hpp"
+#include "voxels/GlobalChunks.hpp"
 #include "window/Camera.hpp"
 #include "world/Level.hpp"
 #include "world/World.hpp"
@@ -54,6 +55,9 @@ Player::Player(
     spCamera->setFov(glm::radians(90.0f));
     tpCamera->setFov(glm::radians(90.0f));
     random.setSeed((id << 8) ^ 34076213);
+    chunks->setBarrier([globalChunks = level.chunks.get()]() {
+        globalChunks->waitWorkers();
+    });
 }
 
 Player::~Player() = default;
@@ -142,9 +146,9 @@ void Player::attemptToChooseSpawnpoint() {
         newpos.y--;
     }
 
-    voxel* headvox = chunks->get(newpos.x, newpos.y + 1, newpos.z);
+    auto headvox = chunks->get(newpos.x, newpos.y + 1, newpos.z);
     if (chunks->isObstacleBlock(newpos.x, newpos.y, newpos.z) ||
-        headvox == nullptr || headvox->id != 0) {
+        !headvox || headvox->id != 0) {
         return;
     }
     spawnpoint = newpos + glm::vec3(0.5f, 0.0f, 0.5f);
@@ -73,6 +73,13 @@ struct Hitbox {
     glm::vec3 prevVelocity {};
     bool prevGrounded = false;
 
+    /// @brief Body is at rest and is not simulated (still is an obstacle)
+    bool sleeping = false;
+    /// @brief Number of steps the body is at rest for
+    uint restingSteps = 0;
+    /// @brief Position the body fell asleep at
+    glm::vec3 sleepPosition {};
+
     static inline constexpr float TELEPORT_THRESOLD_SQR = 0.5f;
 
     Hitbox(
@@ -97,4 +104,9 @@ struct Hitbox {
     glm::vec3 getSurfaceVelocity() const {
         return velocity - groundVelocity;
     }
+
+    void wakeUp() {
+        sleeping = false;
+        restingSteps = 0;
+    }
 };
@@ -7,18 +7,77 @@
 #include "voxels/voxel.hpp"
 #include "objects/Entities.hpp"
 #include "debug/Logger.hpp"
+#include "util/ThreadPool.hpp"
 
 #include <algorithm>
+#include <numeric>
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/norm.hpp>
 
 inline constexpr float E = 0.03f;
 inline constexpr float MAX_FIX = 0.1f;
+/// @brief Broadphase grid cell size
+inline constexpr float GRID_CELL_SIZE = 2.0f;
+/// @brief Solid hitboxes AABBs extension covering movement within substep
+inline constexpr float GRID_MARGIN = 0.5f;
+/// @brief Hitboxes reach extension used to split hitboxes into islands
+inline constexpr float ISLAND_MARGIN = 1.0f;
+/// @brief Min number of hitboxes simulated using workers
+inline constexpr size_t MIN_PARALLEL_HITBOXES = 64;
+/// @brief Number of jobs per worker (for load balancing)
+inline constexpr size_t JOBS_PER_WORKER = 4;
+/// @brief Max squared velocity of a body at rest
+inline constexpr float SLEEP_VELOCITY_SQR = 0.1f * 0.1f;
+/// @brief Number of steps a body should be at rest to fall asleep
+inline constexpr uint SLEEP_STEPS = 30;
+/// @brief Min squared displacement of a solid body waking bodies resting on it
+inline constexpr float SUPPORT_MOVE_SQR = 0.01f * 0.01f;
+/// @brief Height of wake area above a moved or removed solid body
+inline constexpr float SUPPORT_WAKE_HEIGHT = 0.1f;
 
 static debug::Logger logger("physics-solver");
 
+class PhysicsIslandsWorker
+    : public util::Worker<PhysicsSolver::IslandsJob, int> {
+    PhysicsSolver& solver;
+    PhysicsSolver::Context context;
+public:
+    PhysicsIslandsWorker(PhysicsSolver& solver) : solver(solver) {
+    }
+
+    int operator()(const PhysicsSolver::IslandsJob& job) override {
+        for (size_t i = job.begin; i < job.end; i++) {
+            const auto& island = solver.islands[i];
+            solver.simulate(
+                context,
+                island.hitboxes,
+                island.solidHitboxes,
+                job.dt,
+                job.substeps
+            );
+        }
+        return 0;
+    }
+};
+
+PhysicsSolver::Context::Context() : solidsGrid(GRID_CELL_SIZE) {
+}
+
 PhysicsSolver::PhysicsSolver(const GlobalChunks& chunks, glm::vec3 gravity)
-    : chunks(chunks), gravity(std::move(gravity)) {
+    : chunks(chunks),
+      gravity(std::move(gravity)),
+      wakeAreasGrid(GRID_CELL_SIZE),
+      sensorsGrid(GRID_CELL_SIZE),
+      reachGrid(GRID_CELL_SIZE) {
+}
+
+PhysicsSolver::~PhysicsSolver() = default;
+
+void PhysicsSolver::setWorkers(uint workers) {
+    if (this->workers != workers) {
+        workersPool = nullptr;
+    }
+    this->workers = workers;
 }
 
 static glm::vec3 calc_collsion_velocity_result(
@@ -67,7 +126,7 @@ template <int nx, int ny, int nz, int sign>
 static void calc_collision(
     Hitbox& hitbox,
     const GlobalChunks& chunks,
-    const std::vector<Hitbox*>& solidHitboxes,
+    const std::vector<Hitbox*>& nearHitboxes,
     const glm::vec3& half,
     float stepHeight
 ) {
@@ -75,7 +134,7 @@ static void calc_collision(
     auto& vel = hitbox.velocity;
 
     glm::vec3 offset(0.0f, stepHeight + E, 0.0f);
-    for (auto box : solidHitboxes) {
+    for (auto box : nearHitboxes) {
         if (glm::distance2(box->position, pos) < E) {
             continue;
         }
@@ -141,12 +200,13 @@ static void calc_collision(
 }
 
 bool PhysicsSolver::calcCollisionNegY(
-    Hitbox& hitbox, const glm::vec3& half, float dt
+    Context& context, Hitbox& hitbox, const glm::vec3& half, float dt
 ) {
     auto& pos = hitbox.position;
     auto& vel = hitbox.velocity;
+    const auto& nearHitboxes = context.nearHitboxes;
 
-    for (auto box : solidHitboxes) {
+    for (auto box : nearHitboxes) {
         if (glm::distance2(box->position, pos) < E) {
             continue;
         }
@@ -210,6 +270,7 @@ bool PhysicsSolver::calcCollisionNegY(
 }
 
 void PhysicsSolver::calcCollisions(
+    Context& context,
     Hitbox& hitbox,
     glm::vec3& vel,
     glm::vec3& pos,
@@ -217,21 +278,22 @@ void PhysicsSolver::calcCollisions(
     float stepHeight,
     float dt
 ) {
+    const auto& nearHitboxes = context.nearHitboxes;
     stepHeight = calc_step_height(chunks, pos, half, stepHeight);
 
     auto prevPos = pos;
 
-    calc_collision<0, 1, 2, -1>(hitbox, chunks, solidHitboxes, half, stepHeight);
-    calc_collision<0, 1, 2, 1>(hitbox, chunks, solidHitboxes, half, stepHeight);
+    calc_collision<0, 1, 2, -1>(hitbox, chunks, nearHitboxes, half, stepHeight);
+    calc_collision<0, 1, 2, 1>(hitbox, chunks, nearHitboxes, half, stepHeight);
 
     float xpos = pos.x;
     pos.x = prevPos.x;
 
-    calc_collision<2, 1, 0, -1>(hitbox, chunks, solidHitboxes, half, stepHeight);
-    calc_collision<2, 1, 0, 1>(hitbox, chunks, solidHitboxes, half, stepHeight);
+    calc_collision<2, 1, 0, -1>(hitbox, chunks, nearHitboxes, half, stepHeight);
+    calc_collision<2, 1, 0, 1>(hitbox, chunks, nearHitboxes, half, stepHeight);
     pos.x = xpos;
 
-    if (calcCollisionNegY(hitbox, half, dt)) {
+    if (calcCollisionNegY(context, hitbox, half, dt)) {
         hitbox.grounded = true;
     }
 
@@ -255,7 +317,7 @@ void PhysicsSolver::calcCollisions(
                 }
             }
         }
-        for (auto box : solidHitboxes) {
+        for (auto box : nearHitboxes) {
             if (glm::distance2(box->position, pos) < E) {
                 continue;
             }
@@ -297,7 +359,7 @@ void PhysicsSolver::calcCollisions(
                 }
             }
         }
-        for (auto box : solidHitboxes) {
+        for (auto box : nearHitboxes) {
             if (glm::distance2(box->position, pos) < E) {
                 continue;
             }
@@ -314,14 +376,22 @@ void PhysicsSolver::calcCollisions(
 }
 
 void PhysicsSolver::calcSubstep(
-    Hitbox& hitbox, glm::vec3& vel, glm::vec3& pos, float dt
+    Context& context,
+    Hitbox& hitbox,
+    glm::vec3& vel,
+    glm::vec3& pos,
+    float dt
 ) {
     auto initpos = pos;
     auto half = hitbox.getHalfSize();
     float gravityScale = hitbox.gravityScale;
         
+    if (hitbox.type == BodyType::DYNAMIC || hitbox.crouching) {
+        findNearHitboxes(context, hitbox, half, dt);
+    }
     if (hitbox.type == BodyType::DYNAMIC) {
         calcCollisions(
+            context,
             hitbox,
             vel,
             pos,
@@ -359,7 +429,7 @@ void PhysicsSolver::calcSubstep(
                 }
             }
         }
-        for (auto box : solidHitboxes) {
+        for (auto box : context.nearHitboxes) {
             if (glm::distance2(box->position, pos) < E) {
                 continue;
             }
@@ -379,6 +449,10 @@ void PhysicsSolver::calcSubstep(
 void PhysicsSolver::step(
     const GlobalChunks& chunks, float delta, uint substeps
 ) {
+    // already checked by updateSleeping
+    wakeAreas.clear();
+    wakeAreasOutdated = true;
+
     for (auto hitbox : hitboxes) {
         hitbox->groundMaterial.clear();
         hitbox->prevGrounded = hitbox->grounded;
@@ -387,14 +461,14 @@ void PhysicsSolver::step(
     }
     
     float dt = delta / static_cast<float>(substeps);
-    for (uint i = 0; i < substeps; i++) {
-        for (auto hitbox : hitboxes) {
-            glm::vec3& pos = hitbox->position;
-            hitbox->prevPosition = hitbox->position;
-            calcSubstep(*hitbox, hitbox->velocity, pos, dt);
-        }
+    if (workers && hitboxes.size() >= MIN_PARALLEL_HITBOXES &&
+        buildIslands(delta)) {
+        simulateIslands(dt, substeps);
+    } else {
+        simulate(context, hitboxes, solidHitboxes, dt, substeps);
     }
 
+    buildSensorsGrid();
     for (auto hitbox : hitboxes) {
         float linearDamping = hitbox->linearDamping;
 
@@ -415,13 +489,327 @@ void PhysicsSolver::step(
         }
         
         updateSensors(*hitbox);
+        updateResting(*hitbox);
+    }
+    for (auto hitbox : sleepingHitboxes) {
+        updateSensors(*hitbox);
     }
+    wakeUnsupported();
+}
+
+void PhysicsSolver::updateResting(Hitbox& hitbox) {
+    if (hitbox.type != BodyType::DYNAMIC || !hitbox.grounded ||
+        hitbox.groundVelocity != glm::vec3() ||
+        glm::length2(hitbox.velocity) > SLEEP_VELOCITY_SQR) {
+        hitbox.restingSteps = 0;
+        return;
+    }
+    if (++hitbox.restingSteps >= SLEEP_STEPS) {
+        hitbox.sleeping = true;
+        hitbox.velocity = {};
+        hitbox.sleepPosition = hitbox.position;
+    }
+}
+
+void PhysicsSolver::addWakeArea(const AABB& aabb) {
+    wakeAreas.push_back(aabb);
+    wakeAreasOutdated = true;
+}
+
+/// @brief Area of bodies resting on or inside of the solid body
+static AABB support_wake_area(const AABB& aabb) {
+    return AABB(
+        aabb.a + glm::vec3(E, 0.0f, E),
+        aabb.b + glm::vec3(-E, SUPPORT_WAKE_HEIGHT, -E)
+    );
+}
+
+void PhysicsSolver::wakeUnsupported() {
+    nextSolidStates.clear();
+    for (const auto hitbox : solidHitboxes) {
+        auto aabb = hitbox->getAABB();
+        aabb.fix();
+        nextSolidStates.push_back({hitbox->entity, aabb});
+    }
+    std::sort(
+        nextSolidStates.begin(),
+        nextSolidStates.end(),
+        [](const auto& a, const auto& b) { return a.entity < b.entity; }
+    );
+    // entities missing in the next states are removed or not solid anymore
+    auto prev = solidStates.begin();
+    for (auto& next : nextSolidStates) {
+        for (; prev != solidStates.end() && prev->entity < next.entity;
+             ++prev) {
+            addWakeArea(support_wake_area(prev->aabb));
+        }
+        if (prev == solidStates.end() || prev->entity != next.entity) {
+            continue;
+        }
+        if (glm::distance2(prev->aabb.a, next.aabb.a) > SUPPORT_MOVE_SQR ||
+            glm::distance2(prev->aabb.b, next.aabb.b) > SUPPORT_MOVE_SQR) {
+            addWakeArea(support_wake_area(prev->aabb));
+            addWakeArea(support_wake_area(next.aabb));
+        } else {
+            // keep the old AABB, so slow movement is not missed
+            next.aabb = prev->aabb;
+        }
+        ++prev;
+    }
+    for (; prev != solidStates.end(); ++prev) {
+        addWakeArea(support_wake_area(prev->aabb));
+    }
+    std::swap(solidStates, nextSolidStates);
+}
+
+bool PhysicsSolver::updateSleeping(Hitbox& hitbox) {
+    if (!hitbox.sleeping) {
+        return false;
+    }
+    // velocity is changed by collisions and scripts
+    bool wake = hitbox.type != BodyType::DYNAMIC ||
+                hitbox.velocity != glm::vec3() ||
+                hitbox.position != hitbox.sleepPosition;
+    if (!wake && !wakeAreas.empty()) {
+        if (wakeAreasOutdated) {
+            wakeAreasGrid.build(wakeAreas);
+            wakeAreasOutdated = false;
+        }
+        auto aabb = hitbox.getAABB();
+        aabb.fix();
+        wakeAreasGrid.query(aabb, context.foundIndices);
+        wake = !context.foundIndices.empty();
+    }
+    if (wake) {
+        hitbox.wakeUp();
+        return false;
+    }
+    return true;
+}
+
+void PhysicsSolver::simulate(
+    Context& context,
+    const std::vector<Hitbox*>& hitboxes,
+    const std::vector<Hitbox*>& solidHitboxes,
+    float dt,
+    uint substeps
+) {
+    context.solidHitboxes = &solidHitboxes;
+    for (uint i = 0; i < substeps; i++) {
+        buildSolidsGrid(context, dt);
+        for (auto hitbox : hitboxes) {
+            glm::vec3& pos = hitbox->position;
+            hitbox->prevPosition = hitbox->position;
+            calcSubstep(context, *hitbox, hitbox->velocity, pos, dt);
+        }
+    }
+}
+
+static uint32_t find_root(std::vector<uint32_t>& parents, uint32_t index) {
+    while (parents[index] != index) {
+        parents[index] = parents[parents[index]];
+        index = parents[index];
+    }
+    return index;
+}
+
+bool PhysicsSolver::buildIslands(float delta) {
+    // solid hitboxes are expected to be a subsequence of hitboxes
+    // mixed with sleeping hitboxes, those are added as extra nodes
+    islandNodes = hitboxes;
+    std::vector<bool> solid(hitboxes.size());
+    // node index of every solid hitbox
+    std::vector<uint32_t> solidNodes;
+    size_t solidIndex = 0;
+    auto skipSleeping = [&](const Hitbox* next) {
+        while (solidIndex < solidHitboxes.size() &&
+               solidHitboxes[solidIndex] != next &&
+               solidHitboxes[solidIndex]->sleeping) {
+            solidNodes.push_back(islandNodes.size());
+            islandNodes.push_back(solidHitboxes[solidIndex++]);
+            solid.push_back(true);
+        }
+    };
+    for (size_t i = 0; i < hitboxes.size(); i++) {
+        skipSleeping(hitboxes[i]);
+        if (solidIndex < solidHitboxes.size() &&
+            solidHitboxes[solidIndex] == hitboxes[i]) {
+            solid[i] = true;
+            solidNodes.push_back(i);
+            solidIndex++;
+        }
+    }
+    skipSleeping(nullptr);
+    if (solidIndex != solidHitboxes.size()) {
+        return false;
+    }
+
+    auto& gridBoxes = context.gridBoxes;
+    gridBoxes.clear();
+    for (const auto hitbox : islandNodes) {
+        float gravityPath = glm::length(gravity) *
+                            glm::abs(hitbox->gravityScale) * delta * delta;
+        glm::vec3 reach = glm::abs(hitbox->velocity) * delta + gravityPath +
+                          ISLAND_MARGIN;
+        reach.y += glm::max(hitbox->stepHeight, 0.0f);
+        glm::vec3 half = glm::abs(hitbox->getHalfSize());
+        half.y *= 1.5f;
+        gridBoxes.emplace_back(
+            hitbox->position - half - reach, hitbox->position + half + reach
+        );
+    }
+    reachGrid.build(gridBoxes);
+
+    // non-solid hitboxes do not interact with each other
+    islandParents.resize(islandNodes.size());
+    std::iota(islandParents.begin(), islandParents.end(), 0);
+    auto& found = context.foundIndices;
+    for (uint32_t i = 0; i < islandNodes.size(); i++) {
+        reachGrid.query(gridBoxes[i], found);
+        for (uint32_t j : found) {
+            if (j <= i || !(solid[i] || solid[j])) {
+                continue;
+            }
+            uint32_t a = find_root(islandParents, i);
+            uint32_t b = find_root(islandParents, j);
+            if (a != b) {
+                islandParents[std::max(a, b)] = std::min(a, b);
+            }
+        }
+    }
+
+    // roots are the first hitboxes of islands, so order is kept within
+    islandIndices.resize(hitboxes.size());
+    islandsCount = 0;
+    for (uint32_t i = 0; i < hitboxes.size(); i++) {
+        uint32_t root = find_root(islandParents, i);
+        if (root == i) {
+            islandIndices[i] = islandsCount++;
+            if (islands.size() < islandsCount) {
+                islands.emplace_back();
+            }
+            islands[islandIndices[i]].hitboxes.clear();
+            islands[islandIndices[i]].solidHitboxes.clear();
+        }
+        islands[islandIndices[root]].hitboxes.push_back(hitboxes[i]);
+    }
+    // roots are minimal indices, so islands of sleeping hitboxes only
+    // have roots out of hitboxes range and are not simulated
+    for (size_t i = 0; i < solidNodes.size(); i++) {
+        uint32_t root = find_root(islandParents, solidNodes[i]);
+        if (root < hitboxes.size()) {
+            islands[islandIndices[root]].solidHitboxes.push_back(
+                solidHitboxes[i]
+            );
+        }
+    }
+    return islandsCount > 1;
+}
+
+void PhysicsSolver::simulateIslands(float dt, uint substeps) {
+    if (workersPool == nullptr) {
+        workersPool = std::make_unique<util::ThreadPool<IslandsJob, int>>(
+            "physics-pool",
+            [this]() {
+                return std::make_unique<PhysicsIslandsWorker>(*this);
+            },
+            [](int&&) {},
+            workers
+        );
+    }
+    // consecutive islands are merged into jobs of similar size
+    size_t jobsCount = workersPool->getWorkersCount() * JOBS_PER_WORKER;
+    size_t jobSize = (hitboxes.size() + jobsCount - 1) / jobsCount;
+    size_t enqueued = 0;
+    size_t begin = 0;
+    size_t size = 0;
+    for (size_t i = 0; i < islandsCount; i++) {
+        size += islands[i].hitboxes.size();
+        if (size >= jobSize || i + 1 == islandsCount) {
+            workersPool->enqueueJob(IslandsJob {begin, i + 1, dt, substeps});
+            enqueued++;
+            begin = i + 1;
+            size = 0;
+        }
+    }
+    // wait for all islands to be done: islands do not share hitboxes,
+    // so results do not depend on the order jobs are done
+    while (enqueued) {
+        enqueued -= workersPool->pullResults(enqueued);
+        if (enqueued) {
+            std::this_thread::yield();
+        }
+    }
+}
+
+void PhysicsSolver::buildSolidsGrid(Context& context, float dt) {
+    auto& gridBoxes = context.gridBoxes;
+    gridBoxes.clear();
+    for (const auto box : *context.solidHitboxes) {
+        glm::vec3 margin = glm::abs(box->velocity) * dt + GRID_MARGIN;
+        auto aabb = box->getAABB();
+        aabb.fix();
+        gridBoxes.emplace_back(aabb.a - margin, aabb.b + margin);
+    }
+    context.solidsGrid.build(gridBoxes);
+}
+
+void PhysicsSolver::findNearHitboxes(
+    Context& context, const Hitbox& hitbox, const glm::vec3& half, float dt
+) {
+    const auto& pos = hitbox.position;
+    // covers all solid hitboxes checks of the substep including step height
+    // and crouching (AABB height scaled by 1.5)
+    glm::vec3 margin = glm::abs(hitbox.velocity) * dt + MAX_FIX + E * 4;
+    margin.y += glm::max(hitbox.stepHeight, 0.0f) + glm::abs(half.y) * 0.5f;
+    AABB aabb(pos - glm::abs(half) - margin, pos + glm::abs(half) + margin);
+
+    const auto& solidHitboxes = *context.solidHitboxes;
+    context.solidsGrid.query(aabb, context.foundIndices);
+    context.nearHitboxes.clear();
+    for (uint32_t index : context.foundIndices) {
+        context.nearHitboxes.push_back(solidHitboxes[index]);
+    }
+}
+
+void PhysicsSolver::buildSensorsGrid() {
+    auto& gridBoxes = context.gridBoxes;
+    gridBoxes.clear();
+    for (const auto sensor : sensors) {
+        AABB aabb;
+        switch (sensor->type) {
+            case SensorType::AABB:
+                aabb = sensor->calculated.aabb;
+                aabb.fix();
+                break;
+            case SensorType::RADIUS: {
+                glm::vec3 center(sensor->calculated.radial);
+                float radius = glm::sqrt(sensor->calculated.radial.w);
+                aabb = AABB(center - radius, center + radius);
+                break;
+            }
+        }
+        gridBoxes.push_back(aabb);
+    }
+    sensorsGrid.build(gridBoxes);
+    sensorsGridOutdated = false;
 }
 
 void PhysicsSolver::updateSensors(Hitbox& hitbox) {
     auto aabb = hitbox.getAABB();
 
-    for (size_t i = 0; i < sensors.size(); i++) {
+    if (sensorsGridOutdated) {
+        buildSensorsGrid();
+    }
+    auto boundingBox = aabb;
+    boundingBox.fix();
+    auto& foundIndices = context.foundIndices;
+    sensorsGrid.query(boundingBox, foundIndices);
+    for (uint32_t i : foundIndices) {
+        // removed by a callback
+        if (i >= sensors.size()) {
+            break;
+        }
         auto& sensor = *sensors[i];
         if (sensor.entity == hitbox.entity) {
             continue;
@@ -451,4 +839,5 @@ void PhysicsSolver::removeSensor(Sensor* sensor) {
     sensors.erase(
         std::remove(sensors.begin(), sensors.end(), sensor), sensors.end()
     );
+    sensorsGridOutdated = true;
 }
@@ -1,10 +1,12 @@
 #pragma once
 
 #include "Hitbox.hpp"
+#include "SpatialHash.hpp"
 
 #include "typedefs.hpp"
 #include "voxels/voxel.hpp"
 
+#include <memory>
 #include <vector>
 #include <glm/glm.hpp>
 
@@ -13,12 +15,22 @@ class Entities;
 class GlobalChunks;
 struct Sensor;
 
+namespace util {
+    template <class T, class R>
+    class ThreadPool;
+}
+
 class PhysicsSolver {
 public:
     PhysicsSolver(const GlobalChunks& chunks, glm::vec3 gravity);
+    ~PhysicsSolver();
 
     void step(const GlobalChunks& chunks, float delta, uint substeps);
 
+    /// @brief Set number of threads simulating independent islands
+    /// of hitboxes (0 - main thread only)
+    void setWorkers(uint workers);
+
     auto& getSensorsWriteable() {
         return sensors;
     }
@@ -31,15 +43,110 @@ public:
         return hitboxes;
     }
 
+    auto& getSleepingHitboxesWriteable() {
+        return sleepingHitboxes;
+    }
+
     void removeSensor(Sensor* sensor);
+
+    /// @brief Wake up sleeping hitboxes intersecting the area before
+    /// the next step
+    void addWakeArea(const AABB& aabb);
+
+    /// @brief Wake up the sleeping hitbox if it was moved or pushed since it
+    /// fell asleep or it is inside of a wake area
+    /// @return true if the hitbox is still sleeping
+    bool updateSleeping(Hitbox& hitbox);
 private:
+    friend class PhysicsIslandsWorker;
+
+    /// @brief Collisions detection buffers of a thread
+    struct Context {
+        /// @brief Solid hitboxes of the simulated island
+        const std::vector<Hitbox*>* solidHitboxes = nullptr;
+        /// @brief Broadphase of solid hitboxes, rebuilt every substep
+        SpatialHash solidsGrid;
+        std::vector<AABB> gridBoxes;
+        std::vector<uint32_t> foundIndices;
+        /// @brief Solid hitboxes near the current hitbox
+        std::vector<Hitbox*> nearHitboxes;
+
+        Context();
+    };
+
+    /// @brief Hitboxes that may interact with each other during the step
+    /// and do not reach hitboxes of other islands
+    struct Island {
+        std::vector<Hitbox*> hitboxes;
+        std::vector<Hitbox*> solidHitboxes;
+    };
+
+    /// @brief Range of islands simulated by a worker
+    struct IslandsJob {
+        size_t begin;
+        size_t end;
+        float dt;
+        uint substeps;
+    };
+
     const GlobalChunks& chunks;
     glm::vec3 gravity;
     std::vector<Sensor*> sensors;
     std::vector<Hitbox*> solidHitboxes;
     std::vector<Hitbox*> hitboxes;
+    /// @brief Sleeping hitboxes (not simulated, sensors are still updated)
+    std::vector<Hitbox*> sleepingHitboxes;
+
+    std::vector<AABB> wakeAreas;
+    SpatialHash wakeAreasGrid;
+    bool wakeAreasOutdated = false;
+
+    struct SolidState {
+        entityid_t entity;
+        AABB aabb;
+    };
+    /// @brief Solid hitboxes AABBs known to hitboxes resting on them,
+    /// sorted by entity
+    std::vector<SolidState> solidStates;
+    std::vector<SolidState> nextSolidStates;
+
+    /// @brief Main thread buffers
+    Context context;
+    SpatialHash sensorsGrid;
+    bool sensorsGridOutdated = false;
+
+    uint workers = 0;
+    std::unique_ptr<util::ThreadPool<IslandsJob, int>> workersPool;
+    std::vector<Island> islands;
+    size_t islandsCount = 0;
+    /// @brief Islands broadphase (hitboxes reach during the step)
+    SpatialHash reachGrid;
+    /// @brief Hitboxes followed by sleeping solid hitboxes
+    std::vector<Hitbox*> islandNodes;
+    std::vector<uint32_t> islandParents;
+    std::vector<uint32_t> islandIndices;
+
+    /// @brief Split hitboxes into islands
+    /// @return false if hitboxes can not be split
+    bool buildIslands(float delta);
+    void simulateIslands(float dt, uint substeps);
+
+    void simulate(
+        Context& context,
+        const std::vector<Hitbox*>& hitboxes,
+        const std::vector<Hitbox*>& solidHitboxes,
+        float dt,
+        uint substeps
+    );
+
+    void buildSolidsGrid(Context& context, float dt);
+    void buildSensorsGrid();
+    void findNearHitboxes(
+        Context& context, const Hitbox& hitbox, const glm::vec3& half, float dt
+    );
 
     void calcCollisions(
+        Context& context,
         Hitbox& hitbox,
         glm::vec3& vel,
         glm::vec3& pos,
@@ -48,9 +155,24 @@ private:
         float dt
     );
 
-    void calcSubstep(Hitbox& hitbox, glm::vec3& vel, glm::vec3& pos, float dt);
+    void calcSubstep(
+        Context& context,
+        Hitbox& hitbox,
+        glm::vec3& vel,
+        glm::vec3& pos,
+        float dt
+    );
 
-    bool calcCollisionNegY(Hitbox& hitbox, const glm::vec3& half, float dt);
+    bool calcCollisionNegY(
+        Context& context, Hitbox& hitbox, const glm::vec3& half, float dt
+    );
 
     void updateSensors(Hitbox& hitbox);
+
+    /// @brief Put the hitbox to sleep if it is at rest for long enough
+    void updateResting(Hitbox& hitbox);
+
+    /// @brief Add wake areas over solid hitboxes moved or removed since
+    /// the previous step, so hitboxes sleeping on them do not hang in the air
+    void wakeUnsupported();
 };
@@ -0,0 +1,115 @@
+#include "SpatialHash.hpp"
+
+#include <algorithm>
+
+/// @brief Boxes overlapping more cells are always tested
+inline constexpr float MAX_BOX_CELLS = 64.0f;
+/// @brief Limits cells coordinates for boxes far away (or infinite)
+inline constexpr float MAX_CELL_COORD = 1e9f;
+
+static inline uint32_t hash_cell(int x, int y, int z) {
+    return (static_cast<uint32_t>(x) * 73856093u) ^
+           (static_cast<uint32_t>(y) * 19349663u) ^
+           (static_cast<uint32_t>(z) * 83492791u);
+}
+
+SpatialHash::SpatialHash(float cellSize) : invCellSize(1.0f / cellSize) {
+}
+
+glm::ivec3 SpatialHash::toCell(const glm::vec3& pos) const {
+    return glm::ivec3(glm::clamp(
+        glm::floor(pos * invCellSize), -MAX_CELL_COORD, MAX_CELL_COORD
+    ));
+}
+
+bool SpatialHash::isTooLarge(const AABB& aabb, float maxCells) const {
+    glm::vec3 cells = aabb.size() * invCellSize + 2.0f;
+    // also true for nan
+    return !(cells.x * cells.y * cells.z <= maxCells);
+}
+
+void SpatialHash::build(const std::vector<AABB>& boxes) {
+    this->boxes = boxes;
+    largeBoxes.clear();
+    pairs.clear();
+    for (uint32_t i = 0; i < boxes.size(); i++) {
+        const auto& aabb = boxes[i];
+        if (isTooLarge(aabb, MAX_BOX_CELLS)) {
+            largeBoxes.push_back(i);
+            continue;
+        }
+        auto beg = toCell(aabb.min());
+        auto end = toCell(aabb.max());
+        for (int y = beg.y; y <= end.y; y++) {
+            for (int z = beg.z; z <= end.z; z++) {
+                for (int x = beg.x; x <= end.x; x++) {
+                    pairs.emplace_back(hash_cell(x, y, z), i);
+                }
+            }
+        }
+    }
+    size_t tableSize = 16;
+    while (tableSize < pairs.size() * 2) {
+        tableSize <<= 1;
+    }
+    mask = tableSize - 1;
+
+    cellsStart.assign(tableSize + 1, 0);
+    for (const auto& [hash, _] : pairs) {
+        cellsStart[hash & mask]++;
+    }
+    uint32_t offset = 0;
+    for (size_t i = 0; i <= tableSize; i++) {
+        offset += cellsStart[i];
+        cellsStart[i] = offset;
+    }
+    // filled backwards to keep indices ascending within a cell
+    entries.resize(pairs.size());
+    for (auto it = pairs.rbegin(); it != pairs.rend(); ++it) {
+        entries[--cellsStart[it->first & mask]] = it->second;
+    }
+
+    marks.assign(boxes.size(), 0);
+    queryIndex = 0;
+}
+
+void SpatialHash::query(const AABB& aabb, std::vector<uint32_t>& dst) {
+    dst.clear();
+    if (++queryIndex == 0) {
+        std::fill(marks.begin(), marks.end(), 0);
+        queryIndex = 1;
+    }
+    auto test = [this, &aabb, &dst](uint32_t index) {
+        if (marks[index] == queryIndex) {
+            return;
+        }
+        marks[index] = queryIndex;
+        if (boxes[index].intersects(aabb)) {
+            dst.push_back(index);
+        }
+    };
+    for (uint32_t index : largeBoxes) {
+        test(index);
+    }
+    if (isTooLarge(aabb, mask + 1)) {
+        for (uint32_t index = 0; index < boxes.size(); index++) {
+            test(index);
+        }
+    } else {
+        auto beg = toCell(aabb.min());
+        auto end = toCell(aabb.max());
+        for (int y = beg.y; y <= end.y; y++) {
+            for (int z = beg.z; z <= end.z; z++) {
+                for (int x = beg.x; x <= end.x; x++) {
+                    uint32_t hash = hash_cell(x, y, z) & mask;
+                    for (uint32_t i = cellsStart[hash];
+                         i < cellsStart[hash + 1];
+                         i++) {
+                        test(entries[i]);
+                    }
+                }
+            }
+        }
+    }
+    std::sort(dst.begin(), dst.end());
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "maths/aabb.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+/// @brief Uniform grid broadphase for axis-aligned boxes.
+/// Every box is put into all grid cells it overlaps, cells are hashed into
+/// a table sized by the number of entries and sorted with a counting sort,
+/// so rebuild is O(n) and does not allocate once buffers are grown.
+/// Hash collisions only produce extra candidates filtered by queries.
+class SpatialHash {
+public:
+    /// @param cellSize grid cell size, close to typical box size
+    SpatialHash(float cellSize);
+
+    /// @brief Rebuild the grid from scratch
+    void build(const std::vector<AABB>& boxes);
+
+    /// @brief Find boxes intersecting the aabb
+    /// @param dst indices of found boxes in ascending order
+    /// (previous content is cleared)
+    void query(const AABB& aabb, std::vector<uint32_t>& dst);
+
+    /// @return number of boxes
+    size_t size() const {
+        return boxes.size();
+    }
+private:
+    float invCellSize;
+    std::vector<AABB> boxes;
+    /// @brief Indices of boxes covering too many cells to be put into grid
+    std::vector<uint32_t> largeBoxes;
+    /// @brief (cell hash, box index) pairs, used while building only
+    std::vector<std::pair<uint32_t, uint32_t>> pairs;
+    /// @brief Entries of cell with hash h are [cellsStart[h], cellsStart[h+1])
+    std::vector<uint32_t> cellsStart;
+    std::vector<uint32_t> entries;
+    /// @brief Last query a box was tested in (deduplication)
+    std::vector<uint32_t> marks;
+    uint32_t queryIndex = 0;
+    uint32_t mask = 0;
+
+    glm::ivec3 toCell(const glm::vec3& pos) const;
+    bool isTooLarge(const AABB& aabb, float maxCells) const;
+};
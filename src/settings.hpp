@@ -47,6 +47,13 @@ struct ChunksSettings {
     IntegerSetting loadDistance {22, 3, 80};
     /// @brief Buffer zone where chunks are not unloading (chunk is unit)
     IntegerSetting padding {2, 1, 8};
+    /// @brief Number of chunks generation threads (0 - main thread only)
+    IntegerSetting generatorWorkers {0, 0, 32};
+    /// @brief Number of chunks lights building threads (0 - main thread only)
+    IntegerSetting lightingWorkers {0, 0, 32};
+    /// @brief Keep voxels of idle chunks in memory-compact paletted form
+    /// (experimental, off by default)
+    FlagSetting packVoxels {false};
 };
 
 struct CameraSettings {
@@ -96,6 +103,8 @@ struct GraphicsSettings {
     FlagSetting softLighting {true};
     /// @brief Clouds quality level
     IntegerSetting cloudsQuality {2, 0, 2};
+    /// @brief Merge coplanar cube faces with the same texture and lights
+    FlagSetting greedyMeshing {false};
 };
 
 struct PathfindingSettings {
@@ -103,11 +112,19 @@ struct PathfindingSettings {
     IntegerSetting stepsPerAsyncAgent {128, 1, 2048};
 };
 
+struct PhysicsSettings {
+    /// @brief Number of entities physics threads (0 - main thread only)
+    IntegerSetting workers {0, 0, 32};
+};
+
 struct DebugSettings {
     /// @brief Turns off chunks saving/loading
     FlagSetting generatorTestMode {false};
     /// @brief Write lights cache
     FlagSetting doWriteLights {true};
+    /// @brief Compress voxels and lights regions with LZ4 (faster, larger
+    /// files). Existing region files are converted on write
+    FlagSetting lz4Regions {false};
     /// @brief Write preprocessed shaders code to user:export
     FlagSetting doTraceShaders {false};
     /// @brief Enable experimental optimizations and features
@@ -120,6 +137,9 @@ struct UiSettings {
 };
 
 struct NetworkSettings {
+    /// @brief Max bytes received by a TCP connection but not read yet.
+    /// Receiving is paused when reached
+    IntegerSetting tcpReceiveBuffer {1'048'576, 16'384, 64 * 1'048'576};
 };
 
 struct SystemSettings {
@@ -141,5 +161,6 @@ struct EngineSettings {
     UiSettings ui;
     NetworkSettings network;
     PathfindingSettings pathfinding;
+    PhysicsSettings physics;
     SystemSettings system;
 };
@@ -0,0 +1,143 @@
+#pragma once
+
+#include <memory>
+#include <cstdint>
+#include <unordered_map>
+
+namespace util {
+    /// @brief Sparse 2D table of values split into square pages.
+    /// Pages are placed into the direct-mapped slots table by their
+    /// coordinates, colliding pages are kept in the overflow hash map,
+    /// so lookup near the origin of previous lookups costs two indexings.
+    /// Lookups do not modify the table (safe for concurrent readers).
+    /// @tparam T value type where T{} means no value (like a pointer)
+    /// @tparam PAGE_BITS page size is 1 << PAGE_BITS
+    /// @tparam SLOT_BITS slots table size is 1 << SLOT_BITS pages
+    template <class T, int PAGE_BITS = 4, int SLOT_BITS = 4>
+    class PagedTable2D {
+        static constexpr int PAGE_SIZE = 1 << PAGE_BITS;
+        static constexpr int SLOTS = 1 << SLOT_BITS;
+
+        struct Page {
+            int32_t x;
+            int32_t z;
+            size_t count = 0;
+            T values[PAGE_SIZE * PAGE_SIZE] {};
+        };
+
+        std::unique_ptr<Page> slots[SLOTS * SLOTS];
+        std::unordered_map<uint64_t, std::unique_ptr<Page>> overflow;
+        size_t valuesCount = 0;
+
+        static inline uint64_t keyfrom(int32_t x, int32_t z) {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) |
+                   static_cast<uint32_t>(z);
+        }
+
+        static inline size_t slot_index(int32_t px, int32_t pz) {
+            return (pz & (SLOTS - 1)) * SLOTS + (px & (SLOTS - 1));
+        }
+
+        static inline size_t value_index(int32_t x, int32_t z) {
+            return (z & (PAGE_SIZE - 1)) * PAGE_SIZE + (x & (PAGE_SIZE - 1));
+        }
+
+        Page* findPage(int32_t px, int32_t pz) const {
+            const auto& slot = slots[slot_index(px, pz)];
+            if (slot && slot->x == px && slot->z == pz) {
+                return slot.get();
+            }
+            if (overflow.empty()) {
+                return nullptr;
+            }
+            const auto& found = overflow.find(keyfrom(px, pz));
+            if (found == overflow.end()) {
+                return nullptr;
+            }
+            return found->second.get();
+        }
+
+        void removePage(Page* page) {
+            auto& slot = slots[slot_index(page->x, page->z)];
+            if (slot.get() != page) {
+                overflow.erase(keyfrom(page->x, page->z));
+                return;
+            }
+            slot = nullptr;
+            // move a colliding page to the released slot
+            for (auto it = overflow.begin(); it != overflow.end(); ++it) {
+                auto& other = it->second;
+                if (&slots[slot_index(other->x, other->z)] == &slot) {
+                    slot = std::move(other);
+                    overflow.erase(it);
+                    break;
+                }
+            }
+        }
+    public:
+        PagedTable2D() = default;
+        PagedTable2D(const PagedTable2D&) = delete;
+
+        /// @return value at x, z or T{} if not set
+        T get(int32_t x, int32_t z) const {
+            const Page* page = findPage(x >> PAGE_BITS, z >> PAGE_BITS);
+            if (page == nullptr) {
+                return T {};
+            }
+            return page->values[value_index(x, z)];
+        }
+
+        /// @brief Set value at x, z (T{} removes the value)
+        void set(int32_t x, int32_t z, T value) {
+            int32_t px = x >> PAGE_BITS;
+            int32_t pz = z >> PAGE_BITS;
+            Page* page = findPage(px, pz);
+            bool empty = value == T {};
+            if (page == nullptr) {
+                if (empty) {
+                    return;
+                }
+                auto newPage = std::make_unique<Page>();
+                newPage->x = px;
+                newPage->z = pz;
+                page = newPage.get();
+                auto& slot = slots[slot_index(px, pz)];
+                if (slot == nullptr) {
+                    slot = std::move(newPage);
+                } else {
+                    overflow[keyfrom(px, pz)] = std::move(newPage);
+                }
+            }
+            auto& dst = page->values[value_index(x, z)];
+            bool wasEmpty = dst == T {};
+            dst = std::move(value);
+            if (wasEmpty && !empty) {
+                page->count++;
+                valuesCount++;
+            } else if (!wasEmpty && empty) {
+                valuesCount--;
+                if (--page->count == 0) {
+                    removePage(page);
+                }
+            }
+        }
+
+        void clear() {
+            for (auto& slot : slots) {
+                slot = nullptr;
+            }
+            overflow.clear();
+            valuesCount = 0;
+        }
+
+        /// @return number of set values
+        size_t size() const {
+            return valuesCount;
+        }
+
+        /// @return number of pages not fitting the slots table
+        size_t countOverflow() const {
+            return overflow.size();
+        }
+    };
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <cstring>
+#include <algorithm>
+#include <type_traits>
+
+namespace util {
+    /// @brief Fixed capacity single-producer single-consumer ring buffer.
+    /// write() must be called from one thread and read() from another one
+    /// (or the same), no locks are used. Writer gets less than requested
+    /// elements written when the buffer is full (backpressure)
+    /// @tparam T trivially copyable elements type
+    template <typename T>
+    class RingBuffer {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        std::unique_ptr<T[]> buffer;
+        size_t capacity;
+        size_t mask;
+        /// @brief Total elements written, modified by producer only
+        alignas(64) std::atomic<size_t> head {0};
+        /// @brief Total elements read, modified by consumer only
+        alignas(64) std::atomic<size_t> tail {0};
+
+        static size_t round_capacity(size_t capacity) {
+            size_t result = 1;
+            while (result < capacity) {
+                result <<= 1;
+            }
+            return result;
+        }
+    public:
+        /// @param capacity max elements stored, rounded up to power of 2
+        RingBuffer(size_t capacity)
+            : buffer(std::make_unique<T[]>(round_capacity(capacity))),
+              capacity(round_capacity(capacity)),
+              mask(this->capacity - 1) {
+        }
+
+        RingBuffer(const RingBuffer&) = delete;
+
+        /// @brief Append elements (producer)
+        /// @return number of elements written
+        size_t write(const T* src, size_t count) {
+            size_t h = head.load(std::memory_order_relaxed);
+            size_t t = tail.load(std::memory_order_acquire);
+            count = std::min(count, capacity - (h - t));
+            if (count == 0) {
+                return 0;
+            }
+            size_t offset = h & mask;
+            size_t first = std::min(count, capacity - offset);
+            std::memcpy(buffer.get() + offset, src, first * sizeof(T));
+            std::memcpy(buffer.get(), src + first, (count - first) * sizeof(T));
+            head.store(h + count, std::memory_order_release);
+            return count;
+        }
+
+        /// @brief Take elements (consumer)
+        /// @return number of elements read
+        size_t read(T* dst, size_t count) {
+            size_t t = tail.load(std::memory_order_relaxed);
+            size_t h = head.load(std::memory_order_acquire);
+            count = std::min(count, h - t);
+            if (count == 0) {
+                return 0;
+            }
+            size_t offset = t & mask;
+            size_t first = std::min(count, capacity - offset);
+            std::memcpy(dst, buffer.get() + offset, first * sizeof(T));
+            std::memcpy(dst + first, buffer.get(), (count - first) * sizeof(T));
+            tail.store(t + count, std::memory_order_release);
+            return count;
+        }
+
+        /// @brief Drop all stored elements (consumer)
+        void clear() {
+            tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+        }
+
+        /// @return number of elements available to read
+        size_t size() const {
+            return head.load(std::memory_order_acquire) -
+                   tail.load(std::memory_order_acquire);
+        }
+
+        /// @return number of elements may be written
+        size_t freeSpace() const {
+            return capacity - size();
+        }
+
+        bool empty() const {
+            return size() == 0;
+        }
+
+        size_t getCapacity() const {
+            return capacity;
+        }
+    };
+}
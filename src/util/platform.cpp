@@ -506,3 +506,31 @@ bool platform::stdin_has_data() {
     return poll(&fds, 1, 0) == 1;
 #endif
 }
+
+bool platform::sync_file(const std::filesystem::path& file) {
+#ifdef _WIN32
+    HANDLE handle = CreateFileW(
+        file.wstring().c_str(),
+        GENERIC_WRITE,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr,
+        OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL,
+        nullptr
+    );
+    if (handle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    bool success = FlushFileBuffers(handle);
+    CloseHandle(handle);
+    return success;
+#else
+    int fd = open(file.c_str(), O_RDONLY);
+    if (fd == -1) {
+        return false;
+    }
+    bool success = fsync(fd) == 0;
+    close(fd);
+    return success;
+#endif
+}
@@ -30,4 +30,8 @@ namespace platform {
     bool open_url(const std::string& url);
     /// @brief Check if stdin has input
     bool stdin_has_data();
+    /// @brief Flush file contents from OS cache to the storage device
+    /// (fsync / FlushFileBuffers)
+    /// @return false if the file could not be opened or synced
+    bool sync_file(const std::filesystem::path& file);
 }
@@ -55,6 +55,9 @@ struct BlockFuncsSet {
 struct BlockFuncNamesCache {
     std::string update;
     std::string randomUpdate;
+    std::string blockTick;
+    std::string blockPresent;
+    std::string blockRemoved;
 };
 
 struct CoordSystem {
@@ -0,0 +1,182 @@
+#include "BlockTicksScheduler.hpp"
+
+#include <algorithm>
+
+#include "Block.hpp"
+
+BlockTicksScheduler::BlockType& BlockTicksScheduler::getType(
+    const Block& def
+) {
+    blockid_t id = def.rt.id;
+    if (id >= types.size()) {
+        types.resize(id + 1);
+    }
+    auto& type = types[id];
+    type.def = &def;
+    return type;
+}
+
+void BlockTicksScheduler::add(const Block& def, const glm::ivec3& pos) {
+    const auto& funcsset = def.rt.funcsset;
+    if (!funcsset.onblocktick && !funcsset.onblockpresent) {
+        return;
+    }
+    auto& type = getType(def);
+    if (type.indices.find(pos) != type.indices.end()) {
+        return;
+    }
+    type.indices[pos] = type.blocks.size();
+    type.blocks.push_back(Entry {pos, funcsset.onblockpresent});
+    if (funcsset.onblockpresent) {
+        type.presentQueue.push_back(pos);
+    }
+}
+
+void BlockTicksScheduler::remove(const Block& def, const glm::ivec3& pos) {
+    const auto& funcsset = def.rt.funcsset;
+    if (funcsset.onblockremoved) {
+        getType(def).removed.push_back(pos);
+    }
+    if (!funcsset.onblocktick && !funcsset.onblockpresent) {
+        return;
+    }
+    auto& type = getType(def);
+    const auto& found = type.indices.find(pos);
+    if (found != type.indices.end()) {
+        erase(type, found->second);
+    }
+}
+
+void BlockTicksScheduler::erase(BlockType& type, uint32_t index) {
+    auto& blocks = type.blocks;
+    type.indices.erase(blocks[index].pos);
+    if (index + 1 != blocks.size()) {
+        blocks[index] = blocks.back();
+        type.indices[blocks[index].pos] = index;
+    }
+    blocks.pop_back();
+}
+
+void BlockTicksScheduler::pushBatch(
+    const Block& def, BlockEventType type, size_t offset, float tps
+) {
+    if (positions.size() > offset) {
+        batches.push_back(
+            Batch {&def, type, offset, positions.size() - offset, tps}
+        );
+    }
+}
+
+void BlockTicksScheduler::collectRemoved() {
+    for (auto& type : types) {
+        if (type.removed.empty()) {
+            continue;
+        }
+        size_t offset = positions.size();
+        positions.insert(
+            positions.end(), type.removed.begin(), type.removed.end()
+        );
+        type.removed.clear();
+        pushBatch(*type.def, BlockEventType::REMOVED, offset, 0.0f);
+    }
+}
+
+void BlockTicksScheduler::update(
+    float delta, int tickRate, const EventsConsumer& consumer
+) {
+    collectRemoved();
+    for (auto& type : types) {
+        if (type.def == nullptr) {
+            continue;
+        }
+        const auto& def = *type.def;
+        float tps = tickRate / static_cast<float>(def.tickInterval);
+
+        auto& queue = type.presentQueue;
+        if (!queue.empty()) {
+            type.presentBudget += delta * tps * queue.size();
+            size_t steps = std::min<size_t>(type.presentBudget, queue.size());
+            type.presentBudget -= steps;
+
+            size_t offset = positions.size();
+            for (size_t i = 0; i < steps; i++) {
+                auto pos = queue.back();
+                queue.pop_back();
+                const auto& found = type.indices.find(pos);
+                // removed before the event
+                if (found == type.indices.end() ||
+                    !type.blocks[found->second].pending) {
+                    continue;
+                }
+                type.blocks[found->second].pending = false;
+                positions.push_back(pos);
+                if (!def.rt.funcsset.onblocktick) {
+                    erase(type, found->second);
+                }
+            }
+            if (queue.empty()) {
+                type.presentBudget = 0.0f;
+            }
+            pushBatch(def, BlockEventType::PRESENT, offset, 0.0f);
+        }
+
+        auto& blocks = type.blocks;
+        if (!def.rt.funcsset.onblocktick || blocks.empty()) {
+            type.ticksBudget = 0.0f;
+            continue;
+        }
+        type.ticksBudget += delta * tps * blocks.size();
+        size_t steps = std::min<size_t>(type.ticksBudget, blocks.size());
+        // ticks skipped on lags are not repeated
+        type.ticksBudget = std::min(type.ticksBudget - steps, 1.0f);
+
+        size_t offset = positions.size();
+        for (size_t i = 0; i < steps; i++) {
+            type.pointer %= blocks.size();
+            const auto& entry = blocks[type.pointer++];
+            if (!entry.pending) {
+                positions.push_back(entry.pos);
+            }
+        }
+        pushBatch(def, BlockEventType::TICK, offset, tps);
+    }
+    dispatch(consumer);
+}
+
+void BlockTicksScheduler::flushRemoved(const EventsConsumer& consumer) {
+    collectRemoved();
+    dispatch(consumer);
+}
+
+void BlockTicksScheduler::dispatch(const EventsConsumer& consumer) {
+    // consumer may modify the scheduler state
+    auto batches = std::move(this->batches);
+    auto positions = std::move(this->positions);
+    this->batches.clear();
+    this->positions.clear();
+    for (const auto& batch : batches) {
+        consumer(
+            *batch.def,
+            batch.type,
+            util::span(positions.data() + batch.offset, batch.count),
+            batch.tps
+        );
+    }
+    batches.clear();
+    positions.clear();
+    this->batches = std::move(batches);
+    this->positions = std::move(positions);
+}
+
+void BlockTicksScheduler::clear() {
+    types.clear();
+    batches.clear();
+    positions.clear();
+}
+
+size_t BlockTicksScheduler::count(blockid_t id) const {
+    if (id >= types.size()) {
+        return 0;
+    }
+    return types[id].blocks.size();
+}
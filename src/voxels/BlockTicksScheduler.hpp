@@ -0,0 +1,94 @@
+#pragma once
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
+
+#include "typedefs.hpp"
+#include "util/span.hpp"
+
+class Block;
+
+enum class BlockEventType {
+    /// @brief on_block_tick
+    TICK,
+    /// @brief on_block_present
+    PRESENT,
+    /// @brief on_block_removed
+    REMOVED,
+};
+
+/// @brief Schedules on_block_tick, on_block_present and on_block_removed
+/// events of loaded blocks. Blocks are kept in dense lists per block type
+/// indexed by position, so placing, breaking and unloading a block is O(1).
+/// Events are dispatched in batches, one consumer call per block type.
+class BlockTicksScheduler {
+public:
+    /// @param tps block ticks per second (TICK events only)
+    using EventsConsumer = std::function<void(
+        const Block& def,
+        BlockEventType type,
+        util::span<glm::ivec3> positions,
+        float tps
+    )>;
+
+    /// @brief Register block appeared (generated, loaded or placed)
+    void add(const Block& def, const glm::ivec3& pos);
+
+    /// @brief Unregister block removed or unloaded
+    void remove(const Block& def, const glm::ivec3& pos);
+
+    /// @brief Dispatch removed events and part of ticks and present events
+    /// spread so every block is processed once per its tick interval
+    /// @param tickRate world ticks per second
+    void update(float delta, int tickRate, const EventsConsumer& consumer);
+
+    /// @brief Dispatch pending removed events only
+    void flushRemoved(const EventsConsumer& consumer);
+
+    void clear();
+
+    /// @return number of registered blocks of the type
+    size_t count(blockid_t id) const;
+private:
+    struct Entry {
+        glm::ivec3 pos;
+        /// @brief on_block_present is not called yet (no ticks until)
+        bool pending;
+    };
+
+    struct BlockType {
+        const Block* def = nullptr;
+        std::vector<Entry> blocks;
+        /// @brief Index of the block entry by position
+        std::unordered_map<glm::ivec3, uint32_t> indices;
+        std::vector<glm::ivec3> presentQueue;
+        std::vector<glm::ivec3> removed;
+        /// @brief Next ticked block index
+        size_t pointer = 0;
+        float ticksBudget = 0.0f;
+        float presentBudget = 0.0f;
+    };
+
+    struct Batch {
+        const Block* def;
+        BlockEventType type;
+        size_t offset;
+        size_t count;
+        float tps;
+    };
+
+    std::vector<BlockType> types;
+    std::vector<Batch> batches;
+    std::vector<glm::ivec3> positions;
+
+    BlockType& getType(const Block& def);
+    void erase(BlockType& type, uint32_t index);
+    void pushBatch(const Block& def, BlockEventType type, size_t offset, float tps);
+    void collectRemoved();
+    void dispatch(const EventsConsumer& consumer);
+};
@@ -6,24 +6,72 @@
 #include "util/data_io.hpp"
 #include "voxel.hpp"
 
+#include <cstring>
 #include <utility>
 
 Chunk::Chunk(int xpos, int zpos, std::shared_ptr<Lightmap> lightmap)
-    : x(xpos), z(zpos), lightmap(std::move(lightmap)) {
+    : voxels(std::make_unique<voxel[]>(CHUNK_VOL)),
+      x(xpos),
+      z(zpos),
+      lightmap(std::move(lightmap)) {
     bottom = 0;
     top = CHUNK_H;
 }
 
+voxel* Chunk::getVoxels() {
+    voxelsAccessed = true;
+    if (voxels == nullptr) {
+        voxels = std::make_unique<voxel[]>(CHUNK_VOL);
+        packedVoxels.unpack(voxels.get());
+        packedVoxels = PalettedVoxels();
+    }
+    return voxels.get();
+}
+
+void Chunk::copyVoxels(voxel* dst, uint index, uint count) const {
+    if (voxels) {
+        std::memcpy(dst, voxels.get() + index, count * sizeof(voxel));
+    } else {
+        packedVoxels.unpack(dst, index, count);
+    }
+}
+
+void Chunk::pack() {
+    if (voxels) {
+        packedVoxels.pack(voxels.get());
+        voxels = nullptr;
+    }
+}
+
+bool Chunk::packIfIdle() {
+    if (voxels == nullptr) {
+        return packedVoxels.compact();
+    }
+    if (voxelsAccessed) {
+        voxelsAccessed = false;
+        return false;
+    }
+    pack();
+    return true;
+}
+
+size_t Chunk::getVoxelsMemoryUsage() const {
+    if (voxels) {
+        return CHUNK_VOL * sizeof(voxel);
+    }
+    return packedVoxels.getMemoryUsage();
+}
+
 void Chunk::updateHeights() {
     flags.dirtyHeights = false;
     for (uint i = 0; i < CHUNK_VOL; i++) {
-        if (voxels[i].id != 0) {
+        if (get(i).id != 0) {
             bottom = i / (CHUNK_D * CHUNK_W);
             break;
         }
     }
     for (int i = CHUNK_VOL - 1; i >= 0; i--) {
-        if (voxels[i].id != 0) {
+        if (get(i).id != 0) {
             top = i / (CHUNK_D * CHUNK_W) + 1;
             break;
         }
@@ -70,6 +118,9 @@ std::shared_ptr<Inventory> Chunk::getBlockInventory(uint x, uint y, uint z)
     Total size: (CHUNK_VOL * 4) bytes
 */
 std::unique_ptr<ubyte[]> Chunk::encode() const {
+    if (voxels == nullptr) {
+        return packedVoxels.encode();
+    }
     auto buffer = std::make_unique<ubyte[]>(CHUNK_DATA_LEN);
     auto dst = reinterpret_cast<uint16_t*>(buffer.get());
     for (uint i = 0; i < CHUNK_VOL; i++) {
@@ -80,6 +131,7 @@ std::unique_ptr<ubyte[]> Chunk::encode() const {
 }
 
 bool Chunk::decode(const ubyte* data) {
+    voxel* voxels = getVoxels();
     auto src = reinterpret_cast<const uint16_t*>(data);
     for (uint i = 0; i < CHUNK_VOL; i++) {
         voxel& vox = voxels[i];
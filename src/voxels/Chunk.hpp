@@ -2,13 +2,16 @@
 
 #include <stdlib.h>
 
+#include <array>
 #include <memory>
+#include <algorithm>
 #include <unordered_map>
 
 #include "constants.hpp"
 #include "lighting/Lightmap.hpp"
 #include "util/SmallHeap.hpp"
 #include "maths/aabb.hpp"
+#include "PalettedVoxels.hpp"
 #include "voxel.hpp"
 
 /// @brief Total bytes number of chunk voxel data
@@ -23,10 +26,15 @@ using ChunkInventoriesMap =
 using BlocksMetadata = util::SmallHeap<uint16_t, uint8_t>;
 
 class Chunk {
+    /// @brief Flat voxels array, nullptr while voxels are packed
+    std::unique_ptr<voxel[]> voxels;
+    /// @brief Voxels storage used while the chunk is idle
+    PalettedVoxels packedVoxels;
+    /// @brief Was flat voxels array requested since the last packIfIdle call
+    bool voxelsAccessed = false;
 public:
     int x, z;
     int bottom, top;
-    voxel voxels[CHUNK_VOL] {};
     std::shared_ptr<Lightmap> lightmap;
     struct {
         bool modified : 1; // is chunk mesh should be updated
@@ -40,6 +48,19 @@ public:
         bool dirtyHeights : 1; // is chunk bottom, top should be recalculated
         bool inventoriesRemoved : 1; // was block inventories removed since the last save
     } flags {};
+    /// @brief Is chunk used by a lights building worker. Kept out of flags
+    /// bitfield as the worker modifies the chunk while the main thread
+    /// writes the flags. Accessed by the main thread only
+    bool lightsLocked = false;
+    /// @brief Bit mask of mesh sections (CHUNK_SECTION_H blocks high)
+    /// should be updated, unlike flags.modified not requiring full update
+    uint32_t modifiedSections = 0;
+    /// @brief Incremented on every voxels or lights modification marked
+    /// with the setters below, used to detect outdated snapshots
+    uint32_t generation = 0;
+    /// @brief Generation of the last modification of each section,
+    /// used to share unmodified sections between snapshots
+    std::array<uint32_t, CHUNK_SECTIONS> sectionsGeneration {};
 
     uint64_t lastRandomTickId = -1;
 
@@ -50,6 +71,53 @@ public:
 
     Chunk(int x, int z, std::shared_ptr<Lightmap> lightmap=nullptr);
 
+    /// @param index voxel index (see vox_index)
+    inline voxel get(uint index) const {
+        return voxels ? voxels[index] : packedVoxels.get(index);
+    }
+
+    inline voxel get(uint lx, uint y, uint lz) const {
+        return get(vox_index(lx, y, lz));
+    }
+
+    /// @brief Set voxel without unpacking voxels
+    inline void set(uint index, voxel vox) {
+        if (voxels) {
+            voxels[index] = vox;
+        } else {
+            packedVoxels.set(index, vox);
+        }
+    }
+
+    inline void set(uint lx, uint y, uint lz, voxel vox) {
+        set(vox_index(lx, y, lz), vox);
+    }
+
+    /// @brief Get flat CHUNK_VOL voxels array for bulk access. Unpacks
+    /// voxels if packed, so the chunk is modified: call it from the main
+    /// thread only (or on a chunk not shared with it yet). The pointer is
+    /// invalidated by packIfIdle (see GlobalChunks::packIdle), so it must
+    /// not be kept.
+    voxel* getVoxels();
+
+    /// @brief Write count voxels starting from the index to dst
+    void copyVoxels(voxel* dst, uint index = 0, uint count = CHUNK_VOL) const;
+
+    bool isPacked() const {
+        return voxels == nullptr;
+    }
+
+    /// @brief Pack voxels to paletted storage
+    void pack();
+
+    /// @brief Pack voxels if flat array was not requested since the
+    /// previous call. Packed voxels modified since packing are compacted
+    /// @return true if voxels have been packed or compacted
+    bool packIfIdle();
+
+    /// @return Number of bytes used by voxels storage
+    size_t getVoxelsMemoryUsage() const;
+
     /// @brief Refresh `bottom` and `top` values
     void updateHeights();
 
@@ -64,8 +132,31 @@ public:
     /// @return inventory bound to the given block or nullptr
     std::shared_ptr<Inventory> getBlockInventory(uint x, uint y, uint z) const;
 
-    inline void setModifiedAndUnsaved() {
+    inline void setModified() {
         flags.modified = true;
+        generation++;
+        sectionsGeneration.fill(generation);
+    }
+
+    inline void setModifiedAndUnsaved() {
+        setModified();
+        flags.unsaved = true;
+    }
+
+    /// @brief Mark mesh sections depending on the block layer y modified
+    /// (adjacent layers faces culling and lighting depend on it)
+    inline void setSectionsModified(int y) {
+        int from = std::max(y - 1, 0) / CHUNK_SECTION_H;
+        int to = std::min(y + 1, CHUNK_H - 1) / CHUNK_SECTION_H;
+        generation++;
+        for (int i = from; i <= to; i++) {
+            modifiedSections |= 1U << i;
+            sectionsGeneration[i] = generation;
+        }
+    }
+
+    inline void setBlockModifiedAndUnsaved(int y) {
+        setSectionsModified(y);
         flags.unsaved = true;
     }
 
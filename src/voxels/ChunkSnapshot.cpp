@@ -0,0 +1,65 @@
+#include "ChunkSnapshot.hpp"
+
+#include "Chunk.hpp"
+
+#include <cstring>
+
+ChunkSnapshot::ChunkSnapshot(
+    const Chunk& chunk, uint32_t requested, const ChunkSnapshot* previous
+)
+    : x(chunk.x),
+      z(chunk.z),
+      bottom(chunk.bottom),
+      top(chunk.top),
+      generation(chunk.generation),
+      lighted(chunk.flags.lighted),
+      hasLights(chunk.lightmap != nullptr) {
+    // lights may be built without marking sections modified
+    if (previous && (previous->lighted != lighted ||
+                     previous->hasLights != hasLights)) {
+        previous = nullptr;
+    }
+    for (int i = 0; i < CHUNK_SECTIONS; i++) {
+        uint32_t sectionGeneration = chunk.sectionsGeneration[i];
+        if (previous) {
+            const auto& section = previous->sections[i];
+            if (section && section->generation == sectionGeneration) {
+                sections[i] = section;
+                sectionsMask |= 1U << i;
+                continue;
+            }
+        }
+        if (!(requested & (1U << i))) {
+            continue;
+        }
+        auto section = std::make_shared<ChunkSnapshotSection>();
+        section->generation = sectionGeneration;
+        uint begin = i * ChunkSnapshotSection::VOLUME;
+        chunk.copyVoxels(section->voxels, begin, ChunkSnapshotSection::VOLUME);
+        if (chunk.lightmap) {
+            std::memcpy(
+                section->lights,
+                chunk.lightmap->getLights() + begin,
+                sizeof(section->lights)
+            );
+        }
+        sections[i] = std::move(section);
+        sectionsMask |= 1U << i;
+    }
+}
+
+std::shared_ptr<const ChunkSnapshot> ChunkSnapshot::create(
+    const Chunk& chunk, uint32_t requested, const ChunkSnapshot* previous
+) {
+    return std::make_shared<ChunkSnapshot>(chunk, requested, previous);
+}
+
+bool ChunkSnapshot::isActual(const Chunk& chunk) const {
+    return generation == chunk.generation &&
+           lighted == chunk.flags.lighted && bottom == chunk.bottom &&
+           top == chunk.top && hasLights == (chunk.lightmap != nullptr);
+}
+
+bool ChunkSnapshot::isActual(const Chunk& chunk, uint32_t required) const {
+    return isActual(chunk) && (sectionsMask & required) == required;
+}
@@ -0,0 +1,121 @@
+#pragma once
+
+#include "constants.hpp"
+#include "typedefs.hpp"
+#include "voxel.hpp"
+
+#include <array>
+#include <memory>
+
+class Chunk;
+
+/// @brief Immutable copy of CHUNK_SECTION_H voxel layers and their lights
+struct ChunkSnapshotSection {
+    static constexpr int VOLUME = CHUNK_W * CHUNK_D * CHUNK_SECTION_H;
+
+    /// @brief Chunk section generation the copy was made at
+    uint32_t generation;
+    voxel voxels[VOLUME];
+    light_t lights[VOLUME];
+};
+
+/// @brief Immutable copy of chunk voxels and lights shared between threads.
+/// Snapshot stays valid for the chunk while its generation is the same.
+/// Only requested sections are copied, sections not modified since the
+/// previous snapshot are shared with it
+class ChunkSnapshot {
+public:
+    static constexpr uint32_t ALL_SECTIONS =
+        CHUNK_SECTIONS == 32 ? ~0U : (1U << CHUNK_SECTIONS) - 1;
+
+    int x, z;
+    int bottom, top;
+    uint32_t generation;
+    bool lighted;
+
+    /// @brief Copy chunk sections (to be called by the chunk owner)
+    /// @param requested bit mask of sections to copy
+    /// @param previous previous snapshot of the same chunk instance
+    /// or nullptr
+    ChunkSnapshot(
+        const Chunk& chunk, uint32_t requested, const ChunkSnapshot* previous
+    );
+
+    /// @brief Create shared snapshot of the chunk
+    static std::shared_ptr<const ChunkSnapshot> create(
+        const Chunk& chunk,
+        uint32_t requested = ALL_SECTIONS,
+        const ChunkSnapshot* previous = nullptr
+    );
+
+    /// @return true if the chunk has not been modified since the snapshot
+    /// was created
+    bool isActual(const Chunk& chunk) const;
+
+    /// @return true if the snapshot is actual and contains the required
+    /// sections
+    bool isActual(const Chunk& chunk, uint32_t required) const;
+
+    /// @return bit mask of sections contained in the snapshot
+    uint32_t getSections() const {
+        return sectionsMask;
+    }
+
+    /// @return section voxels or nullptr if the section is not contained
+    const voxel* getSectionVoxels(int index) const {
+        const auto& section = sections[index];
+        return section ? section->voxels : nullptr;
+    }
+
+    /// @param index voxel index (see vox_index)
+    /// @return BLOCK_VOID voxel if the section is not contained
+    voxel getVoxel(uint index) const {
+        const auto& section = sections[index / ChunkSnapshotSection::VOLUME];
+        if (section == nullptr) {
+            return {BLOCK_VOID, {}};
+        }
+        return section->voxels[index % ChunkSnapshotSection::VOLUME];
+    }
+
+    /// @param index voxel index (see vox_index)
+    /// @return zero if the chunk has no lightmap or the section is not
+    /// contained
+    light_t getLight(uint index) const {
+        const auto& section = sections[index / ChunkSnapshotSection::VOLUME];
+        if (!hasLights || section == nullptr) {
+            return 0;
+        }
+        return section->lights[index % ChunkSnapshotSection::VOLUME];
+    }
+
+    bool hasLightmap() const {
+        return hasLights;
+    }
+private:
+    bool hasLights;
+    uint32_t sectionsMask = 0;
+    std::array<std::shared_ptr<const ChunkSnapshotSection>, CHUNK_SECTIONS>
+        sections;
+};
+
+/// @brief Snapshots of 3x3 chunks area, missing chunks are nullptr
+struct ChunkSnapshotsArea {
+    /// @brief Center chunk coords
+    int x, z;
+    /// @brief Snapshots in z-major order
+    std::array<std::shared_ptr<const ChunkSnapshot>, 9> snapshots;
+
+    /// @return nullptr if chunk is missing or out of the area
+    const ChunkSnapshot* get(int cx, int cz) const {
+        int lx = cx - x + 1;
+        int lz = cz - z + 1;
+        if (lx < 0 || lz < 0 || lx >= 3 || lz >= 3) {
+            return nullptr;
+        }
+        return snapshots[lz * 3 + lx].get();
+    }
+
+    const ChunkSnapshot& getCenter() const {
+        return *snapshots[4];
+    }
+};
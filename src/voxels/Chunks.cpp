@@ -12,6 +12,7 @@
 #include "world/Level.hpp"
 #include "world/LevelEvents.hpp"
 #include "VoxelsVolume.hpp"
+#include "ChunkSnapshot.hpp"
 #include "blocks_agent.hpp"
 
 #include <math.h>
@@ -29,10 +30,13 @@ Chunks::Chunks(
 )
     : events(events),
       indices(indices),
-      areaMap(w, d) {
+      areaMap(w, d),
+      frontier(w, d) {
     areaMap.setCenter(ox - w / 2, oz - d / 2);
     areaMap.setOutCallback([this](int, int, const auto& chunk) {
-        this->events->trigger(LevelEventType::CHUNK_HIDDEN, chunk.get());
+        if (this->events) {
+            this->events->trigger(LevelEventType::CHUNK_HIDDEN, chunk.get());
+        }
     });
 }
 
@@ -44,11 +48,11 @@ void Chunks::configure(int32_t x, int32_t z, uint32_t radius) {
     setCenter(x, z);
 }
 
-voxel* Chunks::get(int32_t x, int32_t y, int32_t z) const {
+std::optional<voxel> Chunks::get(int32_t x, int32_t y, int32_t z) const {
     return blocks_agent::get(*this, x, y, z);
 }
 
-voxel& Chunks::require(int32_t x, int32_t y, int32_t z) const {
+voxel Chunks::require(int32_t x, int32_t y, int32_t z) const {
     return blocks_agent::require(*this, x, y, z);
 }
 
@@ -56,8 +60,8 @@ const AABB* Chunks::isObstacleAt(float x, float y, float z) const {
     int ix = std::floor(x);
     int iy = std::floor(y);
     int iz = std::floor(z);
-    voxel* v = get(ix, iy, iz);
-    if (v == nullptr) {
+    auto v = get(ix, iy, iz);
+    if (!v) {
         if (iy >= CHUNK_H) {
             return nullptr;
         } else {
@@ -95,8 +99,8 @@ bool Chunks::isReplaceableBlock(int32_t x, int32_t y, int32_t z) {
 }
 
 bool Chunks::isObstacleBlock(int32_t x, int32_t y, int32_t z) {
-    voxel* v = get(x, y, z);
-    if (v == nullptr) return false;
+    auto v = get(x, y, z);
+    if (!v) return false;
     return indices.blocks.require(v->id).obstacle;
 }
 
@@ -208,7 +212,7 @@ void Chunks::set(
     blocks_agent::set(*this, x, y, z, id, state);
 }
 
-voxel* Chunks::rayCast(
+std::optional<voxel> Chunks::rayCast(
     const glm::vec3& start,
     const glm::vec3& dir,
     float maxDist,
@@ -257,7 +261,7 @@ glm::vec3 Chunks::rayCastToObstacle(
     float tzMax = (tzDelta < infinity) ? tzDelta * zdist : infinity;
 
     while (t <= maxDist) {
-        voxel* voxel = get(ix, iy, iz);
+        auto voxel = get(ix, iy, iz);
         if (voxel) {
             const auto& def = indices.blocks.require(voxel->id);
             if (def.obstacle) {
@@ -318,15 +322,22 @@ glm::vec3 Chunks::rayCastToObstacle(
 }
 
 void Chunks::setCenter(int32_t x, int32_t z) {
+    int offsetX = areaMap.getOffsetX();
+    int offsetY = areaMap.getOffsetY();
     areaMap.setCenter(floordiv<CHUNK_W>(x), floordiv<CHUNK_D>(z));
+    if (offsetX != areaMap.getOffsetX() || offsetY != areaMap.getOffsetY()) {
+        frontier.reset();
+    }
 }
 
 void Chunks::resize(uint32_t newW, uint32_t newD) {
     areaMap.resize(newW, newD);
+    frontier.resize(newW, newD);
 }
 
 bool Chunks::putChunk(const std::shared_ptr<Chunk>& chunk) {
     if (areaMap.set(chunk->x, chunk->z, chunk)) {
+        invalidateFrontier(chunk->x, chunk->z);
         if (events) {
             events->trigger(LevelEventType::CHUNK_SHOWN, chunk.get());
         }
@@ -341,9 +352,10 @@ static void fill_with_void(
     const glm::ivec3& pos,
     const glm::ivec3& size,
     int cx,
-    int cz
+    int cz,
+    int bottom
 ) {
-    for (int ly = pos.y; ly < pos.y + size.y; ly++) {
+    for (int ly = std::max(pos.y, bottom); ly < pos.y + size.y; ly++) {
         for (int lz = std::max(pos.z, cz * CHUNK_D);
              lz < std::min(pos.z + size.z, (cz + 1) * CHUNK_D);
              lz++) {
@@ -369,21 +381,40 @@ static inline light_t apply_backlight(light_t light) {
     );
 }
 
+static inline voxel get_voxel(const Chunk& chunk, uint index) {
+    return chunk.get(index);
+}
+
+static inline voxel get_voxel(const ChunkSnapshot& snapshot, uint index) {
+    return snapshot.getVoxel(index);
+}
+
+static inline light_t get_light(const Chunk& chunk, uint index) {
+    return chunk.lightmap ? chunk.lightmap->getLights()[index]
+                          : Lightmap::SUN_LIGHT_ONLY;
+}
+
+static inline light_t get_light(const ChunkSnapshot& snapshot, uint index) {
+    return snapshot.hasLightmap() ? snapshot.getLight(index)
+                                  : Lightmap::SUN_LIGHT_ONLY;
+}
+
 // ugly
-static inline void sample_chunk(
+/// @tparam ChunkT Chunk or ChunkSnapshot
+template <typename ChunkT>
+static inline void sample_voxels(
     const decltype(ContentIndices::blocks)& defs,
-    const Chunk& chunk,
+    const ChunkT& chunk,
     voxel* voxels,
     light_t* lights,
     const glm::ivec3& pos,
     const glm::ivec3& size,
     int cx,
     int cz,
-    bool backlight
+    bool backlight,
+    int bottom
 ) {
-    const auto cvoxels = chunk.voxels;
-    const auto clights = chunk.lightmap ? chunk.lightmap->getLights() : nullptr;
-    for (int ly = pos.y; ly < pos.y + size.y; ly++) {
+    for (int ly = std::max(pos.y, bottom); ly < pos.y + size.y; ly++) {
         for (int lz = std::max(pos.z, cz * CHUNK_D);
                 lz < std::min(pos.z + size.z, (cz + 1) * CHUNK_D);
                 lz++) {
@@ -401,9 +432,8 @@ static inline void sample_chunk(
                     CHUNK_D
                 );
                 auto& vox = voxels[vidx];
-                vox = cvoxels[cidx];
-                light_t light = clights ? clights[cidx]
-                                        : Lightmap::SUN_LIGHT_ONLY;
+                vox = get_voxel(chunk, cidx);
+                light_t light = get_light(chunk, cidx);
                 // todo: move to the BlocksRenderer
                 if (backlight) {
                     const auto block = defs.get(vox.id);
@@ -417,14 +447,19 @@ static inline void sample_chunk(
     }
 }
 
-void Chunks::getVoxels(
+/// @param getChunk (cx, cz) -> pointer to Chunk or ChunkSnapshot or nullptr
+template <typename ChunkGetter>
+static void sample_area(
+    const decltype(ContentIndices::blocks)& defs,
+    const ChunkGetter& getChunk,
     voxel* voxels,
     light_t* lights,
     const glm::ivec3& pos,
     const glm::ivec3& size,
     bool backlight,
-    int top
-) const {
+    int top,
+    int bottom
+) {
     int h = std::min<int>(size.y, top);
 
     int scx = floordiv<CHUNK_W>(pos.x);
@@ -442,12 +477,12 @@ void Chunks::getVoxels(
             const auto chunk = getChunk(cx, cz);
             if (chunk == nullptr) {
                 fill_with_void(
-                    voxels, lights, pos, {size.x, h, size.z}, cx, cz
+                    voxels, lights, pos, {size.x, h, size.z}, cx, cz, bottom
                 );
                 continue;
             }
-            sample_chunk(
-                indices.blocks,
+            sample_voxels(
+                defs,
                 *chunk,
                 voxels,
                 lights,
@@ -455,27 +490,83 @@ void Chunks::getVoxels(
                 {size.x, h, size.z},
                 cx,
                 cz,
-                backlight
+                backlight,
+                bottom
             );
         }
     }
 }
 
-void Chunks::getVoxels(VoxelsVolume& volume, bool backlight, int top) const {
+void Chunks::getVoxels(
+    voxel* voxels,
+    light_t* lights,
+    const glm::ivec3& pos,
+    const glm::ivec3& size,
+    bool backlight,
+    int top,
+    int bottom
+) const {
+    sample_area(
+        indices.blocks,
+        [this](int cx, int cz) { return getChunk(cx, cz); },
+        voxels,
+        lights,
+        pos,
+        size,
+        backlight,
+        top,
+        bottom
+    );
+}
+
+void Chunks::getVoxels(
+    const ContentIndices& indices,
+    const ChunkSnapshotsArea& area,
+    voxel* voxels,
+    light_t* lights,
+    const glm::ivec3& pos,
+    const glm::ivec3& size,
+    bool backlight,
+    int top,
+    int bottom
+) {
+    sample_area(
+        indices.blocks,
+        [&area](int cx, int cz) { return area.get(cx, cz); },
+        voxels,
+        lights,
+        pos,
+        size,
+        backlight,
+        top,
+        bottom
+    );
+}
+
+void Chunks::getVoxels(
+    VoxelsVolume& volume, bool backlight, int top, int bottom
+) const {
     getVoxels(
         volume.getVoxels(),
         volume.getLights(),
         {volume.getX(), volume.getY(), volume.getZ()},
         {volume.getW(), volume.getH(), volume.getD()},
         backlight,
-        top
+        top,
+        bottom
     );
 }
 
 void Chunks::saveAndClear() {
     areaMap.clear();
+    frontier.reset();
 }
 
 void Chunks::remove(int32_t x, int32_t z) {
     areaMap.remove(x, z);
+    invalidateFrontier(x, z);
+}
+
+void Chunks::invalidateFrontier(int32_t x, int32_t z) {
+    frontier.invalidate(x - areaMap.getOffsetX(), z - areaMap.getOffsetY());
 }
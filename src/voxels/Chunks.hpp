@@ -4,10 +4,13 @@
 #include "voxel.hpp"
 #include "constants.hpp"
 #include "util/AreaMap2D.hpp"
+#include "delegates.hpp"
+#include "ChunksFrontier.hpp"
 
 #include <stdlib.h>
 #include <glm/glm.hpp>
 #include <memory>
+#include <optional>
 #include <set>
 #include <vector>
 
@@ -21,6 +24,7 @@ class WorldFiles;
 class LevelEvents;
 class Block;
 class VoxelsVolume;
+struct ChunkSnapshotsArea;
 
 template <int w, int h, int d> class StaticVoxelsVolume;
 
@@ -45,6 +49,8 @@ class Chunks {
     );
 
     util::AreaMap2D<std::shared_ptr<Chunk>, int32_t> areaMap;
+    ChunksFrontier frontier;
+    runnable barrier;
 public:
     Chunks(
         int32_t w,
@@ -58,6 +64,20 @@ public:
 
     void configure(int32_t x, int32_t z, uint32_t radius);
 
+    /// @brief Set callback waiting for background workers accessing chunks
+    /// (see GlobalChunks::setBarrier)
+    void setBarrier(runnable barrier) {
+        this->barrier = std::move(barrier);
+    }
+
+    /// @brief Wait for background workers accessing chunks. Must be called
+    /// before voxels modification
+    void waitWorkers() const {
+        if (barrier) {
+            barrier();
+        }
+    }
+
     bool putChunk(const std::shared_ptr<Chunk>& chunk);
 
     Chunk* getChunk(int32_t x, int32_t z) const;
@@ -70,14 +90,10 @@ public:
         );
     }
 
-    voxel* get(int32_t x, int32_t y, int32_t z) const;
-    voxel& require(int32_t x, int32_t y, int32_t z) const;
+    std::optional<voxel> get(int32_t x, int32_t y, int32_t z) const;
+    voxel require(int32_t x, int32_t y, int32_t z) const;
 
-    inline voxel* get(const glm::ivec3& pos) {
-        return get(pos.x, pos.y, pos.z);
-    }
-
-    inline const voxel* get(const glm::ivec3& pos) const {
+    inline std::optional<voxel> get(const glm::ivec3& pos) const {
         return get(pos.x, pos.y, pos.z);
     }
 
@@ -109,7 +125,7 @@ public:
 
     void setRotation(int32_t x, int32_t y, int32_t z, uint8_t rotation);
 
-    voxel* rayCast(
+    std::optional<voxel> rayCast(
         const glm::vec3& start,
         const glm::vec3& dir,
         float maxLength,
@@ -133,15 +149,22 @@ public:
     bool isReplaceableBlock(int32_t x, int32_t y, int32_t z);
     bool isObstacleBlock(int32_t x, int32_t y, int32_t z);
 
+    /// @param top sampled layers upper limit (exclusive)
+    /// @param bottom sampled layers lower limit, layers out of
+    /// [bottom, top) range are left untouched
     void getVoxels(
-        VoxelsVolume& volume, bool backlight = false, int top = CHUNK_H
+        VoxelsVolume& volume,
+        bool backlight = false,
+        int top = CHUNK_H,
+        int bottom = 0
     ) const;
 
     template <int w, int h, int d>
     void getVoxels(
         StaticVoxelsVolume<w, h, d>& volume,
         bool backlight = false,
-        int top = CHUNK_H
+        int top = CHUNK_H,
+        int bottom = 0
     ) const {
         getVoxels(
             volume.getVoxels(),
@@ -149,7 +172,8 @@ public:
             {volume.getX(), volume.getY(), volume.getZ()},
             {w, h, d},
             backlight,
-            top
+            top,
+            bottom
         );
     }
 
@@ -159,9 +183,24 @@ public:
         const glm::ivec3& pos,
         const glm::ivec3& size,
         bool backlight,
-        int top
+        int top,
+        int bottom = 0
     ) const;
 
+    /// @brief Thread-safe variant of getVoxels reading chunks snapshots,
+    /// chunks out of the area are considered missing
+    static void getVoxels(
+        const ContentIndices& indices,
+        const ChunkSnapshotsArea& area,
+        voxel* voxels,
+        light_t* lights,
+        const glm::ivec3& pos,
+        const glm::ivec3& size,
+        bool backlight,
+        int top,
+        int bottom = 0
+    );
+
     void setCenter(int32_t x, int32_t z);
     void resize(uint32_t newW, uint32_t newD);
 
@@ -173,6 +212,14 @@ public:
         return areaMap.getBuffer();
     }
 
+    /// @brief Area cells loading order, kept in sync with the area changes
+    ChunksFrontier& getFrontier() {
+        return frontier;
+    }
+
+    /// @brief Make the chunk revisited by loader (e.g. after lights reset)
+    void invalidateFrontier(int32_t x, int32_t z);
+
     int getWidth() const {
         return areaMap.getWidth();
     }
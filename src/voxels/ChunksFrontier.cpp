@@ -0,0 +1,51 @@
+#include "ChunksFrontier.hpp"
+
+#include <algorithm>
+
+ChunksFrontier::ChunksFrontier(int width, int height) {
+    resize(width, height);
+}
+
+void ChunksFrontier::resize(int width, int height) {
+    this->width = width;
+    this->height = height;
+
+    cells.clear();
+    for (int z = 0; z < height; z++) {
+        for (int x = 0; x < width; x++) {
+            int lx = x - width / 2;
+            int lz = z - height / 2;
+            cells.push_back(Cell {
+                static_cast<uint32_t>(z * width + x), x, z, lx * lx + lz * lz
+            });
+        }
+    }
+    std::sort(cells.begin(), cells.end(), [](const Cell& a, const Cell& b) {
+        return a.distance < b.distance ||
+               (a.distance == b.distance && a.index < b.index);
+    });
+    ranks.resize(cells.size());
+    for (uint32_t i = 0; i < cells.size(); i++) {
+        ranks[cells[i].index] = i;
+    }
+    reset();
+}
+
+void ChunksFrontier::reset() {
+    loadCursor = 0;
+    lightsCursor = 0;
+    trimRequired = true;
+}
+
+void ChunksFrontier::invalidate(int x, int z) {
+    if (x < 0 || z < 0 || x >= width || z >= height) {
+        return;
+    }
+    size_t rank = ranks[z * width + x];
+    const auto& cell = cells[rank];
+    loadCursor = std::min(loadCursor, rank);
+    lightsCursor = std::min(lightsCursor, rank);
+    if (cell.distance >= getTrimDistance()) {
+        trimRequired = true;
+    }
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+/// @brief Cells of a chunks area ordered by distance to the area center.
+/// Cursors mark prefixes of cells known to need no processing, so the
+/// nearest cell to process is found without scanning the whole area.
+/// Cursors move back when a cell before them changes and get reset when
+/// the area moves.
+class ChunksFrontier {
+public:
+    struct Cell {
+        /// @brief Index in the area buffer
+        uint32_t index;
+        /// @brief Local coords in the area
+        int x, z;
+        /// @brief Squared distance to the area center
+        int distance;
+    };
+
+    /// @brief All cells before the cursor contain chunks
+    size_t loadCursor = 0;
+    /// @brief All chunks before the cursor are lighted (or missing)
+    size_t lightsCursor = 0;
+    /// @brief Chunks may be present in cells beyond the trim distance
+    bool trimRequired = false;
+
+    ChunksFrontier(int width, int height);
+
+    void resize(int width, int height);
+
+    /// @brief Reset cursors after the area moved
+    void reset();
+
+    /// @brief Move cursors back to the cell if they are past it
+    void invalidate(int x, int z);
+
+    /// @return cells ordered by distance, then by index
+    const std::vector<Cell>& getCells() const {
+        return cells;
+    }
+
+    /// @brief Chunks at this or larger distance should be removed
+    int getTrimDistance() const {
+        return (width / 2) * (height / 2);
+    }
+private:
+    int width;
+    int height;
+    std::vector<Cell> cells;
+    /// @brief Cells order by area index
+    std::vector<uint32_t> ranks;
+};
@@ -0,0 +1,128 @@
+#include "ChunksInterest.hpp"
+
+#include <algorithm>
+#include <numeric>
+
+void ChunksInterest::apply(const Area& area, const Area* other, int delta) {
+    for (int z = area.z - area.radius; z <= area.z + area.radius; z++) {
+        for (int x = area.x - area.radius; x <= area.x + area.radius; x++) {
+            if (!area.contains(x, z) || (other && other->contains(x, z))) {
+                continue;
+            }
+            if (delta > 0) {
+                demand[{x, z}]++;
+                continue;
+            }
+            const auto& found = demand.find({x, z});
+            if (found != demand.end() && --found->second == 0) {
+                demand.erase(found);
+            }
+        }
+    }
+}
+
+void ChunksInterest::setArea(u64id_t id, int x, int z, int radius) {
+    Area area {x, z, radius};
+    const auto& found = areas.find(id);
+    if (found == areas.end()) {
+        apply(area, nullptr, 1);
+        areas[id] = area;
+        return;
+    }
+    auto& prev = found->second;
+    if (prev.x == x && prev.z == z && prev.radius == radius) {
+        return;
+    }
+    apply(prev, &area, -1);
+    apply(area, &prev, 1);
+    prev = area;
+}
+
+void ChunksInterest::removeArea(u64id_t id) {
+    const auto& found = areas.find(id);
+    if (found == areas.end()) {
+        return;
+    }
+    apply(found->second, nullptr, -1);
+    areas.erase(found);
+}
+
+std::vector<u64id_t> ChunksInterest::getAreasIds() const {
+    std::vector<u64id_t> ids;
+    for (const auto& [id, _] : areas) {
+        ids.push_back(id);
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+uint ChunksInterest::getDemand(int x, int z) const {
+    const auto& found = demand.find({x, z});
+    return found == demand.end() ? 0 : found->second;
+}
+
+static size_t find_root(std::vector<size_t>& parents, size_t index) {
+    while (parents[index] != index) {
+        parents[index] = parents[parents[index]];
+        index = parents[index];
+    }
+    return index;
+}
+
+std::vector<ChunksRegion> ChunksInterest::getRegions(int margin) const {
+    std::vector<Area> sorted;
+    for (auto id : getAreasIds()) {
+        sorted.push_back(areas.at(id));
+    }
+    std::vector<size_t> parents(sorted.size());
+    std::iota(parents.begin(), parents.end(), 0);
+    for (size_t i = 0; i < sorted.size(); i++) {
+        for (size_t j = i + 1; j < sorted.size(); j++) {
+            const auto& a = sorted[i];
+            const auto& b = sorted[j];
+            int distance = a.radius + b.radius + margin * 2;
+            if (std::abs(a.x - b.x) > distance ||
+                std::abs(a.z - b.z) > distance) {
+                continue;
+            }
+            size_t rootA = find_root(parents, i);
+            size_t rootB = find_root(parents, j);
+            // lower index stays the root to keep regions order
+            parents[std::max(rootA, rootB)] = std::min(rootA, rootB);
+        }
+    }
+    std::vector<ChunksRegion> regions;
+    std::vector<glm::ivec4> bounds;
+    std::vector<size_t> regionIndices(sorted.size());
+    for (size_t i = 0; i < sorted.size(); i++) {
+        const auto& area = sorted[i];
+        glm::ivec4 box(
+            area.x - area.radius,
+            area.z - area.radius,
+            area.x + area.radius,
+            area.z + area.radius
+        );
+        size_t root = find_root(parents, i);
+        if (root == i) {
+            regionIndices[i] = bounds.size();
+            bounds.push_back(box);
+            continue;
+        }
+        auto& dst = bounds[regionIndices[root]];
+        dst = glm::ivec4(
+            std::min(dst.x, box.x),
+            std::min(dst.y, box.y),
+            std::max(dst.z, box.z),
+            std::max(dst.w, box.w)
+        );
+    }
+    for (const auto& box : bounds) {
+        int x = (box.x + box.z) / 2;
+        int z = (box.y + box.w) / 2;
+        int radius = std::max(
+            std::max(x - box.x, box.z - x), std::max(z - box.y, box.w - z)
+        );
+        regions.push_back(ChunksRegion {x, z, radius});
+    }
+    return regions;
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <unordered_map>
+
+#define GLM_ENABLE_EXPERIMENTAL
+#include <glm/glm.hpp>
+#include <glm/gtx/hash.hpp>
+
+#include "typedefs.hpp"
+
+/// @brief Square area of chunks
+struct ChunksRegion {
+    /// @brief Center chunk coords
+    int x, z;
+    /// @brief Number of chunks from the center to the square side
+    int radius;
+};
+
+/// @brief Server-side chunks demand merged from load areas of all players.
+/// Every chunk has number of areas containing it, so a chunk is processed
+/// once however many players are interested in it
+class ChunksInterest {
+    struct Area {
+        int x, z;
+        int radius;
+
+        bool contains(int cx, int cz) const {
+            int dx = cx - x;
+            int dz = cz - z;
+            return dx * dx + dz * dz < radius * radius;
+        }
+    };
+    std::unordered_map<u64id_t, Area> areas;
+    std::unordered_map<glm::ivec2, uint> demand;
+
+    /// @brief Change demand of area chunks not contained by the other area
+    void apply(const Area& area, const Area* other, int delta);
+public:
+    /// @brief Set or move load area (circle) of the player
+    void setArea(u64id_t id, int x, int z, int radius);
+
+    void removeArea(u64id_t id);
+
+    /// @return ids of players with areas set
+    std::vector<u64id_t> getAreasIds() const;
+
+    /// @return number of areas containing the chunk
+    uint getDemand(int x, int z) const;
+
+    bool isDemanded(int x, int z) const {
+        return demand.find({x, z}) != demand.end();
+    }
+
+    /// @return number of demanded chunks
+    size_t size() const {
+        return demand.size();
+    }
+
+    /// @brief Merge areas into square regions. Areas are merged if their
+    /// squares extended by margin overlap
+    /// @return regions ordered by the lowest player id
+    std::vector<ChunksRegion> getRegions(int margin) const;
+};
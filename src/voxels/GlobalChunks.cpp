@@ -31,6 +31,10 @@ void GlobalChunks::setOnUnload(consumer<Chunk&> onUnload) {
     this->onUnload = std::move(onUnload);
 }
 
+void GlobalChunks::setBarrier(runnable barrier) {
+    this->barrier = std::move(barrier);
+}
+
 std::shared_ptr<Chunk> GlobalChunks::fetch(int x, int z) {
     const auto& found = chunksMap.find(keyfrom(x, z));
     if (found == chunksMap.end()) {
@@ -42,8 +46,9 @@ std::shared_ptr<Chunk> GlobalChunks::fetch(int x, int z) {
 static void check_voxels(const ContentIndices& indices, Chunk& chunk) {
     bool corrupted = false;
     blockid_t defsCount = indices.blocks.count();
+    voxel* voxels = chunk.getVoxels();
     for (size_t i = 0; i < CHUNK_VOL; i++) {
-        blockid_t id = chunk.voxels[i].id;
+        blockid_t id = voxels[i].id;
         if (id >= defsCount) {
             if (!corrupted) {
 #ifdef NDEBUG
@@ -58,13 +63,14 @@ static void check_voxels(const ContentIndices& indices, Chunk& chunk) {
                 abort();
 #endif
             }
-            chunk.voxels[i] = {};
+            voxels[i] = {};
         }
     }
 }
 
 void GlobalChunks::erase(int x, int z) {
     chunksMap.erase(keyfrom(x, z));
+    chunksTable.set(x, z, nullptr);
 }
 
 static inline auto load_inventories(
@@ -76,7 +82,7 @@ static inline auto load_inventories(
     auto iterator = invs.begin();
     while (iterator != invs.end()) {
         uint index = iterator->first;
-        const auto& def = defs.require(chunk.voxels[index].id);
+        const auto& def = defs.require(chunk.get(index).id);
         if (def.inventorySize == 0) {
             iterator = invs.erase(iterator);
             continue;
@@ -106,6 +112,7 @@ std::shared_ptr<Chunk> GlobalChunks::create(int x, int z, bool lighting) {
     auto chunk =
         chunks_pool.create(x, z, lighting ? lightmaps_pool.create() : nullptr);
     chunksMap[keyfrom(x, z)] = chunk;
+    chunksTable.set(x, z, chunk.get());
 
     World& world = level.getWorld();
     auto& regions = world.wfile.get()->getRegions();
@@ -181,15 +188,20 @@ void GlobalChunks::decref(Chunk* chunk) {
         if (onUnload) {
             onUnload(*chunk);
         }
+        chunksTable.set(chunk->x, chunk->z, nullptr);
         chunksMap.erase(ekey.key);
         refCounters.erase(found);
     }
 }
 
-void GlobalChunks::save(Chunk* chunk) {
+void GlobalChunks::save(Chunk* chunk, bool deferCompression) {
     if (chunk == nullptr) {
         return;
     }
+    // lightmap is being written by a lights worker
+    if (chunk->lightsLocked) {
+        waitWorkers();
+    }
     AABB aabb = chunk->getAABB();
     auto entities = level.entities->getAllInside(aabb);
     auto root = dv::object();
@@ -200,20 +212,51 @@ void GlobalChunks::save(Chunk* chunk) {
     level.getWorld().wfile->getRegions().put(
         chunk,
         chunk->flags.entities ? json::to_binary(root, true)
-                                : std::vector<ubyte>()
+                                : std::vector<ubyte>(),
+        deferCompression
     );
 }
 
-void GlobalChunks::saveAll() {
+void GlobalChunks::saveAll(bool deferCompression) {
     for (const auto& [_, chunk] : chunksMap) {
-        save(chunk.get());
+        save(chunk.get(), deferCompression);
     }
 }
 
 void GlobalChunks::putChunk(std::shared_ptr<Chunk> chunk) {
+    chunksTable.set(chunk->x, chunk->z, chunk.get());
     chunksMap[keyfrom(chunk->x, chunk->z)] = std::move(chunk);
 }
 
+size_t GlobalChunks::packIdle(size_t maxCount, size_t maxVisited) {
+    if (packQueue.empty()) {
+        packQueue.reserve(chunksMap.size());
+        for (const auto& [key, _] : chunksMap) {
+            packQueue.push_back(key);
+        }
+    }
+    size_t count = 0;
+    size_t visited = 0;
+    while (!packQueue.empty() && count < maxCount && visited < maxVisited) {
+        uint64_t key = packQueue.back();
+        packQueue.pop_back();
+        visited++;
+
+        const auto& found = chunksMap.find(key);
+        // unloaded since the queue was filled
+        if (found == chunksMap.end()) {
+            continue;
+        }
+        const auto& chunk = found->second;
+        // lights workers read voxels of locked chunks
+        if (chunk->flags.ready && !chunk->lightsLocked &&
+            chunk->packIfIdle()) {
+            count++;
+        }
+    }
+    return count;
+}
+
 std::optional<AABB> GlobalChunks::isObstacleAt(float x, float y, float z, const AABB& aabb) const {
     return blocks_agent::is_obstacle_at(*this, x, y, z, aabb);
 }
@@ -3,6 +3,7 @@
 #include <memory>
 #include <optional>
 #include <unordered_map>
+#include <vector>
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/glm.hpp>
@@ -10,6 +11,7 @@
 
 #include "voxel.hpp"
 #include "delegates.hpp"
+#include "util/PagedTable2D.hpp"
 
 class Chunk;
 class Level;
@@ -30,16 +32,34 @@ class GlobalChunks {
     Level& level;
     const ContentIndices& indices;
     std::unordered_map<uint64_t, std::shared_ptr<Chunk>> chunksMap;
+    /// @brief Loaded chunks lookup table (chunksMap owns the chunks)
+    util::PagedTable2D<Chunk*> chunksTable;
     std::unordered_map<glm::ivec2, std::shared_ptr<Chunk>> pinnedChunks;
     std::unordered_map<ptrdiff_t, int> refCounters;
+    /// @brief Keys of chunks not visited by packIdle in the current pass,
+    /// refilled from chunksMap when empty
+    std::vector<uint64_t> packQueue;
 
     consumer<Chunk&> onUnload;
+    runnable barrier;
 public:
     GlobalChunks(Level& level);
     ~GlobalChunks() = default;
 
     void setOnUnload(consumer<Chunk&> onUnload);
 
+    /// @brief Set callback waiting for background workers accessing chunks
+    /// (see Chunk::lightsLocked)
+    void setBarrier(runnable barrier);
+
+    /// @brief Wait for background workers accessing chunks. Must be called
+    /// before voxels modification
+    void waitWorkers() const {
+        if (barrier) {
+            barrier();
+        }
+    }
+
     std::shared_ptr<Chunk> fetch(int x, int z);
     std::shared_ptr<Chunk> create(int x, int z, bool lighting);
 
@@ -53,19 +73,24 @@ public:
 
     void erase(int x, int z);
 
-    void save(Chunk* chunk);
-    void saveAll();
+    /// @param deferCompression keep chunk data uncompressed until written
+    void save(Chunk* chunk, bool deferCompression = false);
+    void saveAll(bool deferCompression = false);
 
     void putChunk(std::shared_ptr<Chunk> chunk);
 
+    /// @brief Pack voxels of ready chunks which flat voxels array was not
+    /// requested since the previous call (see Chunk::packIfIdle).
+    /// Continues from the chunk the previous call stopped at
+    /// @param maxCount max number of chunks to pack
+    /// @param maxVisited max number of chunks to check
+    /// @return number of packed chunks
+    size_t packIdle(size_t maxCount, size_t maxVisited);
+
     std::optional<AABB> isObstacleAt(float x, float y, float z, const AABB& aabb) const;
 
     inline Chunk* getChunk(int cx, int cz) const {
-        const auto& found = chunksMap.find(keyfrom(cx, cz));
-        if (found == chunksMap.end()) {
-            return nullptr;
-        }
-        return found->second.get();
+        return chunksTable.get(cx, cz);
     }
 
     const ContentIndices& getContentIndices() const {
@@ -0,0 +1,267 @@
+#include "PalettedVoxels.hpp"
+
+#include <algorithm>
+
+#include "Chunk.hpp"
+#include "util/data_io.hpp"
+
+static inline uint words_count(uint8_t bits) {
+    return (VOXELS_SECTION_VOL * bits + 31) / 32;
+}
+
+PalettedSection::PalettedSection(voxel vox) : palette({pack_voxel(vox)}) {
+}
+
+uint32_t PalettedSection::getRaw(uint index) const {
+    switch (bits) {
+        case 0:
+            return palette[0];
+        case DIRECT_BITS:
+            return data[index];
+        default: {
+            uint bitIndex = index * bits;
+            uint32_t mask = (1U << bits) - 1;
+            return palette[(data[bitIndex / 32] >> (bitIndex % 32)) & mask];
+        }
+    }
+}
+
+void PalettedSection::grow(uint8_t newBits) {
+    auto newData = std::make_unique<uint32_t[]>(words_count(newBits));
+    for (uint i = 0; i < VOXELS_SECTION_VOL; i++) {
+        uint32_t value;
+        if (bits == 0) {
+            value = 0;
+        } else {
+            uint bitIndex = i * bits;
+            value = (data[bitIndex / 32] >> (bitIndex % 32)) & ((1U << bits) - 1);
+        }
+        if (newBits == DIRECT_BITS) {
+            newData[i] = palette[value];
+        } else {
+            uint bitIndex = i * newBits;
+            newData[bitIndex / 32] |= value << (bitIndex % 32);
+        }
+    }
+    if (newBits == DIRECT_BITS) {
+        palette.clear();
+        palette.shrink_to_fit();
+    }
+    data = std::move(newData);
+    bits = newBits;
+}
+
+void PalettedSection::set(uint index, voxel vox) {
+    uint32_t raw = pack_voxel(vox);
+    dirty = true;
+    if (bits == DIRECT_BITS) {
+        data[index] = raw;
+        return;
+    }
+    uint32_t paletteIndex;
+    auto found = std::find(palette.begin(), palette.end(), raw);
+    if (found == palette.end()) {
+        paletteIndex = palette.size();
+        if (paletteIndex >= 256) {
+            grow(DIRECT_BITS);
+            data[index] = raw;
+            return;
+        }
+        palette.push_back(raw);
+        uint8_t requiredBits = bits == 0 ? 1 : bits;
+        while ((1U << requiredBits) < palette.size()) {
+            requiredBits *= 2;
+        }
+        if (requiredBits != bits) {
+            grow(requiredBits);
+        }
+    } else {
+        paletteIndex = found - palette.begin();
+        if (bits == 0) {
+            return;
+        }
+    }
+    uint bitIndex = index * bits;
+    uint32_t& word = data[bitIndex / 32];
+    uint32_t mask = ((1U << bits) - 1) << (bitIndex % 32);
+    word = (word & ~mask) | (paletteIndex << (bitIndex % 32));
+}
+
+void PalettedSection::pack(const voxel* src) {
+    dirty = false;
+    palette.clear();
+    // collecting indices first to choose index width once
+    auto indices = std::make_unique<uint16_t[]>(VOXELS_SECTION_VOL);
+    uint32_t prevRaw = pack_voxel(src[0]);
+    uint16_t prevIndex = 0;
+    palette.push_back(prevRaw);
+    for (uint i = 0; i < VOXELS_SECTION_VOL; i++) {
+        uint32_t raw = pack_voxel(src[i]);
+        if (raw != prevRaw) {
+            auto found = std::find(palette.begin(), palette.end(), raw);
+            if (found == palette.end()) {
+                if (palette.size() == 256) {
+                    palette.clear();
+                    palette.shrink_to_fit();
+                    bits = DIRECT_BITS;
+                    data = std::make_unique<uint32_t[]>(VOXELS_SECTION_VOL);
+                    for (uint j = 0; j < VOXELS_SECTION_VOL; j++) {
+                        data[j] = pack_voxel(src[j]);
+                    }
+                    return;
+                }
+                prevIndex = palette.size();
+                palette.push_back(raw);
+            } else {
+                prevIndex = found - palette.begin();
+            }
+            prevRaw = raw;
+        }
+        indices[i] = prevIndex;
+    }
+    bits = 0;
+    if (palette.size() > 1) {
+        bits = 1;
+        while ((1U << bits) < palette.size()) {
+            bits *= 2;
+        }
+    }
+    if (bits == 0) {
+        data = nullptr;
+        return;
+    }
+    data = std::make_unique<uint32_t[]>(words_count(bits));
+    for (uint i = 0; i < VOXELS_SECTION_VOL; i++) {
+        uint bitIndex = i * bits;
+        data[bitIndex / 32] |= static_cast<uint32_t>(indices[i])
+                               << (bitIndex % 32);
+    }
+}
+
+void PalettedSection::unpack(voxel* dst) const {
+    for (uint i = 0; i < VOXELS_SECTION_VOL; i++) {
+        dst[i] = get(i);
+    }
+}
+
+bool PalettedSection::compact() {
+    if (!dirty) {
+        return false;
+    }
+    voxel voxels[VOXELS_SECTION_VOL];
+    unpack(voxels);
+    pack(voxels);
+    return true;
+}
+
+bool PalettedSection::isEmpty() const {
+    if (bits == 0) {
+        return palette[0] == 0;
+    }
+    for (uint i = 0; i < VOXELS_SECTION_VOL; i++) {
+        if (getRaw(i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t PalettedSection::getMemoryUsage() const {
+    return sizeof(PalettedSection) + palette.capacity() * sizeof(uint32_t) +
+           (bits ? words_count(bits) * sizeof(uint32_t) : 0);
+}
+
+PalettedVoxels::PalettedVoxels(const voxel* voxels) {
+    pack(voxels);
+}
+
+void PalettedVoxels::set(uint index, voxel vox) {
+    auto& section = sections[index / VOXELS_SECTION_VOL];
+    if (section == nullptr) {
+        if (vox.id == BLOCK_AIR && blockstate2int(vox.state) == 0) {
+            return;
+        }
+        section = std::make_unique<PalettedSection>();
+    }
+    section->set(index % VOXELS_SECTION_VOL, vox);
+}
+
+void PalettedVoxels::pack(const voxel* src) {
+    for (uint i = 0; i < VOXELS_SECTIONS_COUNT; i++) {
+        const voxel* sectionVoxels = src + i * VOXELS_SECTION_VOL;
+        bool empty = std::all_of(
+            sectionVoxels,
+            sectionVoxels + VOXELS_SECTION_VOL,
+            [](const voxel& vox) {
+                return PalettedSection::pack_voxel(vox) == 0;
+            }
+        );
+        if (empty) {
+            sections[i] = nullptr;
+            continue;
+        }
+        if (sections[i] == nullptr) {
+            sections[i] = std::make_unique<PalettedSection>();
+        }
+        sections[i]->pack(sectionVoxels);
+    }
+}
+
+void PalettedVoxels::unpack(voxel* dst, uint index, uint count) const {
+    uint end = index + count;
+    while (index < end) {
+        const auto& section = sections[index / VOXELS_SECTION_VOL];
+        uint local = index % VOXELS_SECTION_VOL;
+        uint n = std::min(end - index, VOXELS_SECTION_VOL - local);
+        if (section == nullptr) {
+            std::fill(dst, dst + n, voxel {});
+        } else if (n == VOXELS_SECTION_VOL) {
+            section->unpack(dst);
+        } else {
+            for (uint i = 0; i < n; i++) {
+                dst[i] = section->get(local + i);
+            }
+        }
+        dst += n;
+        index += n;
+    }
+}
+
+bool PalettedVoxels::compact() {
+    bool compacted = false;
+    for (auto& section : sections) {
+        if (section && section->compact()) {
+            compacted = true;
+            if (section->isEmpty()) {
+                section = nullptr;
+            }
+        }
+    }
+    return compacted;
+}
+
+std::unique_ptr<ubyte[]> PalettedVoxels::encode() const {
+    auto buffer = std::make_unique<ubyte[]>(CHUNK_DATA_LEN);
+    auto dst = reinterpret_cast<uint16_t*>(buffer.get());
+    for (uint s = 0; s < VOXELS_SECTIONS_COUNT; s++) {
+        const auto& section = sections[s];
+        uint offset = s * VOXELS_SECTION_VOL;
+        for (uint i = 0; i < VOXELS_SECTION_VOL; i++) {
+            voxel vox = section ? section->get(i) : voxel {};
+            dst[offset + i] = dataio::h2le(vox.id);
+            dst[CHUNK_VOL + offset + i] =
+                dataio::h2le(blockstate2int(vox.state));
+        }
+    }
+    return buffer;
+}
+
+size_t PalettedVoxels::getMemoryUsage() const {
+    size_t size = sizeof(PalettedVoxels);
+    for (const auto& section : sections) {
+        if (section) {
+            size += section->getMemoryUsage();
+        }
+    }
+    return size;
+}
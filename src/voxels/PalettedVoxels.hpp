@@ -0,0 +1,136 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "constants.hpp"
+#include "typedefs.hpp"
+#include "voxel.hpp"
+
+/// @brief Height of a paletted voxels section
+inline constexpr int VOXELS_SECTION_H = 16;
+/// @brief Number of voxels in a paletted voxels section
+inline constexpr int VOXELS_SECTION_VOL = CHUNK_W * VOXELS_SECTION_H * CHUNK_D;
+/// @brief Number of paletted voxels sections in a chunk
+inline constexpr int VOXELS_SECTIONS_COUNT = CHUNK_H / VOXELS_SECTION_H;
+
+/// @brief 16x16x16 voxels section storing indices into the section palette
+/// of unique voxels. Index width is 0 (single voxel value), 1, 2, 4 or 8 bits.
+/// Section with more than 256 unique voxels stores voxels directly.
+class PalettedSection {
+    /// @brief Unique voxels (see PalettedSection::pack_voxel)
+    std::vector<uint32_t> palette;
+    /// @brief Bits per voxel index, DIRECT_BITS if palette is not used
+    uint8_t bits = 0;
+    /// @brief Packed indices or voxels, nullptr if bits is 0
+    std::unique_ptr<uint32_t[]> data;
+    /// @brief Was the section modified with set since the last pack. Set
+    /// only grows the palette, so it may contain unused voxels
+    bool dirty = false;
+
+    void grow(uint8_t newBits);
+    uint32_t getRaw(uint index) const;
+public:
+    static inline constexpr uint8_t DIRECT_BITS = 32;
+
+    /// @brief Create section filled with the voxel
+    PalettedSection(voxel vox = {});
+
+    voxel get(uint index) const {
+        return unpack_voxel(getRaw(index));
+    }
+
+    void set(uint index, voxel vox);
+
+    /// @brief Build section from VOXELS_SECTION_VOL voxels
+    void pack(const voxel* src);
+
+    /// @brief Write VOXELS_SECTION_VOL voxels to dst
+    void unpack(voxel* dst) const;
+
+    /// @brief Repack the section modified since the last pack, dropping
+    /// unused palette entries
+    /// @return true if the section has been repacked
+    bool compact();
+
+    /// @brief Check if the section contains only air with default state
+    bool isEmpty() const;
+
+    uint8_t getBits() const {
+        return bits;
+    }
+
+    size_t getPaletteSize() const {
+        return palette.size();
+    }
+
+    /// @return Number of bytes used by the section
+    size_t getMemoryUsage() const;
+
+    static inline uint32_t pack_voxel(voxel vox) {
+        return vox.id | static_cast<uint32_t>(blockstate2int(vox.state)) << 16;
+    }
+
+    static inline voxel unpack_voxel(uint32_t value) {
+        return voxel {
+            static_cast<blockid_t>(value & 0xFFFF),
+            int2blockstate(static_cast<blockstate_t>(value >> 16))};
+    }
+};
+
+/// @brief Memory-compact chunk voxels storage used by idle chunks instead of
+/// the flat voxels array. Empty (air) sections are not allocated.
+class PalettedVoxels {
+    std::unique_ptr<PalettedSection> sections[VOXELS_SECTIONS_COUNT];
+public:
+    PalettedVoxels() = default;
+
+    /// @brief Build storage from CHUNK_VOL voxels array
+    PalettedVoxels(const voxel* voxels);
+
+    voxel get(uint x, uint y, uint z) const {
+        const auto& section = sections[y / VOXELS_SECTION_H];
+        if (section == nullptr) {
+            return {};
+        }
+        return section->get(
+            vox_index(x, y % VOXELS_SECTION_H, z)
+        );
+    }
+
+    /// @param index voxel index in the chunk (see vox_index)
+    voxel get(uint index) const {
+        const auto& section = sections[index / VOXELS_SECTION_VOL];
+        if (section == nullptr) {
+            return {};
+        }
+        return section->get(index % VOXELS_SECTION_VOL);
+    }
+
+    void set(uint x, uint y, uint z, voxel vox) {
+        set(vox_index(x, y, z), vox);
+    }
+
+    void set(uint index, voxel vox);
+
+    void pack(const voxel* src);
+
+    /// @brief Write count voxels starting from the index to dst
+    void unpack(voxel* dst, uint index = 0, uint count = CHUNK_VOL) const;
+
+    /// @brief Compact sections modified since the last pack and release
+    /// memory of the sections containing only air
+    /// @return true if some of the sections has been compacted
+    bool compact();
+
+    /// @brief Encode voxels to bytes array of size CHUNK_DATA_LEN
+    /// (same format as Chunk::encode produces)
+    std::unique_ptr<ubyte[]> encode() const;
+
+    /// @return Number of bytes used by the storage
+    size_t getMemoryUsage() const;
+
+    const PalettedSection* getSection(uint index) const {
+        return sections[index].get();
+    }
+};
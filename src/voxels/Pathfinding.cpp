@@ -217,7 +217,7 @@ const std::unordered_map<int, Agent>& Pathfinding::getAgents() const {
 
 int Pathfinding::checkPoint(const Agent& agent, int x, int y, int z, int& cost) {
     auto vox = blocks_agent::get(chunks, x, y, z);
-    if (vox == nullptr) {
+    if (!vox) {
         return OBSTACLE;
     }
     const auto& def = blockDefs.require(vox->id);
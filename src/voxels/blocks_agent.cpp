@@ -6,21 +6,16 @@
 
 using namespace blocks_agent;
 
-static std::vector<BlockRegisterEvent> block_register_events {};
+static BlockTicksScheduler ticks_scheduler {};
 
-std::vector<BlockRegisterEvent> blocks_agent::pull_register_events() {
-    auto events = block_register_events;
-    block_register_events.clear();
-    return events;
+BlockTicksScheduler& blocks_agent::get_ticks_scheduler() {
+    return ticks_scheduler;
 }
 
-static uint8_t get_events_bits(const Block& def) {
-    uint8_t bits = 0;
+static inline bool has_block_events(const Block& def) {
     auto funcsset = def.rt.funcsset;
-    bits |= BlockRegisterEvent::UPDATING_BIT * funcsset.onblocktick;
-    bits |= BlockRegisterEvent::PRESENT_EVENT_BIT * funcsset.onblockpresent;
-    bits |= BlockRegisterEvent::REMOVED_EVENT_BIT * funcsset.onblockremoved;
-    return bits;
+    return funcsset.onblocktick || funcsset.onblockpresent ||
+           funcsset.onblockremoved;
 }
 
 static void on_chunk_register_event(
@@ -28,19 +23,16 @@ static void on_chunk_register_event(
     const Chunk& chunk,
     bool present
 ) {
-    const auto& voxels = chunk.voxels;
-
     int totalBegin = chunk.bottom * (CHUNK_W * CHUNK_D);
     int totalEnd = chunk.top * (CHUNK_W * CHUNK_D);
 
     uint8_t flagsCache[1024] {};
 
     for (int i = totalBegin; i < totalEnd; i++) {
-        blockid_t id = voxels[i].id;
+        blockid_t id = chunk.get(i).id;
         uint8_t bits = id < sizeof(flagsCache) ? flagsCache[id] : 0;
         if ((bits & 0x80) == 0) {
-            const auto& def = indices.blocks.require(id);
-            bits = get_events_bits(def);
+            bits = has_block_events(indices.blocks.require(id));
             if (id < sizeof(flagsCache)) {
                 flagsCache[id] = bits | 0x80;
             }
@@ -52,9 +44,12 @@ static void on_chunk_register_event(
         int x = i % CHUNK_W + chunk.x * CHUNK_W;
         int z = (i / CHUNK_W) % CHUNK_D + chunk.z * CHUNK_D;
         int y = (i / CHUNK_W / CHUNK_D);
-        block_register_events.push_back(BlockRegisterEvent {
-            static_cast<uint8_t>(bits | (present ? 1 : 0)), id, {x, y, z}
-        });
+        const auto& def = indices.blocks.require(id);
+        if (present) {
+            ticks_scheduler.add(def, {x, y, z});
+        } else {
+            ticks_scheduler.remove(def, {x, y, z});
+        }
     }
 }
 
@@ -72,20 +67,20 @@ void blocks_agent::on_chunk_remove(
 
 template <class Storage>
 static void mark_neighboirs_modified(
-    Storage& chunks, int32_t cx, int32_t cz, int32_t lx, int32_t lz
+    Storage& chunks, int32_t cx, int32_t cz, int32_t lx, int32_t y, int32_t lz
 ) {
     Chunk* chunk;
     if (lx == 0 && (chunk = get_chunk(chunks, cx - 1, cz))) {
-        chunk->flags.modified = true;
+        chunk->setSectionsModified(y);
     }
     if (lz == 0 && (chunk = get_chunk(chunks, cx, cz - 1))) {
-        chunk->flags.modified = true;
+        chunk->setSectionsModified(y);
     }
     if (lx == CHUNK_W - 1 && (chunk = get_chunk(chunks, cx + 1, cz))) {
-        chunk->flags.modified = true;
+        chunk->setSectionsModified(y);
     }
     if (lz == CHUNK_D - 1 && (chunk = get_chunk(chunks, cx, cz + 1))) {
-        chunk->flags.modified = true;
+        chunk->setSectionsModified(y);
     }
 }
 
@@ -102,7 +97,7 @@ template <class Storage>
 static void finalize_block(
     Storage& chunks,
     Chunk& chunk,
-    voxel& vox,
+    voxel vox,
     int32_t x, int32_t y, int32_t z,
     int32_t lx, int32_t lz
 ) {
@@ -123,20 +118,15 @@ static void finalize_block(
         }
     }
 
-    uint8_t bits = get_events_bits(def);
-    if (bits == 0) {
-        return;
+    if (has_block_events(def)) {
+        ticks_scheduler.remove(def, {x, y, z});
     }
-    block_register_events.push_back(BlockRegisterEvent {
-        bits, def.rt.id, {x, y, z}
-    });
 }
 
 template <class Storage>
 static void initialize_block(
     Storage& chunks,
     Chunk& chunk,
-    voxel& vox,
     blockid_t id,
     blockstate state,
     int32_t x, int32_t y, int32_t z,
@@ -145,23 +135,18 @@ static void initialize_block(
 ) {
     const auto& indices = chunks.getContentIndices();
     const auto& def = indices.blocks.require(id);
-    vox.id = id;
-    vox.state = state;
-    chunk.setModifiedAndUnsaved();
+    chunk.set(lx, y, lz, {id, state});
+    chunk.setBlockModifiedAndUnsaved(y);
     if (!state.segment && def.rt.extended) {
         restore_segments(chunks, def, state, x, y, z);
     }
 
     refresh_chunk_heights(chunk, id == BLOCK_AIR, y);
-    mark_neighboirs_modified(chunks, cx, cz, lx, lz);
+    mark_neighboirs_modified(chunks, cx, cz, lx, y, lz);
 
-    uint8_t bits = get_events_bits(def);
-    if (bits == 0) {
-        return;
+    if (has_block_events(def)) {
+        ticks_scheduler.add(def, {x, y, z});
     }
-    block_register_events.push_back(BlockRegisterEvent {
-        static_cast<uint8_t>(bits | 1), def.rt.id, {x, y, z}
-    });
 }
 
 template <class Storage>
@@ -185,10 +170,10 @@ static inline bool set_block(
     int lx = x - cx * CHUNK_W;
     int lz = z - cz * CHUNK_D;
 
-    voxel& vox = chunk->voxels[(y * CHUNK_D + lz) * CHUNK_W + lx];
-
-    finalize_block(chunks, *chunk, vox, x, y, z, lx, lz);
-    initialize_block(chunks, *chunk, vox, id, state, x, y, z, lx, lz, cx, cz);
+    // the block and its neighbours may be modified by workers
+    chunks.waitWorkers();
+    finalize_block(chunks, *chunk, chunk->get(lx, y, lz), x, y, z, lx, lz);
+    initialize_block(chunks, *chunk, id, state, x, y, z, lx, lz, cx, cz);
     return true;
 }
 
@@ -215,7 +200,7 @@ bool blocks_agent::set(
 }
 
 template <class Storage>
-static inline voxel* raycast_blocks(
+static inline std::optional<voxel> raycast_blocks(
     const Storage& chunks,
     const glm::vec3& start,
     const glm::vec3& dir,
@@ -260,9 +245,9 @@ static inline voxel* raycast_blocks(
     bool includeNonSelectable = settings.includeNonSelectable;
     
     while (t <= maxDist) {
-        voxel* voxel = get(chunks, ix, iy, iz);
-        if (voxel == nullptr) {
-            return nullptr;
+        auto voxel = get(chunks, ix, iy, iz);
+        if (!voxel) {
+            return std::nullopt;
         }
 
         auto filter = settings.filter;
@@ -344,10 +329,10 @@ static inline voxel* raycast_blocks(
     iend = {ix, iy, iz};
     end = start + t * dir;
     norm = {0, 0, 0};
-    return nullptr;
+    return std::nullopt;
 }
 
-voxel* blocks_agent::raycast(
+std::optional<voxel> blocks_agent::raycast(
     const Chunks& chunks,
     const glm::vec3& start,
     const glm::vec3& dir,
@@ -360,7 +345,7 @@ voxel* blocks_agent::raycast(
     return raycast_blocks(chunks, start, dir, maxDist, end, norm, iend, settings);
 }
 
-voxel* blocks_agent::raycast(
+std::optional<voxel> blocks_agent::raycast(
     const GlobalChunks& chunks,
     const glm::vec3& start,
     const glm::vec3& dir,
@@ -420,7 +405,6 @@ inline void get_voxels_impl(
                     }
                 }
             } else {
-                const voxel* cvoxels = chunk->voxels;
                 const light_t* clights =
                     chunk->lightmap ? chunk->lightmap->getLights() : nullptr;
                 for (int ly = y; ly < y + h; ly++) {
@@ -438,7 +422,7 @@ inline void get_voxels_impl(
                                 CHUNK_W,
                                 CHUNK_D
                             );
-                            voxels[vidx] = cvoxels[cidx];
+                            voxels[vidx] = chunk->get(cidx);
                             light_t light = clights ? clights[cidx]
                                                     : Lightmap::SUN_LIGHT_ONLY;
                             if (backlight) {
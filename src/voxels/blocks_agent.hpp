@@ -3,6 +3,7 @@
 /// blocks_agent is set of templates but not a class to minimize OOP overhead.
 
 #include "Block.hpp"
+#include "BlockTicksScheduler.hpp"
 #include "Chunk.hpp"
 #include "Chunks.hpp"
 #include "constants.hpp"
@@ -15,6 +16,7 @@
 
 #include <algorithm>
 #include <glm/glm.hpp>
+#include <optional>
 #include <set>
 #include <stdexcept>
 #include <stdint.h>
@@ -23,17 +25,9 @@ struct AABB;
 
 namespace blocks_agent {
 
-struct BlockRegisterEvent {
-    static inline constexpr uint8_t REGISTER_BIT = 0x1;
-    static inline constexpr uint8_t UPDATING_BIT = 0x2;
-    static inline constexpr uint8_t PRESENT_EVENT_BIT = 0x4;
-    static inline constexpr uint8_t REMOVED_EVENT_BIT = 0x8;
-    uint8_t bits;
-    blockid_t id;
-    glm::ivec3 coord;
-};
-
-std::vector<BlockRegisterEvent> pull_register_events();
+/// @brief Per-block events scheduler updated by set and chunks
+/// present/remove events
+BlockTicksScheduler& get_ticks_scheduler();
 
 void on_chunk_present(const ContentIndices& indices, const Chunk& chunk);
 void on_chunk_remove(const ContentIndices& indices, const Chunk& chunk);
@@ -50,27 +44,29 @@ inline Chunk* get_chunk(const Storage& chunks, int cx, int cz) {
 }
 
 /// @brief Get voxel at specified position.
-/// Returns nullptr if voxel does not exists. 
+/// Returns std::nullopt if voxel does not exists. 
 /// @tparam Storage chunks storage class
 /// @param chunks chunks storage
 /// @param x position X
 /// @param y position Y
 /// @param z position Z
-/// @return voxel pointer or nullptr
+/// @return voxel or std::nullopt
 template<class Storage>
-inline voxel* get(const Storage& chunks, int32_t x, int32_t y, int32_t z) {
+inline std::optional<voxel> get(
+    const Storage& chunks, int32_t x, int32_t y, int32_t z
+) {
     if (y < 0 || y >= CHUNK_H) {
-        return nullptr;
+        return std::nullopt;
     }
     int cx = floordiv<CHUNK_W>(x);
     int cz = floordiv<CHUNK_D>(z);
     Chunk* chunk = get_chunk(chunks, cx, cz);
     if (chunk == nullptr) {
-        return nullptr;
+        return std::nullopt;
     }
     int lx = x - cx * CHUNK_W;
     int lz = z - cz * CHUNK_D;
-    return &chunk->voxels[(y * CHUNK_D + lz) * CHUNK_W + lx];
+    return chunk->get(lx, y, lz);
 }
 
 /// @brief Get voxel at specified position.
@@ -80,11 +76,11 @@ inline voxel* get(const Storage& chunks, int32_t x, int32_t y, int32_t z) {
 /// @param x position X
 /// @param y position Y
 /// @param z position Z
-/// @return voxel reference
+/// @return voxel
 template<class Storage>
-inline voxel& require(const Storage& chunks, int32_t x, int32_t y, int32_t z) {
+inline voxel require(const Storage& chunks, int32_t x, int32_t y, int32_t z) {
     auto vox = get(chunks, x, y, z);
-    if (vox == nullptr) {
+    if (!vox) {
         throw std::runtime_error("voxel does not exist");
     }
     return *vox;
@@ -256,7 +252,7 @@ inline glm::ivec3 seek_origin(
         if (segment & 2) pos -= rotation.axes[1];
         if (segment & 4) pos -= rotation.axes[2];
 
-        if (auto* voxel = get(chunks, pos.x, pos.y, pos.z)) {
+        if (auto voxel = get(chunks, pos.x, pos.y, pos.z)) {
             segment = voxel->state.segment;
         } else {
             return pos;
@@ -343,16 +339,21 @@ inline void set_rotation_extended(
                 segState.segment = segment_to_int(sx, sy, sz);
 
                 auto vox = get(chunks, pos.x, pos.y, pos.z);
-                // checked for nullptr by checkReplaceability
+                // checked for std::nullopt by checkReplaceability
                 if (vox->id != def.rt.id) {
                     set(chunks, pos.x, pos.y, pos.z, def.rt.id, segState);
                 } else {
-                    vox->state = segState;
                     int cx = floordiv<CHUNK_W>(pos.x);
                     int cz = floordiv<CHUNK_D>(pos.z);
                     auto chunk = get_chunk(chunks, cx, cz);
                     assert(chunk != nullptr);
-                    chunk->setModifiedAndUnsaved();
+                    chunk->set(
+                        pos.x - cx * CHUNK_W,
+                        pos.y,
+                        pos.z - cz * CHUNK_D,
+                        {vox->id, segState}
+                    );
+                    chunk->setBlockModifiedAndUnsaved(pos.y);
                     segmentBlocks.emplace_back(pos);
                 }
             }
@@ -391,13 +392,14 @@ inline void set_rotation(
         return;
     }
     auto vox = get(chunks, x, y, z);
-    if (vox == nullptr) {
+    if (!vox) {
         return;
     }
     const auto& def = chunks.getContentIndices().blocks.require(vox->id);
     if (!def.rotatable || vox->state.rotation == index) {
         return;
     }
+    chunks.waitWorkers();
     if (def.rt.extended) {
         auto origin = seek_origin(chunks, {x, y, z}, def, vox->state);
         vox = get(chunks, origin.x, origin.y, origin.z);
@@ -408,7 +410,8 @@ inline void set_rotation(
         int cz = floordiv<CHUNK_D>(z);
         auto chunk = get_chunk(chunks, cx, cz);
         assert(chunk != nullptr);
-        chunk->setModifiedAndUnsaved();
+        chunk->set(x - cx * CHUNK_W, y, z - cz * CHUNK_D, *vox);
+        chunk->setBlockModifiedAndUnsaved(y);
     }
 }
 
@@ -428,8 +431,8 @@ struct RaycastSettings {
 /// @param iend [out] ray end integer position (voxel position + normal)
 /// @param filter filtered ids
 /// @param includeNonSelectable will non-selectable blocks be included
-/// @return voxel pointer or nullptr
-voxel* raycast(
+/// @return voxel or std::nullopt
+std::optional<voxel> raycast(
     const Chunks& chunks,
     const glm::vec3& start,
     const glm::vec3& dir,
@@ -450,8 +453,8 @@ voxel* raycast(
 /// @param iend [out] ray end integer position (voxel position + normal)
 /// @param filter filtered ids
 /// @param includeNonSelectable will non-selectable blocks be included
-/// @return voxel pointer or nullptr
-voxel* raycast(
+/// @return voxel or std::nullopt
+std::optional<voxel> raycast(
     const GlobalChunks& chunks,
     const glm::vec3& start,
     const glm::vec3& dir,
@@ -477,8 +480,8 @@ inline std::optional<AABB> is_obstacle_at(
     int ix = std::floor(x);
     int iy = std::floor(y);
     int iz = std::floor(z);
-    voxel* v = get(chunks, ix, iy, iz);
-    if (v == nullptr) {
+    auto v = get(chunks, ix, iy, iz);
+    if (!v) {
         if (iy >= CHUNK_H) {
             return std::nullopt;
         } else {
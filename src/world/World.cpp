@@ -65,15 +65,26 @@ void World::writeResources(const Content& content) {
     io::write_json(wfile->getResourcesFile(), root);
 }
 
+void World::writePlayers(Level& level) {
+    auto playerFile = level.players->serialize();
+    io::write_json(wfile->getPlayerFile(), playerFile);
+}
+
 void World::write(Level& level) {
     level.chunks->saveAll();
     info.nextEntityId = level.entities->peekNextID();
     wfile->write(this, &content);
+    writePlayers(level);
+    writeResources(content);
+}
 
-    auto playerFile = level.players->serialize();
-    io::write_json(wfile->getPlayerFile(), playerFile);
-
+std::shared_ptr<Task> World::writeAsync(Level& level) {
+    level.chunks->saveAll(true);
+    info.nextEntityId = level.entities->peekNextID();
+    auto task = wfile->writeAsync(this, &content);
+    writePlayers(level);
     writeResources(content);
+    return task;
 }
 
 std::unique_ptr<Level> World::create(
@@ -14,6 +14,7 @@ class Content;
 class WorldFiles;
 class Level;
 class ContentReport;
+class Task;
 struct EngineSettings;
 
 class world_load_error : public std::runtime_error {
@@ -57,6 +58,7 @@ class World {
     std::vector<ContentPack> packs;
 
     void writeResources(const Content& content);
+    void writePlayers(Level& level);
 public:
     std::shared_ptr<WorldFiles> wfile;
 
@@ -78,6 +80,11 @@ public:
     /// @brief Write all unsaved level data to the world directory
     void write(Level& level);
 
+    /// @brief Write all unsaved level data to the world directory.
+    /// Chunks data is compressed and written in a background thread
+    /// @return regions writing task or nullptr if nothing to write
+    std::shared_ptr<Task> writeAsync(Level& level);
+
     /// @brief Check world indices and generate ContentReport if convert required
     /// @param directory world directory
     /// @param content current Content instance
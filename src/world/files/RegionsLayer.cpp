@@ -1,8 +1,14 @@
+#include <algorithm>
+#include <chrono>
 #include <cstring>
+#include <filesystem>
+#include <vector>
+#include <zlib.h>
 
 #include "WorldRegions.hpp"
 #include "debug/Logger.hpp"
 #include "util/data_io.hpp"
+#include "util/platform.hpp"
 
 static debug::Logger logger("regions-layer");
 
@@ -13,15 +19,18 @@ static io::path get_region_filename(int x, int z) {
 }
 
 /// @brief Read missing chunks data (null pointers) from region file
-static void fetch_chunks(WorldRegion* region, int x, int z, regfile* file) {
+static void fetch_chunks(
+    const RegionsLayer& layer, WorldRegion* region, int x, int z, regfile* file
+) {
     auto* chunks = region->getChunks();
     auto sizes = region->getSizes();
 
     for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
         int chunk_x = (i % REGION_SIZE) + x * REGION_SIZE;
         int chunk_z = (i / REGION_SIZE) + z * REGION_SIZE;
-        if (chunks[i] == nullptr) {
-            chunks[i] = RegionsLayer::readChunkData(
+        // unsaved null chunk is removed
+        if (chunks[i] == nullptr && !region->isUnsaved(i)) {
+            chunks[i] = layer.readChunkData(
                 chunk_x, chunk_z, sizes[i][0], sizes[i][1], file
             );
         }
@@ -33,8 +42,7 @@ regfile::regfile(io::path filename) : file(filename), filename(filename) {
         throw std::runtime_error(
             "incomplete region file header in " + filename.string()
         );
-    char header[REGION_HEADER_SIZE];
-    file.read(header, REGION_HEADER_SIZE);
+    const char* header = reinterpret_cast<const char*>(file.data());
 
     // avoid of use strcmp_s
     if (std::string(header, std::strlen(REGION_FORMAT_MAGIC)) !=
@@ -50,49 +58,117 @@ regfile::regfile(io::path filename) : file(filename), filename(filename) {
             " is not supported in " + filename.string()
         );
     }
+    ubyte method = header[9];
+    if (method > static_cast<ubyte>(compression::Method::LZ4)) {
+        throw illegal_region_format(
+            "unknown compression method " + std::to_string(method) +
+            " in " + filename.string()
+        );
+    }
+    compression = static_cast<compression::Method>(method);
 
+    if (version >= 4) {
+        readTable();
+        return;
+    }
     size_t file_size = file.length();
+    if (file_size < REGION_HEADER_SIZE + REGION_CHUNKS_COUNT * 4) {
+        throw std::runtime_error(
+            "incomplete region file offsets table in " + filename.string()
+        );
+    }
     size_t table_offset = file_size - REGION_CHUNKS_COUNT * 4;
 
-    file.seekg(table_offset);
-    file.read(
-        reinterpret_cast<char*>(offsets.data()),
+    std::memcpy(
+        offsets.data(),
+        file.data() + table_offset,
         sizeof(uint32_t) * REGION_CHUNKS_COUNT
     );
     if (dataio::is_big_endian()) {
         for (size_t i = 0; i < offsets.size(); i++) {
-            offsets[i] = dataio::le2h(i);
+            offsets[i] = dataio::le2h(offsets[i]);
         }
     }
 }
 
-std::unique_ptr<ubyte[]> regfile::read(
-    int index, uint32_t& size, uint32_t& srcSize
+static uint32_t read_uint32(const ubyte* src) {
+    uint32_t value;
+    std::memcpy(&value, src, 4);
+    return dataio::le2h(value);
+}
+
+static void write_uint32(ubyte* dst, uint32_t value) {
+    value = dataio::h2le(value);
+    std::memcpy(dst, &value, 4);
+}
+
+void encode_region_table(
+    ubyte* dst, const uint32_t* sectors, uint32_t generation
 ) {
+    write_uint32(dst, generation);
+    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        write_uint32(dst + (i + 1) * 4, sectors[i]);
+    }
+    const size_t checked = REGION_TABLE_SIZE - 4;
+    write_uint32(dst + checked, crc32(0L, dst, checked));
+}
+
+void regfile::readTable() {
+    if (file.length() < REGION_DATA_SECTOR * REGION_SECTOR_SIZE) {
+        throw std::runtime_error(
+            "incomplete region file offsets table in " + filename.string()
+        );
+    }
+    const size_t checked = REGION_TABLE_SIZE - 4;
+    const ubyte* active = nullptr;
+    for (int slot = 0; slot < 2; slot++) {
+        const ubyte* table = file.data() +
+            (1 + slot * REGION_TABLE_SECTORS) * REGION_SECTOR_SIZE;
+        // table write may be interrupted
+        if (read_uint32(table + checked) != crc32(0L, table, checked)) {
+            continue;
+        }
+        uint32_t tableGeneration = read_uint32(table);
+        if (active == nullptr || tableGeneration > generation) {
+            active = table;
+            generation = tableGeneration;
+            tableSlot = slot;
+        }
+    }
+    if (active == nullptr) {
+        throw illegal_region_format(
+            "no valid offsets table found in " + filename.string()
+        );
+    }
+    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        offsets[i] = read_uint32(active + (i + 1) * 4) * REGION_SECTOR_SIZE;
+    }
+}
+
+const ubyte* regfile::view(
+    int index, uint32_t& size, uint32_t& srcSize
+) const {
     size_t file_size = file.length();
-    size_t table_offset = file_size - REGION_CHUNKS_COUNT * 4;
 
     uint32_t offset = offsets.at(index);
     if (offset == 0) {
         return nullptr;
     }
+    if (static_cast<size_t>(offset) + 8 > file_size) {
+        logger.error() << "corrupted region " << filename.string()
+                       << " chunk " << index << " offset detected";
+        return nullptr;
+    }
+    const ubyte* src = file.data() + offset;
+    size = read_uint32(src);
+    srcSize = read_uint32(src + 4);
 
-    uint32_t buff32;
-    file.seekg(offset);
-    file.read(reinterpret_cast<char*>(&buff32), 4);
-    size = dataio::le2h(buff32);
-    file.read(reinterpret_cast<char*>(&buff32), 4);
-    srcSize = dataio::le2h(buff32);
-
-    if (offset + size > file_size) {
+    if (static_cast<size_t>(offset) + 8 + size > file_size) {
         logger.error() << "corrupted region " << filename.string()
-                       << " chunk offset detected at "
-                       << (table_offset + index * 4);
+                       << " chunk " << index << " size detected";
         return nullptr;
     }
-    auto data = std::make_unique<ubyte[]>(size);
-    file.read(reinterpret_cast<char*>(data.get()), size);
-    return data;
+    return src + 8;
 }
 
 void RegionsLayer::closeRegFile(glm::ivec2 coord) {
@@ -103,6 +179,7 @@ void RegionsLayer::closeRegFile(glm::ivec2 coord) {
 regfile_ptr RegionsLayer::useRegFile(glm::ivec2 coord) {
     auto* file = openRegFiles[coord].get();
     file->inUse = true;
+    file->lastUse = ++regFilesUseCounter;
     return regfile_ptr(file, &regFilesCv);
 }
 
@@ -129,31 +206,37 @@ regfile_ptr RegionsLayer::createRegFile(glm::ivec2 coord) {
     if (!io::exists(file)) {
         return nullptr;
     }
+    std::unique_lock lock(regFilesMutex);
+    // the file may have been opened by another thread since the lookup
+    const auto found = openRegFiles.find(coord);
+    if (found != openRegFiles.end()) {
+        if (found->second->inUse) {
+            throw std::runtime_error("regfile is currently in use");
+        }
+        return useRegFile(coord);
+    }
     if (openRegFiles.size() == MAX_OPEN_REGION_FILES) {
-        std::unique_lock lock(regFilesMutex);
         while (true) {
-            bool closed = false;
-            // FIXME: bad choosing algorithm
-            for (auto& entry : openRegFiles) {
-                if (!entry.second->inUse) {
-                    closeRegFile(entry.first);
-                    closed = true;
-                    break;
+            // close least recently used file
+            regfile* lru = nullptr;
+            glm::ivec2 lruCoord {};
+            for (auto& [regcoord, regfile] : openRegFiles) {
+                if (!regfile->inUse &&
+                    (lru == nullptr || regfile->lastUse < lru->lastUse)) {
+                    lru = regfile.get();
+                    lruCoord = regcoord;
                 }
             }
-            if (closed) {
+            if (lru) {
+                closeRegFile(lruCoord);
                 break;
             }
             // notified when any regfile gets out of use or closed
             regFilesCv.wait(lock);
         }
-        openRegFiles[coord] = std::make_unique<regfile>(file);
-        return useRegFile(coord);
-    } else {
-        std::lock_guard lock(regFilesMutex);
-        openRegFiles[coord] = std::make_unique<regfile>(file);
-        return useRegFile(coord);
     }
+    openRegFiles[coord] = std::make_unique<regfile>(file);
+    return useRegFile(coord);
 }
 
 WorldRegion* RegionsLayer::getRegion(int x, int z) {
@@ -185,6 +268,7 @@ ubyte* RegionsLayer::getData(int x, int z, uint32_t& size, uint32_t& srcSize) {
     calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
 
     WorldRegion* region = getOrCreateRegion(regionX, regionZ);
+    region->compress(localZ * REGION_SIZE + localX, compression);
     ubyte* data = region->getChunkData(localX, localZ);
     if (data == nullptr) {
         auto regfile = getRegFile({regionX, regionZ});
@@ -205,64 +289,261 @@ ubyte* RegionsLayer::getData(int x, int z, uint32_t& size, uint32_t& srcSize) {
     return nullptr;
 }
 
+/// @brief Count sectors required to store chunk data with size prefix
+static uint32_t count_sectors(uint32_t size) {
+    return (size + 8 + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE;
+}
+
+static void mark_sectors(
+    std::vector<bool>& used, uint32_t sector, uint32_t count
+) {
+    if (sector + count > used.size()) {
+        used.resize(sector + count, false);
+    }
+    std::fill(used.begin() + sector, used.begin() + sector + count, true);
+}
+
+/// @brief Find first free sectors sequence of the specified length.
+/// Sequence is appended to the end of file if not found
+static uint32_t allocate_sectors(std::vector<bool>& used, uint32_t count) {
+    uint32_t start = REGION_DATA_SECTOR;
+    uint32_t length = 0;
+    for (uint32_t i = REGION_DATA_SECTOR; i < used.size(); i++) {
+        if (used[i]) {
+            start = i + 1;
+            length = 0;
+        } else if (++length == count) {
+            break;
+        }
+    }
+    mark_sectors(used, start, count);
+    return start;
+}
+
+static void write_chunk(
+    std::ostream& file, uint32_t sector, const ubyte* data, glm::u32vec2 size
+) {
+    uint32_t compressedSize = size[0];
+    uint32_t srcSize = size[1];
+
+    file.seekp(static_cast<std::streamoff>(sector) * REGION_SECTOR_SIZE);
+    uint32_t intbuf = dataio::h2le(compressedSize);
+    file.write(reinterpret_cast<const char*>(&intbuf), 4);
+    intbuf = dataio::h2le(srcSize);
+    file.write(reinterpret_cast<const char*>(&intbuf), 4);
+    file.write(reinterpret_cast<const char*>(data), compressedSize);
+
+    // pad to sectors boundary to keep file length sector-aligned
+    static const char zeros[REGION_SECTOR_SIZE] {};
+    size_t padding = count_sectors(compressedSize) * REGION_SECTOR_SIZE -
+                     (compressedSize + 8);
+    file.write(zeros, padding);
+}
+
+static void write_table(
+    std::ostream& file,
+    int slot,
+    const uint32_t* sectors,
+    uint32_t generation
+) {
+    ubyte table[REGION_TABLE_SIZE];
+    encode_region_table(table, sectors, generation);
+    file.seekp((1 + slot * REGION_TABLE_SECTORS) * REGION_SECTOR_SIZE);
+    file.write(reinterpret_cast<const char*>(table), REGION_TABLE_SIZE);
+}
+
+static void sync_region_file(const io::path& filename) {
+    if (!platform::sync_file(io::resolve(filename))) {
+        throw std::runtime_error(
+            "could not sync region file " + filename.string()
+        );
+    }
+}
+
+/// @brief Write complete region file. Temporary file is written first
+/// and then replaces the target one
+static void write_region_file(
+    const io::path& filename,
+    WorldRegion* entry,
+    compression::Method compression
+) {
+    io::path tmpfile = filename.string() + ".tmp";
+    {
+        std::ofstream file(
+            io::resolve(tmpfile),
+            std::ios::out | std::ios::binary | std::ios::trunc
+        );
+        // header sector and empty table slots
+        std::vector<char> head(REGION_DATA_SECTOR * REGION_SECTOR_SIZE);
+        std::memcpy(head.data(), REGION_FORMAT_MAGIC, 8);
+        head[8] = REGION_FORMAT_VERSION;
+        head[9] = static_cast<ubyte>(compression);
+        file.write(head.data(), head.size());
+
+        uint32_t sectors[REGION_CHUNKS_COUNT] {};
+        uint32_t sector = REGION_DATA_SECTOR;
+
+        auto region = entry->getChunks();
+        auto sizes = entry->getSizes();
+        for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+            ubyte* chunk = region[i].get();
+            if (chunk == nullptr) {
+                continue;
+            }
+            sectors[i] = sector;
+            write_chunk(file, sector, chunk, sizes[i]);
+            sector += count_sectors(sizes[i][0]);
+        }
+        write_table(file, 0, sectors, 1);
+        if (!file.good()) {
+            throw std::runtime_error(
+                "could not write region file " + tmpfile.string()
+            );
+        }
+    }
+    // file contents must reach the disk before it replaces the old one
+    sync_region_file(tmpfile);
+    std::filesystem::rename(io::resolve(tmpfile), io::resolve(filename));
+}
+
 void RegionsLayer::writeRegion(int x, int z, WorldRegion* entry) {
     io::path filename = folder / get_region_filename(x, z);
 
     glm::ivec2 regcoord(x, z);
-    if (auto regfile = getRegFile(regcoord, false)) {
-        fetch_chunks(entry, x, z, regfile.get());
-
-        std::lock_guard lock(regFilesMutex);
-        regfile.reset();
-        closeRegFile(regcoord);
+    {
+        // may be called in writer thread, so wait for readers
+        std::unique_lock lock(regFilesMutex);
+        while (true) {
+            const auto found = openRegFiles.find(regcoord);
+            if (found == openRegFiles.end()) {
+                break;
+            }
+            if (!found->second->inUse) {
+                closeRegFile(regcoord);
+                break;
+            }
+            regFilesCv.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        entry->compress(i, compression);
     }
 
-    char header[REGION_HEADER_SIZE] = REGION_FORMAT_MAGIC;
-    header[8] = REGION_FORMAT_VERSION;
-    header[9] = static_cast<ubyte>(compression);  // FIXME
-    std::ofstream file(io::resolve(filename), std::ios::out | std::ios::binary);
-    file.write(header, REGION_HEADER_SIZE);
+    std::unique_ptr<regfile> oldfile;
+    if (io::exists(filename)) {
+        oldfile = std::make_unique<regfile>(filename);
+    }
+    if (oldfile == nullptr ||
+        static_cast<uint>(oldfile->version) < REGION_FORMAT_VERSION ||
+        oldfile->compression != compression) {
+        if (oldfile) {
+            fetch_chunks(*this, entry, x, z, oldfile.get());
+            oldfile.reset();
+        }
+        write_region_file(filename, entry, compression);
+        entry->setUnsaved(false);
+        return;
+    }
 
-    size_t offset = REGION_HEADER_SIZE;
-    uint32_t intbuf;
-    uint offsets[REGION_CHUNKS_COUNT] {};
+    // sectors used by the active table must stay untouched until the new
+    // table is written
+    uint32_t sectors[REGION_CHUNKS_COUNT];
+    std::vector<bool> usedSectors(REGION_DATA_SECTOR, true);
+    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        uint32_t size, srcSize;
+        if (oldfile->view(i, size, srcSize) == nullptr) {
+            sectors[i] = 0;
+            continue;
+        }
+        sectors[i] = oldfile->offsets[i] / REGION_SECTOR_SIZE;
+        mark_sectors(usedSectors, sectors[i], count_sectors(size));
+    }
+    uint32_t generation = oldfile->generation + 1;
+    int slot = 1 - oldfile->tableSlot;
+    // unmap before writing
+    oldfile.reset();
 
+    std::fstream file(
+        io::resolve(filename), std::ios::in | std::ios::out | std::ios::binary
+    );
     auto region = entry->getChunks();
     auto sizes = entry->getSizes();
-
     for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        if (!entry->isUnsaved(i)) {
+            continue;
+        }
         ubyte* chunk = region[i].get();
         if (chunk == nullptr) {
+            sectors[i] = 0;
             continue;
         }
-        offsets[i] = offset;
-
-        auto sizevec = sizes[i];
-        uint32_t compressedSize = sizevec[0];
-        uint32_t srcSize = sizevec[1];
-
-        intbuf = dataio::h2le(compressedSize);
-        file.write(reinterpret_cast<const char*>(&intbuf), 4);
-        offset += 4;
-
-        intbuf = dataio::h2le(srcSize);
-        file.write(reinterpret_cast<const char*>(&intbuf), 4);
-        offset += 4;
-
-        file.write(reinterpret_cast<const char*>(chunk), compressedSize);
-        offset += compressedSize;
+        sectors[i] = allocate_sectors(usedSectors, count_sectors(sizes[i][0]));
+        write_chunk(file, sectors[i], chunk, sizes[i]);
     }
-    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
-        intbuf = dataio::h2le(offsets[i]);
-        file.write(reinterpret_cast<const char*>(&intbuf), 4);
+    // chunks data must be on disk before the table referencing it
+    file.flush();
+    sync_region_file(filename);
+    write_table(file, slot, sectors, generation);
+    file.flush();
+    if (!file.good()) {
+        throw std::runtime_error(
+            "could not write region file " + filename.string()
+        );
     }
+    sync_region_file(filename);
+    entry->setUnsaved(false);
 }
 
 std::unique_ptr<ubyte[]> RegionsLayer::readChunkData(
     int x, int z, uint32_t& size, uint32_t& srcSize, regfile* rfile
-) {
+) const {
     int regionX, regionZ, localX, localZ;
     calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
     int chunkIndex = localZ * REGION_SIZE + localX;
-    return rfile->read(chunkIndex, size, srcSize);
+    const ubyte* src = rfile->view(chunkIndex, size, srcSize);
+    if (src == nullptr) {
+        return nullptr;
+    }
+    if (rfile->compression == compression) {
+        // data outlives the file mapping
+        auto data = std::make_unique<ubyte[]>(size);
+        std::memcpy(data.get(), src, size);
+        return data;
+    }
+    // layer compression method has been changed since the file was written
+    std::unique_ptr<ubyte[]> decompressed;
+    if (rfile->compression != compression::Method::NONE) {
+        decompressed = compression::decompress(
+            src, size, srcSize, rfile->compression
+        );
+        src = decompressed.get();
+    }
+    size = srcSize;
+    if (compression == compression::Method::NONE) {
+        return decompressed;
+    }
+    size_t length;
+    auto data = compression::compress(src, srcSize, length, compression);
+    size = length;
+    return data;
+}
+
+std::unique_ptr<ubyte[]> RegionsLayer::readUncompressedChunkData(
+    int x, int z, uint32_t& srcSize, regfile* rfile
+) const {
+    int regionX, regionZ, localX, localZ;
+    calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
+    int chunkIndex = localZ * REGION_SIZE + localX;
+    uint32_t size;
+    const ubyte* src = rfile->view(chunkIndex, size, srcSize);
+    if (src == nullptr) {
+        return nullptr;
+    }
+    if (rfile->compression != compression::Method::NONE) {
+        return compression::decompress(src, size, srcSize, rfile->compression);
+    }
+    srcSize = size;
+    auto data = std::make_unique<ubyte[]>(size);
+    std::memcpy(data.get(), src, size);
+    return data;
 }
@@ -15,6 +15,7 @@
 #include "items/Inventory.hpp"
 #include "voxels/Block.hpp"
 #include "WorldFiles.hpp"
+#include "WorldRegions.hpp"
 
 namespace fs = std::filesystem;
 
@@ -183,8 +184,18 @@ void WorldConverter::upgradeRegion(
     const io::path& file, int x, int z, RegionLayerIndex layer
 ) const {
     auto path = wfile->getRegions().getRegionFilePath(layer, x, z);
-    auto bytes = io::read_bytes_buffer(path);
-    auto buffer = compatibility::convert_region_2to3(bytes, layer);
+    auto buffer = io::read_bytes_buffer(path);
+    if (buffer.size() <= REGION_HEADER_SIZE) {
+        logger.error() << "invalid region file " << path.string();
+        return;
+    }
+    int version = buffer[8];
+    if (version < 3) {
+        buffer = compatibility::convert_region_2to3(buffer, layer);
+    }
+    if (version < 4) {
+        buffer = compatibility::convert_region_3to4(buffer);
+    }
     io::write_bytes(path, buffer.data(), buffer.size());
 }
 
@@ -223,7 +234,7 @@ void WorldConverter::convertBlocksData(int x, int z, const ContentReport& report
         BlocksMetadata newHeap;
         for (const auto& entry : *heap) {
             size_t index = entry.index;
-            const auto& def = indices.require(chunk.voxels[index].id);
+            const auto& def = indices.require(chunk.get(index).id);
             const auto& newStruct = *def.dataStruct;
             const auto& found = report.blocksDataLayouts.find(def.name);
             if (found == report.blocksDataLayouts.end()) {
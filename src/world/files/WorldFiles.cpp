@@ -47,6 +47,10 @@ WorldFiles::WorldFiles(const io::path& directory, const DebugSettings& settings)
     doWriteLights = settings.doWriteLights.get();
     regions.generatorTestMode = generatorTestMode;
     regions.doWriteLights = doWriteLights;
+    if (settings.lz4Regions.get()) {
+        regions.setCompression(REGION_LAYER_VOXELS, compression::Method::LZ4);
+        regions.setCompression(REGION_LAYER_LIGHTS, compression::Method::LZ4);
+    }
 }
 
 WorldFiles::~WorldFiles() = default;
@@ -76,9 +80,7 @@ io::path WorldFiles::getPacksFile() const {
     return directory / "packs.list";
 }
 
-void WorldFiles::write(
-    const World* world, const Content* content
-) {
+void WorldFiles::writeMetadata(const World* world, const Content* content) {
     if (world) {
         writeWorldInfo(world->getInfo());
         if (!io::exists(getPacksFile())) {
@@ -91,9 +93,28 @@ void WorldFiles::write(
     if (content) {
         writeIndices(content->getIndices());
     }
+}
+
+void WorldFiles::write(
+    const World* world, const Content* content
+) {
+    writeMetadata(world, content);
+    if (generatorTestMode) {
+        return;
+    }
     regions.writeAll();
 }
 
+std::shared_ptr<Task> WorldFiles::writeAsync(
+    const World* world, const Content* content
+) {
+    writeMetadata(world, content);
+    if (generatorTestMode) {
+        return nullptr;
+    }
+    return regions.startWriteTask();
+}
+
 void WorldFiles::writePacks(const std::vector<ContentPack>& packs) {
     auto packsFile = getPacksFile();
     std::stringstream ss;
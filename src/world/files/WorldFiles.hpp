@@ -17,6 +17,7 @@
 inline constexpr uint WORLD_FORMAT_VERSION = 1;
 
 class Player;
+class Task;
 class Content;
 class ContentIndices;
 class World;
@@ -35,6 +36,7 @@ class WorldFiles {
 
     void writeWorldInfo(const WorldInfo& info);
     void writeIndices(const ContentIndices* indices);
+    void writeMetadata(const World* world, const Content* content);
 public:
     WorldFiles(const io::path& directory);
     WorldFiles(const io::path& directory, const DebugSettings& settings);
@@ -62,6 +64,13 @@ public:
     /// @param content world content
     void write(const World* world, const Content* content);
 
+    /// @brief Write world info and indices, unsaved regions are written
+    /// in a background thread
+    /// @param world target world
+    /// @param content world content
+    /// @return regions writing task or nullptr if nothing to write
+    std::shared_ptr<Task> writeAsync(const World* world, const Content* content);
+
     void writePacks(const std::vector<ContentPack>& packs);
 
     void removeIndices(const std::vector<std::string>& packs);
@@ -12,6 +12,7 @@
 #include "items/Inventory.hpp"
 #include "maths/voxmaths.hpp"
 #include "util/data_io.hpp"
+#include "util/ThreadPool.hpp"
 
 #define REGION_FORMAT_MAGIC ".VOXREG"
 
@@ -19,7 +20,7 @@ static debug::Logger logger("world-regions");
 
 WorldRegion::WorldRegion()
     : chunksData(
-          std::make_unique<std::unique_ptr<ubyte[]>[]>(REGION_CHUNKS_COUNT)
+          std::make_unique<std::shared_ptr<ubyte[]>[]>(REGION_CHUNKS_COUNT)
       ),
       sizes(std::make_unique<glm::u32vec2[]>(REGION_CHUNKS_COUNT)) {
 }
@@ -28,12 +29,54 @@ WorldRegion::~WorldRegion() = default;
 
 void WorldRegion::setUnsaved(bool unsaved) {
     this->unsaved = unsaved;
+    if (!unsaved) {
+        unsavedChunks.reset();
+    }
+}
+void WorldRegion::setUnsaved(uint x, uint z) {
+    unsaved = true;
+    unsavedChunks.set(z * REGION_SIZE + x);
 }
 bool WorldRegion::isUnsaved() const {
     return unsaved;
 }
+bool WorldRegion::isUnsaved(size_t index) const {
+    return unsavedChunks.test(index);
+}
+bool WorldRegion::isRaw(size_t index) const {
+    return rawChunks.test(index);
+}
+
+void WorldRegion::compress(size_t index, compression::Method method) {
+    if (!rawChunks.test(index)) {
+        return;
+    }
+    size_t size;
+    auto data = compression::compress(
+        chunksData[index].get(), sizes[index][1], size, method
+    );
+    chunksData[index] = std::move(data);
+    sizes[index][0] = size;
+    rawChunks.reset(index);
+}
 
-std::unique_ptr<ubyte[]>* WorldRegion::getChunks() const {
+std::unique_ptr<WorldRegion> WorldRegion::takeUnsaved() {
+    auto region = std::make_unique<WorldRegion>();
+    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        if (!unsavedChunks.test(i)) {
+            continue;
+        }
+        region->chunksData[i] = chunksData[i];
+        region->sizes[i] = sizes[i];
+    }
+    region->unsavedChunks = unsavedChunks;
+    region->rawChunks = rawChunks & unsavedChunks;
+    region->unsaved = true;
+    setUnsaved(false);
+    return region;
+}
+
+std::shared_ptr<ubyte[]>* WorldRegion::getChunks() const {
     return chunksData.get();
 }
 
@@ -42,11 +85,17 @@ glm::u32vec2* WorldRegion::getSizes() const {
 }
 
 void WorldRegion::put(
-    uint x, uint z, std::unique_ptr<ubyte[]> data, uint32_t size, uint32_t srcSize
+    uint x,
+    uint z,
+    std::shared_ptr<ubyte[]> data,
+    uint32_t size,
+    uint32_t srcSize,
+    bool raw
 ) {
     size_t chunk_index = z * REGION_SIZE + x;
     chunksData[chunk_index] = std::move(data);
     sizes[chunk_index] = glm::u32vec2(size, srcSize);
+    rawChunks.set(chunk_index, raw);
 }
 
 ubyte* WorldRegion::getChunkData(uint x, uint z) {
@@ -79,6 +128,12 @@ WorldRegions::WorldRegions(const io::path& directory) : directory(directory) {
 
 WorldRegions::~WorldRegions() = default;
 
+void WorldRegions::setCompression(
+    RegionLayerIndex layerid, compression::Method method
+) {
+    layers[layerid].compression = method;
+}
+
 void RegionsLayer::writeAll() {
     for (auto& it : regions) {
         WorldRegion* region = it.second.get();
@@ -90,12 +145,129 @@ void RegionsLayer::writeAll() {
     }
 }
 
+std::vector<std::shared_ptr<RegionSnapshot>> RegionsLayer::takeUnsaved() {
+    std::vector<std::shared_ptr<RegionSnapshot>> snapshots;
+    std::lock_guard lock(mapMutex);
+    for (auto& [key, region] : regions) {
+        if (!region->isUnsaved()) {
+            continue;
+        }
+        auto snapshot = std::make_shared<RegionSnapshot>();
+        snapshot->layer = layer;
+        snapshot->x = key.x;
+        snapshot->z = key.y;
+        snapshot->region = region->takeUnsaved();
+
+        auto chunks = snapshot->region->getChunks();
+        for (uint i = 0; i < REGION_CHUNKS_COUNT; i++) {
+            if (snapshot->region->isRaw(i)) {
+                snapshot->rawChunks.emplace_back(i, chunks[i]);
+            }
+        }
+        snapshots.push_back(std::move(snapshot));
+    }
+    return snapshots;
+}
+
+void RegionsLayer::writeSnapshot(RegionSnapshot& snapshot) {
+    writeRegion(snapshot.x, snapshot.z, snapshot.region.get());
+}
+
+void RegionsLayer::onWritten(const RegionSnapshot& snapshot) {
+    auto region = getRegion(snapshot.x, snapshot.z);
+    if (region == nullptr) {
+        return;
+    }
+    auto written = snapshot.region->getChunks();
+    auto writtenSizes = snapshot.region->getSizes();
+    auto chunks = region->getChunks();
+    for (const auto& [index, data] : snapshot.rawChunks) {
+        // chunk data has been replaced after the snapshot
+        if (chunks[index] != data) {
+            continue;
+        }
+        region->put(
+            index % REGION_SIZE,
+            index / REGION_SIZE,
+            written[index],
+            writtenSizes[index][0],
+            writtenSizes[index][1]
+        );
+    }
+}
+
+void RegionsLayer::onWriteFailed(const RegionSnapshot& snapshot) {
+    auto region = getOrCreateRegion(snapshot.x, snapshot.z);
+    for (uint i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        if (snapshot.region->isUnsaved(i)) {
+            region->setUnsaved(i % REGION_SIZE, i / REGION_SIZE);
+        }
+    }
+}
+
+using RegionSnapshotPtr = std::shared_ptr<RegionSnapshot>;
+
+class RegionsWriteWorker
+    : public util::Worker<RegionSnapshotPtr, RegionSnapshotPtr> {
+    RegionsLayer* layers;
+public:
+    RegionsWriteWorker(RegionsLayer* layers) : layers(layers) {
+    }
+
+    RegionSnapshotPtr operator()(const RegionSnapshotPtr& snapshot) override {
+        try {
+            layers[snapshot->layer].writeSnapshot(*snapshot);
+        } catch (const std::exception& err) {
+            logger.error() << "could not write region " << snapshot->x << ", "
+                           << snapshot->z << ": " << err.what();
+            snapshot->failed = true;
+        }
+        return snapshot;
+    }
+};
+
+std::shared_ptr<Task> WorldRegions::startWriteTask() {
+    std::vector<RegionSnapshotPtr> snapshots;
+    for (auto& layer : layers) {
+        io::create_directories(layer.folder);
+        auto layerSnapshots = layer.takeUnsaved();
+        snapshots.insert(
+            snapshots.end(), layerSnapshots.begin(), layerSnapshots.end()
+        );
+    }
+    if (snapshots.empty()) {
+        return nullptr;
+    }
+    // single writer thread keeps region files writes ordered
+    auto pool = std::make_shared<util::ThreadPool<RegionSnapshotPtr, RegionSnapshotPtr>>(
+        "regions-writer",
+        [this]() { return std::make_unique<RegionsWriteWorker>(layers); },
+        [this](RegionSnapshotPtr&& snapshot) {
+            auto& layer = layers[snapshot->layer];
+            if (snapshot->failed) {
+                layer.onWriteFailed(*snapshot);
+            } else {
+                layer.onWritten(*snapshot);
+            }
+        },
+        1
+    );
+    for (auto& snapshot : snapshots) {
+        pool->enqueueJob(std::move(snapshot));
+    }
+    pool->setOnComplete([]() {
+        logger.info() << "regions written";
+    });
+    return pool;
+}
+
 void WorldRegions::put(
     int x,
     int z,
     RegionLayerIndex layerid,
     std::unique_ptr<ubyte[]> data,
-    size_t srcSize
+    size_t srcSize,
+    bool deferCompression
 ) {
     size_t size = srcSize;
     auto& layer = layers[layerid];
@@ -103,18 +275,22 @@ void WorldRegions::put(
     calc_reg_coords(x, z, regionX, regionZ, localX, localZ);
 
     WorldRegion* region = layer.getOrCreateRegion(regionX, regionZ);
-    region->setUnsaved(true);
+    region->setUnsaved(localX, localZ);
     
     if (data == nullptr) {
         region->put(localX, localZ, nullptr, 0, 0);
         return;
     }
 
-    if (layer.compression != compression::Method::NONE) {
+    if (layer.compression == compression::Method::NONE) {
+        region->put(localX, localZ, std::move(data), size, srcSize);
+    } else if (deferCompression) {
+        region->put(localX, localZ, std::move(data), size, srcSize, true);
+    } else {
         data = compression::compress(
             data.get(), size, size, layer.compression);
+        region->put(localX, localZ, std::move(data), size, srcSize);
     }
-    region->put(localX, localZ, std::move(data), size, srcSize);
 }
 
 static std::unique_ptr<ubyte[]> write_inventories(
@@ -152,7 +328,9 @@ static ChunkInventoriesMap load_inventories(const ubyte* src, uint32_t size) {
     return inventories;
 }
 
-void WorldRegions::put(Chunk* chunk, std::vector<ubyte> entitiesData) {
+void WorldRegions::put(
+    Chunk* chunk, std::vector<ubyte> entitiesData, bool deferCompression
+) {
     if (generatorTestMode) {
         return;
     }
@@ -172,7 +350,8 @@ void WorldRegions::put(Chunk* chunk, std::vector<ubyte> entitiesData) {
         chunk->z,
         REGION_LAYER_VOXELS,
         chunk->encode(),
-        CHUNK_DATA_LEN);
+        CHUNK_DATA_LEN,
+        deferCompression);
 
     // Writing lights cache
     if (doWriteLights && chunk->flags.lighted && chunk->lightmap) {
@@ -180,7 +359,8 @@ void WorldRegions::put(Chunk* chunk, std::vector<ubyte> entitiesData) {
             chunk->z,
             REGION_LAYER_LIGHTS,
             chunk->lightmap->encode(),
-            LIGHTMAP_DATA_LEN);
+            LIGHTMAP_DATA_LEN,
+            deferCompression);
     }
     // Writing block inventories
     if (!chunk->inventories.empty() || chunk->flags.inventoriesRemoved) {
@@ -240,10 +420,30 @@ bool WorldRegions::getLights(int x, int z, ubyte* dst) {
     return true;
 }
 
+/// @brief Get uncompressed chunk data of a layer
+/// @param holder owns decompressed data if the layer is compressed
+static const ubyte* uncompressed(
+    const RegionsLayer& layer,
+    const ubyte* data,
+    uint32_t& size,
+    uint32_t srcSize,
+    std::unique_ptr<ubyte[]>& holder
+) {
+    if (data == nullptr || layer.compression == compression::Method::NONE) {
+        return data;
+    }
+    holder = compression::decompress(data, size, srcSize, layer.compression);
+    size = srcSize;
+    return holder.get();
+}
+
 ChunkInventoriesMap WorldRegions::fetchInventories(int x, int z) {
     uint32_t bytesSize;
     uint32_t srcSize;
-    auto bytes = layers[REGION_LAYER_INVENTORIES].getData(x, z, bytesSize, srcSize);
+    auto& layer = layers[REGION_LAYER_INVENTORIES];
+    std::unique_ptr<ubyte[]> holder;
+    auto data = layer.getData(x, z, bytesSize, srcSize);
+    auto bytes = uncompressed(layer, data, bytesSize, srcSize, holder);
     if (bytes == nullptr) {
         return {};
     }
@@ -253,7 +453,10 @@ ChunkInventoriesMap WorldRegions::fetchInventories(int x, int z) {
 BlocksMetadata WorldRegions::getBlocksData(int x, int z) {
     uint32_t bytesSize;
     uint32_t srcSize;
-    auto bytes = layers[REGION_LAYER_BLOCKS_DATA].getData(x, z, bytesSize, srcSize);
+    auto& layer = layers[REGION_LAYER_BLOCKS_DATA];
+    std::unique_ptr<ubyte[]> holder;
+    auto data = layer.getData(x, z, bytesSize, srcSize);
+    auto bytes = uncompressed(layer, data, bytesSize, srcSize, holder);
     if (bytes == nullptr) {
         return {};
     }
@@ -297,16 +500,15 @@ void WorldRegions::processBlocksData(int x, int z, const BlockDataProc& func) {
 
             uint32_t datLength;
             uint32_t datSrcSize;
-            auto datData = RegionsLayer::readChunkData(
+            auto datData = datLayer.readChunkData(
                 gx, gz, datLength, datSrcSize, datRegfile.get()
             );
             if (datData == nullptr) {
                 continue;
             }
-            uint32_t voxLength;
             uint32_t voxSrcSize;
-            auto voxData = RegionsLayer::readChunkData(
-                gx, gz, voxLength, voxSrcSize, voxRegfile.get()
+            auto voxData = voxLayer.readUncompressedChunkData(
+                gx, gz, voxSrcSize, voxRegfile.get()
             );
             if (voxData == nullptr) {
                 logger.warning()
@@ -314,9 +516,6 @@ void WorldRegions::processBlocksData(int x, int z, const BlockDataProc& func) {
                 put(gx, gz, REGION_LAYER_BLOCKS_DATA, nullptr, 0);
                 continue;
             }
-            voxData = compression::decompress(
-                voxData.get(), voxLength, voxSrcSize, voxLayer.compression
-            );
 
             BlocksMetadata blocksData;
             blocksData.deserialize(datData.get(), datLength);
@@ -339,7 +538,10 @@ dv::value WorldRegions::fetchEntities(int x, int z) {
     }
     uint32_t bytesSize;
     uint32_t srcSize;
-    const ubyte* data = layers[REGION_LAYER_ENTITIES].getData(x, z, bytesSize, srcSize);
+    auto& layer = layers[REGION_LAYER_ENTITIES];
+    std::unique_ptr<ubyte[]> holder;
+    const ubyte* data = layer.getData(x, z, bytesSize, srcSize);
+    data = uncompressed(layer, data, bytesSize, srcSize, holder);
     if (data == nullptr) {
         return nullptr;
     }
@@ -365,20 +567,13 @@ void WorldRegions::processRegion(
         for (uint cx = 0; cx < REGION_SIZE; cx++) {
             int gx = cx + x * REGION_SIZE;
             int gz = cz + z * REGION_SIZE;
-            uint32_t length;
             uint32_t srcSize;
-            auto data =
-                RegionsLayer::readChunkData(gx, gz, length, srcSize, regfile.get());
+            auto data = layer.readUncompressedChunkData(
+                gx, gz, srcSize, regfile.get()
+            );
             if (data == nullptr) {
                 continue;
             }
-            if (layer.compression != compression::Method::NONE) {
-                data = compression::decompress(
-                    data.get(), length, srcSize, layer.compression
-                );
-            } else {
-                srcSize = length;
-            }
             if (auto writeData = func(std::move(data), &srcSize)) {
                 put(gx, gz, layerid, std::move(writeData), srcSize);
             }
@@ -1,12 +1,14 @@
 #pragma once
 
 #include <array>
+#include <bitset>
 #include <condition_variable>
 #include <functional>
 #include <glm/glm.hpp>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
+#include <vector>
 
 #include "coders/compression.hpp"
 #include "io/io.hpp"
@@ -25,6 +27,23 @@ inline constexpr uint REGION_SIZE_BIT = 5;
 inline constexpr uint REGION_SIZE = (1 << (REGION_SIZE_BIT));
 inline constexpr uint REGION_CHUNKS_COUNT = ((REGION_SIZE) * (REGION_SIZE));
 
+/// @brief Region file (format 4+) chunks data alignment
+inline constexpr uint REGION_SECTOR_SIZE = 512;
+/// @brief Offsets table slot size: generation, sectors, crc32
+inline constexpr uint REGION_TABLE_SIZE = (REGION_CHUNKS_COUNT + 2) * 4;
+inline constexpr uint REGION_TABLE_SECTORS =
+    (REGION_TABLE_SIZE + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE;
+/// @brief First chunks data sector: header sector and two table slots
+inline constexpr uint REGION_DATA_SECTOR = 1 + REGION_TABLE_SECTORS * 2;
+
+/// @brief Encode region file (format 4+) offsets table slot
+/// @param dst destination buffer of REGION_TABLE_SIZE bytes
+/// @param sectors chunks first sectors (0 - chunk is not present)
+/// @param generation table generation, greater is newer
+void encode_region_table(
+    ubyte* dst, const uint32_t* sectors, uint32_t generation
+);
+
 class illegal_region_format : public std::runtime_error {
 public:
     illegal_region_format(const std::string& message)
@@ -32,36 +51,90 @@ public:
     }
 };
 
+class Task;
+
 class WorldRegion {
-    std::unique_ptr<std::unique_ptr<ubyte[]>[]> chunksData;
+    /// @brief Chunks data may be shared with detached regions being written
+    std::unique_ptr<std::shared_ptr<ubyte[]>[]> chunksData;
     std::unique_ptr<glm::u32vec2[]> sizes;
+    /// @brief Chunks modified since last write
+    std::bitset<REGION_CHUNKS_COUNT> unsavedChunks;
+    /// @brief Chunks data is not compressed yet (see compress)
+    std::bitset<REGION_CHUNKS_COUNT> rawChunks;
     bool unsaved = false;
 public:
     WorldRegion();
     ~WorldRegion();
 
-    void put(uint x, uint z, std::unique_ptr<ubyte[]> data, uint32_t size, uint32_t srcSize);
+    /// @param raw data compression is deferred
+    void put(
+        uint x,
+        uint z,
+        std::shared_ptr<ubyte[]> data,
+        uint32_t size,
+        uint32_t srcSize,
+        bool raw = false
+    );
     ubyte* getChunkData(uint x, uint z);
     glm::u32vec2 getChunkDataSize(uint x, uint z);
 
+    /// @brief Set region unsaved flag. Clears chunks unsaved flags if false
     void setUnsaved(bool unsaved);
+    /// @brief Mark chunk and region as unsaved
+    void setUnsaved(uint x, uint z);
     bool isUnsaved() const;
+    bool isUnsaved(size_t index) const;
+    bool isRaw(size_t index) const;
+
+    /// @brief Compress chunk data stored with deferred compression
+    void compress(size_t index, compression::Method method);
+
+    /// @brief Move unsaved flags to a detached region sharing unsaved
+    /// chunks data
+    std::unique_ptr<WorldRegion> takeUnsaved();
 
-    std::unique_ptr<ubyte[]>* getChunks() const;
+    std::shared_ptr<ubyte[]>* getChunks() const;
     glm::u32vec2* getSizes() const;
 };
 
+/// @brief Unsaved region chunks detached for writing in another thread
+struct RegionSnapshot {
+    RegionLayerIndex layer;
+    int x;
+    int z;
+    std::unique_ptr<WorldRegion> region;
+    /// @brief Uncompressed chunks data by index, replaced in cache with
+    /// compressed data after writing if not changed since
+    std::vector<std::pair<uint, std::shared_ptr<ubyte[]>>> rawChunks;
+    /// @brief Region file write failed, chunks must be marked unsaved again
+    bool failed = false;
+};
+
 struct regfile {
-    io::rafile file;
+    io::mmfile file;
     io::path filename;
     int version;
+    /// @brief Chunks data compression method from the file header
+    compression::Method compression;
     bool inUse = false;
+    /// @brief Last use stamp used to choose least recently used file to close
+    uint64_t lastUse = 0;
+    /// @brief Active offsets table generation (format 4+)
+    uint32_t generation = 0;
+    /// @brief Active offsets table slot index (format 4+)
+    int tableSlot = 0;
     std::array<uint32_t, REGION_CHUNKS_COUNT> offsets;
 
     regfile(io::path filename);
     regfile(const regfile&) = delete;
 
-    std::unique_ptr<ubyte[]> read(int index, uint32_t& size, uint32_t& srcSize);
+    /// @brief Read the newest valid offsets table (format 4+)
+    void readTable();
+
+    /// @brief Get chunk data without copying
+    /// @return pointer to the mapped chunk data valid while the file is open
+    /// or nullptr if chunk is not present
+    const ubyte* view(int index, uint32_t& size, uint32_t& srcSize) const;
 };
 
 using RegionsMap = std::unordered_map<glm::ivec2, std::unique_ptr<WorldRegion>>;
@@ -137,6 +210,8 @@ struct RegionsLayer {
     /// @brief Open region files map mutex
     std::mutex regFilesMutex;
     std::condition_variable regFilesCv;
+    /// @brief Region files use counter (see regfile::lastUse)
+    uint64_t regFilesUseCounter = 0;
 
     [[nodiscard]] regfile_ptr getRegFile(glm::ivec2 coord, bool create = true);
     [[nodiscard]] regfile_ptr useRegFile(glm::ivec2 coord);
@@ -156,7 +231,10 @@ struct RegionsLayer {
     /// @return nullptr if no saved chunk data found
     [[nodiscard]] ubyte* getData(int x, int z, uint32_t& size, uint32_t& srcSize);
 
-    /// @brief Write or rewrite region file
+    /// @brief Write unsaved region chunks to the region file. Chunks are
+    /// written to free sectors, then the inactive offsets table slot is
+    /// updated, so the file remains valid if the write is interrupted.
+    /// Files of older formats are rewritten completely
     /// @param x region X
     /// @param z region Z
     void writeRegion(int x, int y, WorldRegion* entry);
@@ -164,16 +242,39 @@ struct RegionsLayer {
     /// @brief Write all unsaved regions to files
     void writeAll();
 
+    /// @brief Detach unsaved chunks of all unsaved regions
+    std::vector<std::shared_ptr<RegionSnapshot>> takeUnsaved();
+
+    /// @brief Write detached region. May be called in another thread
+    void writeSnapshot(RegionSnapshot& snapshot);
+
+    /// @brief Replace uncompressed chunks data in cache with the written
+    /// compressed data
+    void onWritten(const RegionSnapshot& snapshot);
+
+    /// @brief Mark chunks of the snapshot unsaved again, so they will be
+    /// written by the next save
+    void onWriteFailed(const RegionSnapshot& snapshot);
+
     /// @brief Read chunk data from region file
     /// @param x chunk x coord
     /// @param z chunk z coord
     /// @param size [out] compressed chunk data length
     /// @param srcSize [out] source chunk data length
     /// @param rfile region file
-    /// @return nullptr if chunk is not present in region file
-    [[nodiscard]] static std::unique_ptr<ubyte[]> readChunkData(
+    /// @return nullptr if chunk is not present in region file. Data stored
+    /// with other compression method is converted to the layer one
+    [[nodiscard]] std::unique_ptr<ubyte[]> readChunkData(
         int x, int z, uint32_t& size, uint32_t& srcSize, regfile* rfile
-    );
+    ) const;
+
+    /// @brief Read chunk data from region file decompressing it straight
+    /// from the mapped file
+    /// @param srcSize [out] source chunk data length
+    /// @return nullptr if chunk is not present in region file
+    [[nodiscard]] std::unique_ptr<ubyte[]> readUncompressedChunkData(
+        int x, int z, uint32_t& srcSize, regfile* rfile
+    ) const;
 };
 
 class WorldRegions {
@@ -190,7 +291,12 @@ public:
     ~WorldRegions();
 
     /// @brief Put all chunk data to regions
-    void put(Chunk* chunk, std::vector<ubyte> entitiesData);
+    /// @param deferCompression keep data uncompressed until written
+    void put(
+        Chunk* chunk,
+        std::vector<ubyte> entitiesData,
+        bool deferCompression = false
+    );
 
     /// @brief Store data in specified region
     /// @param x chunk.x
@@ -198,12 +304,14 @@ public:
     /// @param layer regions layer
     /// @param data target data
     /// @param size data size
+    /// @param deferCompression keep data uncompressed until written
     void put(
         int x,
         int z,
         RegionLayerIndex layer,
         std::unique_ptr<ubyte[]> data,
-        size_t size
+        size_t size,
+        bool deferCompression = false
     );
 
     /// @brief Get chunk voxels data
@@ -248,8 +356,19 @@ public:
     /// @brief Write all region layers
     void writeAll();
 
+    /// @brief Write all unsaved regions in a background thread.
+    /// Deferred chunks compression is performed in the thread too
+    /// @return writing task to be updated in the main thread or nullptr
+    /// if there is nothing to write
+    std::shared_ptr<Task> startWriteTask();
+
     void deleteRegion(RegionLayerIndex layerid, int x, int z);
 
+    /// @brief Set chunks data compression method of the layer.
+    /// Must be called before any chunk data of the layer is read or put.
+    /// Existing files compressed with other method are still readable
+    void setCompression(RegionLayerIndex layerid, compression::Method method);
+
     /// @brief Extract X and Z from 'X_Z.bin' region file name.
     /// @param name source region file name
     /// @param x parsed X destination
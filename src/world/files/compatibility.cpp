@@ -1,6 +1,8 @@
 #include "compatibility.hpp"
 
+#include <cstring>
 #include <stdexcept>
+#include <vector>
 
 #include "constants.hpp"
 #include "voxels/voxel.hpp"
@@ -8,6 +10,7 @@
 #include "coders/byte_utils.hpp"
 #include "lighting/Lightmap.hpp"
 #include "util/data_io.hpp"
+#include "WorldRegions.hpp"
 
 static inline size_t VOXELS_DATA_SIZE_V1 = CHUNK_VOL * 4;
 static inline size_t VOXELS_DATA_SIZE_V2 = CHUNK_VOL * 4;
@@ -107,3 +110,49 @@ util::Buffer<ubyte> compatibility::convert_region_2to3(
     }
     return util::Buffer<ubyte>(builder.build().data(), builder.size());
 }
+
+static uint32_t read_uint32_le(const ubyte* src) {
+    uint32_t value;
+    std::memcpy(&value, src, sizeof(uint32_t));
+    return dataio::le2h(value);
+}
+
+util::Buffer<ubyte> compatibility::convert_region_3to4(
+    const util::Buffer<ubyte>& src
+) {
+    const size_t OFFSET_TABLE_SIZE = REGION_CHUNKS_COUNT * sizeof(uint32_t);
+    if (src.size() < REGION_HEADER_SIZE + OFFSET_TABLE_SIZE) {
+        throw std::runtime_error("incomplete region file");
+    }
+    const ubyte* const ptr = src.data();
+    const size_t tableOffset = src.size() - OFFSET_TABLE_SIZE;
+
+    // header sector and table slots
+    std::vector<ubyte> dst(REGION_DATA_SECTOR * REGION_SECTOR_SIZE);
+    std::memcpy(dst.data(), ptr, REGION_HEADER_SIZE);
+    dst[8] = 4;
+
+    uint32_t sectors[REGION_CHUNKS_COUNT] {};
+    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        uint32_t srcOffset = read_uint32_le(ptr + tableOffset + i * 4);
+        if (srcOffset == 0) {
+            continue;
+        }
+        if (srcOffset + 8 > tableOffset) {
+            throw std::runtime_error("corrupted region chunk offset");
+        }
+        size_t length = read_uint32_le(ptr + srcOffset) + 8;
+        if (srcOffset + length > tableOffset) {
+            throw std::runtime_error("corrupted region chunk size");
+        }
+        size_t start = dst.size();
+        sectors[i] = start / REGION_SECTOR_SIZE;
+        dst.insert(dst.end(), ptr + srcOffset, ptr + srcOffset + length);
+        dst.resize(
+            start + (length + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE *
+                        REGION_SECTOR_SIZE
+        );
+    }
+    encode_region_table(dst.data() + REGION_SECTOR_SIZE, sectors, 1);
+    return util::Buffer<ubyte>(dst.data(), dst.size());
+}
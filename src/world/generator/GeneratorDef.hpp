@@ -129,6 +129,10 @@ public:
 
     virtual void initialize(uint64_t seed) = 0;
 
+    /// @brief Create not initialized instance of the script with own state.
+    /// Instances may be used from different threads at the same time
+    virtual std::unique_ptr<GeneratorScript> createCopy() const = 0;
+
     /// @brief Generate a heightmap with values in range 0..1
     /// @param offset position of the heightmap in the world
     /// @param size size of the heightmap
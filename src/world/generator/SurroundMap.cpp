@@ -14,20 +14,30 @@ SurroundMap::SurroundMap(int maxLevelRadius, int8_t maxLevel)
 void SurroundMap::setLevelCallback(int8_t level, LevelCallback callback) {
     auto& wrapper = levelCallbacks.at(level - 1);
     wrapper.callback = callback;
-    wrapper.active = callback != nullptr;
+    wrapper.active = wrapper.callback || wrapper.batchCallback;
+}
+
+void SurroundMap::setLevelBatchCallback(
+    int8_t level, LevelBatchCallback callback
+) {
+    auto& wrapper = levelCallbacks.at(level - 1);
+    wrapper.batchCallback = callback;
+    wrapper.active = wrapper.callback || wrapper.batchCallback;
 }
 
 void SurroundMap::setOutCallback(util::AreaMap2D<int8_t>::OutCallback callback) {
     areaMap.setOutCallback(callback);
 }
 
-void SurroundMap::upgrade(int x, int y, int8_t level) {
+void SurroundMap::upgrade(
+    const glm::ivec2& point, int8_t level, std::vector<glm::ivec2>& upgraded
+) {
     auto& callback = levelCallbacks[level - 1];
     int size = maxLevel - level + 1;
     for (int ly = -size+1; ly < size; ly++) {
         for (int lx = -size+1; lx < size; lx++) {
-            int posX = lx + x;
-            int posY = ly + y;
+            int posX = lx + point.x;
+            int posY = ly + point.y;
             int8_t sourceLevel = areaMap.get(posX, posY, 0);
             if (sourceLevel < level-1) {
                 throw std::runtime_error("invalid map state");
@@ -36,9 +46,15 @@ void SurroundMap::upgrade(int x, int y, int8_t level) {
                 continue;
             }
             areaMap.set(posX, posY, level);
-            if (callback.active) {
+            if (!callback.active) {
+                continue;
+            }
+            if (callback.callback) {
                 callback.callback(posX, posY);
             }
+            if (callback.batchCallback) {
+                upgraded.emplace_back(posX, posY);
+            }
         }
     }
 }
@@ -48,14 +64,44 @@ void SurroundMap::resize(int maxLevelRadius) {
                    (maxLevelRadius + maxLevel) * 2 + 1);
 }
 
+bool SurroundMap::isCompletable(int x, int y) const {
+    return areaMap.isInside(x - maxLevel + 1, y - maxLevel + 1) &&
+           areaMap.isInside(x + maxLevel - 1, y + maxLevel - 1);
+}
+
+void SurroundMap::clear() {
+    areaMap.clear();
+}
+
 void SurroundMap::completeAt(int x, int y) {
-    if (!areaMap.isInside(x - maxLevel + 1, y - maxLevel + 1) ||
-        !areaMap.isInside(x + maxLevel - 1, y + maxLevel - 1)) {
-        throw std::invalid_argument(
-            "upgrade square is not fully inside of area");
+    completeAt(std::vector<glm::ivec2> {{x, y}});
+}
+
+void SurroundMap::completeAt(const std::vector<glm::ivec2>& points) {
+    for (const auto& point : points) {
+        if (!isCompletable(point.x, point.y)) {
+            throw std::invalid_argument(
+                "upgrade square is not fully inside of area");
+        }
     }
+    std::vector<glm::ivec2> upgraded;
     for (int8_t level = 1; level <= maxLevel; level++) {
-        upgrade(x, y, level);
+        upgraded.clear();
+        for (const auto& point : points) {
+            upgrade(point, level, upgraded);
+        }
+        const auto& callback = levelCallbacks[level - 1];
+        if (callback.batchCallback && !upgraded.empty()) {
+            try {
+                callback.batchCallback(upgraded);
+            } catch (...) {
+                // points are upgraded again by the next call
+                for (const auto& point : upgraded) {
+                    areaMap.set(point.x, point.y, level - 1);
+                }
+                throw;
+            }
+        }
     }
 }
 
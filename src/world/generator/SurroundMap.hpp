@@ -1,5 +1,6 @@
 #pragma once
 
+#include <vector>
 #include <unordered_map>
 #include <functional>
 
@@ -12,8 +13,11 @@
 class SurroundMap {
 public:
     using LevelCallback = std::function<void(int, int)>;
+    using LevelBatchCallback =
+        std::function<void(const std::vector<glm::ivec2>&)>;
     struct LevelCallbackWrapper {
         LevelCallback callback;
+        LevelBatchCallback batchCallback;
         bool active = false;
     };
 private:
@@ -21,13 +25,22 @@ private:
     std::vector<LevelCallbackWrapper> levelCallbacks;
     int8_t maxLevel;
 
-    void upgrade(int x, int y, int8_t level);
+    /// @param upgraded destination for points passed to batch callback
+    void upgrade(
+        const glm::ivec2& point,
+        int8_t level,
+        std::vector<glm::ivec2>& upgraded
+    );
 public:
     SurroundMap(int maxLevelRadius, int8_t maxLevel);
 
     /// @brief Callback called on point level increments
     void setLevelCallback(int8_t level, LevelCallback callback);
 
+    /// @brief Callback called once per level with all points upgraded
+    /// to the level by completeAt, in the upgrade order
+    void setLevelBatchCallback(int8_t level, LevelBatchCallback callback);
+
     /// @brief Callback called when non-zero value moves out of area
     void setOutCallback(util::AreaMap2D<int8_t>::OutCallback callback);   
     
@@ -35,6 +48,19 @@ public:
     /// @throws std::invalid_argument - upgrade square is not fully inside
     void completeAt(int x, int y);
 
+    /// @brief Upgrade points to maxLevel. Each level is reached by squares
+    /// of all points before the next level. If a batch callback throws,
+    /// its points are reverted to the previous level
+    /// @throws std::invalid_argument - upgrade square of a point is not
+    /// fully inside
+    void completeAt(const std::vector<glm::ivec2>& points);
+
+    /// @return true if upgrade square of the point is fully inside
+    bool isCompletable(int x, int y) const;
+
+    /// @brief Reset all points calling out callback for non-zero ones
+    void clear();
+
     /// @brief Set map area center
     void setCenter(int x, int y);
 
@@ -1,6 +1,8 @@
 #include "WorldGenerator.hpp"
 
 #include <cstring>
+#include <limits>
+#include <thread>
 #include <algorithm>
 
 #include "maths/util.hpp"
@@ -23,58 +25,224 @@ static inline constexpr uint MAX_PARAMETERS = 4;
 /// @brief Initial + wide_structs + biomes + heightmaps + complete
 static inline constexpr uint BASIC_PROTOTYPE_LAYERS = 5;
 
+class WorldGenerator::PrototypesWorker
+    : public util::Worker<ChunkPrototypeJob, int> {
+    const WorldGenerator& generator;
+    std::unique_ptr<GeneratorScript> script;
+public:
+    PrototypesWorker(
+        const WorldGenerator& generator, std::unique_ptr<GeneratorScript> script
+    )
+        : generator(generator), script(std::move(script)) {
+    }
+
+    int operator()(const ChunkPrototypeJob& job) override {
+        generator.generateJob(*script, job);
+        return 0;
+    }
+};
+
 WorldGenerator::WorldGenerator(
-    const GeneratorDef& def, const Content& content, uint64_t seed
+    const GeneratorDef& def,
+    const Content& content,
+    uint64_t seed,
+    uint workers
 )
     : def(def), 
       content(content), 
       seed(seed),
-      surroundMap(0, BASIC_PROTOTYPE_LAYERS + def.wideStructsChunksRadius * 2)
+      prototypeLevels(BASIC_PROTOTYPE_LAYERS + def.wideStructsChunksRadius * 2)
 {
     def.script->initialize(seed);
 
-    uint levels = BASIC_PROTOTYPE_LAYERS + def.wideStructsChunksRadius * 2;
+    logger.info() << "total number of prototype levels is " << prototypeLevels;
+    for (int i = 0; i < def.structures.size(); i++) {
+        // pre-calculate rotated structure variants
+        def.structures[i]->fragments[0]->prepare(content);
+        for (int j = 1; j < 4; j++) {
+            def.structures[i]->fragments[j] = 
+                def.structures[i]->fragments[j-1]->rotated(content);
+        }
+    }
+    if (workers == 0) {
+        return;
+    }
+    prototypesPool =
+        std::make_unique<util::ThreadPool<ChunkPrototypeJob, int>>(
+            "prototypes-pool",
+            [this]() {
+                auto script = this->def.script->createCopy();
+                script->initialize(this->seed);
+                return std::make_unique<PrototypesWorker>(
+                    *this, std::move(script)
+                );
+            },
+            [](int&&) {},
+            workers
+        );
+    // the pool is kept working after a script error, generateLevel waits
+    // for the whole batch and throws
+    prototypesPool->setStopOnFail(false);
+    prototypesPool->setOnJobFailed([this](auto&) { failedJobs++; });
+}
+
+WorldGenerator::~WorldGenerator() {}
 
-    surroundMap = SurroundMap(0, levels);
-    logger.info() << "total number of prototype levels is " << levels;
+SurroundMap WorldGenerator::createSurroundMap(const ChunksRegion& region) {
+    int levels = prototypeLevels;
+    SurroundMap surroundMap(region.radius, levels);
     surroundMap.setOutCallback([this](int const x, int const z, int8_t) {
-        const auto& found = prototypes.find({x, z});
-        if (found == prototypes.end()) {
+        const auto& found = prototypesRefs.find({x, z});
+        if (found == prototypesRefs.end()) {
             logger.warning() << "unable to remove non-existing chunk prototype";
             return;
         }
-        prototypes.erase({x, z});
+        if (--found->second == 0) {
+            prototypesRefs.erase(found);
+            prototypes.erase({x, z});
+        }
     });
     surroundMap.setLevelCallback(1, [this](int const x, int const z) {
-        if (prototypes.find({x, z}) != prototypes.end()) {
+        // prototype may be already generated by another map
+        if (prototypesRefs[{x, z}]++) {
             return;
         }
         prototypes[{x, z}] = generatePrototype(x, z);
     });
-    surroundMap.setLevelCallback(def.wideStructsChunksRadius + 1, 
-    [this](int const x, int const z) {
-        generateStructuresWide(requirePrototype(x, z), x, z);
+    surroundMap.setLevelBatchCallback(def.wideStructsChunksRadius + 1,
+    [this](const std::vector<glm::ivec2>& positions) {
+        generateLevel(ChunkPrototypeLevel::WIDE_STRUCTS, positions);
     });
-    surroundMap.setLevelCallback(levels-3, [this](int const x, int const z) {
-        generateBiomes(requirePrototype(x, z), x, z);
+    surroundMap.setLevelBatchCallback(levels-3,
+    [this](const std::vector<glm::ivec2>& positions) {
+        generateLevel(ChunkPrototypeLevel::BIOMES, positions);
     });
-    surroundMap.setLevelCallback(levels-2, [this](int const x, int const z) {
-        generateHeightmap(requirePrototype(x, z), x, z);
+    surroundMap.setLevelBatchCallback(levels-2,
+    [this](const std::vector<glm::ivec2>& positions) {
+        generateLevel(ChunkPrototypeLevel::HEIGHTMAP, positions);
     });
-    surroundMap.setLevelCallback(levels-1, [this](int const x, int const z) {
-        generateStructures(requirePrototype(x, z), x, z);
+    surroundMap.setLevelBatchCallback(levels-1,
+    [this](const std::vector<glm::ivec2>& positions) {
+        generateLevel(ChunkPrototypeLevel::STRUCTURES, positions);
     });
-    for (int i = 0; i < def.structures.size(); i++) {
-        // pre-calculate rotated structure variants
-        def.structures[i]->fragments[0]->prepare(content);
-        for (int j = 1; j < 4; j++) {
-            def.structures[i]->fragments[j] = 
-                def.structures[i]->fragments[j-1]->rotated(content);
+    surroundMap.setCenter(region.x, region.z);
+    return surroundMap;
+}
+
+void WorldGenerator::complete(const std::vector<glm::ivec2>& chunks) {
+    // chunks are completed by the first area able to
+    std::vector<std::vector<glm::ivec2>> areasChunks(areas.size());
+    for (const auto& pos : chunks) {
+        auto found = std::find_if(
+            areas.begin(),
+            areas.end(),
+            [&pos](const auto& area) {
+                return area.map.isCompletable(pos.x, pos.y);
+            }
+        );
+        if (found == areas.end()) {
+            throw std::invalid_argument("chunk is out of the generator areas");
+        }
+        areasChunks[found - areas.begin()].push_back(pos);
+    }
+    for (size_t i = 0; i < areas.size(); i++) {
+        if (!areasChunks[i].empty()) {
+            areas[i].map.completeAt(areasChunks[i]);
         }
     }
 }
 
-WorldGenerator::~WorldGenerator() {}
+void WorldGenerator::generateLevel(
+    ChunkPrototypeLevel level, const std::vector<glm::ivec2>& positions
+) {
+    std::vector<ChunkPrototypeJob> jobs;
+    std::vector<std::vector<Placement>> placements(positions.size());
+    for (size_t i = 0; i < positions.size(); i++) {
+        const auto& pos = positions[i];
+        auto& prototype = requirePrototype(pos.x, pos.y);
+        // prototype may be already upgraded by another map
+        if (prototype.level >= level) {
+            continue;
+        }
+        jobs.push_back(
+            ChunkPrototypeJob {level, pos.x, pos.y, &prototype, &placements[i]}
+        );
+    }
+    if (prototypesPool && jobs.size() > 1) {
+        for (auto job : jobs) {
+            prototypesPool->enqueueJob(std::move(job));
+        }
+        // wait for the whole batch to be done, including failed jobs:
+        // jobs refer to the prototypes and placements
+        size_t remaining = jobs.size();
+        size_t failed = 0;
+        while (remaining) {
+            remaining -= prototypesPool->pullResults(remaining);
+            size_t justFailed = failedJobs.exchange(0);
+            failed += justFailed;
+            remaining -= justFailed;
+            if (remaining) {
+                std::this_thread::yield();
+            }
+        }
+        // prototypes levels are not changed, map levels are reverted
+        // by SurroundMap
+        if (failed) {
+            throw std::runtime_error(
+                std::to_string(failed) + " prototype jobs failed"
+            );
+        }
+    } else {
+        for (const auto& job : jobs) {
+            generateJob(*def.script, job);
+        }
+    }
+    // structures are placed to neighbour prototypes in the positions order,
+    // independent of the jobs completion order
+    for (const auto& job : jobs) {
+        switch (level) {
+            case ChunkPrototypeLevel::WIDE_STRUCTS:
+                placeStructures(
+                    *job.placements, *job.prototype, job.x, job.z
+                );
+                break;
+            case ChunkPrototypeLevel::STRUCTURES:
+                generateStructures(
+                    *job.placements, *job.prototype, job.x, job.z
+                );
+                break;
+            default:
+                break;
+        }
+        job.prototype->level = level;
+    }
+}
+
+void WorldGenerator::generateJob(
+    GeneratorScript& script, const ChunkPrototypeJob& job
+) const {
+    glm::ivec2 offset(job.x * CHUNK_W, job.z * CHUNK_D);
+    glm::ivec2 size(CHUNK_W, CHUNK_D);
+    switch (job.level) {
+        case ChunkPrototypeLevel::WIDE_STRUCTS:
+            *job.placements =
+                script.placeStructuresWide(offset, size, CHUNK_H);
+            break;
+        case ChunkPrototypeLevel::BIOMES:
+            generateBiomes(script, *job.prototype, job.x, job.z);
+            break;
+        case ChunkPrototypeLevel::HEIGHTMAP:
+            generateHeightmap(script, *job.prototype, job.x, job.z);
+            break;
+        case ChunkPrototypeLevel::STRUCTURES:
+            *job.placements = script.placeStructures(
+                offset, size, job.prototype->heightmap, CHUNK_H
+            );
+            break;
+        default:
+            break;
+    }
+}
 
 ChunkPrototype& WorldGenerator::requirePrototype(int x, int z) {
     const auto& found = prototypes.find({x, z});
@@ -269,33 +437,15 @@ void WorldGenerator::placeStructures(
     }
 }
 
-void WorldGenerator::generateStructuresWide(
-    ChunkPrototype& prototype, int chunkX, int chunkZ
-) {
-    if (prototype.level >= ChunkPrototypeLevel::WIDE_STRUCTS) {
-        return;
-    }
-    auto placements = def.script->placeStructuresWide(
-        {chunkX * CHUNK_W, chunkZ * CHUNK_D}, {CHUNK_W, CHUNK_D}, CHUNK_H
-    );
-    placeStructures(placements, prototype, chunkX, chunkZ);
-
-    prototype.level = ChunkPrototypeLevel::WIDE_STRUCTS;
-}
-
 void WorldGenerator::generateStructures(
-    ChunkPrototype& prototype, int chunkX, int chunkZ
+    const std::vector<Placement>& placements,
+    ChunkPrototype& prototype,
+    int chunkX,
+    int chunkZ
 ) {
-    if (prototype.level >= ChunkPrototypeLevel::STRUCTURES) {
-        return;
-    }
     const auto& biomes = prototype.biomes;
     const auto& heightmap = prototype.heightmap;
 
-    auto placements = def.script->placeStructures(
-        {chunkX * CHUNK_W, chunkZ * CHUNK_D}, {CHUNK_W, CHUNK_D},
-        heightmap, CHUNK_H
-    );
     placeStructures(placements, prototype, chunkX, chunkZ);
 
     util::PseudoRandom structsRand;
@@ -333,17 +483,13 @@ void WorldGenerator::generateStructures(
             );
         }
     }
-    prototype.level = ChunkPrototypeLevel::STRUCTURES;
 }
 
 void WorldGenerator::generateBiomes(
-    ChunkPrototype& prototype, int chunkX, int chunkZ
-) {
-    if (prototype.level >= ChunkPrototypeLevel::BIOMES) {
-        return;
-    }
+    GeneratorScript& script, ChunkPrototype& prototype, int chunkX, int chunkZ
+) const {
     uint bpd = def.biomesBPD;
-    auto biomeParams = def.script->generateParameterMaps(
+    auto biomeParams = script.generateParameterMaps(
         {floordiv(chunkX * CHUNK_W, bpd), floordiv(chunkZ * CHUNK_D, bpd)},
         {floordiv(CHUNK_W, bpd)+1, floordiv(CHUNK_D, bpd)+1},
         bpd
@@ -374,17 +520,13 @@ void WorldGenerator::generateBiomes(
         }
     }
     prototype.biomes = std::move(chunkBiomes);
-    prototype.level = ChunkPrototypeLevel::BIOMES;
 }
 
 void WorldGenerator::generateHeightmap(
-    ChunkPrototype& prototype, int chunkX, int chunkZ
-) {
-    if (prototype.level >= ChunkPrototypeLevel::HEIGHTMAP) {
-        return;
-    }
+    GeneratorScript& script, ChunkPrototype& prototype, int chunkX, int chunkZ
+) const {
     uint bpd = def.heightsBPD;
-    prototype.heightmap = def.script->generateHeightmap(
+    prototype.heightmap = script.generateHeightmap(
         {floordiv(chunkX * CHUNK_W, bpd), floordiv(chunkZ * CHUNK_D, bpd)},
         {floordiv(CHUNK_W, bpd)+1, floordiv(CHUNK_D, bpd)+1},
         bpd,
@@ -395,13 +537,40 @@ void WorldGenerator::generateHeightmap(
         CHUNK_W + bpd, CHUNK_D + bpd, def.heightsInterpolation
     );
     prototype.heightmap->crop(0, 0, CHUNK_W, CHUNK_D);
-    prototype.level = ChunkPrototypeLevel::HEIGHTMAP;
 }
 
-void WorldGenerator::update(int centerX, int centerY, int loadDistance) {
-    surroundMap.setCenter(centerX, centerY);
-    surroundMap.resize(loadDistance);
-    surroundMap.setCenter(centerX, centerY);
+void WorldGenerator::update(const ChunksInterest& interest) {
+    std::vector<PrototypesArea> updated;
+    for (const auto& region : interest.getRegions(prototypeLevels)) {
+        auto nearest = areas.end();
+        int minDistance = std::numeric_limits<int>::max();
+        for (auto it = areas.begin(); it != areas.end(); ++it) {
+            int distance = std::max(
+                std::abs(it->region.x - region.x),
+                std::abs(it->region.z - region.z)
+            );
+            if (distance <= it->region.radius + region.radius &&
+                distance < minDistance) {
+                minDistance = distance;
+                nearest = it;
+            }
+        }
+        if (nearest == areas.end()) {
+            updated.push_back({region, createSurroundMap(region)});
+            continue;
+        }
+        auto& surroundMap = updated.emplace_back(std::move(*nearest)).map;
+        areas.erase(nearest);
+        surroundMap.setCenter(region.x, region.z);
+        surroundMap.resize(region.radius);
+        surroundMap.setCenter(region.x, region.z);
+        updated.back().region = region;
+    }
+    // release prototypes of areas no longer needed
+    for (auto& area : areas) {
+        area.map.clear();
+    }
+    areas = std::move(updated);
 }
 
 void WorldGenerator::generatePlants(
@@ -411,7 +580,7 @@ void WorldGenerator::generatePlants(
     int chunkX,
     int chunkZ,
     const Biome** biomes
-) {
+) const {
     const auto& indices = content.getIndices()->blocks;
     util::PseudoRandom plantsRand;
     plantsRand.setSeed(chunkX, chunkZ);
@@ -453,7 +622,7 @@ void WorldGenerator::generateLand(
     int chunkX,
     int chunkZ,
     const Biome** biomes
-) {
+) const {
     uint seaLevel = def.seaLevel;
     for (uint z = 0; z < CHUNK_D; z++) {
         for (uint x = 0; x < CHUNK_W; x++) {
@@ -472,9 +641,31 @@ void WorldGenerator::generateLand(
 }
 
 void WorldGenerator::generate(voxel* voxels, int chunkX, int chunkZ) {
-    surroundMap.completeAt(chunkX, chunkZ);
+    complete({{chunkX, chunkZ}});
+    generate(voxels, requirePrototype(chunkX, chunkZ), chunkX, chunkZ);
+}
+
+std::unique_ptr<ChunkPrototype> WorldGenerator::prepare(int chunkX, int chunkZ) {
+    complete({{chunkX, chunkZ}});
 
     const auto& prototype = requirePrototype(chunkX, chunkZ);
+    auto copy = std::make_unique<ChunkPrototype>();
+    copy->level = prototype.level;
+    copy->biomes = std::make_unique<const Biome*[]>(CHUNK_W * CHUNK_D);
+    std::copy(
+        prototype.biomes.get(),
+        prototype.biomes.get() + CHUNK_W * CHUNK_D,
+        copy->biomes.get()
+    );
+    // heightmap is not modified after the HEIGHTMAP level
+    copy->heightmap = prototype.heightmap;
+    copy->placements = prototype.placements;
+    return copy;
+}
+
+void WorldGenerator::generate(
+    voxel* voxels, const ChunkPrototype& prototype, int chunkX, int chunkZ
+) const {
     const auto values = prototype.heightmap->getValues();
 
     uint seaLevel = def.seaLevel;
@@ -515,7 +706,7 @@ void WorldGenerator::generate(voxel* voxels, int chunkX, int chunkZ) {
 
 void WorldGenerator::generatePlacements(
     const ChunkPrototype& prototype, voxel* voxels, int chunkX, int chunkZ
-) {
+) const {
     auto placements = prototype.placements;
     std::stable_sort(
         placements.begin(),
@@ -540,7 +731,7 @@ void WorldGenerator::generateStructure(
     const StructurePlacement& placement,
     voxel* voxels, 
     int chunkX, int chunkZ
-) {
+) const {
     if (placement.structure < 0 || placement.structure >= def.structures.size()) {
         logger.error() << "invalid structure index " << placement.structure;
         return;
@@ -581,7 +772,7 @@ void WorldGenerator::generateLine(
     const LinePlacement& line,
     voxel* voxels, 
     int chunkX, int chunkZ
-) {
+) const {
     const auto& indices = content.getIndices()->blocks;
 
     int cgx = chunkX * CHUNK_W;
@@ -642,7 +833,7 @@ void WorldGenerator::generateBlock(
     const BlockPlacement& placement,
     voxel* voxels,
     int chunkX, int chunkZ
-) {
+) const {
     const auto& indices = content.getIndices()->blocks;
     const auto& def = indices.require(placement.block);
 
@@ -692,8 +883,16 @@ void WorldGenerator::generateBlock(
     }
 }
 
-WorldGenDebugInfo WorldGenerator::createDebugInfo() const {
-    const auto& area = surroundMap.getArea();
+WorldGenDebugInfo WorldGenerator::createDebugInfo(int x, int z) const {
+    auto found = std::find_if(
+        areas.begin(),
+        areas.end(),
+        [x, z](const auto& area) { return area.map.getArea().isInside(x, z); }
+    );
+    if (found == areas.end()) {
+        return WorldGenDebugInfo {x, z, 0, 0, nullptr};
+    }
+    const auto& area = found->map.getArea();
     const auto& levels = area.getBuffer();
     auto values = std::make_unique<ubyte[]>(area.getWidth()*area.getHeight());
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <atomic>
 #include <string>
 #include <memory>
 #include <vector>
@@ -9,11 +10,14 @@
 #include "constants.hpp"
 #include "typedefs.hpp"
 #include "voxels/voxel.hpp"
+#include "voxels/ChunksInterest.hpp"
+#include "util/ThreadPool.hpp"
 #include "SurroundMap.hpp"
 #include "StructurePlacement.hpp"
 
 class Content;
 struct GeneratorDef;
+class GeneratorScript;
 class Heightmap;
 struct Biome;
 class VoxelFragment;
@@ -37,6 +41,16 @@ struct ChunkPrototype {
     std::vector<std::shared_ptr<Heightmap>> heightmapInputs {};
 };
 
+/// @brief Part of a prototype level not depending on other prototypes
+struct ChunkPrototypeJob {
+    ChunkPrototypeLevel level;
+    int x;
+    int z;
+    ChunkPrototype* prototype;
+    /// @brief Destination for placements generated by the script
+    std::vector<Placement>* placements;
+};
+
 struct WorldGenDebugInfo {
     int areaOffsetX;
     int areaOffsetY;
@@ -53,10 +67,30 @@ class WorldGenerator {
     const Content& content;
     /// @param seed world seed
     uint64_t seed;
+    /// @brief Total number of prototype levels
+    uint prototypeLevels;
     /// @brief Chunk prototypes main storage
     std::unordered_map<glm::ivec2, std::unique_ptr<ChunkPrototype>> prototypes;
-    /// @brief Chunk prototypes loading surround map
-    SurroundMap surroundMap;
+    /// @brief Number of surround maps containing the prototype
+    std::unordered_map<glm::ivec2, int> prototypesRefs;
+
+    struct PrototypesArea {
+        ChunksRegion region;
+        SurroundMap map;
+    };
+    /// @brief Chunk prototypes loading surround maps, one per chunks interest
+    /// region. Prototypes are shared between overlapping maps
+    std::vector<PrototypesArea> areas;
+
+    class PrototypesWorker;
+    /// @brief Prototype levels jobs pool, workers have own script instances.
+    /// nullptr if levels are generated in the main thread
+    std::unique_ptr<util::ThreadPool<ChunkPrototypeJob, int>> prototypesPool;
+    /// @brief Number of prototypes pool jobs failed and not yet counted
+    /// by generateLevel
+    std::atomic<size_t> failedJobs = 0;
+
+    SurroundMap createSurroundMap(const ChunksRegion& region);
 
     /// @brief Generate chunk prototype (see ChunkPrototype)
     /// @param x chunk position X divided by CHUNK_W
@@ -65,13 +99,33 @@ class WorldGenerator {
 
     ChunkPrototype& requirePrototype(int x, int z);
 
-    void generateStructuresWide(ChunkPrototype& prototype, int x, int z);
+    /// @brief Upgrade prototypes to the level. Script calls are done in
+    /// parallel if the pool is available, then structures are placed
+    /// in the positions order
+    void generateLevel(
+        ChunkPrototypeLevel level, const std::vector<glm::ivec2>& positions
+    );
 
-    void generateStructures(ChunkPrototype& prototype, int x, int z);
+    /// @brief Execute the prototype level job.
+    /// May be called from worker threads
+    void generateJob(
+        GeneratorScript& script, const ChunkPrototypeJob& job
+    ) const;
 
-    void generateBiomes(ChunkPrototype& prototype, int x, int z);
+    void generateStructures(
+        const std::vector<Placement>& placements,
+        ChunkPrototype& prototype,
+        int x,
+        int z
+    );
+
+    void generateBiomes(
+        GeneratorScript& script, ChunkPrototype& prototype, int x, int z
+    ) const;
 
-    void generateHeightmap(ChunkPrototype& prototype, int x, int z);
+    void generateHeightmap(
+        GeneratorScript& script, ChunkPrototype& prototype, int x, int z
+    ) const;
 
     void placeStructure(
         const StructurePlacement& placement, int priority, 
@@ -83,25 +137,25 @@ class WorldGenerator {
 
     void generatePlacements(
         const ChunkPrototype& prototype, voxel* voxels, int x, int z
-    );
+    ) const;
     void generateLine(
         const ChunkPrototype& prototype, 
         const LinePlacement& placement,
         voxel* voxels, 
         int x, int z
-    );
+    ) const;
     void generateBlock(
         const ChunkPrototype& prototype,
         const BlockPlacement& placement,
         voxel* voxels,
         int x, int z
-    );
+    ) const;
     void generateStructure(
         const ChunkPrototype& prototype, 
         const StructurePlacement& placement,
         voxel* voxels, 
         int x, int z
-    );
+    ) const;
     void generatePlants(
         const ChunkPrototype& prototype,
         float* values,
@@ -109,7 +163,7 @@ class WorldGenerator {
         int x,
         int z,
         const Biome** biomes
-    );
+    ) const;
     void generateLand(
         const ChunkPrototype& prototype,
         float* values,
@@ -117,7 +171,7 @@ class WorldGenerator {
         int x,
         int z,
         const Biome** biomes
-    );
+    ) const;
 
     void placeStructures(
         const std::vector<Placement>& placements,
@@ -125,14 +179,19 @@ class WorldGenerator {
         int x, int z
     );
 public:
+    /// @param workers number of prototype levels generation threads,
+    /// 0 - generate in the main thread
     WorldGenerator(
         const GeneratorDef& def,
         const Content& content,
-        uint64_t seed
+        uint64_t seed,
+        uint workers = 0
     );
     ~WorldGenerator();
 
-    void update(int centerX, int centerY, int loadDistance);
+    /// @brief Move prototypes areas to cover the chunks interest regions.
+    /// Area nearest to a region is reused, so prototypes are kept
+    void update(const ChunksInterest& interest);
 
     /// @brief Generate complete chunk voxels
     /// @param voxels destinatiopn chunk voxels buffer
@@ -140,7 +199,32 @@ public:
     /// @param z chunk position Y divided by CHUNK_D
     void generate(voxel* voxels, int x, int z);
 
-    WorldGenDebugInfo createDebugInfo() const;
+    /// @brief Complete prototypes of all the chunks at once, so levels of
+    /// the chunks are generated in the same batches
+    /// @param chunks chunks positions divided by CHUNK_W and CHUNK_D
+    /// @throws std::invalid_argument - chunk is out of all prototypes areas
+    void complete(const std::vector<glm::ivec2>& chunks);
+
+    /// @brief Complete chunk prototype and make a copy of data required
+    /// for the voxels generation stage
+    /// @param x chunk position X divided by CHUNK_W
+    /// @param z chunk position Y divided by CHUNK_D
+    /// @return prototype copy independent of the prototypes storage
+    std::unique_ptr<ChunkPrototype> prepare(int x, int z);
+
+    /// @brief Generate complete chunk voxels using prepared prototype.
+    /// Does not access the generator script and prototypes storage, so may be
+    /// called from worker threads
+    /// @param voxels destinatiopn chunk voxels buffer
+    /// @param prototype complete chunk prototype (see prepare)
+    /// @param x chunk position X divided by CHUNK_W
+    /// @param z chunk position Y divided by CHUNK_D
+    void generate(
+        voxel* voxels, const ChunkPrototype& prototype, int x, int z
+    ) const;
+
+    /// @brief Get prototypes levels of the area containing the chunk
+    WorldGenDebugInfo createDebugInfo(int x, int z) const;
 
     uint64_t getSeed() const;
 };
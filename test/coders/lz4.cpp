@@ -0,0 +1,102 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <vector>
+
+#include "coders/compression.hpp"
+#include "coders/lz4.hpp"
+#include "coders/rle.hpp"
+#include "voxels/Chunk.hpp"
+
+static void test_encode_decode(int dencity, size_t size) {
+    std::vector<ubyte> initial(size);
+    ubyte next = rand();
+    for (size_t i = 0; i < size; i++) {
+        initial[i] = next;
+        if (rand() % dencity == 0) {
+            next = rand() % 16;
+        }
+    }
+    std::vector<ubyte> encoded(lz4::max_encoded_size(size));
+    size_t encodedSize = lz4::encode(initial.data(), size, encoded.data());
+    ASSERT_LE(encodedSize, encoded.size());
+
+    std::vector<ubyte> decoded(size);
+    size_t decodedSize =
+        lz4::decode(encoded.data(), encodedSize, decoded.data(), size);
+    ASSERT_EQ(decodedSize, size);
+    EXPECT_EQ(decoded, initial);
+}
+
+TEST(LZ4, EncodeDecode) {
+    for (size_t size : {0, 1, 12, 13, 100, 65'536, 300'000}) {
+        test_encode_decode(1, size);
+        test_encode_decode(13, size);
+        test_encode_decode(90123, size);
+    }
+}
+
+TEST(LZ4, Corrupted) {
+    std::vector<ubyte> initial(10'000, 42);
+    std::vector<ubyte> encoded(lz4::max_encoded_size(initial.size()));
+    size_t encodedSize =
+        lz4::encode(initial.data(), initial.size(), encoded.data());
+
+    std::vector<ubyte> decoded(initial.size() - 1);
+    EXPECT_THROW(
+        lz4::decode(
+            encoded.data(), encodedSize, decoded.data(), decoded.size()
+        ),
+        std::runtime_error
+    );
+}
+
+/// @brief Layered terrain with ore veins and caves
+static void generate_terrain(voxel* voxels) {
+    for (uint y = 0; y < CHUNK_H; y++) {
+        for (uint z = 0; z < CHUNK_D; z++) {
+            for (uint x = 0; x < CHUNK_W; x++) {
+                auto& vox = voxels[vox_index(x, y, z)];
+                uint height = 60 + (x * 3 + z * 5) % 7;
+                if (y == 0) {
+                    vox.id = 1;
+                } else if (y < height - 4) {
+                    bool cave = ((x + y / 3) % 11 == 0) && (z + y) % 5 < 2;
+                    vox.id = cave ? 0 : (rand() % 40 == 0 ? 3 + rand() % 3 : 2);
+                } else if (y < height) {
+                    vox.id = 6;
+                } else if (y == height) {
+                    vox.id = 7;
+                    vox.state.rotation = rand() % 4;
+                } else if (y < 64) {
+                    vox.id = 8;
+                }
+            }
+        }
+    }
+}
+
+TEST(LZ4, ChunkData) {
+    using compression::Method;
+
+    Chunk chunk(0, 0);
+    generate_terrain(chunk.getVoxels());
+    auto raw = chunk.encode();
+
+    std::vector<ubyte> rleBuffer(CHUNK_DATA_LEN * 2);
+    size_t rleSize =
+        extrle::encode16(raw.get(), CHUNK_DATA_LEN, rleBuffer.data());
+
+    for (const auto& [src, srcSize] : {
+             std::make_pair(raw.get(), static_cast<size_t>(CHUNK_DATA_LEN)),
+             std::make_pair(rleBuffer.data(), rleSize)}) {
+        size_t size = 0;
+        auto compressed =
+            compression::compress(src, srcSize, size, Method::LZ4);
+        EXPECT_LT(size, srcSize);
+        auto decompressed = compression::decompress(
+            compressed.get(), size, srcSize, Method::LZ4
+        );
+        EXPECT_EQ(std::memcmp(decompressed.get(), src, srcSize), 0);
+    }
+}
@@ -0,0 +1,181 @@
+#include <gtest/gtest.h>
+
+#include <iostream>
+
+#include "assets/Assets.hpp"
+#include "content/Content.hpp"
+#include "content/ContentBuilder.hpp"
+#include "core_defs.hpp"
+#include "frontend/ContentGfxCache.hpp"
+#include "graphics/core/Atlas.hpp"
+#include "graphics/core/ImageData.hpp"
+#include "graphics/render/BlocksRenderer.hpp"
+#include "items/ItemDef.hpp"
+#include "lighting/Lightmap.hpp"
+#include "settings.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/Chunk.hpp"
+
+TEST(ChunkVertex, PositionPacking) {
+    for (float value : {-0.5f, 0.0f, 15.5f, 255.5f, 0.125f, 3.0078125f}) {
+        // positions are in [-64, 448) range
+        glm::vec3 pos(value, value + 1.0f, value - 63.5f);
+        ChunkVertex vertex {ChunkVertex::packPosition(pos)};
+        EXPECT_EQ(vertex.getPosition().x, pos.x);
+        EXPECT_EQ(vertex.getPosition().y, pos.y);
+        EXPECT_EQ(vertex.getPosition().z, pos.z);
+    }
+#if VC_PACKED_CHUNK_VERTEX
+    EXPECT_EQ(ChunkVertex::packUV(1.0f, 0.0f)[0], 65535);
+    EXPECT_EQ(ChunkVertex::packUV(1.0f, 0.0f)[1], 0);
+#endif
+}
+
+class BlocksRendererTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Content> content;
+    Assets assets {nullptr};
+    EngineSettings settings;
+    std::unique_ptr<ContentGfxCache> cache;
+    std::unique_ptr<VoxelsRenderVolume> volume;
+
+    void SetUp() override {
+        ContentBuilder builder;
+        builder.items.create("core:empty");
+        auto& air = builder.blocks.create("core:air");
+        air.defaults.model.type = BlockModelType::NONE;
+        air.lightPassing = true;
+        air.skyLightPassing = true;
+        air.obstacle = false;
+        air.material = "base:air";
+        air.pickingItem = "core:empty";
+        for (const auto& name : {"stone", "dirt"}) {
+            auto& block = builder.blocks.create(std::string("base:") + name);
+            block.material = "base:stone";
+            block.pickingItem = "core:empty";
+            for (auto& texture : block.defaults.textureFaces) {
+                texture = name;
+            }
+        }
+        content = builder.build();
+
+        assets.store(
+            std::make_unique<Atlas>(
+                std::make_unique<ImageData>(ImageFormat::RGBA8888, 64, 64),
+                std::unordered_map<std::string, UVRegion> {
+                    {TEXTURE_NOTFOUND, UVRegion(0.0f, 0.0f, 0.25f, 0.25f)},
+                    {"stone", UVRegion(0.25f, 0.0f, 0.5f, 0.25f)},
+                    {"dirt", UVRegion(0.5f, 0.0f, 0.75f, 0.25f)},
+                },
+                false
+            ),
+            "blocks"
+        );
+        cache = std::make_unique<ContentGfxCache>(
+            *content, assets, settings.graphics
+        );
+        volume = std::make_unique<VoxelsRenderVolume>(
+            -VOXELS_BUFFER_PADDING, 0, -VOXELS_BUFFER_PADDING
+        );
+    }
+
+    /// @brief Fill chunk and render volume with terrain made of plateaus
+    void generate(Chunk& chunk, int (*height)(int x, int z)) {
+        constexpr int w = VoxelsRenderVolume::width;
+        constexpr int d = VoxelsRenderVolume::depth;
+        auto voxels = volume->getVoxels();
+        auto lights = volume->getLights();
+        for (int y = 0; y < CHUNK_H; y++) {
+            for (int z = 0; z < d; z++) {
+                for (int x = 0; x < w; x++) {
+                    int lx = x - VOXELS_BUFFER_PADDING;
+                    int lz = z - VOXELS_BUFFER_PADDING;
+                    int h = height(lx, lz);
+                    blockid_t id = y < h ? (y < h - 3 ? 1 : 2) : 0;
+                    size_t index = vox_index(x, y, z, w, d);
+                    voxels[index] = {id, {}};
+                    lights[index] = id ? 0 : Lightmap::SUN_LIGHT_ONLY;
+                    if (lx >= 0 && lz >= 0 && lx < CHUNK_W && lz < CHUNK_D) {
+                        chunk.set(lx, y, lz, {id, {}});
+                    }
+                }
+            }
+        }
+        chunk.updateHeights();
+    }
+
+    size_t countVertices(const Chunk& chunk, bool greedy) {
+        settings.graphics.greedyMeshing.set(greedy);
+        BlocksRenderer renderer(
+            1'000'000, content->getIndices()->blocks.getDefs(), *cache, settings
+        );
+        renderer.build(&chunk, *volume);
+        return countVertices(renderer.createMesh());
+    }
+
+    static size_t countVertices(const ChunkMeshData& data) {
+        size_t count = 0;
+        for (const auto& section : data.sections) {
+            count += section.mesh.vertices.size();
+        }
+        return count;
+    }
+};
+
+TEST_F(BlocksRendererTest, GreedyFlatSurface) {
+    Chunk chunk(0, 0, std::make_shared<Lightmap>());
+    generate(chunk, [](int, int) { return 64; });
+
+    EXPECT_EQ(countVertices(chunk, false), CHUNK_W * CHUNK_D * 4);
+    EXPECT_EQ(countVertices(chunk, true), 4);
+}
+
+TEST_F(BlocksRendererTest, GreedyTerrainVerticesCount) {
+    Chunk chunk(0, 0, std::make_shared<Lightmap>());
+    generate(chunk, [](int x, int z) {
+        return 60 + ((x + 32) / 4 * 7 + (z + 32) / 4 * 13) % 6;
+    });
+
+    size_t plain = countVertices(chunk, false);
+    size_t greedy = countVertices(chunk, true);
+    std::cout << "vertices: " << plain << " -> " << greedy << std::endl;
+    EXPECT_LT(greedy, plain);
+}
+
+TEST_F(BlocksRendererTest, SectionsBuild) {
+    Chunk chunk(0, 0, std::make_shared<Lightmap>());
+    generate(chunk, [](int, int) { return 40; });
+    settings.graphics.greedyMeshing.set(false);
+    BlocksRenderer renderer(
+        1'000'000, content->getIndices()->blocks.getDefs(), *cache, settings
+    );
+
+    renderer.build(&chunk, *volume);
+    auto full = renderer.createMesh();
+    ASSERT_EQ(full.sectionsMask, BlocksRenderer::ALL_SECTIONS);
+    // the only visible surface is at y = 39
+    ASSERT_EQ(full.sections.size(), 1);
+    EXPECT_EQ(full.sections[0].index, 39 / CHUNK_SECTION_H);
+
+    uint32_t mask = 1U << (39 / CHUNK_SECTION_H) | 1;
+    renderer.build(&chunk, *volume, mask);
+    auto partial = renderer.createMesh();
+    EXPECT_EQ(partial.sectionsMask, mask);
+    ASSERT_EQ(partial.sections.size(), 1);
+    EXPECT_EQ(
+        partial.sections[0].mesh.vertices.size(),
+        full.sections[0].mesh.vertices.size()
+    );
+}
+
+TEST(ChunkSections, ModifiedSections) {
+    Chunk chunk(0, 0, std::make_shared<Lightmap>());
+    chunk.setSectionsModified(CHUNK_SECTION_H + 5);
+    EXPECT_EQ(chunk.modifiedSections, 0b10);
+    chunk.modifiedSections = 0;
+    chunk.setSectionsModified(CHUNK_SECTION_H);
+    EXPECT_EQ(chunk.modifiedSections, 0b11);
+    chunk.modifiedSections = 0;
+    chunk.setSectionsModified(0);
+    EXPECT_EQ(chunk.modifiedSections, 0b1);
+}
@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "content/Content.hpp"
+#include "lighting/Lighting.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/Chunks.hpp"
+
+/// @brief Original per-column implementation used as a reference
+static void prebuild_sky_light_scalar(
+    Chunk& chunk, const ContentIndices& indices
+) {
+    auto& lightmap = *chunk.lightmap;
+    const auto* blockDefs = indices.blocks.getDefs();
+
+    int highestPoint = 0;
+    for (int z = 0; z < CHUNK_D; z++) {
+        for (int x = 0; x < CHUNK_W; x++) {
+            for (int y = CHUNK_H - 1; y >= 0; y--) {
+                voxel vox = chunk.get(x, y, z);
+                if (!blockDefs[vox.id]->skyLightPassing) {
+                    if (highestPoint < y) {
+                        highestPoint = y;
+                    }
+                    break;
+                }
+                lightmap.setS(x, y, z, 15);
+            }
+        }
+    }
+    if (highestPoint < CHUNK_H - 1) {
+        highestPoint++;
+    }
+    lightmap.highestPoint = highestPoint;
+}
+
+static void generate_terrain(Chunk& chunk) {
+    std::mt19937 random(0);
+    voxel* voxels = chunk.getVoxels();
+    for (int z = 0; z < CHUNK_D; z++) {
+        for (int x = 0; x < CHUNK_W; x++) {
+            int height = 60 + (x * 7 + z * 13) % 40;
+            for (int y = 0; y < height; y++) {
+                voxels[vox_index(x, y, z)].id = 1 + random() % 3;
+            }
+        }
+    }
+}
+
+static void set_block_id(Chunks& chunks, int x, int y, int z, blockid_t id) {
+    auto chunk = chunks.getChunkByVoxel(x, y, z);
+    chunk->set(x - chunk->x * CHUNK_W, y, z - chunk->z * CHUNK_D, {id, {}});
+}
+
+class LightingTest : public ::testing::Test {
+protected:
+    Block air {"core:air"};
+    Block stone {"base:stone"};
+    Block glass {"base:glass"};
+    Block leaves {"base:leaves"};
+    Block lamp {"base:lamp"};
+    std::unique_ptr<ContentIndices> indices;
+
+    void SetUp() override {
+        air.lightPassing = true;
+        air.skyLightPassing = true;
+        glass.lightPassing = true;
+        glass.skyLightPassing = true;
+        leaves.lightPassing = true;
+        lamp.emission[0] = 14;
+        lamp.emission[1] = 7;
+        indices = std::make_unique<ContentIndices>(
+            ContentUnitIndices<Block, blockid_t>(
+                {&air, &stone, &glass, &leaves, &lamp}
+            ),
+            ContentUnitIndices<ItemDef, itemid_t>({}),
+            ContentUnitIndices<EntityDef, entitydefid_t>({})
+        );
+    }
+
+    /// @brief Load 3x3 lighted chunks of terrain around chunk 0, 0
+    std::unique_ptr<Chunks> create_chunks(Lighting*& lighting) {
+        // area offset is ox - w / 2 * 2, so the area covers chunks -1..1
+        auto chunks = std::make_unique<Chunks>(3, 3, 1, 1, nullptr, *indices);
+        for (int cz = -1; cz <= 1; cz++) {
+            for (int cx = -1; cx <= 1; cx++) {
+                auto chunk = std::make_shared<Chunk>(
+                    cx, cz, std::make_shared<Lightmap>()
+                );
+                generate_terrain(*chunk);
+                Lighting::prebuildSkyLight(*chunk, *indices);
+                // lights are built reading packed voxels
+                chunk->pack();
+                chunks->putChunk(chunk);
+            }
+        }
+        lighting = new Lighting(*indices, *chunks);
+        for (int cz = -1; cz <= 1; cz++) {
+            for (int cx = -1; cx <= 1; cx++) {
+                lighting->buildSkyLight(cx, cz);
+                lighting->onChunkLoaded(cx, cz, true);
+            }
+        }
+        return chunks;
+    }
+};
+
+TEST_F(LightingTest, PrebuildSkyLightMatchesScalar) {
+    Chunk chunk1(0, 0, std::make_shared<Lightmap>());
+    generate_terrain(chunk1);
+    prebuild_sky_light_scalar(chunk1, *indices);
+
+    for (auto level : {
+             noise::SimdLevel::NONE,
+             noise::SimdLevel::SSE41,
+             noise::SimdLevel::AVX2,
+         }) {
+        SCOPED_TRACE(static_cast<int>(level));
+        Chunk chunk2(0, 0, std::make_shared<Lightmap>());
+        chunk1.copyVoxels(chunk2.getVoxels());
+        chunk2.pack();
+        Lighting::prebuildSkyLight(chunk2, *indices, level);
+
+        EXPECT_EQ(
+            chunk1.lightmap->highestPoint, chunk2.lightmap->highestPoint
+        );
+        for (uint i = 0; i < CHUNK_VOL; i++) {
+            ASSERT_EQ(chunk1.lightmap->map[i], chunk2.lightmap->map[i]);
+        }
+    }
+}
+
+TEST_F(LightingTest, BlocksSetBatchMatchesSequential) {
+    Lighting* sequentialLighting;
+    Lighting* batchLighting;
+    auto sequential = create_chunks(sequentialLighting);
+    auto batch = create_chunks(batchLighting);
+    std::unique_ptr<Lighting> lighting1(sequentialLighting);
+    std::unique_ptr<Lighting> lighting2(batchLighting);
+
+    // carve a cave with pillars and lamps crossing chunk borders
+    std::vector<glm::ivec3> positions;
+    for (int y = 70; y < 100; y++) {
+        for (int z = -4; z < 6; z++) {
+            for (int x = 10; x < 22; x++) {
+                blockid_t id = (x * 3 + y + z * 5) % 7 == 0 ? 1 : 0;
+                if ((x + y + z) % 23 == 0) {
+                    id = 4;
+                }
+                if (sequential->get(x, y, z)->id == id) {
+                    continue;
+                }
+                set_block_id(*sequential, x, y, z, id);
+                lighting1->onBlockSet(x, y, z, id);
+                set_block_id(*batch, x, y, z, id);
+                positions.emplace_back(x, y, z);
+            }
+        }
+    }
+    ASSERT_FALSE(positions.empty());
+    lighting2->onBlocksSet(positions);
+
+    for (int cz = -1; cz <= 1; cz++) {
+        for (int cx = -1; cx <= 1; cx++) {
+            const auto& expected = *sequential->getChunk(cx, cz)->lightmap;
+            const auto& actual = *batch->getChunk(cx, cz)->lightmap;
+            for (uint i = 0; i < CHUNK_VOL; i++) {
+                ASSERT_EQ(expected.map[i], actual.map[i]);
+            }
+        }
+    }
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "maths/FastNoiseLite.h"
+#include "maths/noise_batch.hpp"
+
+static constexpr noise::SimdLevel LEVELS[] {
+    noise::SimdLevel::NONE,
+    noise::SimdLevel::SSE41,
+    noise::SimdLevel::AVX2,
+};
+
+struct Points {
+    std::vector<float> xs;
+    std::vector<float> ys;
+    std::vector<float> values;
+
+    Points(size_t count) {
+        std::mt19937 random(count);
+        std::uniform_real_distribution<float> coord(-5000.0f, 5000.0f);
+        std::uniform_int_distribution<int> cell(-500, 500);
+        for (size_t i = 0; i < count; i++) {
+            // integer coordinates are edge cases for floor and round
+            if (i % 3 == 0) {
+                xs.push_back(cell(random));
+                ys.push_back(cell(random));
+            } else {
+                xs.push_back(coord(random));
+                ys.push_back(coord(random));
+            }
+            values.push_back(coord(random) * 0.001f);
+        }
+    }
+};
+
+static void expect_same_as_reference(fnl_state state, const Points& points) {
+    float amplitude = 0.75f;
+    std::vector<float> expected = points.values;
+    for (size_t i = 0; i < expected.size(); i++) {
+        expected[i] +=
+            fnlGetNoise2D(&state, points.xs[i], points.ys[i]) * amplitude;
+    }
+    for (auto level : LEVELS) {
+        if (level > noise::get_simd_level()) {
+            break;
+        }
+        auto values = points.values;
+        noise::add_noise_2d(
+            state,
+            points.xs.data(),
+            points.ys.data(),
+            amplitude,
+            values.data(),
+            values.size(),
+            level
+        );
+        // bit-identical, not just close
+        for (size_t i = 0; i < values.size(); i++) {
+            ASSERT_EQ(values[i], expected[i])
+                << "noise type " << state.noise_type << ", simd level "
+                << static_cast<int>(level) << ", point " << points.xs[i]
+                << " " << points.ys[i];
+        }
+    }
+}
+
+TEST(NoiseBatch, MatchesFastNoiseLite) {
+    // not a multiple of vector width to test the tail
+    Points points(1003);
+
+    auto state = fnlCreateState();
+    state.seed = 42;
+    for (auto type : {FNL_NOISE_OPENSIMPLEX2, FNL_NOISE_PERLIN}) {
+        state.noise_type = type;
+        expect_same_as_reference(state, points);
+    }
+    state.noise_type = FNL_NOISE_CELLULAR;
+    for (int func = FNL_CELLULAR_DISTANCE_EUCLIDEAN;
+         func <= FNL_CELLULAR_DISTANCE_HYBRID;
+         func++) {
+        for (int ret = FNL_CELLULAR_RETURN_VALUE_CELLVALUE;
+             ret <= FNL_CELLULAR_RETURN_VALUE_DISTANCE2DIV;
+             ret++) {
+            state.cellular_distance_func =
+                static_cast<fnl_cellular_distance_func>(func);
+            state.cellular_return_type =
+                static_cast<fnl_cellular_return_type>(ret);
+            expect_same_as_reference(state, points);
+        }
+    }
+    // settings without vectorized kernels
+    state.noise_type = FNL_NOISE_OPENSIMPLEX2S;
+    expect_same_as_reference(state, points);
+    state.noise_type = FNL_NOISE_OPENSIMPLEX2;
+    state.fractal_type = FNL_FRACTAL_FBM;
+    expect_same_as_reference(state, points);
+}
@@ -0,0 +1,86 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+#include "network/Network.hpp"
+
+using namespace std::chrono;
+
+/// @brief Stream total bytes through a loopback TCP connection
+/// @return elapsed time in microseconds or -1 on failure
+static long long stream_loopback(size_t total) {
+    const size_t chunkSize = 64 * 1024;
+
+    NetworkSettings settings {};
+    auto network = network::Network::create(settings);
+
+    std::atomic<u64id_t> serverSide = 0;
+    std::atomic<bool> connected = false;
+    int port = network->findFreePort();
+    network->openTcpServer(port, [&serverSide](u64id_t, u64id_t cid) {
+        serverSide = cid;
+    });
+    u64id_t clientSide = network->connectTcp(
+        "127.0.0.1",
+        port,
+        [&connected](u64id_t) { connected = true; },
+        [](u64id_t, std::string message) { ADD_FAILURE() << message; }
+    );
+    for (int i = 0; i < 1000 && !(connected && serverSide); i++) {
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    EXPECT_TRUE(connected && serverSide);
+    if (!(connected && serverSide)) {
+        return -1;
+    }
+
+    auto sender = network->getConnection(clientSide, true);
+    auto receiver = dynamic_cast<network::ReadableConnection*>(
+        network->getConnection(serverSide, true)
+    );
+    EXPECT_NE(receiver, nullptr);
+    if (receiver == nullptr) {
+        return -1;
+    }
+
+    std::vector<char> chunk(chunkSize);
+    for (size_t i = 0; i < chunkSize; i++) {
+        chunk[i] = i % 251;
+    }
+    auto start = high_resolution_clock::now();
+    std::thread producer([sender, &chunk, total, chunkSize]() {
+        for (size_t sent = 0; sent < total; sent += chunkSize) {
+            sender->send(chunk.data(), chunk.size());
+        }
+    });
+    std::vector<char> dst(chunkSize);
+    size_t received = 0;
+    bool valid = true;
+    while (received < total) {
+        int size = receiver->recv(dst.data(), dst.size());
+        EXPECT_GE(size, 0);
+        if (size < 0) {
+            break;
+        }
+        for (int i = 0; i < size; i++) {
+            valid &= dst[i] == static_cast<char>((received + i) % chunkSize % 251);
+        }
+        received += size;
+        if (size == 0) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    auto elapsed = duration_cast<microseconds>(
+        high_resolution_clock::now() - start
+    ).count();
+    EXPECT_TRUE(valid);
+    EXPECT_EQ(received, total);
+    return elapsed;
+}
+
+TEST(Sockets, TcpLoopbackStream) {
+    EXPECT_GE(stream_loopback(4 * 1024 * 1024), 0);
+}
@@ -0,0 +1,226 @@
+#include <gtest/gtest.h>
+
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "constants.hpp"
+#include "content/Content.hpp"
+#include "content/ContentBuilder.hpp"
+#include "content/ContentPack.hpp"
+#include "items/ItemDef.hpp"
+#include "physics/Hitbox.hpp"
+#include "physics/PhysicsSolver.hpp"
+#include "settings.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/GlobalChunks.hpp"
+#include "world/Level.hpp"
+#include "world/World.hpp"
+
+static constexpr float DELTA = 1.0f / 60.0f;
+static constexpr uint SUBSTEPS = 16;
+/// @brief Scene is above the world height, so hitboxes are the only obstacles
+static constexpr float FLOOR_Y = CHUNK_H + 16;
+
+struct Body {
+    Hitbox hitbox;
+    bool solid;
+};
+
+class PhysicsSolverTest : public ::testing::Test {
+protected:
+    std::unique_ptr<Content> content;
+    EngineSettings settings;
+    std::unique_ptr<Level> level;
+    std::vector<std::unique_ptr<Body>> bodies;
+    entityid_t nextEntity = 1;
+
+    void SetUp() override {
+        ContentBuilder builder;
+        builder.items.create("core:empty");
+        auto& air = builder.blocks.create("core:air");
+        air.material = "base:air";
+        air.pickingItem = "core:empty";
+        content = builder.build();
+        reset();
+    }
+
+    /// @brief Create empty level
+    void reset() {
+        bodies.clear();
+        nextEntity = 1;
+        auto world = std::make_unique<World>(
+            WorldInfo(), nullptr, *content, std::vector<ContentPack> {}
+        );
+        level = std::make_unique<Level>(std::move(world), *content, settings);
+    }
+
+    Hitbox& add(BodyType type, glm::vec3 pos, glm::vec3 half, bool solid) {
+        bodies.push_back(std::make_unique<Body>(
+            Body {Hitbox(nextEntity++, type, pos, half), solid}
+        ));
+        auto& hitbox = bodies.back()->hitbox;
+        if (type != BodyType::DYNAMIC) {
+            hitbox.mass = std::numeric_limits<float>::infinity();
+            hitbox.gravityScale = 0.0f;
+        }
+        return hitbox;
+    }
+
+    Hitbox& addPlatform(float x = 0.0f) {
+        return add(
+            BodyType::KINEMATIC,
+            {x, FLOOR_Y, 0.0f},
+            {2.0f, 0.5f, 2.0f},
+            true
+        );
+    }
+
+    Hitbox& addBox(glm::vec3 pos) {
+        return add(BodyType::DYNAMIC, pos, glm::vec3(0.5f), true);
+    }
+
+    void remove(const Hitbox& hitbox) {
+        for (auto it = bodies.begin(); it != bodies.end(); ++it) {
+            if (&(*it)->hitbox == &hitbox) {
+                bodies.erase(it);
+                return;
+            }
+        }
+    }
+
+    /// @brief Fill solver lists the same way Entities::preparePhysics does
+    void prepare() {
+        auto& physics = *level->physics;
+        auto& hitboxes = physics.getHitboxesWriteable();
+        auto& solidHitboxes = physics.getSolidHitboxesWriteable();
+        auto& sleepingHitboxes = physics.getSleepingHitboxesWriteable();
+        hitboxes.clear();
+        solidHitboxes.clear();
+        sleepingHitboxes.clear();
+        for (const auto& body : bodies) {
+            if (physics.updateSleeping(body->hitbox)) {
+                sleepingHitboxes.push_back(&body->hitbox);
+            } else {
+                hitboxes.push_back(&body->hitbox);
+            }
+            if (body->solid) {
+                solidHitboxes.push_back(&body->hitbox);
+            }
+        }
+    }
+
+    void step(int count = 1) {
+        for (int i = 0; i < count; i++) {
+            prepare();
+            level->physics->step(*level->chunks, DELTA, SUBSTEPS);
+        }
+    }
+};
+
+TEST_F(PhysicsSolverTest, FallsAsleepAtRest) {
+    addPlatform();
+    auto& box = addBox({0.0f, FLOOR_Y + 1.5f, 0.0f});
+
+    step(120);
+    ASSERT_TRUE(box.sleeping);
+    EXPECT_NEAR(box.position.y, FLOOR_Y + 1.0f, 0.05f);
+
+    auto position = box.position;
+    step(10);
+    EXPECT_TRUE(box.sleeping);
+    EXPECT_EQ(box.position, position);
+}
+
+TEST_F(PhysicsSolverTest, WakesUpByImpulse) {
+    addPlatform();
+    auto& box = addBox({0.0f, FLOOR_Y + 1.0f, 0.0f});
+    step(120);
+    ASSERT_TRUE(box.sleeping);
+
+    float y = box.position.y;
+    box.velocity = {0.0f, 5.0f, 0.0f};
+    step();
+    EXPECT_FALSE(box.sleeping);
+    EXPECT_GT(box.position.y, y);
+}
+
+TEST_F(PhysicsSolverTest, WakesUpInWakeArea) {
+    addPlatform();
+    auto& box = addBox({0.0f, FLOOR_Y + 1.0f, 0.0f});
+    auto& farBox = addBox({10.0f, FLOOR_Y + 1.0f, 0.0f});
+    addPlatform(10.0f);
+    step(120);
+    ASSERT_TRUE(box.sleeping);
+    ASSERT_TRUE(farBox.sleeping);
+
+    level->physics->addWakeArea(box.getAABB());
+    step();
+    EXPECT_FALSE(box.sleeping);
+    EXPECT_TRUE(farBox.sleeping);
+}
+
+TEST_F(PhysicsSolverTest, WakesUpWhenSupportMoves) {
+    auto& platform = addPlatform();
+    auto& lower = addBox({0.0f, FLOOR_Y + 1.0f, 0.0f});
+    auto& upper = addBox({0.0f, FLOOR_Y + 2.0f, 0.0f});
+    step(120);
+    ASSERT_TRUE(lower.sleeping);
+    ASSERT_TRUE(upper.sleeping);
+
+    // moved by a script
+    platform.setPos(platform.position - glm::vec3(0.0f, 4.0f, 0.0f));
+    step(120);
+    EXPECT_NEAR(lower.position.y, FLOOR_Y - 3.0f, 0.05f);
+    EXPECT_NEAR(upper.position.y, FLOOR_Y - 2.0f, 0.05f);
+}
+
+TEST_F(PhysicsSolverTest, WakesUpWhenSupportRemoved) {
+    auto& platform = addPlatform();
+    auto& box = addBox({0.0f, FLOOR_Y + 1.0f, 0.0f});
+    step(120);
+    ASSERT_TRUE(box.sleeping);
+
+    remove(platform);
+    step(30);
+    EXPECT_FALSE(box.sleeping);
+    EXPECT_LT(box.position.y, FLOOR_Y);
+}
+
+TEST_F(PhysicsSolverTest, WorkersGiveSameResult) {
+    // separate piles of boxes thrown on platforms, simulated as islands
+    auto simulate = [this](uint workers) {
+        reset();
+        level->physics->setWorkers(workers);
+        std::mt19937 random(42);
+        std::uniform_real_distribution<float> jitter(-0.1f, 0.1f);
+        std::uniform_real_distribution<float> speed(-2.0f, 2.0f);
+        for (int i = 0; i < 8; i++) {
+            float x = i * 20.0f;
+            addPlatform(x);
+            for (int j = 0; j < 9; j++) {
+                glm::vec3 pos(
+                    x + (j % 3 - 1) * 1.2f + jitter(random),
+                    FLOOR_Y + 1.5f + j / 3 * 1.2f,
+                    (j / 3 - 1) * 1.2f + jitter(random)
+                );
+                addBox(pos).velocity = {speed(random), 0.0f, speed(random)};
+            }
+        }
+        step(90);
+        std::vector<Hitbox> result;
+        for (const auto& body : bodies) {
+            result.push_back(body->hitbox);
+        }
+        return result;
+    };
+    auto expected = simulate(0);
+    auto result = simulate(4);
+    ASSERT_EQ(result.size(), expected.size());
+    for (size_t i = 0; i < result.size(); i++) {
+        EXPECT_EQ(result[i].position, expected[i].position);
+        EXPECT_EQ(result[i].velocity, expected[i].velocity);
+        EXPECT_EQ(result[i].sleeping, expected[i].sleeping);
+    }
+}
@@ -0,0 +1,58 @@
+#include <gtest/gtest.h>
+
+#include <random>
+#include <vector>
+
+#include "physics/SpatialHash.hpp"
+
+static std::vector<AABB> generate_boxes(size_t count, float range) {
+    std::mt19937 random(count);
+    std::uniform_real_distribution<float> coord(-range, range);
+    std::uniform_real_distribution<float> size(0.2f, 1.5f);
+    std::vector<AABB> boxes;
+    for (size_t i = 0; i < count; i++) {
+        glm::vec3 pos(coord(random), coord(random) * 0.25f, coord(random));
+        glm::vec3 half(size(random), size(random), size(random));
+        boxes.emplace_back(pos - half, pos + half);
+    }
+    return boxes;
+}
+
+static void query_brute_force(
+    const std::vector<AABB>& boxes,
+    const AABB& aabb,
+    std::vector<uint32_t>& dst
+) {
+    dst.clear();
+    for (uint32_t i = 0; i < boxes.size(); i++) {
+        if (boxes[i].intersects(aabb)) {
+            dst.push_back(i);
+        }
+    }
+}
+
+TEST(SpatialHash, MatchesBruteForce) {
+    auto boxes = generate_boxes(2000, 50.0f);
+    // large box is not put into the grid cells
+    boxes.emplace_back(glm::vec3(-100.0f), glm::vec3(100.0f));
+
+    SpatialHash grid(2.0f);
+    grid.build(boxes);
+    EXPECT_EQ(grid.size(), boxes.size());
+
+    std::vector<uint32_t> expected;
+    std::vector<uint32_t> found;
+    for (const auto& aabb : boxes) {
+        query_brute_force(boxes, aabb, expected);
+        grid.query(aabb, found);
+        EXPECT_EQ(found, expected);
+    }
+    // query covering more cells than the table has
+    AABB everything(glm::vec3(-1000.0f), glm::vec3(1000.0f));
+    grid.query(everything, found);
+    EXPECT_EQ(found.size(), boxes.size());
+
+    grid.build({});
+    grid.query(everything, found);
+    EXPECT_TRUE(found.empty());
+}
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "util/PagedTable2D.hpp"
+
+TEST(PagedTable2D, SetGet) {
+    util::PagedTable2D<int*> table;
+    std::vector<int> values(64 * 64);
+    for (int z = -32; z < 32; z++) {
+        for (int x = -32; x < 32; x++) {
+            table.set(x, z, &values[(z + 32) * 64 + x + 32]);
+        }
+    }
+    EXPECT_EQ(table.size(), values.size());
+    EXPECT_EQ(table.countOverflow(), 0);
+    for (int z = -32; z < 32; z++) {
+        for (int x = -32; x < 32; x++) {
+            EXPECT_EQ(table.get(x, z), &values[(z + 32) * 64 + x + 32]);
+        }
+    }
+    EXPECT_EQ(table.get(32, 0), nullptr);
+    EXPECT_EQ(table.get(-33, -33), nullptr);
+
+    for (int z = -32; z < 32; z++) {
+        for (int x = -32; x < 32; x++) {
+            table.set(x, z, nullptr);
+        }
+    }
+    EXPECT_EQ(table.size(), 0);
+    EXPECT_EQ(table.get(0, 0), nullptr);
+}
+
+TEST(PagedTable2D, CollidingPages) {
+    util::PagedTable2D<int*, 2, 2> table;
+    int a = 1, b = 2, c = 3;
+    // pages (0, 0), (4, 0) and (-4, 0) share the same slot
+    table.set(1, 1, &a);
+    table.set(17, 1, &b);
+    table.set(-15, 1, &c);
+    EXPECT_EQ(table.countOverflow(), 2);
+    EXPECT_EQ(table.get(1, 1), &a);
+    EXPECT_EQ(table.get(17, 1), &b);
+    EXPECT_EQ(table.get(-15, 1), &c);
+    EXPECT_EQ(table.get(33, 1), nullptr);
+
+    table.set(1, 1, nullptr);
+    EXPECT_EQ(table.countOverflow(), 1);
+    EXPECT_EQ(table.get(1, 1), nullptr);
+    EXPECT_EQ(table.get(17, 1), &b);
+    EXPECT_EQ(table.get(-15, 1), &c);
+    EXPECT_EQ(table.size(), 2);
+}
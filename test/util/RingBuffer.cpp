@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+#include <vector>
+
+#include "util/RingBuffer.hpp"
+
+using namespace util;
+
+TEST(RingBuffer, WrapAround) {
+    RingBuffer<char> buffer(10);
+    EXPECT_EQ(buffer.getCapacity(), 16);
+
+    char src[16];
+    char dst[16];
+    for (int i = 0; i < 16; i++) {
+        src[i] = i;
+    }
+    for (int step = 0; step < 20; step++) {
+        ASSERT_EQ(buffer.write(src, 11), 11);
+        ASSERT_EQ(buffer.size(), 11);
+        ASSERT_EQ(buffer.read(dst, 16), 11);
+        for (int i = 0; i < 11; i++) {
+            ASSERT_EQ(dst[i], src[i]);
+        }
+        EXPECT_TRUE(buffer.empty());
+    }
+}
+
+TEST(RingBuffer, Backpressure) {
+    RingBuffer<int> buffer(8);
+    std::vector<int> src(12, 7);
+    EXPECT_EQ(buffer.write(src.data(), src.size()), 8);
+    EXPECT_EQ(buffer.freeSpace(), 0);
+    EXPECT_EQ(buffer.write(src.data(), 1), 0);
+
+    int dst[3];
+    EXPECT_EQ(buffer.read(dst, 3), 3);
+    EXPECT_EQ(buffer.write(src.data(), src.size()), 3);
+    buffer.clear();
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(buffer.read(dst, 3), 0);
+}
+
+TEST(RingBuffer, ProducerConsumer) {
+    const size_t total = 16'000'000;
+    RingBuffer<uint32_t> buffer(4096);
+
+    std::thread producer([&buffer, total]() {
+        uint32_t chunk[333];
+        size_t written = 0;
+        while (written < total) {
+            size_t count = std::min<size_t>(std::size(chunk), total - written);
+            for (size_t i = 0; i < count; i++) {
+                chunk[i] = written + i;
+            }
+            size_t offset = 0;
+            while (offset < count) {
+                size_t size = buffer.write(chunk + offset, count - offset);
+                if (size == 0) {
+                    std::this_thread::yield();
+                }
+                offset += size;
+            }
+            written += count;
+        }
+    });
+    uint32_t chunk[500];
+    size_t read = 0;
+    bool valid = true;
+    while (read < total) {
+        size_t count = buffer.read(chunk, std::size(chunk));
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+        for (size_t i = 0; i < count; i++) {
+            valid &= chunk[i] == read + i;
+        }
+        read += count;
+    }
+    producer.join();
+    EXPECT_TRUE(valid);
+}
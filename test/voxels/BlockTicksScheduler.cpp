@@ -0,0 +1,87 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "voxels/Block.hpp"
+#include "voxels/BlockTicksScheduler.hpp"
+
+struct EventsLog {
+    std::vector<glm::ivec3> ticks;
+    std::vector<glm::ivec3> present;
+    std::vector<glm::ivec3> removed;
+    int batches = 0;
+
+    BlockTicksScheduler::EventsConsumer consumer() {
+        return [this](
+            const Block&, BlockEventType type, auto positions, float
+        ) {
+            batches++;
+            auto& dst = type == BlockEventType::TICK      ? ticks
+                        : type == BlockEventType::PRESENT ? present
+                                                          : removed;
+            dst.insert(dst.end(), positions.begin(), positions.end());
+        };
+    }
+};
+
+TEST(BlockTicksScheduler, TicksOncePerInterval) {
+    Block def("test:ticking");
+    def.rt.id = 1;
+    def.rt.funcsset.onblocktick = true;
+    def.tickInterval = 2;
+
+    BlockTicksScheduler scheduler;
+    for (int i = 0; i < 100; i++) {
+        scheduler.add(def, {i, 0, 0});
+    }
+    EXPECT_EQ(scheduler.count(1), 100);
+
+    EventsLog log;
+    // 10 ticks per second, so every block ticks once per 0.1 s
+    for (int i = 0; i < 10; i++) {
+        scheduler.update(0.01f, 20, log.consumer());
+    }
+    EXPECT_EQ(log.batches, 10);
+    EXPECT_NEAR(static_cast<int>(log.ticks.size()), 100, 1);
+
+    scheduler.remove(def, {5, 0, 0});
+    scheduler.remove(def, {6, 0, 0});
+    EXPECT_EQ(scheduler.count(1), 98);
+    log.ticks.clear();
+    for (int i = 0; i < 10; i++) {
+        scheduler.update(0.01f, 20, log.consumer());
+    }
+    for (const auto& pos : log.ticks) {
+        EXPECT_NE(pos.x, 5);
+        EXPECT_NE(pos.x, 6);
+    }
+}
+
+TEST(BlockTicksScheduler, PresentAndRemovedEvents) {
+    Block def("test:present");
+    def.rt.id = 2;
+    def.rt.funcsset.onblocktick = true;
+    def.rt.funcsset.onblockpresent = true;
+    def.rt.funcsset.onblockremoved = true;
+
+    BlockTicksScheduler scheduler;
+    scheduler.add(def, {0, 0, 0});
+    scheduler.add(def, {1, 0, 0});
+    scheduler.remove(def, {1, 0, 0});
+
+    EventsLog log;
+    scheduler.update(1.0f, 20, log.consumer());
+    // removed block does not get present event
+    ASSERT_EQ(log.present.size(), 1);
+    EXPECT_EQ(log.present[0], glm::ivec3(0, 0, 0));
+    ASSERT_EQ(log.removed.size(), 1);
+    EXPECT_EQ(log.removed[0], glm::ivec3(1, 0, 0));
+    // removed, present and then tick events batches
+    EXPECT_EQ(log.batches, 3);
+    EXPECT_EQ(log.ticks.size(), 1);
+
+    scheduler.update(1.0f, 20, log.consumer());
+    EXPECT_EQ(log.ticks.size(), 2);
+    EXPECT_EQ(log.present.size(), 1);
+    EXPECT_EQ(log.removed.size(), 1);
+}
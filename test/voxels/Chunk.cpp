@@ -1,14 +1,28 @@
 #include <gtest/gtest.h>
 
+#include <cstring>
+
 #include "voxels/Chunk.hpp"
 
+static void generate_terrain(voxel* voxels) {
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        uint y = i / (CHUNK_W * CHUNK_D);
+        if (y < 50) {
+            voxels[i].id = 1 + rand() % 4;
+        } else if (y < 64) {
+            voxels[i].id = 5 + rand() % 2;
+        }
+    }
+}
+
 TEST(Chunk, EncodeDecode) {
     Chunk chunk1(0, 0);
+    voxel* voxels = chunk1.getVoxels();
     for (uint i = 0; i < CHUNK_VOL; i++) {
-        chunk1.voxels[i].id = rand();
-        chunk1.voxels[i].state.rotation = rand();
-        chunk1.voxels[i].state.segment = rand();
-        chunk1.voxels[i].state.userbits = rand();
+        voxels[i].id = rand();
+        voxels[i].state.rotation = rand();
+        voxels[i].state.segment = rand();
+        voxels[i].state.userbits = rand();
     }
     auto bytes = chunk1.encode();
 
@@ -16,10 +30,69 @@ TEST(Chunk, EncodeDecode) {
     chunk2.decode(bytes.get());
 
     for (uint i = 0; i < CHUNK_VOL; i++) {
-        EXPECT_EQ(chunk1.voxels[i].id, chunk2.voxels[i].id);
+        EXPECT_EQ(chunk1.get(i).id, chunk2.get(i).id);
         EXPECT_EQ(
-            blockstate2int(chunk1.voxels[i].state), 
-            blockstate2int(chunk2.voxels[i].state)
+            blockstate2int(chunk1.get(i).state), 
+            blockstate2int(chunk2.get(i).state)
         );
     }
 }
+
+TEST(Chunk, PackUnpack) {
+    Chunk chunk(0, 0);
+    generate_terrain(chunk.getVoxels());
+    auto bytes = chunk.encode();
+    size_t flatSize = chunk.getVoxelsMemoryUsage();
+
+    chunk.pack();
+    ASSERT_TRUE(chunk.isPacked());
+    EXPECT_LE(chunk.getVoxelsMemoryUsage() * 5, flatSize);
+    EXPECT_EQ(std::memcmp(chunk.encode().get(), bytes.get(), CHUNK_DATA_LEN), 0);
+
+    Chunk expected(0, 0);
+    expected.decode(bytes.get());
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        ASSERT_EQ(chunk.get(i).id, expected.get(i).id);
+    }
+
+    voxel* voxels = chunk.getVoxels();
+    EXPECT_FALSE(chunk.isPacked());
+    EXPECT_EQ(std::memcmp(voxels, expected.getVoxels(), CHUNK_VOL * 4), 0);
+}
+
+TEST(Chunk, SetPacked) {
+    Chunk chunk(0, 0);
+    generate_terrain(chunk.getVoxels());
+    chunk.pack();
+
+    voxel vox {700, {}};
+    vox.state.rotation = 3;
+    chunk.set(1, 2, 3, vox);
+    chunk.set(4, CHUNK_H - 1, 5, vox);
+    chunk.set(6, 60, 7, {});
+    ASSERT_TRUE(chunk.isPacked());
+
+    Chunk decoded(0, 0);
+    decoded.decode(chunk.encode().get());
+    for (const Chunk* target : {&chunk, &decoded}) {
+        EXPECT_EQ(target->get(1, 2, 3).id, 700);
+        EXPECT_EQ(target->get(1, 2, 3).state.rotation, 3);
+        EXPECT_EQ(target->get(4, CHUNK_H - 1, 5).id, 700);
+        EXPECT_EQ(target->get(6, 60, 7).id, BLOCK_AIR);
+    }
+}
+
+TEST(Chunk, PackIfIdle) {
+    Chunk chunk(0, 0);
+    chunk.getVoxels();
+    EXPECT_FALSE(chunk.packIfIdle());
+    EXPECT_FALSE(chunk.isPacked());
+
+    // reading and setting voxels does not prevent packing
+    chunk.get(0);
+    chunk.set(0, {1, {}});
+    EXPECT_TRUE(chunk.packIfIdle());
+    EXPECT_TRUE(chunk.isPacked());
+    EXPECT_FALSE(chunk.packIfIdle());
+    EXPECT_EQ(chunk.get(0).id, 1);
+}
@@ -0,0 +1,142 @@
+#include <gtest/gtest.h>
+
+#include <vector>
+
+#include "content/Content.hpp"
+#include "content/ContentBuilder.hpp"
+#include "items/ItemDef.hpp"
+#include "lighting/Lightmap.hpp"
+#include "maths/voxmaths.hpp"
+#include "voxels/Block.hpp"
+#include "voxels/Chunk.hpp"
+#include "voxels/Chunks.hpp"
+#include "voxels/ChunkSnapshot.hpp"
+
+TEST(ChunkSnapshot, Generation) {
+    Chunk chunk(1, 2, std::make_shared<Lightmap>());
+    chunk.set(3, 4, 5, {7, {}});
+    chunk.lightmap->setS(3, 4, 5, 15);
+
+    auto snapshot = ChunkSnapshot::create(chunk);
+    EXPECT_EQ(snapshot->x, 1);
+    EXPECT_EQ(snapshot->z, 2);
+    EXPECT_EQ(snapshot->getVoxel(vox_index(3, 4, 5)).id, 7);
+    EXPECT_EQ(
+        snapshot->getLight(vox_index(3, 4, 5)),
+        chunk.lightmap->get(3, 4, 5)
+    );
+    EXPECT_TRUE(snapshot->isActual(chunk));
+
+    // snapshot is not affected by the chunk modifications
+    chunk.set(3, 4, 5, {8, {}});
+    chunk.setBlockModifiedAndUnsaved(4);
+    EXPECT_EQ(snapshot->getVoxel(vox_index(3, 4, 5)).id, 7);
+    EXPECT_FALSE(snapshot->isActual(chunk));
+
+    snapshot = ChunkSnapshot::create(chunk);
+    EXPECT_TRUE(snapshot->isActual(chunk));
+    chunk.flags.lighted = true;
+    EXPECT_FALSE(snapshot->isActual(chunk));
+
+    // packed chunk voxels are unpacked to the snapshot
+    chunk.pack();
+    snapshot = ChunkSnapshot::create(chunk);
+    EXPECT_TRUE(chunk.isPacked());
+    EXPECT_EQ(snapshot->getVoxel(vox_index(3, 4, 5)).id, 8);
+
+    snapshot = ChunkSnapshot::create(chunk);
+    chunk.setModified();
+    EXPECT_FALSE(snapshot->isActual(chunk));
+}
+
+TEST(ChunkSnapshot, SharedSections) {
+    Chunk chunk(0, 0, std::make_shared<Lightmap>());
+    chunk.set(1, 2, 3, {5, {}});
+    chunk.set(1, CHUNK_SECTION_H * 2 + 2, 3, {6, {}});
+
+    // only requested sections are copied
+    auto first = ChunkSnapshot::create(chunk, 0b101);
+    EXPECT_EQ(first->getSections(), 0b101U);
+    EXPECT_EQ(first->getVoxel(vox_index(1, 2, 3)).id, 5);
+    EXPECT_EQ(first->getSectionVoxels(1), nullptr);
+    EXPECT_EQ(
+        first->getVoxel(vox_index(1, CHUNK_SECTION_H, 3)).id, BLOCK_VOID
+    );
+    EXPECT_TRUE(first->isActual(chunk, 0b101));
+    EXPECT_FALSE(first->isActual(chunk, 0b111));
+
+    // only the modified section is copied again
+    chunk.set(1, 2, 3, {7, {}});
+    chunk.setBlockModifiedAndUnsaved(2);
+    auto second = ChunkSnapshot::create(chunk, 0b101, first.get());
+    EXPECT_EQ(first->getVoxel(vox_index(1, 2, 3)).id, 5);
+    EXPECT_EQ(second->getVoxel(vox_index(1, 2, 3)).id, 7);
+    EXPECT_NE(first->getSectionVoxels(0), second->getSectionVoxels(0));
+    EXPECT_EQ(first->getSectionVoxels(2), second->getSectionVoxels(2));
+    EXPECT_EQ(
+        second->getVoxel(vox_index(1, CHUNK_SECTION_H * 2 + 2, 3)).id, 6
+    );
+
+    // full modification invalidates all sections
+    chunk.setModified();
+    auto third = ChunkSnapshot::create(chunk, 0b100, second.get());
+    EXPECT_EQ(third->getSections(), 0b100U);
+    EXPECT_NE(second->getSectionVoxels(2), third->getSectionVoxels(2));
+}
+
+TEST(ChunkSnapshot, AreaVoxels) {
+    ContentBuilder builder;
+    builder.items.create("core:empty");
+    auto& air = builder.blocks.create("core:air");
+    air.material = "base:air";
+    air.pickingItem = "core:empty";
+    auto content = builder.build();
+
+    ChunkSnapshotsArea area {0, 0, {}};
+    for (int cz = -1; cz <= 1; cz++) {
+        for (int cx = -1; cx <= 1; cx++) {
+            // left column is missing
+            if (cx == -1) {
+                continue;
+            }
+            Chunk chunk(cx, cz);
+            voxel* voxels = chunk.getVoxels();
+            for (int i = 0; i < CHUNK_VOL; i++) {
+                voxels[i].id = (cz + 1) * 3 + cx + 1;
+            }
+            area.snapshots[(cz + 1) * 3 + cx + 1] =
+                ChunkSnapshot::create(chunk);
+        }
+    }
+    constexpr int w = CHUNK_W + 4;
+    constexpr int h = 8;
+    constexpr int d = CHUNK_D + 4;
+    std::vector<voxel> voxels(w * h * d);
+    std::vector<light_t> lights(w * h * d);
+    Chunks::getVoxels(
+        *content->getIndices(),
+        area,
+        voxels.data(),
+        lights.data(),
+        {-2, 0, -2},
+        {w, h, d},
+        false,
+        h
+    );
+    for (int y = 0; y < h; y++) {
+        for (int z = 0; z < d; z++) {
+            for (int x = 0; x < w; x++) {
+                int cx = floordiv<CHUNK_W>(x - 2);
+                int cz = floordiv<CHUNK_D>(z - 2);
+                size_t index = vox_index(x, y, z, w, d);
+                if (cx == -1) {
+                    EXPECT_EQ(voxels[index].id, BLOCK_VOID);
+                    continue;
+                }
+                EXPECT_EQ(voxels[index].id, (cz + 1) * 3 + cx + 1);
+                // chunks without lightmap
+                EXPECT_EQ(lights[index], Lightmap::SUN_LIGHT_ONLY);
+            }
+        }
+    }
+}
@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+
+#include "voxels/ChunksFrontier.hpp"
+
+TEST(ChunksFrontier, CellsOrder) {
+    ChunksFrontier frontier(8, 6);
+    const auto& cells = frontier.getCells();
+    ASSERT_EQ(cells.size(), 8 * 6);
+    EXPECT_EQ(cells[0].x, 4);
+    EXPECT_EQ(cells[0].z, 3);
+    EXPECT_EQ(cells[0].distance, 0);
+    for (size_t i = 1; i < cells.size(); i++) {
+        EXPECT_LE(cells[i - 1].distance, cells[i].distance);
+        const auto& cell = cells[i];
+        EXPECT_EQ(cell.index, cell.z * 8 + cell.x);
+    }
+}
+
+TEST(ChunksFrontier, Invalidate) {
+    ChunksFrontier frontier(16, 16);
+    const auto& cells = frontier.getCells();
+    EXPECT_TRUE(frontier.trimRequired);
+
+    frontier.loadCursor = 100;
+    frontier.lightsCursor = 50;
+    frontier.trimRequired = false;
+
+    const auto& near = cells[20];
+    frontier.invalidate(near.x, near.z);
+    EXPECT_EQ(frontier.loadCursor, 20);
+    EXPECT_EQ(frontier.lightsCursor, 20);
+    EXPECT_FALSE(frontier.trimRequired);
+
+    // cells after cursors do not affect them
+    const auto& far = cells.back();
+    frontier.invalidate(far.x, far.z);
+    EXPECT_EQ(frontier.loadCursor, 20);
+    EXPECT_GE(far.distance, frontier.getTrimDistance());
+    EXPECT_TRUE(frontier.trimRequired);
+
+    // out of area
+    frontier.invalidate(-1, 0);
+    frontier.invalidate(0, 16);
+    EXPECT_EQ(frontier.loadCursor, 20);
+
+    frontier.reset();
+    EXPECT_EQ(frontier.loadCursor, 0);
+    EXPECT_EQ(frontier.lightsCursor, 0);
+}
@@ -0,0 +1,51 @@
+#include <gtest/gtest.h>
+
+#include "voxels/ChunksInterest.hpp"
+
+TEST(ChunksInterest, Demand) {
+    ChunksInterest interest;
+    interest.setArea(1, 0, 0, 4);
+    EXPECT_EQ(interest.getDemand(0, 0), 1);
+    EXPECT_EQ(interest.getDemand(3, 0), 1);
+    EXPECT_EQ(interest.getDemand(4, 0), 0);
+    size_t area = interest.size();
+
+    // overlapping area of another player
+    interest.setArea(2, 2, 0, 4);
+    EXPECT_EQ(interest.getDemand(0, 0), 2);
+    EXPECT_EQ(interest.getDemand(5, 0), 1);
+
+    // moved area keeps demand of the other one
+    interest.setArea(1, 4, 0, 4);
+    EXPECT_EQ(interest.getDemand(0, 0), 1);
+    EXPECT_EQ(interest.getDemand(4, 0), 2);
+    EXPECT_EQ(interest.getDemand(7, 0), 1);
+
+    interest.removeArea(2);
+    EXPECT_FALSE(interest.isDemanded(0, 0));
+    EXPECT_EQ(interest.size(), area);
+    interest.removeArea(1);
+    EXPECT_EQ(interest.size(), 0);
+}
+
+TEST(ChunksInterest, Regions) {
+    ChunksInterest interest;
+    interest.setArea(3, 0, 0, 8);
+    interest.setArea(1, 20, 0, 8);
+    interest.setArea(2, 1000, 1000, 8);
+
+    auto regions = interest.getRegions(0);
+    ASSERT_EQ(regions.size(), 3);
+    EXPECT_EQ(regions[0].x, 20);
+    EXPECT_EQ(regions[1].x, 1000);
+    EXPECT_EQ(regions[2].x, 0);
+
+    // areas close enough to share prototypes
+    regions = interest.getRegions(4);
+    ASSERT_EQ(regions.size(), 2);
+    const auto& merged = regions[0];
+    EXPECT_EQ(merged.x, 10);
+    EXPECT_EQ(merged.z, 0);
+    EXPECT_EQ(merged.radius, 18);
+    EXPECT_EQ(regions[1].x, 1000);
+}
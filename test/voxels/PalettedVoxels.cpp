@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+
+#include "voxels/Chunk.hpp"
+#include "voxels/PalettedVoxels.hpp"
+
+static void generate_terrain(voxel* voxels) {
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        uint y = i / (CHUNK_W * CHUNK_D);
+        if (y < 50) {
+            voxels[i].id = 1 + rand() % 4;
+        } else if (y < 64) {
+            voxels[i].id = 5 + rand() % 2;
+        }
+    }
+}
+
+TEST(PalettedVoxels, PackUnpack) {
+    Chunk chunk(0, 0);
+    generate_terrain(chunk.getVoxels());
+
+    PalettedVoxels paletted(chunk.getVoxels());
+    auto unpacked = std::make_unique<voxel[]>(CHUNK_VOL);
+    paletted.unpack(unpacked.get());
+    for (uint i = 0; i < CHUNK_VOL; i++) {
+        ASSERT_EQ(chunk.get(i).id, unpacked[i].id);
+        ASSERT_EQ(paletted.get(i).id, unpacked[i].id);
+    }
+    EXPECT_EQ(paletted.getSection(VOXELS_SECTIONS_COUNT - 1), nullptr);
+
+    auto bytes1 = chunk.encode();
+    auto bytes2 = paletted.encode();
+    EXPECT_EQ(std::memcmp(bytes1.get(), bytes2.get(), CHUNK_DATA_LEN), 0);
+}
+
+TEST(PalettedVoxels, UnpackRange) {
+    Chunk chunk(0, 0);
+    generate_terrain(chunk.getVoxels());
+    PalettedVoxels paletted(chunk.getVoxels());
+
+    // crossing sections bounds, including the empty ones
+    uint begin = VOXELS_SECTION_VOL * 3 - 100;
+    uint count = VOXELS_SECTION_VOL * 2 + 200;
+    auto unpacked = std::make_unique<voxel[]>(count);
+    paletted.unpack(unpacked.get(), begin, count);
+    for (uint i = 0; i < count; i++) {
+        ASSERT_EQ(chunk.get(begin + i).id, unpacked[i].id);
+    }
+    begin = VOXELS_SECTION_VOL * 4 - 10;
+    count = 20;
+    paletted.unpack(unpacked.get(), begin, count);
+    for (uint i = 0; i < count; i++) {
+        ASSERT_EQ(chunk.get(begin + i).id, unpacked[i].id);
+    }
+}
+
+TEST(PalettedVoxels, SetGet) {
+    auto voxels = std::make_unique<voxel[]>(CHUNK_VOL);
+    PalettedVoxels paletted;
+    for (int i = 0; i < 100'000; i++) {
+        uint x = rand() % CHUNK_W;
+        uint y = rand() % CHUNK_H;
+        uint z = rand() % CHUNK_D;
+        voxel vox {static_cast<blockid_t>(rand() % 600), {}};
+        vox.state.rotation = rand() % 4;
+        paletted.set(x, y, z, vox);
+        voxels[vox_index(x, y, z)] = vox;
+    }
+    for (uint y = 0; y < CHUNK_H; y++) {
+        for (uint z = 0; z < CHUNK_D; z++) {
+            for (uint x = 0; x < CHUNK_W; x++) {
+                const auto& expected = voxels[vox_index(x, y, z)];
+                auto vox = paletted.get(x, y, z);
+                ASSERT_EQ(expected.id, vox.id);
+                ASSERT_EQ(
+                    blockstate2int(expected.state), blockstate2int(vox.state)
+                );
+            }
+        }
+    }
+}
+
+TEST(PalettedVoxels, Compact) {
+    PalettedVoxels paletted;
+    for (uint i = 0; i < VOXELS_SECTION_VOL; i++) {
+        paletted.set(i, voxel {static_cast<blockid_t>(1 + i % 100), {}});
+    }
+    for (uint i = 0; i < VOXELS_SECTION_VOL; i++) {
+        paletted.set(i, voxel {5, {}});
+    }
+    paletted.set(VOXELS_SECTION_VOL, voxel {1, {}});
+    paletted.set(VOXELS_SECTION_VOL, voxel {});
+
+    // air of the new section and 100 ids set
+    EXPECT_EQ(paletted.getSection(0)->getPaletteSize(), 101);
+    EXPECT_TRUE(paletted.compact());
+    EXPECT_FALSE(paletted.compact());
+
+    const auto section = paletted.getSection(0);
+    ASSERT_NE(section, nullptr);
+    EXPECT_EQ(section->getPaletteSize(), 1);
+    EXPECT_EQ(section->getBits(), 0);
+    EXPECT_EQ(paletted.getSection(1), nullptr);
+    for (uint i = 0; i < VOXELS_SECTION_VOL; i++) {
+        ASSERT_EQ(paletted.get(i).id, 5);
+    }
+}
@@ -0,0 +1,194 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <filesystem>
+
+#include "coders/byte_utils.hpp"
+#include "io/io.hpp"
+#include "io/devices/StdfsDevice.hpp"
+#include "voxels/Chunk.hpp"
+#include "world/files/WorldRegions.hpp"
+#include "world/files/compatibility.hpp"
+
+namespace fs = std::filesystem;
+
+static std::unique_ptr<ubyte[]> make_data(uint32_t size, ubyte seed) {
+    auto data = std::make_unique<ubyte[]>(size);
+    for (uint32_t i = 0; i < size; i++) {
+        data[i] = static_cast<ubyte>(i * 31 + seed);
+    }
+    return data;
+}
+
+static void put_chunk(RegionsLayer& layer, int x, int z, uint32_t size) {
+    auto region = layer.getOrCreateRegion(0, 0);
+    region->put(x, z, make_data(size, x + z), size, size);
+    region->setUnsaved(x, z);
+}
+
+static void check_chunk(RegionsLayer& layer, int x, int z, uint32_t size) {
+    auto rfile = layer.getRegFile({0, 0});
+    ASSERT_TRUE(rfile);
+    uint32_t length, srcSize;
+    auto data = layer.readChunkData(x, z, length, srcSize, rfile.get());
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(length, size);
+    EXPECT_EQ(std::memcmp(data.get(), make_data(size, x + z).get(), size), 0);
+}
+
+class RegionsLayerTest : public ::testing::Test {
+protected:
+    fs::path root;
+
+    void SetUp() override {
+        root = fs::temp_directory_path() / "voxelcore-regions-test";
+        fs::remove_all(root);
+        io::set_device("regtest", std::make_shared<io::StdfsDevice>(root));
+    }
+
+    void TearDown() override {
+        io::remove_device("regtest");
+        fs::remove_all(root);
+    }
+};
+
+TEST_F(RegionsLayerTest, InPlaceUpdate) {
+    io::path file = "regtest:0_0.bin";
+    {
+        RegionsLayer layer {};
+        layer.folder = "regtest:";
+        for (int i = 0; i < 8; i++) {
+            put_chunk(layer, i, 0, 3000 + i * 100);
+        }
+        layer.writeAll();
+    }
+    size_t fullSize = io::file_size(file);
+    {
+        RegionsLayer layer {};
+        layer.folder = "regtest:";
+        // smaller data fits into free sectors after the first rewrite
+        put_chunk(layer, 3, 0, 500);
+        layer.writeAll();
+        put_chunk(layer, 5, 0, 500);
+        layer.writeAll();
+    }
+    EXPECT_LE(io::file_size(file), fullSize + 2 * REGION_SECTOR_SIZE);
+
+    RegionsLayer layer {};
+    layer.folder = "regtest:";
+    for (int i = 0; i < 8; i++) {
+        check_chunk(layer, i, 0, (i == 3 || i == 5) ? 500 : 3000 + i * 100);
+    }
+}
+
+TEST_F(RegionsLayerTest, Convert3to4) {
+    ByteBuilder builder;
+    builder.putCStr(".VOXREG");
+    builder.put(3);
+    builder.put(0);
+    uint32_t offsets[REGION_CHUNKS_COUNT] {};
+    for (int i = 0; i < 4; i++) {
+        uint32_t size = 700 + i;
+        offsets[i] = builder.size();
+        builder.putInt32(size);
+        builder.putInt32(size);
+        builder.put(make_data(size, i).get(), size);
+    }
+    for (size_t i = 0; i < REGION_CHUNKS_COUNT; i++) {
+        builder.putInt32(offsets[i]);
+    }
+    util::Buffer<ubyte> src(builder.build().data(), builder.size());
+    auto dst = compatibility::convert_region_3to4(src);
+    io::write_bytes("regtest:0_0.bin", dst.data(), dst.size());
+
+    RegionsLayer layer {};
+    layer.folder = "regtest:";
+    for (int i = 0; i < 4; i++) {
+        check_chunk(layer, i, 0, 700 + i);
+    }
+}
+
+TEST_F(RegionsLayerTest, DeferredCompressionSnapshot) {
+    const uint32_t size = 4096;
+    RegionsLayer layer {};
+    layer.folder = "regtest:";
+    layer.compression = compression::Method::EXTRLE8;
+
+    auto region = layer.getOrCreateRegion(0, 0);
+    region->put(1, 0, make_data(size, 1), size, size, true);
+    region->setUnsaved(1, 0);
+
+    auto snapshots = layer.takeUnsaved();
+    ASSERT_EQ(snapshots.size(), 1);
+    EXPECT_FALSE(region->isUnsaved());
+    ASSERT_EQ(snapshots[0]->rawChunks.size(), 1);
+
+    layer.writeSnapshot(*snapshots[0]);
+    EXPECT_TRUE(region->isRaw(1));
+    layer.onWritten(*snapshots[0]);
+    EXPECT_FALSE(region->isRaw(1));
+
+    RegionsLayer reader {};
+    reader.folder = "regtest:";
+    reader.compression = compression::Method::EXTRLE8;
+    auto rfile = reader.getRegFile({0, 0});
+    ASSERT_TRUE(rfile);
+    uint32_t length, srcSize;
+    auto data = reader.readChunkData(1, 0, length, srcSize, rfile.get());
+    ASSERT_NE(data, nullptr);
+    EXPECT_EQ(srcSize, size);
+    auto decompressed = compression::decompress(
+        data.get(), length, srcSize, compression::Method::EXTRLE8
+    );
+    EXPECT_EQ(std::memcmp(decompressed.get(), make_data(size, 1).get(), size), 0);
+}
+
+TEST_F(RegionsLayerTest, FailedWriteKeepsChunksUnsaved) {
+    const uint32_t size = 4096;
+    RegionsLayer layer {};
+    layer.folder = "regtest:";
+    put_chunk(layer, 2, 0, size);
+
+    // region file path is occupied by a directory, so the write fails
+    fs::create_directories(root / "0_0.bin" / "blocker");
+    auto snapshots = layer.takeUnsaved();
+    ASSERT_EQ(snapshots.size(), 1);
+    auto region = layer.getRegion(0, 0);
+    EXPECT_FALSE(region->isUnsaved());
+    EXPECT_ANY_THROW(layer.writeSnapshot(*snapshots[0]));
+    layer.onWriteFailed(*snapshots[0]);
+    EXPECT_TRUE(region->isUnsaved(2));
+
+    fs::remove_all(root / "0_0.bin");
+    snapshots = layer.takeUnsaved();
+    ASSERT_EQ(snapshots.size(), 1);
+    layer.writeSnapshot(*snapshots[0]);
+    layer.onWritten(*snapshots[0]);
+    check_chunk(layer, 2, 0, size);
+}
+
+TEST_F(RegionsLayerTest, LZ4VoxelsRoundTrip) {
+    auto src = make_data(CHUNK_DATA_LEN, 7);
+    {
+        WorldRegions regions("regtest:");
+        regions.setCompression(REGION_LAYER_VOXELS, compression::Method::LZ4);
+        auto data = std::make_unique<ubyte[]>(CHUNK_DATA_LEN);
+        std::memcpy(data.get(), src.get(), CHUNK_DATA_LEN);
+        regions.put(
+            -3, 5, REGION_LAYER_VOXELS, std::move(data), CHUNK_DATA_LEN
+        );
+        regions.writeAll();
+    }
+    auto dst = std::make_unique<ubyte[]>(CHUNK_DATA_LEN);
+    {
+        WorldRegions regions("regtest:");
+        regions.setCompression(REGION_LAYER_VOXELS, compression::Method::LZ4);
+        ASSERT_TRUE(regions.getVoxels(-3, 5, dst.get()));
+        EXPECT_EQ(std::memcmp(dst.get(), src.get(), CHUNK_DATA_LEN), 0);
+    }
+    // default extrle16 layer converts LZ4 data on read
+    WorldRegions regions("regtest:");
+    std::memset(dst.get(), 0, CHUNK_DATA_LEN);
+    ASSERT_TRUE(regions.getVoxels(-3, 5, dst.get()));
+    EXPECT_EQ(std::memcmp(dst.get(), src.get(), CHUNK_DATA_LEN), 0);
+}
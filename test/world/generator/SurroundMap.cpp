@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include <atomic>
+#include <stdexcept>
 
 #include "world/generator/SurroundMap.hpp"
 
@@ -31,6 +32,57 @@ TEST(SurroundMap, InitTest) {
     EXPECT_EQ(affected, maxLevel * 2 - 1);
 }
 
+TEST(SurroundMap, BatchCallback) {
+    int8_t maxLevel = 3;
+    SurroundMap map(10, maxLevel);
+    map.setCenter(0, 0);
+
+    std::vector<std::vector<glm::ivec2>> batches;
+    std::vector<int> levels;
+    for (int8_t level = 2; level <= maxLevel; level++) {
+        map.setLevelBatchCallback(
+            level,
+            [&batches, &levels, level](const auto& points) {
+                batches.push_back(points);
+                levels.push_back(level);
+            }
+        );
+    }
+    map.completeAt({{0, 0}, {1, 0}});
+    // one batch per level, 3x3 squares of the points overlap
+    ASSERT_EQ(batches.size(), 2);
+    EXPECT_EQ(levels, std::vector<int>({2, 3}));
+    EXPECT_EQ(batches[0].size(), 12);
+    EXPECT_EQ(batches[1], std::vector<glm::ivec2>({{0, 0}, {1, 0}}));
+
+    batches.clear();
+    map.completeAt(1, 0);
+    EXPECT_TRUE(batches.empty());
+}
+
+TEST(SurroundMap, BatchCallbackFailure) {
+    int8_t maxLevel = 3;
+    SurroundMap map(10, maxLevel);
+    map.setCenter(0, 0);
+
+    bool fail = true;
+    int calls = 0;
+    map.setLevelBatchCallback(maxLevel, [&fail, &calls](const auto&) {
+        calls++;
+        if (fail) {
+            throw std::runtime_error("failed");
+        }
+    });
+    EXPECT_THROW(map.completeAt(0, 0), std::runtime_error);
+    EXPECT_EQ(map.at(0, 0), maxLevel - 1);
+
+    // failed level is upgraded again
+    fail = false;
+    map.completeAt(0, 0);
+    EXPECT_EQ(calls, 2);
+    EXPECT_EQ(map.at(0, 0), maxLevel);
+}
+
 #define VISUAL_TEST
 #ifdef VISUAL_TEST
 